@@ -0,0 +1,299 @@
+/*
+ * Host-side I2C bus simulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Routes bus events to device models attached at 7-bit addresses, so drivers can be
+ * run and measured on the host. Transfers are not timed: every event completes at
+ * once, and stats.clocks gives the bus time at any SCL rate. An address byte with no
+ * device attached is not acknowledged, and the rest of the transfer is ignored
+ * until the next START.
+ * 
+ * Not simulated: clock stretching, arbitration and bus errors, e.g. reading after a
+ * write address or a missing STOP (a new START simply ends the transfer).
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "i2c-sim.h"
+
+/* SCL periods for a byte and its acknowledge bit */
+#define I2C_SIM_BYTE_CLOCKS       9
+
+/* Default SCL period (400 kHz) */
+#define I2C_SIM_SCL_NS            2500
+
+void i2c_sim_init(I2C_SIM *bus) {
+    memset(bus, 0, sizeof(*bus));
+    bus->scl_ns = I2C_SIM_SCL_NS;
+}
+
+void i2c_sim_delay(I2C_SIM *bus, uint32_t us) {
+    bus->now_ns += us * 1000;
+}
+
+uint32_t i2c_sim_time_us(I2C_SIM *bus) {
+    return bus->now_ns / 1000;
+}
+
+static void i2c_sim_clocks(I2C_SIM *bus, uint8_t clocks) {
+    bus->stats.clocks += clocks;
+    bus->now_ns += (uint32_t)clocks * bus->scl_ns;
+}
+
+uint8_t i2c_sim_attach(I2C_SIM *bus, uint8_t addr, const I2C_SIM_OPS *ops, void *context) {
+    I2C_SIM_DEVICE *device;
+    uint8_t i;
+    
+    if (bus->num_devices >= I2C_SIM_DEVICES) {
+        return 0;
+    }
+    
+    for (i = 0; i < bus->num_devices; i++) {
+        if (bus->devices[i].addr == addr) {
+            return 0;
+        }
+    }
+    
+    device = &bus->devices[bus->num_devices++];
+    device->addr = addr;
+    device->ops = ops;
+    device->context = context;
+    
+    return 1;
+}
+
+static void i2c_sim_regfile_start(void *context, uint8_t read) {
+    I2C_SIM_REGFILE *regfile = context;
+    
+    regfile->address_next = !read;
+}
+
+static uint8_t i2c_sim_regfile_write(void *context, uint8_t data) {
+    I2C_SIM_REGFILE *regfile = context;
+    
+    if (regfile->address_next) {
+        regfile->address_next = 0;
+        regfile->addr = data;
+    } else {
+        regfile->regs[regfile->addr++] = data;
+    }
+    
+    return 1;
+}
+
+static uint8_t i2c_sim_regfile_read(void *context) {
+    I2C_SIM_REGFILE *regfile = context;
+    
+    return regfile->regs[regfile->addr++];
+}
+
+static void i2c_sim_regfile_stop(void *context) {
+    (void)context;
+}
+
+static const I2C_SIM_OPS i2c_sim_regfile_ops = {
+    i2c_sim_regfile_start,
+    i2c_sim_regfile_write,
+    i2c_sim_regfile_read,
+    i2c_sim_regfile_stop
+};
+
+uint8_t i2c_sim_attach_regfile(I2C_SIM *bus, uint8_t addr, I2C_SIM_REGFILE *regfile) {
+    return i2c_sim_attach(bus, addr, &i2c_sim_regfile_ops, regfile);
+}
+
+/* End the transfer with the addressed device, if any */
+static void i2c_sim_release(I2C_SIM *bus) {
+    if (bus->target) {
+        bus->target->ops->stop(bus->target->context);
+        bus->target = 0;
+    }
+}
+
+void i2c_sim_start(I2C_SIM *bus) {
+    i2c_sim_release(bus);
+    
+    bus->stats.transactions++;
+    i2c_sim_clocks(bus, 1);
+    bus->address_next = 1;
+    bus->held = 1;
+}
+
+/* The device keeps its state until it is addressed again, as a register pointer must */
+void i2c_sim_restart(I2C_SIM *bus) {
+    bus->stats.restarts++;
+    i2c_sim_clocks(bus, 1);
+    bus->address_next = 1;
+}
+
+void i2c_sim_stop(I2C_SIM *bus) {
+    i2c_sim_release(bus);
+    
+    i2c_sim_clocks(bus, 1);
+    bus->address_next = 0;
+    bus->held = 0;
+}
+
+static I2C_SIM_DEVICE *i2c_sim_find(I2C_SIM *bus, uint8_t addr) {
+    uint8_t i;
+    
+    for (i = 0; i < bus->num_devices; i++) {
+        if (bus->devices[i].addr == addr) {
+            return &bus->devices[i];
+        }
+    }
+    
+    return 0;
+}
+
+uint8_t i2c_sim_write(I2C_SIM *bus, uint8_t data) {
+    I2C_SIM_DEVICE *device;
+    uint8_t ack = 0;
+    
+    bus->stats.bytes++;
+    i2c_sim_clocks(bus, I2C_SIM_BYTE_CLOCKS);
+    
+    if (bus->address_next) {
+        bus->address_next = 0;
+        device = i2c_sim_find(bus, data >> 1);
+        
+        /* A repeated START to another device ends the transfer with the first */
+        if (bus->target && bus->target != device) {
+            i2c_sim_release(bus);
+        }
+        
+        bus->target = device;
+        bus->reading = data & 1;
+        
+        if (device) {
+            device->ops->start(device->context, bus->reading);
+            ack = 1;
+        }
+    } else if (bus->target && !bus->reading) {
+        ack = bus->target->ops->write(bus->target->context, data);
+    }
+    
+    if (!ack) {
+        bus->stats.nacks++;
+    }
+    
+    return ack;
+}
+
+/* With nobody driving SDA the bus reads as 0xFF */
+static uint8_t i2c_sim_read_byte(I2C_SIM *bus, uint8_t clocks) {
+    bus->stats.bytes++;
+    i2c_sim_clocks(bus, clocks);
+    
+    if (bus->target && bus->reading) {
+        return bus->target->ops->read(bus->target->context);
+    }
+    
+    return 0xFF;
+}
+
+uint8_t i2c_sim_read(I2C_SIM *bus, uint8_t ack) {
+    (void)ack;
+    
+    return i2c_sim_read_byte(bus, I2C_SIM_BYTE_CLOCKS);
+}
+
+/* Raise the interrupt for a completed event, unless it is to be dropped */
+static void i2c_sim_raise(I2C_SIM *bus) {
+    if (bus->stall) {
+        bus->stall--;
+    } else {
+        bus->pending = 1;
+    }
+}
+
+void i2c_sim_hw_start(I2C_SIM *bus) {
+    i2c_sim_start(bus);
+    i2c_sim_raise(bus);
+}
+
+void i2c_sim_hw_restart(I2C_SIM *bus) {
+    i2c_sim_restart(bus);
+    i2c_sim_raise(bus);
+}
+
+void i2c_sim_hw_stop(I2C_SIM *bus) {
+    i2c_sim_stop(bus);
+    i2c_sim_raise(bus);
+}
+
+/* Losing arbitration ends the transfer - the other master finishes it and releases the bus */
+void i2c_sim_hw_write(I2C_SIM *bus, uint8_t data) {
+    if (bus->collide) {
+        bus->collide = 0;
+        bus->collision = 1;
+        bus->stats.collisions++;
+        i2c_sim_release(bus);
+        bus->address_next = 0;
+        bus->held = 0;
+        bus->acked = 0;
+    } else {
+        bus->acked = i2c_sim_write(bus, data);
+    }
+    
+    i2c_sim_raise(bus);
+}
+
+uint8_t i2c_sim_hw_acked(I2C_SIM *bus) {
+    return bus->acked;
+}
+
+/* The acknowledge bit is clocked separately with i2c_sim_hw_send_ack, so its clock is counted there */
+void i2c_sim_hw_receive(I2C_SIM *bus) {
+    bus->received = i2c_sim_read_byte(bus, I2C_SIM_BYTE_CLOCKS - 1);
+    i2c_sim_raise(bus);
+}
+
+uint8_t i2c_sim_hw_read(I2C_SIM *bus) {
+    return bus->received;
+}
+
+void i2c_sim_hw_send_ack(I2C_SIM *bus, uint8_t ack) {
+    (void)ack;
+    
+    i2c_sim_clocks(bus, 1);
+    i2c_sim_raise(bus);
+}
+
+uint8_t i2c_sim_hw_collision(I2C_SIM *bus) {
+    uint8_t collision = bus->collision;
+    
+    bus->collision = 0;
+    
+    return collision;
+}
+
+uint8_t i2c_sim_interrupt(I2C_SIM *bus) {
+    uint8_t pending = bus->pending;
+    
+    if (pending) {
+        bus->pending = 0;
+        bus->stats.interrupts++;
+    }
+    
+    return pending;
+}
@@ -0,0 +1,172 @@
+/*
+ * Constant definitions and function prototypes for
+ * host-side I2C bus simulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * The bus can be driven byte by byte, for drivers such as mpu6050.c that run the bus
+ * themselves, or through the interrupt-driven interface expected by i2c.c. For the
+ * blocking driver, mpu6050-cfg.h for the host build would contain for example:
+ * 
+ * #include "i2c-sim.h"
+ * extern I2C_SIM bus;
+ * #define MPU6050_I2C_START()      i2c_sim_start(&bus)
+ * #define MPU6050_I2C_RESTART()    i2c_sim_restart(&bus)
+ * #define MPU6050_I2C_STOP()       i2c_sim_stop(&bus)
+ * #define MPU6050_I2C_WRITE(x)     i2c_sim_write(&bus, x)
+ * #define MPU6050_I2C_READ(ack)    i2c_sim_read(&bus, ack)
+ * 
+ * and for i2c.c, i2c-cfg.h would contain:
+ * 
+ * #define I2C_HW_START()           i2c_sim_hw_start(&bus)
+ * #define I2C_HW_RESTART()         i2c_sim_hw_restart(&bus)
+ * #define I2C_HW_STOP()            i2c_sim_hw_stop(&bus)
+ * #define I2C_HW_WRITE(x)          i2c_sim_hw_write(&bus, x)
+ * #define I2C_HW_ACKED()           i2c_sim_hw_acked(&bus)
+ * #define I2C_HW_RECEIVE()         i2c_sim_hw_receive(&bus)
+ * #define I2C_HW_READ()            i2c_sim_hw_read(&bus)
+ * #define I2C_HW_SEND_ACK(ack)     i2c_sim_hw_send_ack(&bus, ack)
+ * #define I2C_HW_COLLISION()       i2c_sim_hw_collision(&bus)
+ * #define I2C_GET_TIME_US()        i2c_sim_time_us(&bus)
+ * 
+ * with the interrupt handler replaced by:
+ * 
+ * while (i2c_sim_interrupt(&bus)) {
+ *     i2c_isr();
+ * }
+ * 
+ * as in i2c/tools/i2c-cfg.h. Bus time advances with the SCL clocks of each transfer and
+ * with i2c_sim_delay. Collisions and lost interrupts can be injected with the collide
+ * and stall fields.
+ * 
+ * This header does not include i2c.h so it can be included from the config headers.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef I2C_SIM_H
+#define I2C_SIM_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define I2C_SIM_DEVICES           4
+
+/*
+ * Device model callbacks, all given the context passed to i2c_sim_attach. start is
+ * called when the device is addressed, after a START or repeated START, with read
+ * set for a read. write returns 1 to acknowledge the byte.
+ */
+typedef struct {
+    void (*start)(void *context, uint8_t read);
+    uint8_t (*write)(void *context, uint8_t data);
+    uint8_t (*read)(void *context);
+    void (*stop)(void *context);
+} I2C_SIM_OPS;
+
+/* Bus statistics, e.g. for measuring the traffic a driver needs per sample */
+typedef struct {
+    uint32_t transactions;      /* STARTs, not counting repeated STARTs */
+    uint32_t restarts;
+    uint32_t bytes;             /* Bytes transferred, including address bytes */
+    uint32_t nacks;             /* Bytes not acknowledged, including unanswered addresses */
+    uint32_t clocks;            /* SCL periods, counting 1 per START, repeated START and STOP */
+    uint32_t interrupts;        /* Events reported by i2c_sim_interrupt */
+    uint32_t collisions;
+} I2C_SIM_STATS;
+
+typedef struct {
+    uint8_t addr;               /* 7-bit address */
+    const I2C_SIM_OPS *ops;
+    void *context;
+} I2C_SIM_DEVICE;
+
+typedef struct {
+    I2C_SIM_DEVICE devices[I2C_SIM_DEVICES];
+    uint8_t num_devices;
+    
+    /* Transfer in progress */
+    I2C_SIM_DEVICE *target;     /* Addressed device, 0 if none answered */
+    uint8_t address_next;       /* Next byte written is an address byte */
+    uint8_t reading;
+    
+    /* Interrupt-driven interface */
+    uint8_t pending;            /* Interrupt flag, set when an event completes */
+    uint8_t acked;
+    uint8_t received;
+    uint8_t collision;          /* Arbitration was lost, read by i2c_sim_hw_collision */
+    
+    /* Faults for the interrupt-driven interface, set by the test */
+    uint8_t collide;            /* Next address or data byte written loses arbitration */
+    uint8_t stall;              /* Interrupts to drop, as if the hardware stopped responding */
+    
+    uint8_t held;               /* Between START and STOP - this master owns the bus */
+    uint16_t scl_ns;            /* SCL period, 2500 (400 kHz) after i2c_sim_init */
+    uint32_t now_ns;            /* Bus time */
+    
+    I2C_SIM_STATS stats;
+} I2C_SIM;
+
+/* Register file device - 8-bit register address, auto-incrementing on each data byte */
+typedef struct {
+    uint8_t regs[256];
+    uint8_t addr;
+    uint8_t address_next;
+} I2C_SIM_REGFILE;
+
+void i2c_sim_init(I2C_SIM *bus);
+
+/* Let time pass on the bus, e.g. for work done between transactions */
+void i2c_sim_delay(I2C_SIM *bus, uint32_t us);
+uint32_t i2c_sim_time_us(I2C_SIM *bus);
+
+/* Returns 0 if the address is taken or the bus has no room for another device */
+uint8_t i2c_sim_attach(I2C_SIM *bus, uint8_t addr, const I2C_SIM_OPS *ops, void *context);
+uint8_t i2c_sim_attach_regfile(I2C_SIM *bus, uint8_t addr, I2C_SIM_REGFILE *regfile);
+
+/* Byte-level interface - write returns 1 if the byte was acknowledged */
+void i2c_sim_start(I2C_SIM *bus);
+void i2c_sim_restart(I2C_SIM *bus);
+void i2c_sim_stop(I2C_SIM *bus);
+uint8_t i2c_sim_write(I2C_SIM *bus, uint8_t data);
+uint8_t i2c_sim_read(I2C_SIM *bus, uint8_t ack);
+
+/* Interrupt-driven interface - each event completes at once and sets the interrupt flag */
+void i2c_sim_hw_start(I2C_SIM *bus);
+void i2c_sim_hw_restart(I2C_SIM *bus);
+void i2c_sim_hw_stop(I2C_SIM *bus);
+void i2c_sim_hw_write(I2C_SIM *bus, uint8_t data);
+uint8_t i2c_sim_hw_acked(I2C_SIM *bus);
+void i2c_sim_hw_receive(I2C_SIM *bus);
+uint8_t i2c_sim_hw_read(I2C_SIM *bus);
+void i2c_sim_hw_send_ack(I2C_SIM *bus, uint8_t ack);
+
+/* Return and clear the collision flag */
+uint8_t i2c_sim_hw_collision(I2C_SIM *bus);
+
+/* Return and clear the interrupt flag */
+uint8_t i2c_sim_interrupt(I2C_SIM *bus);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* I2C_SIM_H */
@@ -0,0 +1,426 @@
+/*
+ * Interrupt-driven I2C transaction engine
+ * Copyright (c) 2019 David Rice
+ * 
+ * Transactions are queued by the main loop (or by completion callbacks) and run by
+ * a state machine that advances one bus event per interrupt, so the CPU is only
+ * busy for a few instructions per byte instead of waiting out the whole transfer.
+ * Any driver on the bus can queue transactions alongside the others.
+ * 
+ * Requires definitions for:
+ * I2C_HW_START() - Start a START condition
+ * I2C_HW_RESTART() - Start a repeated START condition
+ * I2C_HW_STOP() - Start a STOP condition
+ * I2C_HW_WRITE(x) - Start transmitting one byte
+ * I2C_HW_ACKED() - Nonzero if the last byte transmitted was acknowledged
+ * I2C_HW_RECEIVE() - Start receiving one byte
+ * I2C_HW_READ() - Received byte
+ * I2C_HW_SEND_ACK(ack) - Start sending ACK (ack nonzero) or NACK for the received byte
+ * I2C_INT_DISABLE() - Mask the I2C interrupt
+ * I2C_INT_ENABLE() - Unmask the I2C interrupt
+ * 
+ * Each operation started by the macros above must raise the interrupt that calls
+ * i2c_isr when it completes. For the PIC MSSP in I2C master mode, for example:
+ * 
+ * #define I2C_HW_START()           (SSP1CON2bits.SEN = 1)
+ * #define I2C_HW_RESTART()         (SSP1CON2bits.RSEN = 1)
+ * #define I2C_HW_STOP()            (SSP1CON2bits.PEN = 1)
+ * #define I2C_HW_WRITE(x)          (SSP1BUF = (x))
+ * #define I2C_HW_ACKED()           (!SSP1CON2bits.ACKSTAT)
+ * #define I2C_HW_RECEIVE()         (SSP1CON2bits.RCEN = 1)
+ * #define I2C_HW_READ()            SSP1BUF
+ * #define I2C_HW_SEND_ACK(ack)     do { SSP1CON2bits.ACKDT = !(ack); SSP1CON2bits.ACKEN = 1; } while (0)
+ * #define I2C_INT_DISABLE()        (PIE3bits.SSP1IE = 0)
+ * #define I2C_INT_ENABLE()         (PIE3bits.SSP1IE = 1)
+ * #define I2C_HW_COLLISION()       (PIR3bits.BCL1IF ? (PIR3bits.BCL1IF = 0, 1) : 0)
+ * 
+ * Optional definitions:
+ * I2C_HW_COLLISION() - Nonzero (clearing the flag) if the last operation lost arbitration;
+ *     the bus collision interrupt must then also call i2c_isr
+ * I2C_GET_TIME_US() - Free-running 16-bit timer value with 1 us resolution, for latency
+ *     statistics and the i2c_wait timeout
+ * I2C_WAIT_POLL() - Run on every pass of the i2c_wait loop, e.g. to service a simulated bus
+ * I2C_QUEUE_SIZE - Transactions queued at once (default 8)
+ * 
+ * Configuration is usually located in i2c-cfg.h in the same folder with the main project
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "i2c.h"
+#include "i2c-cfg.h"
+
+/* Transactions waiting or in progress (must be a power of two, at most 128) */
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE            8
+#endif
+
+#define I2C_QUEUE_MASK            (I2C_QUEUE_SIZE - 1)
+
+/* Bus states - each names the event whose completion raises the next interrupt */
+#define I2C_STATE_IDLE            0
+#define I2C_STATE_START           1
+#define I2C_STATE_ADDR_W          2
+#define I2C_STATE_TX              3
+#define I2C_STATE_RESTART         4
+#define I2C_STATE_ADDR_R          5
+#define I2C_STATE_RX              6
+#define I2C_STATE_RX_ACK          7
+#define I2C_STATE_STOP            8
+#define I2C_STATE_ABORT           9           /* STOP after i2c_abort, no transaction on the bus */
+#define I2C_STATE_COLLISION       10          /* Not stored - selects the collision step in i2c_isr */
+
+#ifdef I2C_GET_TIME_US
+#define I2C_NOW()                 ((uint16_t)I2C_GET_TIME_US())
+#endif
+
+/* Queue - slot at tail is the transaction on the bus */
+static I2C_TRANSACTION *i2c_queue[I2C_QUEUE_SIZE];
+static volatile uint8_t i2c_head;
+static volatile uint8_t i2c_tail;
+
+static volatile uint8_t i2c_state;
+static uint16_t i2c_index;
+static uint8_t i2c_nack;
+
+static I2C_STATS i2c_stats;
+
+/* Empty the queue and clear statistics */
+void i2c_init(void) {
+    uint8_t *p = (uint8_t *)&i2c_stats;
+    uint8_t i;
+    
+    i2c_head = 0;
+    i2c_tail = 0;
+    i2c_state = I2C_STATE_IDLE;
+    
+    for (i = 0; i < sizeof(I2C_STATS); i++) {
+        p[i] = 0;
+    }
+}
+
+/* Put the transaction at the tail on the bus */
+static void i2c_begin(void) {
+    I2C_TRANSACTION *t = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+    
+    t->status = I2C_BUSY;
+#ifdef I2C_GET_TIME_US
+    t->started = I2C_NOW();
+#endif
+    
+    i2c_index = 0;
+    i2c_nack = 0;
+    i2c_state = I2C_STATE_START;
+    
+    I2C_HW_START();
+}
+
+/* Queue a transaction - returns 0 if the queue is full */
+uint8_t i2c_submit(I2C_TRANSACTION *t) {
+    uint8_t queued;
+    
+    t->status = I2C_PENDING;
+#ifdef I2C_GET_TIME_US
+    t->submitted = I2C_NOW();
+#endif
+    
+    I2C_INT_DISABLE();
+    
+    queued = (i2c_head - i2c_tail) & 0xFF;
+    
+    if (queued >= I2C_QUEUE_SIZE) {
+        i2c_stats.rejected++;
+        I2C_INT_ENABLE();
+        t->status = I2C_IDLE;
+        return 0;
+    }
+    
+    i2c_queue[i2c_head & I2C_QUEUE_MASK] = t;
+    i2c_head++;
+    
+    if (queued + 1 > i2c_stats.max_queued) {
+        i2c_stats.max_queued = queued + 1;
+    }
+    
+    if (i2c_state == I2C_STATE_IDLE) {
+        i2c_begin();
+    }
+    
+    I2C_INT_ENABLE();
+    
+    return 1;
+}
+
+/* End the transaction on the bus */
+static void i2c_stop(void) {
+    i2c_state = I2C_STATE_STOP;
+    I2C_HW_STOP();
+}
+
+/* Take the transaction at the tail off the bus with its final status */
+static void i2c_retire(uint8_t status) {
+    I2C_TRANSACTION *t = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+#ifdef I2C_GET_TIME_US
+    uint16_t now = I2C_NOW();
+    uint16_t elapsed;
+    uint8_t bucket = 0;
+#endif
+    
+    i2c_tail++;
+    
+#ifdef I2C_GET_TIME_US
+    elapsed = now - t->started;
+    i2c_stats.bus_us += elapsed;
+    if (elapsed > i2c_stats.bus_us_max) {
+        i2c_stats.bus_us_max = elapsed;
+    }
+    
+    elapsed = (uint16_t)(now - t->submitted) / I2C_STATS_HIST_BASE_US;
+    
+    while (elapsed && bucket < I2C_STATS_HIST_BUCKETS - 1) {
+        elapsed >>= 1;
+        bucket++;
+    }
+    
+    i2c_stats.latency[bucket]++;
+#endif
+    i2c_stats.completed++;
+    
+    if (status == I2C_NACK) {
+        i2c_stats.nacks++;
+    } else if (status == I2C_COLLISION) {
+        i2c_stats.collisions++;
+    } else if (status == I2C_TIMEOUT) {
+        i2c_stats.timeouts++;
+    }
+    
+    t->status = status;
+    
+    /* The callback may submit, which starts the bus if it is idle */
+    if (t->done) {
+        t->done(t);
+    }
+}
+
+/* Start the next queued transaction if the bus is free */
+static void i2c_next(void) {
+    if (i2c_state == I2C_STATE_IDLE && i2c_head != i2c_tail) {
+        i2c_begin();
+    }
+}
+
+/*
+ * One step per interrupt: the hardware raises the interrupt when a START, address or
+ * data byte, received byte, ACK sequence or STOP has completed.
+ * 
+ * A NACK ends the transaction with a STOP, so the bus is released before the next one
+ * starts. After a collision the other master owns the bus and the hardware has already
+ * let go of it, so the transaction ends at once and the next START waits for a free bus.
+ */
+void i2c_isr(void) {
+    I2C_TRANSACTION *t = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+#ifdef I2C_GET_TIME_US
+    uint16_t entry = I2C_NOW();
+    uint16_t spent;
+#endif
+    uint8_t state = i2c_state;
+    
+#ifdef I2C_HW_COLLISION
+    if (state != I2C_STATE_IDLE && I2C_HW_COLLISION()) {
+        state = I2C_STATE_COLLISION;
+    }
+#endif
+    
+    switch (state) {
+        case I2C_STATE_START:
+            /* Write phase unless the transaction only reads */
+            i2c_stats.bytes++;
+            if (t->tx_len || !t->rx_len) {
+                i2c_state = I2C_STATE_ADDR_W;
+                I2C_HW_WRITE(t->addr << 1);
+            } else {
+                i2c_state = I2C_STATE_ADDR_R;
+                I2C_HW_WRITE((t->addr << 1) | 1);
+            }
+            break;
+        
+        case I2C_STATE_ADDR_W:
+        case I2C_STATE_TX:
+            if (!I2C_HW_ACKED()) {
+                i2c_nack = 1;
+                i2c_stop();
+            } else if (i2c_index < t->tx_len) {
+                i2c_stats.bytes++;
+                i2c_state = I2C_STATE_TX;
+                I2C_HW_WRITE(t->tx[i2c_index++]);
+            } else if (t->rx_len) {
+                i2c_state = I2C_STATE_RESTART;
+                I2C_HW_RESTART();
+            } else {
+                i2c_stop();
+            }
+            break;
+        
+        case I2C_STATE_RESTART:
+            i2c_stats.bytes++;
+            i2c_state = I2C_STATE_ADDR_R;
+            I2C_HW_WRITE((t->addr << 1) | 1);
+            break;
+        
+        case I2C_STATE_ADDR_R:
+            if (!I2C_HW_ACKED()) {
+                i2c_nack = 1;
+                i2c_stop();
+            } else {
+                i2c_index = 0;
+                i2c_state = I2C_STATE_RX;
+                I2C_HW_RECEIVE();
+            }
+            break;
+        
+        case I2C_STATE_RX:
+            /* NACK the last byte to end the read */
+            i2c_stats.bytes++;
+            t->rx[i2c_index++] = I2C_HW_READ();
+            i2c_state = I2C_STATE_RX_ACK;
+            I2C_HW_SEND_ACK(i2c_index < t->rx_len);
+            break;
+        
+        case I2C_STATE_RX_ACK:
+            if (i2c_index < t->rx_len) {
+                i2c_state = I2C_STATE_RX;
+                I2C_HW_RECEIVE();
+            } else {
+                i2c_stop();
+            }
+            break;
+        
+        case I2C_STATE_STOP:
+            i2c_state = I2C_STATE_IDLE;
+            i2c_retire(i2c_nack ? I2C_NACK : I2C_DONE);
+            i2c_next();
+            break;
+        
+        case I2C_STATE_ABORT:
+            i2c_state = I2C_STATE_IDLE;
+            i2c_next();
+            break;
+        
+        case I2C_STATE_COLLISION:
+            /* Nothing is on the bus while the STOP sent by i2c_abort is pending */
+            state = i2c_state;
+            i2c_state = I2C_STATE_IDLE;
+            if (state != I2C_STATE_ABORT) {
+                i2c_retire(I2C_COLLISION);
+            }
+            i2c_next();
+            break;
+        
+        default:
+            break;
+    }
+    
+#ifdef I2C_GET_TIME_US
+    spent = I2C_NOW() - entry;
+    if (spent > i2c_stats.isr_us_max) {
+        i2c_stats.isr_us_max = spent;
+    }
+#endif
+}
+
+/* Nonzero while transactions are queued or in progress */
+uint8_t i2c_busy(void) {
+    return i2c_head != i2c_tail;
+}
+
+/*
+ * A STOP is sent even if the last one never completed, since the hardware may have
+ * recovered meanwhile. With no transaction on the bus only the STOP is sent.
+ */
+void i2c_abort(void) {
+    uint8_t state;
+    
+    I2C_INT_DISABLE();
+    
+    state = i2c_state;
+    
+    if (state != I2C_STATE_IDLE) {
+        i2c_state = I2C_STATE_ABORT;
+        I2C_HW_STOP();
+        
+        if (state != I2C_STATE_ABORT) {
+            i2c_retire(I2C_TIMEOUT);
+        }
+    }
+    
+    I2C_INT_ENABLE();
+}
+
+/*
+ * Without I2C_GET_TIME_US the timeout counts passes of the wait loop instead, taking
+ * each as 1 us, so it is only approximate.
+ */
+uint8_t i2c_wait(I2C_TRANSACTION *t, uint16_t timeout_us) {
+#ifdef I2C_GET_TIME_US
+    uint16_t start = I2C_NOW();
+#else
+    uint16_t passes = 0;
+#endif
+    
+    while (t->status == I2C_PENDING || t->status == I2C_BUSY) {
+#ifdef I2C_GET_TIME_US
+        if ((uint16_t)(I2C_NOW() - start) >= timeout_us) {
+#else
+        if (passes++ >= timeout_us) {
+#endif
+            i2c_abort();
+            break;
+        }
+        
+#ifdef I2C_WAIT_POLL
+        I2C_WAIT_POLL();
+#endif
+    }
+    
+    return t->status;
+}
+
+/* Copy statistics with the interrupt masked */
+void i2c_stats_get(I2C_STATS *stats) {
+    I2C_INT_DISABLE();
+    *stats = i2c_stats;
+    I2C_INT_ENABLE();
+}
+
+/* Clear statistics */
+void i2c_stats_reset(void) {
+    uint8_t *p = (uint8_t *)&i2c_stats;
+    uint8_t i;
+    
+    I2C_INT_DISABLE();
+    
+    for (i = 0; i < sizeof(I2C_STATS); i++) {
+        p[i] = 0;
+    }
+    
+    I2C_INT_ENABLE();
+}
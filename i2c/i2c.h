@@ -0,0 +1,120 @@
+/*
+ * Constant definitions and function prototypes for
+ * interrupt-driven I2C transaction engine
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Transaction status */
+#define I2C_IDLE                  0           /* Not submitted */
+#define I2C_PENDING               1           /* Queued behind other transactions */
+#define I2C_BUSY                  2           /* On the bus */
+#define I2C_DONE                  3
+#define I2C_NACK                  4           /* Address or data byte not acknowledged */
+#define I2C_TIMEOUT               5           /* Abandoned by i2c_wait or i2c_abort - the hardware stopped responding */
+#define I2C_COLLISION             6           /* Lost arbitration - the bus was left to the other master */
+
+/*
+ * Bus statistics - the timing fields (bus_us, bus_us_max, isr_us_max and latency) are
+ * only collected when I2C_GET_TIME_US is defined.
+ * 
+ * Submit-to-completion latency buckets double in width: bucket 0 is < 100 us, bucket 1
+ * is 100-199 us, bucket 2 is 200-399 us and so on, with the last bucket open-ended.
+ */
+#define I2C_STATS_HIST_BUCKETS    8
+#define I2C_STATS_HIST_BASE_US    100U
+
+typedef struct {
+    uint16_t completed;         /* Transactions retired, whatever their status */
+    uint16_t nacks;
+    uint16_t collisions;
+    uint16_t timeouts;
+    uint16_t rejected;          /* Submissions refused because the queue was full */
+    uint8_t max_queued;         /* Deepest queue seen, including the transaction on the bus */
+    uint32_t bytes;             /* Bytes on the bus, including address bytes */
+    uint32_t bus_us;            /* Total time from START to completion */
+    uint16_t bus_us_max;
+    uint16_t isr_us_max;        /* Longest single call to i2c_isr */
+    uint16_t latency[I2C_STATS_HIST_BUCKETS];
+} I2C_STATS;
+
+/*
+ * One bus transaction: tx_len bytes written to the device, then rx_len bytes read
+ * after a repeated START. Either part may be empty; with both empty the device is
+ * only addressed. The buffers must stay valid until the transaction completes.
+ */
+typedef struct I2C_TRANSACTION {
+    uint8_t addr;                                   /* 7-bit address */
+    const uint8_t *tx;
+    uint8_t tx_len;
+    uint8_t *rx;
+    uint16_t rx_len;
+    void (*done)(struct I2C_TRANSACTION *t);        /* Called from i2c_isr on completion (optional) */
+    void *context;                                  /* For the owner of the transaction */
+    
+    volatile uint8_t status;
+    uint16_t submitted;                             /* Timer values for statistics */
+    uint16_t started;
+} I2C_TRANSACTION;
+
+void i2c_init(void);
+
+/*
+ * Queue a transaction - returns 0 if the queue is full. Safe to call from a done
+ * callback, e.g. to chain a transaction that depends on the result of the last one.
+ */
+uint8_t i2c_submit(I2C_TRANSACTION *t);
+
+/* Advance the bus state machine - call from the interrupt handler after clearing the MSSP interrupt flag */
+void i2c_isr(void);
+
+/* Nonzero while transactions are queued or in progress */
+uint8_t i2c_busy(void);
+
+/*
+ * Wait up to timeout_us for a transaction to complete and return its status. If it
+ * has not, i2c_abort releases the bus: when t was on the bus it ends with I2C_TIMEOUT,
+ * otherwise it stays queued behind the aborted transaction and I2C_PENDING is returned.
+ */
+uint8_t i2c_wait(I2C_TRANSACTION *t, uint16_t timeout_us);
+
+/*
+ * End the transaction on the bus with I2C_TIMEOUT (calling its done callback) and send a
+ * STOP to release the bus. Queued transactions start once the STOP has completed.
+ */
+void i2c_abort(void);
+
+void i2c_stats_get(I2C_STATS *stats);
+void i2c_stats_reset(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* I2C_H */
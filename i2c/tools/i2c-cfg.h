@@ -0,0 +1,51 @@
+/*
+ * I2C engine configuration for host tools - binds i2c.c to the bus simulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef I2C_CFG_H
+#define I2C_CFG_H
+
+#include "i2c-sim.h"
+
+/* Defined by the tool, e.g. i2c-engine-test.c */
+extern I2C_SIM bus;
+
+#define I2C_HW_START()              i2c_sim_hw_start(&bus)
+#define I2C_HW_RESTART()            i2c_sim_hw_restart(&bus)
+#define I2C_HW_STOP()               i2c_sim_hw_stop(&bus)
+#define I2C_HW_WRITE(x)             i2c_sim_hw_write(&bus, x)
+#define I2C_HW_ACKED()              i2c_sim_hw_acked(&bus)
+#define I2C_HW_RECEIVE()            i2c_sim_hw_receive(&bus)
+#define I2C_HW_READ()               i2c_sim_hw_read(&bus)
+#define I2C_HW_SEND_ACK(ack)        i2c_sim_hw_send_ack(&bus, ack)
+#define I2C_HW_COLLISION()          i2c_sim_hw_collision(&bus)
+
+/* The simulator only raises interrupts when the tool services them */
+#define I2C_INT_DISABLE()
+#define I2C_INT_ENABLE()
+
+#define I2C_GET_TIME_US()           i2c_sim_time_us(&bus)
+
+/* Each pass of i2c_wait takes 1 us and services the interrupt */
+#define I2C_WAIT_POLL()             do { i2c_sim_delay(&bus, 1); while (i2c_sim_interrupt(&bus)) { i2c_isr(); } } while (0)
+
+#endif	/* I2C_CFG_H */
@@ -0,0 +1,363 @@
+/*
+ * Host test of the I2C transaction engine on the bus simulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Runs i2c.c against i2c-sim.c through tools/i2c-cfg.h, covering NACKs, lost
+ * arbitration, a stalled interrupt with i2c_wait timing out, a full queue and chained
+ * submissions. Then runs periodic sensor-style traffic for a simulated second and
+ * prints the submit-to-completion latency histogram. Prints each check and exits with
+ * status 1 if any failed.
+ * 
+ * Build with, for example:
+ * cc -I. -I.. -o i2c-engine-test i2c-engine-test.c ../i2c.c ../i2c-sim.c
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "i2c.h"
+#include "i2c-sim.h"
+
+#define IMU_ADDRESS     0x68
+#define MAG_ADDRESS     0x1E
+#define NACK_ADDRESS    0x40        /* Acknowledges its address but no data bytes */
+#define NO_ADDRESS      0x50
+
+#define QUEUE_SIZE      8           /* I2C_QUEUE_SIZE default in i2c.c */
+
+I2C_SIM bus;
+
+static I2C_SIM_REGFILE imu;
+static I2C_SIM_REGFILE mag;
+static int failures;
+
+static void check(int ok, const char *what) {
+    printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+    
+    if (!ok) {
+        failures++;
+    }
+}
+
+/* Service interrupts until the bus has nothing more to do */
+static void pump(void) {
+    while (i2c_sim_interrupt(&bus)) {
+        i2c_isr();
+    }
+}
+
+static void nack_start(void *context, uint8_t read) {
+    (void)context;
+    (void)read;
+}
+
+static uint8_t nack_write(void *context, uint8_t data) {
+    (void)context;
+    (void)data;
+    
+    return 0;
+}
+
+static uint8_t nack_read(void *context) {
+    (void)context;
+    
+    return 0xFF;
+}
+
+static void nack_stop(void *context) {
+    (void)context;
+}
+
+static const I2C_SIM_OPS nack_ops = { nack_start, nack_write, nack_read, nack_stop };
+
+static void setup(void) {
+    uint16_t i;
+    
+    i2c_sim_init(&bus);
+    
+    for (i = 0; i < 256; i++) {
+        imu.regs[i] = (uint8_t)i;
+        mag.regs[i] = (uint8_t)~i;
+    }
+    
+    i2c_sim_attach_regfile(&bus, IMU_ADDRESS, &imu);
+    i2c_sim_attach_regfile(&bus, MAG_ADDRESS, &mag);
+    i2c_sim_attach(&bus, NACK_ADDRESS, &nack_ops, NULL);
+    
+    i2c_init();
+}
+
+static void transaction(I2C_TRANSACTION *t, uint8_t addr, const uint8_t *tx, uint8_t tx_len, uint8_t *rx, uint16_t rx_len) {
+    t->addr = addr;
+    t->tx = tx;
+    t->tx_len = tx_len;
+    t->rx = rx;
+    t->rx_len = rx_len;
+    t->done = NULL;
+    t->context = NULL;
+}
+
+static void test_basic(void) {
+    static const uint8_t write[] = { 0x10, 0xA5, 0x5A };
+    static const uint8_t reg[] = { 0x10 };
+    I2C_TRANSACTION t;
+    uint8_t buffer[2] = { 0, 0 };
+    
+    setup();
+    
+    transaction(&t, IMU_ADDRESS, write, sizeof(write), NULL, 0);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE, "write completes");
+    check(imu.regs[0x10] == 0xA5 && imu.regs[0x11] == 0x5A, "write reaches the device");
+    
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), buffer, sizeof(buffer));
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE, "read completes");
+    check(buffer[0] == 0xA5 && buffer[1] == 0x5A, "read returns the registers written");
+    check(!bus.held && !i2c_busy(), "bus released after the read");
+    check(bus.stats.transactions == 2 && bus.stats.restarts == 1, "one repeated START for the read");
+}
+
+static void test_nack(void) {
+    static const uint8_t write[] = { 0x20, 0x01 };
+    static const uint8_t reg[] = { 0x20 };
+    I2C_TRANSACTION t;
+    I2C_STATS stats;
+    uint8_t buffer[2] = { 0x77, 0x77 };
+    
+    setup();
+    
+    transaction(&t, NO_ADDRESS, reg, sizeof(reg), buffer, sizeof(buffer));
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_NACK, "address NACK reported");
+    check(!bus.held, "bus released after an address NACK");
+    check(buffer[0] == 0x77 && buffer[1] == 0x77, "nothing read after an address NACK");
+    
+    transaction(&t, NACK_ADDRESS, write, sizeof(write), NULL, 0);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_NACK, "data NACK reported");
+    check(!bus.held, "bus released after a data NACK");
+    check(bus.stats.bytes == 3, "no bytes written after the NACK");
+    
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), buffer, 1);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE && buffer[0] == 0x20, "next transaction completes");
+    
+    i2c_stats_get(&stats);
+    check(stats.completed == 3 && stats.nacks == 2, "NACKs counted");
+}
+
+static void test_collision(void) {
+    static const uint8_t write[] = { 0x30, 0x42 };
+    static const uint8_t reg[] = { 0x30 };
+    I2C_TRANSACTION t;
+    I2C_STATS stats;
+    uint8_t value = 0;
+    
+    setup();
+    
+    bus.collide = 1;
+    transaction(&t, IMU_ADDRESS, write, sizeof(write), NULL, 0);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_COLLISION, "lost arbitration reported");
+    check(!bus.held && bus.stats.collisions == 1, "bus left to the other master");
+    check(imu.regs[0x30] == 0x30, "nothing written after the collision");
+    
+    transaction(&t, IMU_ADDRESS, write, sizeof(write), NULL, 0);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE, "write retried after the collision");
+    
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), &value, 1);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE && value == 0x42, "retried write reached the device");
+    
+    i2c_stats_get(&stats);
+    check(stats.completed == 3 && stats.collisions == 1 && stats.nacks == 0, "collision counted");
+}
+
+static void test_timeout(void) {
+    static const uint8_t reg[] = { 0x40 };
+    I2C_TRANSACTION t;
+    I2C_TRANSACTION next;
+    I2C_STATS stats;
+    uint8_t buffer[4];
+    uint8_t value = 0;
+    uint32_t start;
+    uint8_t status;
+    
+    setup();
+    
+    /* The START interrupt is lost, so the engine waits forever without a timeout */
+    bus.stall = 1;
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), buffer, sizeof(buffer));
+    start = i2c_sim_time_us(&bus);
+    check(i2c_submit(&t) && i2c_wait(&t, 500) == I2C_TIMEOUT, "stalled transaction times out");
+    check(i2c_sim_time_us(&bus) - start < 600, "timeout bounded");
+    
+    pump();
+    check(!bus.held && !i2c_busy(), "bus released by the abort");
+    
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), &value, 1);
+    check(i2c_submit(&t) && i2c_wait(&t, 1000) == I2C_DONE && value == 0x40, "next transaction completes");
+    
+    /* A transaction queued behind the stalled one runs once the abort has released the bus */
+    bus.stall = 1;
+    transaction(&t, IMU_ADDRESS, reg, sizeof(reg), buffer, sizeof(buffer));
+    transaction(&next, MAG_ADDRESS, reg, sizeof(reg), &value, 1);
+    check(i2c_submit(&t) && i2c_submit(&next), "submitted behind a stalled transaction");
+    status = i2c_wait(&next, 500);
+    check(status == I2C_PENDING && t.status == I2C_TIMEOUT, "queued transaction still pending after the timeout");
+    check(i2c_wait(&next, 1000) == I2C_DONE && value == (uint8_t)~0x40, "queued transaction completes");
+    
+    i2c_stats_get(&stats);
+    check(stats.completed == 4 && stats.timeouts == 2, "timeouts counted");
+}
+
+static uint8_t chain_reg[] = { 0x50 };
+static uint8_t chain_value;
+static I2C_TRANSACTION chain_second;
+static uint8_t chain_submitted;
+
+static void chain_done(I2C_TRANSACTION *t) {
+    if (t->status == I2C_DONE) {
+        transaction(&chain_second, MAG_ADDRESS, chain_reg, sizeof(chain_reg), &chain_value, 1);
+        chain_submitted = i2c_submit(&chain_second);
+    }
+}
+
+static void test_queue(void) {
+    static const uint8_t reg[] = { 0x60 };
+    I2C_TRANSACTION t[QUEUE_SIZE + 1];
+    I2C_TRANSACTION first;
+    I2C_STATS stats;
+    uint8_t buffer[QUEUE_SIZE + 1];
+    uint8_t accepted = 0;
+    uint8_t i;
+    
+    setup();
+    
+    for (i = 0; i <= QUEUE_SIZE; i++) {
+        transaction(&t[i], IMU_ADDRESS, reg, sizeof(reg), &buffer[i], 1);
+        accepted += i2c_submit(&t[i]);
+    }
+    
+    check(accepted == QUEUE_SIZE && t[QUEUE_SIZE].status == I2C_IDLE, "full queue refuses a submission");
+    
+    pump();
+    
+    for (i = 0; i < QUEUE_SIZE && t[i].status == I2C_DONE && buffer[i] == 0x60; i++) {
+    }
+    
+    check(i == QUEUE_SIZE, "queued transactions complete in order");
+    
+    i2c_stats_get(&stats);
+    check(stats.rejected == 1 && stats.max_queued == QUEUE_SIZE, "queue depth and rejection counted");
+    
+    /* Chained from the done callback, when the queue slot has just been freed */
+    transaction(&first, IMU_ADDRESS, reg, sizeof(reg), &buffer[0], 1);
+    first.done = chain_done;
+    check(i2c_submit(&first), "first of a chain submitted");
+    pump();
+    check(chain_submitted && chain_second.status == I2C_DONE && chain_value == (uint8_t)~0x50, "chained transaction completes");
+}
+
+/*
+ * A 1 kHz sensor burst, a 500 Hz magnetometer read and a 200 Hz configuration write,
+ * all submitted on the same tick so that the later ones queue behind the first.
+ */
+static void test_latency(void) {
+    static const uint8_t imu_reg[] = { 0x3B };
+    static const uint8_t mag_reg[] = { 0x03 };
+    static const uint8_t imu_write[] = { 0x19, 0x07 };
+    I2C_TRANSACTION imu_t;
+    I2C_TRANSACTION mag_t;
+    I2C_TRANSACTION write_t;
+    I2C_STATS stats;
+    uint8_t imu_buffer[14];
+    uint8_t mag_buffer[6];
+    uint16_t submitted = 0;
+    uint16_t sum = 0;
+    uint16_t ms;
+    uint32_t next;
+    uint32_t now;
+    uint8_t i;
+    
+    setup();
+    
+    transaction(&imu_t, IMU_ADDRESS, imu_reg, sizeof(imu_reg), imu_buffer, sizeof(imu_buffer));
+    transaction(&mag_t, MAG_ADDRESS, mag_reg, sizeof(mag_reg), mag_buffer, sizeof(mag_buffer));
+    transaction(&write_t, IMU_ADDRESS, imu_write, sizeof(imu_write), NULL, 0);
+    
+    next = i2c_sim_time_us(&bus);
+    
+    for (ms = 0; ms < 1000; ms++) {
+        submitted += i2c_submit(&imu_t);
+        
+        if (ms % 2 == 0) {
+            submitted += i2c_submit(&mag_t);
+        }
+        
+        if (ms % 5 == 0) {
+            submitted += i2c_submit(&write_t);
+        }
+        
+        pump();
+        
+        next += 1000;
+        now = i2c_sim_time_us(&bus);
+        
+        if (now < next) {
+            i2c_sim_delay(&bus, next - now);
+        }
+    }
+    
+    i2c_stats_get(&stats);
+    
+    printf("\n%u transactions, %lu bytes, %lu us on the bus (longest %u us)\n", stats.completed,
+            (unsigned long)stats.bytes, (unsigned long)stats.bus_us, stats.bus_us_max);
+    printf("submit to completion:\n");
+    
+    for (i = 0; i < I2C_STATS_HIST_BUCKETS; i++) {
+        if (i == 0) {
+            printf("  < %u us", I2C_STATS_HIST_BASE_US);
+        } else if (i == I2C_STATS_HIST_BUCKETS - 1) {
+            printf("  >= %u us", I2C_STATS_HIST_BASE_US << (i - 1));
+        } else {
+            printf("  %u-%u us", I2C_STATS_HIST_BASE_US << (i - 1), (I2C_STATS_HIST_BASE_US << i) - 1);
+        }
+        
+        printf(": %u\n", stats.latency[i]);
+        sum += stats.latency[i];
+    }
+    
+    printf("\n");
+    
+    check(submitted == 1000 + 500 + 200 && stats.completed == submitted, "periodic traffic completes");
+    check(sum == stats.completed, "every transaction in the latency histogram");
+    check(stats.nacks == 0 && stats.collisions == 0 && stats.timeouts == 0, "no errors in periodic traffic");
+    check(stats.latency[0] == 0 && stats.latency[I2C_STATS_HIST_BUCKETS - 1] == 0, "latency within the bus time of a tick");
+}
+
+int main(void) {
+    test_basic();
+    test_nack();
+    test_collision();
+    test_timeout();
+    test_queue();
+    test_latency();
+    
+    printf("%d failed\n", failures);
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Activity-driven ODR scaling for ST Microelectronics LSM6DS3x
+ * Copyright (c) 2019 David Rice
+ * 
+ * The chip's wake-up detector (latched on INT1) reports motion. While still, the
+ * accelerometer runs at a low ODR with the gyro powered down. A wake-up switches
+ * back to full rate on the next poll, so the delay is one idle sample period plus
+ * interrupt latency. Hysteresis is in both amplitude (a lower threshold while
+ * active) and time (still_ms without motion, at least hold_ms after waking).
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-events.h"
+#include "lsm6ds3x-activity.h"
+
+/* Offsets within LSM6D_PROFILE */
+#define LSM6D_ACT_CTRL1_XL        0
+#define LSM6D_ACT_CTRL2_G         1
+#define LSM6D_ACT_WAKE_UP_THS     3
+
+/* Add time since the last update to the current accelerometer ODR */
+static void lsm6d_act_account(LSM6D_ACTIVITY *act, uint32_t now) {
+    uint8_t odr = (act->state == LSM6D_ACT_IDLE) ? act->xl_idle : act->xl_active;
+    
+    act->time_at[odr] += now - act->accounted;
+    act->accounted = now;
+}
+
+/* Switch rates and threshold - the ODRs go in one burst */
+static void lsm6d_act_enter(LSM6D_ACTIVITY *act, uint8_t state, uint32_t now) {
+    LSM6D_PROFILE profile;
+    uint8_t *ctrl = profile.ctrl;
+    
+    lsm6d_act_account(act, now);
+    
+    lsm6d_dev_profile_get(act->dev, &profile);
+    
+    ctrl[LSM6D_ACT_CTRL1_XL] &= ~_CTRL1_XL_ODR_XL_MASK;
+    ctrl[LSM6D_ACT_CTRL2_G] &= ~_CTRL2_G_ODR_G_MASK;
+    profile.func_cfg[LSM6D_ACT_WAKE_UP_THS] &= ~_WAKE_UP_THS_WK_THS_MASK;
+    
+    if (state == LSM6D_ACT_IDLE) {
+        ctrl[LSM6D_ACT_CTRL1_XL] |= act->xl_idle << _CTRL1_XL_ODR_XL_POSN;
+        ctrl[LSM6D_ACT_CTRL2_G] |= _CTRL2_G_ODR_G_POWER_DOWN << _CTRL2_G_ODR_G_POSN;
+        profile.func_cfg[LSM6D_ACT_WAKE_UP_THS] |= act->ths_idle & _WAKE_UP_THS_WK_THS_MASK;
+    } else {
+        ctrl[LSM6D_ACT_CTRL1_XL] |= act->xl_active << _CTRL1_XL_ODR_XL_POSN;
+        ctrl[LSM6D_ACT_CTRL2_G] |= act->g_active << _CTRL2_G_ODR_G_POSN;
+        profile.func_cfg[LSM6D_ACT_WAKE_UP_THS] |= act->ths_active & _WAKE_UP_THS_WK_THS_MASK;
+    }
+    
+    lsm6d_dev_profile_apply(act->dev, &profile);
+    
+    if (state != act->state) {
+        act->transitions++;
+    }
+    
+    act->state = state;
+    act->since = now;
+}
+
+uint8_t lsm6d_act_dev_init(LSM6D_ACTIVITY *act, LSM6D_DEVICE *dev, uint8_t (*int1)(void)) {
+    LSM6D_EVENT_CFG cfg;
+    uint32_t now;
+    uint8_t i;
+    
+    /* Both rates index time_at */
+    if (act->xl_idle >= LSM6D_ACT_ODRS || act->xl_active >= LSM6D_ACT_ODRS) {
+        return 0;
+    }
+    
+    act->dev = dev;
+    act->int1 = int1;
+    
+    now = act->time_ms();
+    
+    lsm6d_events_defaults(&cfg);
+    cfg.enable = LSM6D_EVENT_WAKE;
+    cfg.int1 = LSM6D_EVENT_WAKE;
+    cfg.latched = 1;
+    cfg.wake_ths = act->ths_active;
+    cfg.wake_dur = 0;
+    lsm6d_events_dev_configure(act->dev, &cfg);
+    
+    for (i = 0; i < LSM6D_ACT_ODRS; i++) {
+        act->time_at[i] = 0;
+    }
+    
+    act->transitions = 0;
+    act->accounted = now;
+    act->last_motion = now;
+    act->state = LSM6D_ACT_ACTIVE;
+    lsm6d_act_enter(act, LSM6D_ACT_ACTIVE, now);
+    
+    return 1;
+}
+
+uint8_t lsm6d_act_poll(LSM6D_ACTIVITY *act) {
+    LSM6D_EVENTS events;
+    uint32_t now = act->time_ms();
+    
+    if (!act->int1 || act->int1()) {
+        /* Reading WAKE_UP_SRC releases the latched interrupt */
+        if (lsm6d_events_dev_read(act->dev, &events) & LSM6D_EVENT_WAKE) {
+            act->last_motion = now;
+            
+            if (act->state == LSM6D_ACT_IDLE) {
+                lsm6d_act_enter(act, LSM6D_ACT_ACTIVE, now);
+            }
+        }
+    }
+    
+    if (act->state == LSM6D_ACT_ACTIVE && now - act->last_motion >= act->still_ms && now - act->since >= act->hold_ms) {
+        lsm6d_act_enter(act, LSM6D_ACT_IDLE, now);
+    }
+    
+    return act->state;
+}
+
+void lsm6d_act_report(LSM6D_ACTIVITY *act, uint32_t *time_at) {
+    uint8_t i;
+    
+    lsm6d_act_account(act, act->time_ms());
+    
+    for (i = 0; i < LSM6D_ACT_ODRS; i++) {
+        time_at[i] = act->time_at[i];
+        act->time_at[i] = 0;
+    }
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+static uint8_t lsm6d_act_default_int1(void) {
+    return LSM6D_INT1 ? 1 : 0;
+}
+
+uint8_t lsm6d_act_init(LSM6D_ACTIVITY *act) {
+    return lsm6d_act_dev_init(act, &lsm6d_default_device, lsm6d_act_default_int1);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
@@ -0,0 +1,89 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x activity-driven ODR scaling
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_ACTIVITY_H
+#define LSM6DS3X_ACTIVITY_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Controller states */
+#define LSM6D_ACT_ACTIVE          0
+#define LSM6D_ACT_IDLE            1
+
+/* Number of ODR settings, for time accounting */
+#define LSM6D_ACT_ODRS            11
+
+typedef struct {
+    /* Configuration - set before lsm6d_act_init */
+    uint8_t xl_active;          /* _CTRL1_XL_ODR_XL_x while moving */
+    uint8_t g_active;           /* _CTRL2_G_ODR_G_x while moving */
+    uint8_t xl_idle;            /* _CTRL1_XL_ODR_XL_x while still - gyro is powered down */
+    uint8_t ths_idle;           /* Wake-up threshold while still (FS_XL / 64 per LSB) */
+    uint8_t ths_active;         /* Lower threshold that keeps the controller active */
+    uint16_t still_ms;          /* Time without motion before going idle */
+    uint16_t hold_ms;           /* Minimum time active after waking */
+    uint32_t (*time_ms)(void);  /* Free-running millisecond timer */
+    
+    /* State */
+    LSM6D_DEVICE *dev;
+    uint8_t (*int1)(void);      /* INT1 pin state, NULL to read WAKE_UP_SRC on every poll */
+    uint8_t state;
+    uint32_t since;             /* Time of last state change */
+    uint32_t last_motion;       /* Time motion was last seen */
+    uint32_t accounted;         /* Time up to which time_at has been updated */
+    uint16_t transitions;
+    uint32_t time_at[LSM6D_ACT_ODRS];   /* Milliseconds at each accelerometer ODR setting */
+} LSM6D_ACTIVITY;
+
+/*
+ * Set up wake-up detection on INT1 (latched) of dev and start in the active state.
+ * int1 returns the state of dev's INT1 pin; if it is NULL every poll reads WAKE_UP_SRC.
+ * Returns 0, without touching the device, if xl_idle or xl_active is not a valid ODR setting.
+ */
+uint8_t lsm6d_act_dev_init(LSM6D_ACTIVITY *act, LSM6D_DEVICE *dev, uint8_t (*int1)(void));
+
+/* As lsm6d_act_dev_init, for lsm6d_default_device with its LSM6D_INT1 pin */
+uint8_t lsm6d_act_init(LSM6D_ACTIVITY *act);
+
+/*
+ * Call often, or from the INT1 handler. No SPI traffic is needed unless INT1 is
+ * asserted (or there is no int1 callback) or the still timeout has expired.
+ * Returns LSM6D_ACT_ACTIVE/IDLE.
+ */
+uint8_t lsm6d_act_poll(LSM6D_ACTIVITY *act);
+
+/* Bring time_at up to date and clear it */
+void lsm6d_act_report(LSM6D_ACTIVITY *act, uint32_t *time_at);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_ACTIVITY_H */
@@ -0,0 +1,426 @@
+/*
+ * Fixed-point Mahony orientation filter for ST Microelectronics LSM6DS3x data
+ * Copyright (c) 2019 David Rice
+ * 
+ * Samples are processed in batches, e.g. straight from lsm6d_fifo_read_timed, and
+ * the time step of each one is taken from the on-chip timestamps. All arithmetic is
+ * 32-bit, so no floating point or 64-bit support is needed. Products of two Q30 values
+ * are built from 16-bit partial products, which on an 8-bit PIC is several times
+ * cheaper than a long long multiply. The quaternion is renormalized with a first order
+ * correction every sample, which needs no square root or division.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#ifdef LSM6D_AHRS_FLOAT
+#include <math.h>
+#endif
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-ahrs.h"
+
+/* pi * 2^30 / (8 * 1000 * 180) in Q19, to convert Q3 mdps to Q30 rad/s */
+#define LSM6D_AHRS_MDPS_TO_Q30    1228166276L
+
+/*
+ * Return (a * b) >> shift, adding half an LSB first if round is set. The 64-bit
+ * product is kept as two 32-bit halves built from 16-bit partial products, and the
+ * result is the same as with an int64_t intermediate. shift must be 1..31 and the
+ * result must fit in 32 bits.
+ */
+static int32_t lsm6d_ahrs_mulsh(int32_t a, int32_t b, uint8_t shift, uint8_t round) {
+    uint32_t ua = (a < 0) ? -(uint32_t)a : (uint32_t)a;
+    uint32_t ub = (b < 0) ? -(uint32_t)b : (uint32_t)b;
+    uint32_t lo = (ua & 0xFFFFU) * (ub & 0xFFFFU);
+    uint32_t hi = (ua >> 16) * (ub >> 16);
+    uint32_t mid;
+    uint32_t sum;
+    
+    mid = (ua >> 16) * (ub & 0xFFFFU);
+    sum = lo + (mid << 16);
+    hi += (mid >> 16) + (sum < lo);
+    lo = sum;
+    
+    mid = (ua & 0xFFFFU) * (ub >> 16);
+    sum = lo + (mid << 16);
+    hi += (mid >> 16) + (sum < lo);
+    lo = sum;
+    
+    if ((a < 0) != (b < 0)) {
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0);
+    }
+    
+    if (round) {
+        sum = lo + (1UL << (shift - 1));
+        hi += (sum < lo);
+        lo = sum;
+    }
+    
+    return (int32_t)((lo >> shift) | (hi << (32 - shift)));
+}
+
+/* Multiply two Q30 values */
+#define lsm6d_ahrs_mul(a, b)      lsm6d_ahrs_mulsh((a), (b), LSM6D_AHRS_Q, 0)
+
+/* Convert Q30 error to Q24 rate with a Q16 gain */
+#define lsm6d_ahrs_gain(e, k)     lsm6d_ahrs_mulsh((e), (k), LSM6D_AHRS_Q + LSM6D_AHRS_GAIN_Q - LSM6D_AHRS_RATE_Q, 0)
+
+/* Convert a raw gyro value to Q24 rate with a Q30 scale, rounded */
+#define lsm6d_ahrs_rate(raw, scale) lsm6d_ahrs_mulsh((raw), (scale), LSM6D_AHRS_Q - LSM6D_AHRS_RATE_Q, 1)
+
+/* Convert an interval in us to Q30 seconds */
+static int32_t lsm6d_ahrs_dt(uint32_t us) {
+    if (us > LSM6D_AHRS_MAX_DT_US) {
+        us = LSM6D_AHRS_MAX_DT_US;
+    }
+    
+    /* us * 2^30 / 10^6 is (us << 12) * 2^12 / 15625 - divide in two steps to stay within 32 bits */
+    us <<= 12;
+    
+    return (int32_t)(((us / 15625) << 12) + (((us % 15625) << 12) + 15625 / 2) / 15625);
+}
+
+uint16_t lsm6d_ahrs_sqrt(uint32_t x) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    
+    while (bit > x) {
+        bit >>= 2;
+    }
+    
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return (uint16_t)root;
+}
+
+/* Arctangent of y / x in 0.01 degree, accurate to about 0.01 degree */
+int16_t lsm6d_ahrs_atan2(int32_t y, int32_t x) {
+    uint32_t ax = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+    uint32_t ay = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+    int32_t z;
+    int32_t z2;
+    int32_t p;
+    int16_t angle;
+    
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    
+    /* Keep the ratio numerator within 32 bits */
+    while ((ax | ay) & 0xFFFF0000UL) {
+        ax >>= 1;
+        ay >>= 1;
+    }
+    
+    /* Ratio in Q15 within 0..1, then a polynomial for atan over the first octant */
+    z = (ay <= ax) ? (int32_t)((ay << 15) / ax) : (int32_t)((ax << 15) / ay);
+    z2 = (z * z) >> 15;
+    
+    p = 683;
+    p = -2790 + ((p * z2) >> 15);
+    p = 5903 + ((p * z2) >> 15);
+    p = -10823 + ((p * z2) >> 15);
+    p = 32763 + ((p * z2) >> 15);
+    p = (p * z) >> 15;
+    
+    /* Radians (Q15) to 0.01 degree */
+    angle = (int16_t)((p * 11459L + 32768L) >> 16);
+    
+    if (ay > ax) {
+        angle = 9000 - angle;
+    }
+    
+    if (x < 0) {
+        angle = 18000 - angle;
+    }
+    
+    return (y < 0) ? -angle : angle;
+}
+
+void lsm6d_ahrs_init(LSM6D_AHRS *ahrs, uint16_t g_mult, uint16_t tick_us, uint32_t period_us) {
+    uint8_t i;
+    
+    ahrs->q[0] = LSM6D_AHRS_ONE;
+    
+    for (i = 0; i < 3; i++) {
+        ahrs->q[i + 1] = 0;
+        ahrs->ei[i] = 0;
+    }
+    
+    ahrs->g_scale = lsm6d_ahrs_mulsh(g_mult, LSM6D_AHRS_MDPS_TO_Q30, 19, 1);
+    
+    ahrs->kp = LSM6D_AHRS_KP_DEFAULT;
+    ahrs->ki = LSM6D_AHRS_KI_DEFAULT;
+    ahrs->tick_us = tick_us;
+    ahrs->dt_nominal = lsm6d_ahrs_dt(period_us);
+    ahrs->started = 0;
+    ahrs->dt_ticks = 0;
+    ahrs->dt = ahrs->dt_nominal;
+}
+
+/* One filter step with time step dt (Q30 s) */
+static void lsm6d_ahrs_step(LSM6D_AHRS *ahrs, const LSM6D_SENSOR_DATA *s, int32_t dt) {
+    int32_t *q = ahrs->q;
+    int32_t r[3];
+    int32_t a[3];
+    int32_t v[3];
+    int32_t e[3];
+    int32_t h[3];
+    int32_t q0, q1, q2, q3;
+    int32_t n;
+    uint16_t mag;
+    uint8_t i;
+    
+    r[0] = lsm6d_ahrs_rate(s->g.x, ahrs->g_scale);
+    r[1] = lsm6d_ahrs_rate(s->g.y, ahrs->g_scale);
+    r[2] = lsm6d_ahrs_rate(s->g.z, ahrs->g_scale);
+    
+    mag = lsm6d_ahrs_sqrt((uint32_t)((int32_t)s->xl.x * s->xl.x) + (uint32_t)((int32_t)s->xl.y * s->xl.y)
+            + (uint32_t)((int32_t)s->xl.z * s->xl.z));
+    
+    /* Correct towards measured gravity unless in free fall */
+    if (mag) {
+        a[0] = (((int32_t)s->xl.x << 15) / mag) << 15;
+        a[1] = (((int32_t)s->xl.y << 15) / mag) << 15;
+        a[2] = (((int32_t)s->xl.z << 15) / mag) << 15;
+        
+        /* Gravity direction predicted by the current orientation */
+        v[0] = 2 * (lsm6d_ahrs_mul(q[1], q[3]) - lsm6d_ahrs_mul(q[0], q[2]));
+        v[1] = 2 * (lsm6d_ahrs_mul(q[0], q[1]) + lsm6d_ahrs_mul(q[2], q[3]));
+        v[2] = lsm6d_ahrs_mul(q[0], q[0]) - lsm6d_ahrs_mul(q[1], q[1]) - lsm6d_ahrs_mul(q[2], q[2]) + lsm6d_ahrs_mul(q[3], q[3]);
+        
+        e[0] = lsm6d_ahrs_mul(a[1], v[2]) - lsm6d_ahrs_mul(a[2], v[1]);
+        e[1] = lsm6d_ahrs_mul(a[2], v[0]) - lsm6d_ahrs_mul(a[0], v[2]);
+        e[2] = lsm6d_ahrs_mul(a[0], v[1]) - lsm6d_ahrs_mul(a[1], v[0]);
+        
+        for (i = 0; i < 3; i++) {
+            if (ahrs->ki) {
+                ahrs->ei[i] += lsm6d_ahrs_mul(lsm6d_ahrs_gain(e[i], ahrs->ki), dt);
+                r[i] += ahrs->ei[i];
+            }
+            r[i] += lsm6d_ahrs_gain(e[i], ahrs->kp);
+        }
+    }
+    
+    /* Half rotation angle over the step (Q30 rad) */
+    for (i = 0; i < 3; i++) {
+        h[i] = lsm6d_ahrs_mulsh(r[i], dt, LSM6D_AHRS_RATE_Q + 1, 1);
+    }
+    
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    
+    q[0] = q0 - lsm6d_ahrs_mul(q1, h[0]) - lsm6d_ahrs_mul(q2, h[1]) - lsm6d_ahrs_mul(q3, h[2]);
+    q[1] = q1 + lsm6d_ahrs_mul(q0, h[0]) + lsm6d_ahrs_mul(q2, h[2]) - lsm6d_ahrs_mul(q3, h[1]);
+    q[2] = q2 + lsm6d_ahrs_mul(q0, h[1]) - lsm6d_ahrs_mul(q1, h[2]) + lsm6d_ahrs_mul(q3, h[0]);
+    q[3] = q3 + lsm6d_ahrs_mul(q0, h[2]) + lsm6d_ahrs_mul(q1, h[1]) - lsm6d_ahrs_mul(q2, h[0]);
+    
+    /* Scale by 1 / |q| to first order: (3 - |q|^2) / 2 */
+    n = lsm6d_ahrs_mul(q[0], q[0]) + lsm6d_ahrs_mul(q[1], q[1]) + lsm6d_ahrs_mul(q[2], q[2]) + lsm6d_ahrs_mul(q[3], q[3]);
+    n = LSM6D_AHRS_ONE + ((LSM6D_AHRS_ONE - n) >> 1);
+    
+    for (i = 0; i < 4; i++) {
+        q[i] = lsm6d_ahrs_mul(q[i], n);
+    }
+}
+
+void lsm6d_ahrs_update(LSM6D_AHRS *ahrs, const LSM6D_SENSOR_DATA *data, const uint32_t *timestamps, uint16_t count) {
+    uint32_t ticks;
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        if (!timestamps) {
+            lsm6d_ahrs_step(ahrs, &data[i], ahrs->dt_nominal);
+            continue;
+        }
+        
+        if (!ahrs->started) {
+            /* Nothing to integrate over until the second sample */
+            ahrs->last_ts = timestamps[i];
+            ahrs->started = 1;
+            continue;
+        }
+        
+        ticks = timestamps[i] - ahrs->last_ts;
+        ahrs->last_ts = timestamps[i];
+        
+        if (ticks != ahrs->dt_ticks) {
+            ahrs->dt_ticks = ticks;
+            /* Clamp in ticks first so that the conversion to us cannot overflow */
+            ahrs->dt = lsm6d_ahrs_dt((ticks > LSM6D_AHRS_MAX_DT_US / ahrs->tick_us) ? LSM6D_AHRS_MAX_DT_US : ticks * ahrs->tick_us);
+        }
+        
+        lsm6d_ahrs_step(ahrs, &data[i], ahrs->dt);
+    }
+}
+
+void lsm6d_ahrs_get_euler(const LSM6D_AHRS *ahrs, LSM6D_AHRS_EULER *euler) {
+    const int32_t *q = ahrs->q;
+    int32_t s;
+    
+    euler->roll = lsm6d_ahrs_atan2(2 * (lsm6d_ahrs_mul(q[0], q[1]) + lsm6d_ahrs_mul(q[2], q[3])),
+            LSM6D_AHRS_ONE - 2 * (lsm6d_ahrs_mul(q[1], q[1]) + lsm6d_ahrs_mul(q[2], q[2])));
+    
+    /* asin(s) as atan2(s, sqrt(1 - s^2)) */
+    s = 2 * (lsm6d_ahrs_mul(q[0], q[2]) - lsm6d_ahrs_mul(q[3], q[1]));
+    if (s > LSM6D_AHRS_ONE) {
+        s = LSM6D_AHRS_ONE;
+    } else if (s < -LSM6D_AHRS_ONE) {
+        s = -LSM6D_AHRS_ONE;
+    }
+    
+    euler->pitch = lsm6d_ahrs_atan2(s, (int32_t)lsm6d_ahrs_sqrt(LSM6D_AHRS_ONE - lsm6d_ahrs_mul(s, s)) << 15);
+    
+    euler->yaw = lsm6d_ahrs_atan2(2 * (lsm6d_ahrs_mul(q[0], q[3]) + lsm6d_ahrs_mul(q[1], q[2])),
+            LSM6D_AHRS_ONE - 2 * (lsm6d_ahrs_mul(q[2], q[2]) + lsm6d_ahrs_mul(q[3], q[3])));
+}
+
+#ifdef LSM6D_AHRS_FLOAT
+
+void lsm6d_ahrs_float_init(LSM6D_AHRS_F *ahrs, uint16_t g_mult, uint16_t tick_us, uint32_t period_us) {
+    uint8_t i;
+    
+    ahrs->q[0] = 1.0f;
+    
+    for (i = 0; i < 3; i++) {
+        ahrs->q[i + 1] = 0.0f;
+        ahrs->ei[i] = 0.0f;
+    }
+    
+    ahrs->g_scale = g_mult * (3.14159265f / 1440000.0f);
+    ahrs->kp = (float)LSM6D_AHRS_KP_DEFAULT / (1L << LSM6D_AHRS_GAIN_Q);
+    ahrs->ki = (float)LSM6D_AHRS_KI_DEFAULT / (1L << LSM6D_AHRS_GAIN_Q);
+    ahrs->tick_s = tick_us * 1e-6f;
+    ahrs->dt_nominal = period_us * 1e-6f;
+    ahrs->started = 0;
+}
+
+static void lsm6d_ahrs_float_step(LSM6D_AHRS_F *ahrs, const LSM6D_SENSOR_DATA *s, float dt) {
+    float *q = ahrs->q;
+    float r[3];
+    float a[3];
+    float v[3];
+    float e[3];
+    float q0, q1, q2, q3;
+    float n;
+    uint8_t i;
+    
+    r[0] = s->g.x * ahrs->g_scale;
+    r[1] = s->g.y * ahrs->g_scale;
+    r[2] = s->g.z * ahrs->g_scale;
+    
+    n = sqrtf((float)s->xl.x * s->xl.x + (float)s->xl.y * s->xl.y + (float)s->xl.z * s->xl.z);
+    
+    if (n > 0.0f) {
+        a[0] = s->xl.x / n;
+        a[1] = s->xl.y / n;
+        a[2] = s->xl.z / n;
+        
+        v[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+        v[1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+        v[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+        
+        e[0] = a[1] * v[2] - a[2] * v[1];
+        e[1] = a[2] * v[0] - a[0] * v[2];
+        e[2] = a[0] * v[1] - a[1] * v[0];
+        
+        for (i = 0; i < 3; i++) {
+            if (ahrs->ki > 0.0f) {
+                ahrs->ei[i] += ahrs->ki * e[i] * dt;
+                r[i] += ahrs->ei[i];
+            }
+            r[i] += ahrs->kp * e[i];
+        }
+    }
+    
+    for (i = 0; i < 3; i++) {
+        r[i] *= 0.5f * dt;
+    }
+    
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    
+    q[0] = q0 - q1 * r[0] - q2 * r[1] - q3 * r[2];
+    q[1] = q1 + q0 * r[0] + q2 * r[2] - q3 * r[1];
+    q[2] = q2 + q0 * r[1] - q1 * r[2] + q3 * r[0];
+    q[3] = q3 + q0 * r[2] + q1 * r[1] - q2 * r[0];
+    
+    n = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    
+    for (i = 0; i < 4; i++) {
+        q[i] *= n;
+    }
+}
+
+void lsm6d_ahrs_float_update(LSM6D_AHRS_F *ahrs, const LSM6D_SENSOR_DATA *data, const uint32_t *timestamps, uint16_t count) {
+    float dt;
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        if (!timestamps) {
+            lsm6d_ahrs_float_step(ahrs, &data[i], ahrs->dt_nominal);
+            continue;
+        }
+        
+        if (!ahrs->started) {
+            ahrs->last_ts = timestamps[i];
+            ahrs->started = 1;
+            continue;
+        }
+        
+        dt = (timestamps[i] - ahrs->last_ts) * ahrs->tick_s;
+        ahrs->last_ts = timestamps[i];
+        
+        if (dt > LSM6D_AHRS_MAX_DT_US * 1e-6f) {
+            dt = LSM6D_AHRS_MAX_DT_US * 1e-6f;
+        }
+        
+        lsm6d_ahrs_float_step(ahrs, &data[i], dt);
+    }
+}
+
+/* Euler angles in degrees */
+void lsm6d_ahrs_float_get_euler(const LSM6D_AHRS_F *ahrs, float *roll, float *pitch, float *yaw) {
+    const float *q = ahrs->q;
+    float s;
+    
+    *roll = atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) * 57.2957795f;
+    
+    s = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+    s = (s > 1.0f) ? 1.0f : ((s < -1.0f) ? -1.0f : s);
+    *pitch = asinf(s) * 57.2957795f;
+    
+    *yaw = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) * 57.2957795f;
+}
+
+#endif
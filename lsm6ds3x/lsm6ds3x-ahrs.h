@@ -0,0 +1,124 @@
+/*
+ * Constant definitions and function prototypes for
+ * fixed-point Mahony orientation filter for LSM6DS3x data
+ * Copyright (c) 2019 David Rice
+ * 
+ * Optional definitions (in lsm6ds3x-cfg.h):
+ * LSM6D_AHRS_FLOAT - Also build the single-precision reference filter
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_AHRS_H
+#define LSM6DS3X_AHRS_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point formats
+ * 
+ * Quaternion components, gravity and error vectors and time steps are Q30.
+ * Angular rate is rad/s in Q24 (2000 dps is about 35 rad/s).
+ * Gains are Q16.
+ */
+#define LSM6D_AHRS_Q              30
+#define LSM6D_AHRS_ONE            (1L << LSM6D_AHRS_Q)
+#define LSM6D_AHRS_RATE_Q         24
+#define LSM6D_AHRS_GAIN_Q         16
+
+/* Longest time step integrated, e.g. after the FIFO overran (us, at most 1000000) */
+#ifndef LSM6D_AHRS_MAX_DT_US
+#define LSM6D_AHRS_MAX_DT_US      100000UL
+#endif
+
+/* Default gains - proportional 2 * 0.5, no integral */
+#define LSM6D_AHRS_KP_DEFAULT     (1L << LSM6D_AHRS_GAIN_Q)
+#define LSM6D_AHRS_KI_DEFAULT     0
+
+/* Filter state */
+typedef struct {
+    int32_t q[4];               /* Orientation w, x, y, z */
+    int32_t ei[3];              /* Integral of error, as rate (Q24) */
+    int32_t g_scale;            /* Gyro sensitivity, rad/s per LSB (Q30) */
+    int32_t kp;                 /* Proportional gain (Q16) */
+    int32_t ki;                 /* Integral gain (Q16) */
+    uint16_t tick_us;           /* Timestamp LSB in us */
+    int32_t dt_nominal;         /* Sample period used without timestamps (Q30 s) */
+    uint32_t last_ts;           /* Timestamp of last sample */
+    uint8_t started;            /* last_ts is valid */
+    uint32_t dt_ticks;          /* Interval converted last, to skip the division when it repeats */
+    int32_t dt;                 /* dt_ticks in seconds (Q30) */
+} LSM6D_AHRS;
+
+/* Euler angles in 0.01 degree */
+typedef struct {
+    int16_t roll;
+    int16_t pitch;
+    int16_t yaw;
+} LSM6D_AHRS_EULER;
+
+/*
+ * Reset to identity orientation. g_mult is the gyro multiplier from
+ * lsm6d_units_g_mult (Q3 mdps/LSB), tick_us the timestamp LSB
+ * (LSM6D_TIMESTAMP_LSB_US or LSM6D_TIMESTAMP_LSB_US_HR) and period_us the
+ * sample period assumed when no timestamps are given.
+ */
+void lsm6d_ahrs_init(LSM6D_AHRS *ahrs, uint16_t g_mult, uint16_t tick_us, uint32_t period_us);
+
+/* Process count samples - timestamps may be NULL */
+void lsm6d_ahrs_update(LSM6D_AHRS *ahrs, const LSM6D_SENSOR_DATA *data, const uint32_t *timestamps, uint16_t count);
+
+void lsm6d_ahrs_get_euler(const LSM6D_AHRS *ahrs, LSM6D_AHRS_EULER *euler);
+
+/* Integer helpers - atan2 result in 0.01 degree */
+int16_t lsm6d_ahrs_atan2(int32_t y, int32_t x);
+uint16_t lsm6d_ahrs_sqrt(uint32_t x);
+
+#ifdef LSM6D_AHRS_FLOAT
+
+/* Reference filter - same algorithm in single precision, compared with the fixed-point one by tools/lsm6d-ahrs-check */
+typedef struct {
+    float q[4];
+    float ei[3];
+    float g_scale;              /* rad/s per LSB */
+    float kp;
+    float ki;
+    float tick_s;
+    float dt_nominal;
+    uint32_t last_ts;
+    uint8_t started;
+} LSM6D_AHRS_F;
+
+void lsm6d_ahrs_float_init(LSM6D_AHRS_F *ahrs, uint16_t g_mult, uint16_t tick_us, uint32_t period_us);
+void lsm6d_ahrs_float_update(LSM6D_AHRS_F *ahrs, const LSM6D_SENSOR_DATA *data, const uint32_t *timestamps, uint16_t count);
+void lsm6d_ahrs_float_get_euler(const LSM6D_AHRS_F *ahrs, float *roll, float *pitch, float *yaw);
+
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_AHRS_H */
@@ -0,0 +1,275 @@
+/*
+ * Synchronized acquisition from several LSM6DS3x devices on one SPI bus
+ * Copyright (c) 2019 David Rice
+ * 
+ * Each device is an LSM6D_DEVICE with its own chip select. All FIFOs are configured
+ * first and then switched out of bypass mode in one back-to-back sweep (timestamp
+ * counters too, where enabled), so sample n of every device is taken within one
+ * sweep of the others. Each poll drains the FIFOs round-robin, one burst per device,
+ * into per-device staging queues; a set is complete once every enabled device has
+ * contributed a sample.
+ * 
+ * The devices run from their own oscillators, so one can slowly gain samples on the
+ * others. A device more than LSM6D_ARRAY_SLIP samples ahead of the slowest has its
+ * oldest samples dropped to restore alignment (counted in slips).
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-array.h"
+
+/* Words per sample - temperature, accelerometer x/y/z, gyro x/y/z */
+#define LSM6D_ARRAY_WORDS         (sizeof(LSM6D_SENSOR_DATA) / sizeof(int16_t))
+
+#define LSM6D_ARRAY_USED(a, i)    ((uint8_t)((a)->head[i] - (a)->tail[i]))
+
+/* Reported in the raw slots of disabled devices */
+static const LSM6D_SENSOR_DATA lsm6d_array_zero = {0, {0, 0, 0}, {0, 0, 0}};
+
+void lsm6d_array_init(LSM6D_ARRAY *array, LSM6D_DEVICE **devs, uint8_t count, uint8_t method) {
+    uint8_t i;
+    
+    if (count > LSM6D_ARRAY_MAX) {
+        count = LSM6D_ARRAY_MAX;
+    }
+    
+    array->count = count;
+    array->enabled = (uint8_t)((1 << count) - 1);
+    array->stalled = 0;
+    array->method = method;
+    array->slips = 0;
+    
+    for (i = 0; i < count; i++) {
+        array->dev[i] = devs[i];
+        array->head[i] = 0;
+        array->tail[i] = 0;
+        array->idle[i] = 0;
+        
+        lsm6d_dev_init(devs[i]);
+    }
+}
+
+void lsm6d_array_start(LSM6D_ARRAY *array, uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold) {
+    uint8_t i;
+    
+    /* Everything except the mode change - FIFOs stay in bypass */
+    for (i = 0; i < array->count; i++) {
+        lsm6d_dev_fifo_configure(array->dev[i], odr, _FIFO_CTRL5_FIFO_BYPASS, dec_xl, dec_g, threshold);
+        
+        array->head[i] = 0;
+        array->tail[i] = 0;
+        array->idle[i] = 0;
+    }
+    
+    for (i = 0; i < array->count; i++) {
+        if (array->dev[i]->fifo.dec_ts) {
+            lsm6d_dev_set_register_value(array->dev[i], LSM6D_TIMESTAMP2_REG, LSM6D_TIMESTAMP_RESET);
+            array->dev[i]->fifo.timestamp = 0;
+        }
+    }
+    
+    /* Start sweep - one short transaction per device */
+    for (i = 0; i < array->count; i++) {
+        lsm6d_dev_set_register_value(array->dev[i], LSM6D_FIFO_CTRL5, (odr << _FIFO_CTRL5_ODR_FIFO_POSN) | (mode << _FIFO_CTRL5_FIFO_MODE_POSN));
+    }
+    
+    array->stalled = 0;
+    array->slips = 0;
+}
+
+/* Drain one device's FIFO into its staging queue, up to two contiguous runs */
+static uint8_t lsm6d_array_drain(LSM6D_ARRAY *array, uint8_t i) {
+    uint8_t head = array->head[i];
+    uint8_t space = LSM6D_ARRAY_DEPTH - LSM6D_ARRAY_USED(array, i);
+    uint8_t total = 0;
+    uint8_t run;
+    
+    while (space) {
+        run = LSM6D_ARRAY_DEPTH - (head & (LSM6D_ARRAY_DEPTH - 1));
+        if (run > space) {
+            run = space;
+        }
+        
+        run = (uint8_t)lsm6d_dev_fifo_read(array->dev[i], &array->stage[i][head & (LSM6D_ARRAY_DEPTH - 1)], run);
+        if (run == 0) {
+            break;
+        }
+        
+        head += run;
+        space -= run;
+        total += run;
+    }
+    
+    array->head[i] = head;
+    
+    return total;
+}
+
+/* Number of complete sets - the fewest samples staged by any enabled device */
+static uint8_t lsm6d_array_ready(LSM6D_ARRAY *array) {
+    uint8_t ready = LSM6D_ARRAY_DEPTH;
+    uint8_t i;
+    
+    if (!array->enabled) {
+        return 0;
+    }
+    
+    for (i = 0; i < array->count; i++) {
+        if ((array->enabled & (1 << i)) && LSM6D_ARRAY_USED(array, i) < ready) {
+            ready = LSM6D_ARRAY_USED(array, i);
+        }
+    }
+    
+    return ready;
+}
+
+uint8_t lsm6d_array_poll(LSM6D_ARRAY *array) {
+    uint8_t got = 0;
+    uint8_t ready;
+    uint8_t i;
+    
+    for (i = 0; i < array->count; i++) {
+        if (!(array->enabled & (1 << i))) {
+            continue;
+        }
+        
+        if (lsm6d_array_drain(array, i)) {
+            got |= 1 << i;
+        }
+    }
+    
+    /* A device that keeps returning nothing while the others have data has stopped */
+    for (i = 0; i < array->count; i++) {
+        if (got & (1 << i)) {
+            array->idle[i] = 0;
+            array->stalled &= ~(1 << i);
+        } else if (got && (array->enabled & (1 << i)) && ++array->idle[i] >= LSM6D_ARRAY_STALL) {
+            array->idle[i] = LSM6D_ARRAY_STALL;
+            array->stalled |= 1 << i;
+        }
+    }
+    
+    /* Realign any device that has run ahead of the slowest */
+    ready = lsm6d_array_ready(array);
+    
+    for (i = 0; i < array->count; i++) {
+        if ((array->enabled & (1 << i)) && LSM6D_ARRAY_USED(array, i) > ready + LSM6D_ARRAY_SLIP) {
+            array->slips += LSM6D_ARRAY_USED(array, i) - ready - LSM6D_ARRAY_SLIP;
+            array->tail[i] = array->head[i] - ready - LSM6D_ARRAY_SLIP;
+        }
+    }
+    
+    return ready;
+}
+
+uint8_t lsm6d_array_read(LSM6D_ARRAY *array, LSM6D_SENSOR_DATA *fused, LSM6D_SENSOR_DATA *raw, uint8_t max) {
+    LSM6D_SENSOR_DATA set[LSM6D_ARRAY_MAX];
+    uint8_t ready = lsm6d_array_ready(array);
+    uint8_t n;
+    uint8_t i;
+    
+    if (ready > max) {
+        ready = max;
+    }
+    
+    for (n = 0; n < ready; n++) {
+        for (i = 0; i < array->count; i++) {
+            if (array->enabled & (1 << i)) {
+                set[i] = array->stage[i][array->tail[i]++ & (LSM6D_ARRAY_DEPTH - 1)];
+            } else {
+                set[i] = lsm6d_array_zero;
+            }
+            
+            if (raw) {
+                raw[n * array->count + i] = set[i];
+            }
+        }
+        
+        lsm6d_array_fuse(set, array->count, array->enabled, array->method, &fused[n]);
+    }
+    
+    return ready;
+}
+
+void lsm6d_array_enable(LSM6D_ARRAY *array, uint8_t index, uint8_t enable) {
+    if (index >= array->count) {
+        return;
+    }
+    
+    if (enable) {
+        /* Rejoin at the next sample - older ones are no longer aligned with the rest */
+        array->tail[index] = array->head[index];
+        array->idle[index] = 0;
+        array->enabled |= 1 << index;
+    } else {
+        array->enabled &= ~(1 << index);
+    }
+    
+    array->stalled &= ~(1 << index);
+}
+
+/*
+ * Per-axis median or mean of the samples selected by mask. With an even number of
+ * samples the median is the mean of the middle two.
+ */
+void lsm6d_array_fuse(const LSM6D_SENSOR_DATA *samples, uint8_t count, uint8_t mask, uint8_t method, LSM6D_SENSOR_DATA *out) {
+    int16_t *dest = (int16_t *)out;
+    int16_t values[LSM6D_ARRAY_MAX];
+    int16_t value;
+    int32_t sum;
+    uint8_t n;
+    uint8_t word;
+    uint8_t i;
+    uint8_t j;
+    
+    for (word = 0; word < LSM6D_ARRAY_WORDS; word++) {
+        n = 0;
+        sum = 0;
+        
+        /* Insertion sort - at most LSM6D_ARRAY_MAX values */
+        for (i = 0; i < count && i < LSM6D_ARRAY_MAX; i++) {
+            if (!(mask & (1 << i))) {
+                continue;
+            }
+            
+            value = ((const int16_t *)&samples[i])[word];
+            sum += value;
+            
+            for (j = n; j > 0 && values[j - 1] > value; j--) {
+                values[j] = values[j - 1];
+            }
+            values[j] = value;
+            n++;
+        }
+        
+        if (n == 0) {
+            dest[word] = 0;
+        } else if (method == LSM6D_FUSE_MEAN) {
+            dest[word] = (int16_t)((sum >= 0) ? (sum + n / 2) / n : -((-sum + n / 2) / n));
+        } else if (n & 1) {
+            dest[word] = values[n / 2];
+        } else {
+            sum = (int32_t)values[n / 2 - 1] + values[n / 2];
+            dest[word] = (int16_t)((sum >= 0) ? (sum + 1) / 2 : -((-sum + 1) / 2));
+        }
+    }
+}
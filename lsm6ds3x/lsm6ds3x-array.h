@@ -0,0 +1,100 @@
+/*
+ * Constant definitions and function prototypes for
+ * synchronized LSM6DS3x multi-device array acquisition
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_ARRAY_H
+#define LSM6DS3X_ARRAY_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Largest number of devices in one array */
+#ifndef LSM6D_ARRAY_MAX
+#define LSM6D_ARRAY_MAX           4
+#endif
+
+/* Samples staged per device between sweeps (must be a power of two, at most 128) */
+#ifndef LSM6D_ARRAY_DEPTH
+#define LSM6D_ARRAY_DEPTH         16
+#endif
+
+/* Samples a device may run ahead of the slowest one before its oldest are dropped */
+#ifndef LSM6D_ARRAY_SLIP
+#define LSM6D_ARRAY_SLIP          2
+#endif
+
+/* Consecutive sweeps without data, while other devices have data, before a device is reported stalled */
+#ifndef LSM6D_ARRAY_STALL
+#define LSM6D_ARRAY_STALL         4
+#endif
+
+/* Fusion methods */
+#define LSM6D_FUSE_MEDIAN         0     /* Per-axis median - rejects one faulty device out of three or more */
+#define LSM6D_FUSE_MEAN           1     /* Per-axis mean - lowest noise when all devices are healthy */
+
+typedef struct {
+    LSM6D_DEVICE *dev[LSM6D_ARRAY_MAX];
+    uint8_t count;
+    uint8_t enabled;            /* Devices taking part in alignment and fusion (bit per device) */
+    uint8_t stalled;            /* Devices that have stopped producing data (bit per device) */
+    uint8_t method;             /* LSM6D_FUSE_x */
+    uint16_t slips;             /* Samples dropped to realign a device that ran ahead */
+    
+    /* Per-device staging queues */
+    uint8_t head[LSM6D_ARRAY_MAX];
+    uint8_t tail[LSM6D_ARRAY_MAX];
+    uint8_t idle[LSM6D_ARRAY_MAX];
+    LSM6D_SENSOR_DATA stage[LSM6D_ARRAY_MAX][LSM6D_ARRAY_DEPTH];
+} LSM6D_ARRAY;
+
+/* Initialize every device and the array - device bindings must already be set */
+void lsm6d_array_init(LSM6D_ARRAY *array, LSM6D_DEVICE **devs, uint8_t count, uint8_t method);
+
+/* Configure every FIFO as lsm6d_dev_fifo_configure, then start them all in one sweep */
+void lsm6d_array_start(LSM6D_ARRAY *array, uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold);
+
+/* Drain each FIFO in turn - returns number of aligned sample sets ready */
+uint8_t lsm6d_array_poll(LSM6D_ARRAY *array);
+
+/*
+ * Take up to max aligned sets - fused receives one sample per set, raw (may be NULL) count
+ * samples per set, with the slots of disabled devices zeroed
+ */
+uint8_t lsm6d_array_read(LSM6D_ARRAY *array, LSM6D_SENSOR_DATA *fused, LSM6D_SENSOR_DATA *raw, uint8_t max);
+
+/* Include or exclude a device, e.g. one reported in array->stalled */
+void lsm6d_array_enable(LSM6D_ARRAY *array, uint8_t index, uint8_t enable);
+
+/* Combine samples of the devices in mask into out */
+void lsm6d_array_fuse(const LSM6D_SENSOR_DATA *samples, uint8_t count, uint8_t mask, uint8_t method, LSM6D_SENSOR_DATA *out);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_ARRAY_H */
@@ -0,0 +1,396 @@
+/*
+ * Gyro bias tracking and accelerometer calibration for LSM6DS3x
+ * Copyright (c) 2019 David Rice
+ * 
+ * Gyro bias is learned whenever a window of samples shows the device at rest, and
+ * kept per temperature bin so that it follows the drift with OUT_TEMP. Accelerometer
+ * offset and scale come from six-position calibration. Both are applied in the
+ * batch conversion path, so filters see calibrated data without per-sample work
+ * beyond a subtraction and a multiply.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-units.h"
+#include "lsm6ds3x-cal.h"
+#include "lsm6ds3x-crc.h"
+
+#define LSM6D_CAL_MAGIC           'C'
+
+static void lsm6d_cal_window_reset(LSM6D_CAL *cal) {
+    uint8_t i;
+    
+    cal->n = 0;
+    
+    for (i = 0; i < 3; i++) {
+        cal->g_sum[i] = 0;
+        cal->xl_sum[i] = 0;
+        cal->g_min[i] = INT16_MAX;
+        cal->g_max[i] = INT16_MIN;
+        cal->xl_min[i] = INT16_MAX;
+        cal->xl_max[i] = INT16_MIN;
+    }
+}
+
+static void lsm6d_cal_window_add(int16_t value, int32_t *sum, int16_t *min, int16_t *max) {
+    *sum += value;
+    
+    if (value < *min) {
+        *min = value;
+    }
+    if (value > *max) {
+        *max = value;
+    }
+}
+
+static uint8_t lsm6d_cal_bin(int16_t temp) {
+    int16_t bin;
+    
+    if (temp < LSM6D_CAL_TEMP_BASE) {
+        return 0;
+    }
+    
+    bin = (int16_t)(((int32_t)temp - LSM6D_CAL_TEMP_BASE) / LSM6D_CAL_TEMP_STEP);
+    
+    return (bin >= LSM6D_CAL_TEMP_BINS) ? LSM6D_CAL_TEMP_BINS - 1 : (uint8_t)bin;
+}
+
+static void lsm6d_cal_clear_rem(LSM6D_CAL *cal) {
+    uint8_t i;
+    uint8_t j;
+    
+    for (i = 0; i < LSM6D_CAL_TEMP_BINS; i++) {
+        for (j = 0; j < 4; j++) {
+            cal->rem[i][j] = 0;
+        }
+    }
+}
+
+void lsm6d_cal_dev_init(LSM6D_CAL *cal, LSM6D_DEVICE *dev, uint16_t g_still, uint16_t xl_still) {
+    uint8_t i;
+    uint8_t j;
+    
+    cal->dev = dev;
+    
+    for (i = 0; i < 3; i++) {
+        cal->data.xl_offset[i] = 0;
+        cal->data.xl_scale[i] = LSM6D_CAL_SCALE_ONE;
+        cal->bias[i] = 0;
+    }
+    
+    for (i = 0; i < LSM6D_CAL_TEMP_BINS; i++) {
+        for (j = 0; j < 3; j++) {
+            cal->data.g_bias[i][j] = 0;
+        }
+        cal->data.g_temp[i] = 0;
+        cal->data.g_count[i] = 0;
+    }
+    
+    lsm6d_cal_clear_rem(cal);
+    
+    cal->g_still = g_still;
+    cal->xl_still = xl_still;
+    cal->temp = 0;
+    cal->faces = 0;
+    cal->collecting = 0;
+    
+    lsm6d_cal_window_reset(cal);
+}
+
+/*
+ * Interpolate between the nearest learned bins either side of the temperature, at
+ * the temperatures they were learned at. Beyond the learned range the outermost
+ * bin is used as it is.
+ */
+void lsm6d_cal_set_temperature(LSM6D_CAL *cal, int16_t temp) {
+    const LSM6D_CAL_DATA *d = &cal->data;
+    int8_t bin = (int8_t)lsm6d_cal_bin(temp);
+    int8_t lo;
+    int8_t hi;
+    uint8_t i;
+    
+    cal->temp = temp;
+    
+    if (d->g_count[bin] && d->g_temp[bin] <= temp) {
+        lo = bin;
+        hi = bin + 1;
+    } else {
+        lo = bin - 1;
+        hi = bin;
+    }
+    
+    for (; hi < LSM6D_CAL_TEMP_BINS && d->g_count[hi] == 0; hi++);
+    for (; lo >= 0 && d->g_count[lo] == 0; lo--);
+    
+    for (i = 0; i < 3; i++) {
+        if (lo >= 0 && hi < LSM6D_CAL_TEMP_BINS && d->g_temp[hi] > d->g_temp[lo]) {
+            cal->bias[i] = (int16_t)(d->g_bias[lo][i] + ((int32_t)(d->g_bias[hi][i] - d->g_bias[lo][i])
+                    * (temp - d->g_temp[lo])) / (d->g_temp[hi] - d->g_temp[lo]));
+        } else if (lo >= 0) {
+            cal->bias[i] = d->g_bias[lo][i];
+        } else if (hi < LSM6D_CAL_TEMP_BINS) {
+            cal->bias[i] = d->g_bias[hi][i];
+        } else {
+            cal->bias[i] = 0;
+        }
+    }
+}
+
+/*
+ * Move value 1/div of the way to target. The remainder of the division is carried to
+ * the next call, so differences smaller than div are still learned over a few windows.
+ */
+static int16_t lsm6d_cal_approach(int16_t value, int16_t target, uint8_t div, int8_t *rem) {
+    int32_t d = (int32_t)target - value + *rem;
+    int16_t step = (int16_t)(d / div);
+    
+    *rem = (int8_t)(d - (int32_t)step * div);
+    
+    return value + step;
+}
+
+/* Fold a still window into the bias table and, while collecting, the face it rests on */
+static void lsm6d_cal_still(LSM6D_CAL *cal) {
+    int32_t g_mult = lsm6d_units_dev_g_mult(cal->dev);
+    int32_t xl_mult = lsm6d_units_dev_xl_mult(cal->dev);
+    uint8_t bin = lsm6d_cal_bin(cal->temp);
+    uint8_t count = cal->data.g_count[bin];
+    uint8_t div;
+    uint8_t axis = 0;
+    int16_t mean;
+    int16_t xl[3];
+    uint8_t i;
+    
+    if (count < (1U << LSM6D_CAL_BIAS_SHIFT)) {
+        div = count + 1;
+    } else {
+        div = 1U << LSM6D_CAL_BIAS_SHIFT;
+    }
+    
+    if (count < UINT8_MAX) {
+        cal->data.g_count[bin] = count + 1;
+    }
+    
+    for (i = 0; i < 3; i++) {
+        mean = (int16_t)(((int64_t)cal->g_sum[i] * g_mult) / ((int32_t)LSM6D_CAL_WINDOW << LSM6D_UNITS_G_SHIFT));
+        cal->data.g_bias[bin][i] = lsm6d_cal_approach(cal->data.g_bias[bin][i], mean, div, &cal->rem[bin][i]);
+    }
+    
+    cal->data.g_temp[bin] = lsm6d_cal_approach(cal->data.g_temp[bin], cal->temp, div, &cal->rem[bin][3]);
+    
+    lsm6d_cal_set_temperature(cal, cal->temp);
+    
+    if (!cal->collecting) {
+        return;
+    }
+    
+    for (i = 0; i < 3; i++) {
+        xl[i] = (int16_t)(((int64_t)cal->xl_sum[i] * xl_mult) / ((int32_t)LSM6D_CAL_WINDOW << LSM6D_UNITS_XL_SHIFT));
+        if ((xl[i] < 0 ? -xl[i] : xl[i]) > (xl[axis] < 0 ? -xl[axis] : xl[axis])) {
+            axis = i;
+        }
+    }
+    
+    if (xl[axis] >= LSM6D_CAL_FACE_MG || xl[axis] <= -LSM6D_CAL_FACE_MG) {
+        i = (axis << 1) | (xl[axis] < 0);
+        cal->face_sum[i] += xl[axis];
+        cal->face_n[i]++;
+        cal->faces |= 1U << i;
+    }
+}
+
+void lsm6d_cal_update(LSM6D_CAL *cal, const LSM6D_SENSOR_DATA *samples, uint16_t count) {
+    uint16_t i;
+    uint8_t j;
+    uint8_t still;
+    
+    for (i = 0; i < count; i++) {
+        lsm6d_cal_window_add(samples[i].g.x, &cal->g_sum[0], &cal->g_min[0], &cal->g_max[0]);
+        lsm6d_cal_window_add(samples[i].g.y, &cal->g_sum[1], &cal->g_min[1], &cal->g_max[1]);
+        lsm6d_cal_window_add(samples[i].g.z, &cal->g_sum[2], &cal->g_min[2], &cal->g_max[2]);
+        lsm6d_cal_window_add(samples[i].xl.x, &cal->xl_sum[0], &cal->xl_min[0], &cal->xl_max[0]);
+        lsm6d_cal_window_add(samples[i].xl.y, &cal->xl_sum[1], &cal->xl_min[1], &cal->xl_max[1]);
+        lsm6d_cal_window_add(samples[i].xl.z, &cal->xl_sum[2], &cal->xl_min[2], &cal->xl_max[2]);
+        
+        if (++cal->n < LSM6D_CAL_WINDOW) {
+            continue;
+        }
+        
+        still = 1;
+        
+        for (j = 0; j < 3; j++) {
+            if ((int32_t)cal->g_max[j] - cal->g_min[j] > cal->g_still || (int32_t)cal->xl_max[j] - cal->xl_min[j] > cal->xl_still) {
+                still = 0;
+            }
+        }
+        
+        if (still) {
+            lsm6d_cal_still(cal);
+        }
+        
+        lsm6d_cal_window_reset(cal);
+    }
+}
+
+void lsm6d_cal_accel_begin(LSM6D_CAL *cal) {
+    uint8_t i;
+    
+    for (i = 0; i < LSM6D_CAL_FACES; i++) {
+        cal->face_sum[i] = 0;
+        cal->face_n[i] = 0;
+    }
+    
+    cal->faces = 0;
+    cal->collecting = 1;
+}
+
+/* Offset is the midpoint of the +1 g and -1 g readings on each axis, scale maps their span to 2 g */
+uint8_t lsm6d_cal_accel_solve(LSM6D_CAL *cal) {
+    int32_t up;
+    int32_t down;
+    uint8_t i;
+    
+    if (cal->faces != LSM6D_CAL_FACES_ALL) {
+        return 0;
+    }
+    
+    for (i = 0; i < 3; i++) {
+        up = cal->face_sum[i << 1] / cal->face_n[i << 1];
+        down = cal->face_sum[(i << 1) | 1] / cal->face_n[(i << 1) | 1];
+        
+        cal->data.xl_offset[i] = (int16_t)((up + down) / 2);
+        cal->data.xl_scale[i] = (uint16_t)(((2L * LSM6D_CAL_ONE_G_MG) << 14) / (up - down));
+    }
+    
+    cal->collecting = 0;
+    
+    return 1;
+}
+
+static int16_t lsm6d_cal_xl(int16_t raw, int32_t mult, int32_t offset, int32_t scale) {
+    int32_t mg = (raw * mult + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT;
+    
+    mg = ((mg - offset) * scale + (1L << 13)) >> 14;
+    
+    return (int16_t)((mg > INT16_MAX) ? INT16_MAX : (mg < INT16_MIN) ? INT16_MIN : mg);
+}
+
+/* Bias is taken for the temperature last given to lsm6d_cal_set_temperature, once per batch */
+void lsm6d_cal_convert(const LSM6D_CAL *cal, const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count) {
+    int32_t xl = lsm6d_units_dev_xl_mult(cal->dev);
+    int32_t g = lsm6d_units_dev_g_mult(cal->dev);
+    const LSM6D_CAL_DATA *d = &cal->data;
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        out[i].temp = lsm6d_units_temp(in[i].temp);
+        
+        out[i].xl[0] = lsm6d_cal_xl(in[i].xl.x, xl, d->xl_offset[0], d->xl_scale[0]);
+        out[i].xl[1] = lsm6d_cal_xl(in[i].xl.y, xl, d->xl_offset[1], d->xl_scale[1]);
+        out[i].xl[2] = lsm6d_cal_xl(in[i].xl.z, xl, d->xl_offset[2], d->xl_scale[2]);
+        
+        out[i].g[0] = ((in[i].g.x * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT) - cal->bias[0];
+        out[i].g[1] = ((in[i].g.y * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT) - cal->bias[1];
+        out[i].g[2] = ((in[i].g.z * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT) - cal->bias[2];
+    }
+}
+
+static uint8_t *lsm6d_cal_put_word(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    
+    return p + 2;
+}
+
+static uint16_t lsm6d_cal_get_word(const uint8_t *p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+/*
+ * Record layout, little-endian: 'C', number of temperature bins, accelerometer
+ * offsets and scales, bias x/y/z, temperature and window count for each bin, CRC-16
+ */
+void lsm6d_cal_pack(const LSM6D_CAL *cal, uint8_t *buffer) {
+    uint8_t *p = buffer;
+    uint8_t i;
+    uint8_t j;
+    
+    *p++ = LSM6D_CAL_MAGIC;
+    *p++ = LSM6D_CAL_TEMP_BINS;
+    
+    for (i = 0; i < 3; i++) {
+        p = lsm6d_cal_put_word(p, (uint16_t)cal->data.xl_offset[i]);
+    }
+    for (i = 0; i < 3; i++) {
+        p = lsm6d_cal_put_word(p, cal->data.xl_scale[i]);
+    }
+    
+    for (i = 0; i < LSM6D_CAL_TEMP_BINS; i++) {
+        for (j = 0; j < 3; j++) {
+            p = lsm6d_cal_put_word(p, (uint16_t)cal->data.g_bias[i][j]);
+        }
+        p = lsm6d_cal_put_word(p, (uint16_t)cal->data.g_temp[i]);
+        *p++ = cal->data.g_count[i];
+    }
+    
+    lsm6d_cal_put_word(p, lsm6d_crc16(buffer, LSM6D_CAL_STORE_LEN - 2));
+}
+
+uint8_t lsm6d_cal_unpack(LSM6D_CAL *cal, const uint8_t *buffer) {
+    const uint8_t *p = buffer + 2;
+    uint8_t i;
+    uint8_t j;
+    
+    if (buffer[0] != LSM6D_CAL_MAGIC || buffer[1] != LSM6D_CAL_TEMP_BINS
+            || lsm6d_crc16(buffer, LSM6D_CAL_STORE_LEN - 2) != lsm6d_cal_get_word(&buffer[LSM6D_CAL_STORE_LEN - 2])) {
+        return 0;
+    }
+    
+    for (i = 0; i < 3; i++, p += 2) {
+        cal->data.xl_offset[i] = (int16_t)lsm6d_cal_get_word(p);
+    }
+    for (i = 0; i < 3; i++, p += 2) {
+        cal->data.xl_scale[i] = lsm6d_cal_get_word(p);
+    }
+    
+    for (i = 0; i < LSM6D_CAL_TEMP_BINS; i++) {
+        for (j = 0; j < 3; j++, p += 2) {
+            cal->data.g_bias[i][j] = (int16_t)lsm6d_cal_get_word(p);
+        }
+        cal->data.g_temp[i] = (int16_t)lsm6d_cal_get_word(p);
+        p += 2;
+        cal->data.g_count[i] = *p++;
+    }
+    
+    lsm6d_cal_clear_rem(cal);
+    lsm6d_cal_set_temperature(cal, cal->temp);
+    
+    return 1;
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+void lsm6d_cal_init(LSM6D_CAL *cal, uint16_t g_still, uint16_t xl_still) {
+    lsm6d_cal_dev_init(cal, &lsm6d_default_device, g_still, xl_still);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
@@ -0,0 +1,146 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x gyro bias tracking and accelerometer calibration
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_CAL_H
+#define LSM6DS3X_CAL_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-units.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Gyro bias table - bin i covers raw temperatures BASE + i * STEP up to the next bin (16 LSB/degC, 0 = 25 degC) */
+#ifndef LSM6D_CAL_TEMP_BINS
+#define LSM6D_CAL_TEMP_BINS       8
+#endif
+
+#ifndef LSM6D_CAL_TEMP_BASE
+#define LSM6D_CAL_TEMP_BASE       (-400)        /* 0 degC */
+#endif
+
+#ifndef LSM6D_CAL_TEMP_STEP
+#define LSM6D_CAL_TEMP_STEP       160           /* 10 degC */
+#endif
+
+/* Samples per stillness window (power of two, at most 128) */
+#ifndef LSM6D_CAL_WINDOW
+#define LSM6D_CAL_WINDOW          64
+#endif
+
+/* Bias estimates average the first 2^n still windows in a bin, then track with weight 2^-n */
+#ifndef LSM6D_CAL_BIAS_SHIFT
+#define LSM6D_CAL_BIAS_SHIFT      4
+#endif
+
+/* Smallest reading on the vertical axis that identifies a six-position face */
+#define LSM6D_CAL_FACE_MG         800
+#define LSM6D_CAL_ONE_G_MG        1000
+
+/* Accelerometer faces, in order: +X, -X, +Y, -Y, +Z, -Z up */
+#define LSM6D_CAL_FACES           6
+#define LSM6D_CAL_FACES_ALL       0x3F
+
+#define LSM6D_CAL_SCALE_ONE       16384         /* Q14 */
+
+/* Stored size in bytes, see lsm6d_cal_pack */
+#define LSM6D_CAL_STORE_LEN       (2 + 12 + LSM6D_CAL_TEMP_BINS * 9 + 2)
+
+/* Calibration to keep in non-volatile storage - independent of the full-scale settings */
+typedef struct {
+    int16_t xl_offset[3];                       /* mg */
+    uint16_t xl_scale[3];                       /* Q14 */
+    int16_t g_bias[LSM6D_CAL_TEMP_BINS][3];     /* mdps */
+    int16_t g_temp[LSM6D_CAL_TEMP_BINS];        /* Mean raw temperature the bias was learned at */
+    uint8_t g_count[LSM6D_CAL_TEMP_BINS];       /* Still windows averaged into the bin, 0 if empty */
+} LSM6D_CAL_DATA;
+
+typedef struct {
+    LSM6D_CAL_DATA data;
+    
+    /* Device whose full-scale settings the samples were taken with */
+    LSM6D_DEVICE *dev;
+    
+    /* Configuration - largest spread within a window that still counts as still, raw LSB */
+    uint16_t g_still;
+    uint16_t xl_still;
+    
+    /* Bias at the current temperature, applied by lsm6d_cal_convert */
+    int16_t temp;
+    int16_t bias[3];
+    
+    /* Division remainders carried into the next update of each bin's bias x/y/z and temperature */
+    int8_t rem[LSM6D_CAL_TEMP_BINS][4];
+    
+    /* Stillness window */
+    uint8_t n;
+    int32_t g_sum[3];
+    int32_t xl_sum[3];
+    int16_t g_min[3];
+    int16_t g_max[3];
+    int16_t xl_min[3];
+    int16_t xl_max[3];
+    
+    /* Six-position collection */
+    uint8_t faces;                              /* Faces seen, bit per face */
+    uint8_t collecting;
+    int32_t face_sum[LSM6D_CAL_FACES];          /* Vertical axis, mg */
+    uint16_t face_n[LSM6D_CAL_FACES];
+} LSM6D_CAL;
+
+/* Start with no gyro bias and unit accelerometer calibration, for samples from dev */
+void lsm6d_cal_dev_init(LSM6D_CAL *cal, LSM6D_DEVICE *dev, uint16_t g_still, uint16_t xl_still);
+
+/* As lsm6d_cal_dev_init, for samples from lsm6d_default_device */
+void lsm6d_cal_init(LSM6D_CAL *cal, uint16_t g_still, uint16_t xl_still);
+
+/* Select the bias for a raw OUT_TEMP reading, e.g. from lsm6d_get_temperature */
+void lsm6d_cal_set_temperature(LSM6D_CAL *cal, int16_t temp);
+
+/* Feed raw samples - every still window refines the bias at the current temperature */
+void lsm6d_cal_update(LSM6D_CAL *cal, const LSM6D_SENSOR_DATA *samples, uint16_t count);
+
+/*
+ * Six-position accelerometer calibration: after lsm6d_cal_accel_begin, rest the device
+ * on each face in turn while feeding samples to lsm6d_cal_update. Still windows are
+ * sorted by face. lsm6d_cal_accel_solve returns 0 until every face has been seen.
+ */
+void lsm6d_cal_accel_begin(LSM6D_CAL *cal);
+uint8_t lsm6d_cal_accel_solve(LSM6D_CAL *cal);
+
+/* As lsm6d_units_convert, with accelerometer calibration and gyro bias applied */
+void lsm6d_cal_convert(const LSM6D_CAL *cal, const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count);
+
+/* Serialize to LSM6D_CAL_STORE_LEN bytes, and back - unpack returns 0 if the record is invalid */
+void lsm6d_cal_pack(const LSM6D_CAL *cal, uint8_t *buffer);
+uint8_t lsm6d_cal_unpack(LSM6D_CAL *cal, const uint8_t *buffer);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_CAL_H */
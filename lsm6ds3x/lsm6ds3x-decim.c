@@ -0,0 +1,356 @@
+/*
+ * Multirate decimation pipeline for ST Microelectronics LSM6DS3x data
+ * Copyright (c) 2019 David Rice
+ * 
+ * The planner trades SPI traffic against host filtering. Each sensor runs at the
+ * lowest ODR whose on-chip filtering, alone or followed by host stages, still
+ * passes the requested bandwidth without aliasing. FIFO decimation only matches
+ * the slower sensor to the FIFO rate - its ODR is lowered too, so no samples are
+ * dropped. Host stages (CIC, then a polyphase halfband FIR) are used where the
+ * chip cannot go low enough or its passband is too narrow for the output rate.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-units.h"
+#include "lsm6ds3x-decim.h"
+
+#ifndef LSM6D_DECIM_CHIP_PASS
+#define LSM6D_DECIM_CHIP_PASS     25
+#endif
+
+#ifndef LSM6D_DECIM_SPI_COST
+#define LSM6D_DECIM_SPI_COST      64
+#endif
+
+#ifndef LSM6D_DECIM_ADD_COST
+#define LSM6D_DECIM_ADD_COST      4
+#endif
+
+#ifndef LSM6D_DECIM_MAC_COST
+#define LSM6D_DECIM_MAC_COST      16
+#endif
+
+/* Lowest rate index - output rates down to 12.5 Hz / 2^(CIC + FIR) */
+#define LSM6D_DECIM_MIN_INDEX     (-LSM6D_DECIM_CIC_MAX_LOG2)
+
+#define LSM6D_DECIM_XL_MAX_ODR    _CTRL1_XL_ODR_XL_6_66KHZ
+#define LSM6D_DECIM_G_MAX_ODR     _CTRL2_G_ODR_G_1_66KHZ
+
+/* _FIFO_CTRL3_x settings for decimation by 2^n */
+static const uint8_t lsm6d_decim_fifo_dec[LSM6D_DECIM_FIFO_MAX_LOG2 + 1] = {
+    _FIFO_CTRL3_DECIMATION_NONE,
+    _FIFO_CTRL3_DECIMATION_2,
+    _FIFO_CTRL3_DECIMATION_4,
+    _FIFO_CTRL3_DECIMATION_8,
+    _FIFO_CTRL3_DECIMATION_16,
+    _FIFO_CTRL3_DECIMATION_32
+};
+
+/* Halfband coefficients (Q15) for taps 1, 3 .. 11 either side of the centre; the centre is 0.5 */
+static const int16_t lsm6d_decim_fir[6] = {10237, -2936, 1285, -547, 188, -35};
+
+/* Rate for ODR setting index, continuing below setting 1 by halving */
+static uint32_t lsm6d_decim_rate(int8_t index) {
+    if (index >= 1) {
+        return lsm6d_units_odr_dhz((uint8_t)index);
+    }
+    
+    return lsm6d_units_odr_dhz(1) >> (1 - index);
+}
+
+/* Plan one sensor with ODR setting between min_odr and max_odr - returns 0 if impossible */
+static uint8_t lsm6d_decim_plan_sensor(LSM6D_DECIM_SENSOR *s, uint32_t rate, uint32_t bw, int8_t min_odr, int8_t max_odr) {
+    int8_t out;
+    int8_t odr;
+    uint8_t shift;
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t cost;
+    
+    s->odr = 0;
+    s->fifo_dec = _FIFO_CTRL3_NOT_IN_FIFO;
+    s->cic_log2 = 0;
+    s->fir = 0;
+    s->out_rate = 0;
+    s->cost = 0;
+    
+    if (rate == 0) {
+        return 1;
+    }
+    
+    for (out = LSM6D_DECIM_MIN_INDEX; out <= max_odr && lsm6d_decim_rate(out) < rate; out++);
+    
+    if (out > max_odr) {
+        return 0;
+    }
+    
+    out_rate = lsm6d_decim_rate(out);
+    
+    for (odr = (out > min_odr) ? out : min_odr; odr <= max_odr; odr++) {
+        shift = odr - out;
+        in_rate = lsm6d_decim_rate(odr);
+        
+        if (shift == 0) {
+            /* Chip only */
+            if (bw * 100 > out_rate * LSM6D_DECIM_CHIP_PASS) {
+                continue;
+            }
+            cost = LSM6D_DECIM_SPI_COST * 3 * in_rate;
+        } else {
+            /* Chip, then CIC for all but the last halving and the halfband for that */
+            if (bw * 100 > out_rate * LSM6D_DECIM_FIR_PASS || shift - 1 > LSM6D_DECIM_CIC_MAX_LOG2) {
+                continue;
+            }
+            cost = LSM6D_DECIM_SPI_COST * 3 * in_rate;
+            if (shift > 1) {
+                cost += LSM6D_DECIM_ADD_COST * 3 * LSM6D_DECIM_CIC_ORDER * (in_rate + (in_rate >> (shift - 1)));
+            }
+            cost += LSM6D_DECIM_MAC_COST * 3 * (sizeof(lsm6d_decim_fir) / sizeof(lsm6d_decim_fir[0]) + 1) * out_rate;
+        }
+        
+        cost /= 10;
+        
+        if (s->odr == 0 || cost < s->cost) {
+            s->odr = odr;
+            s->cic_log2 = shift ? shift - 1 : 0;
+            s->fir = shift ? 1 : 0;
+            s->out_rate = out_rate;
+            s->cost = cost;
+        }
+    }
+    
+    return s->odr != 0;
+}
+
+uint8_t lsm6d_decim_plan(LSM6D_DECIM_PLAN *plan, uint32_t xl_rate, uint32_t xl_bw, uint32_t g_rate, uint32_t g_bw) {
+    if (!lsm6d_decim_plan_sensor(&plan->xl, xl_rate, xl_bw, 1, LSM6D_DECIM_XL_MAX_ODR) ||
+            !lsm6d_decim_plan_sensor(&plan->g, g_rate, g_bw, 1, LSM6D_DECIM_G_MAX_ODR)) {
+        return 0;
+    }
+    
+    /* FIFO decimation is limited, so the slower sensor may have to run faster and filter more on the host */
+    if (plan->xl.odr && plan->g.odr) {
+        if (plan->xl.odr > plan->g.odr + LSM6D_DECIM_FIFO_MAX_LOG2) {
+            if (!lsm6d_decim_plan_sensor(&plan->g, g_rate, g_bw, plan->xl.odr - LSM6D_DECIM_FIFO_MAX_LOG2, LSM6D_DECIM_G_MAX_ODR)) {
+                return 0;
+            }
+        } else if (plan->g.odr > plan->xl.odr + LSM6D_DECIM_FIFO_MAX_LOG2) {
+            if (!lsm6d_decim_plan_sensor(&plan->xl, xl_rate, xl_bw, plan->g.odr - LSM6D_DECIM_FIFO_MAX_LOG2, LSM6D_DECIM_XL_MAX_ODR)) {
+                return 0;
+            }
+        }
+    }
+    
+    /* ODR settings are common to the sensors and the FIFO */
+    plan->fifo_odr = (plan->xl.odr > plan->g.odr) ? plan->xl.odr : plan->g.odr;
+    
+    if (plan->fifo_odr == 0) {
+        return 0;
+    }
+    
+    if (plan->xl.odr) {
+        plan->xl.fifo_dec = lsm6d_decim_fifo_dec[plan->fifo_odr - plan->xl.odr];
+    }
+    
+    if (plan->g.odr) {
+        plan->g.fifo_dec = lsm6d_decim_fifo_dec[plan->fifo_odr - plan->g.odr];
+    }
+    
+    return 1;
+}
+
+void lsm6d_decim_dev_apply(LSM6D_DECIM *decim, LSM6D_DEVICE *dev, const LSM6D_DECIM_PLAN *plan, uint8_t mode, uint16_t threshold) {
+    decim->dev = dev;
+    decim->plan = *plan;
+    decim->dec_xl = 0;
+    decim->dec_g = 0;
+    
+    if (plan->xl.odr) {
+        lsm6d_dev_set_accel_data_rate(dev, plan->xl.odr);
+        decim->dec_xl = 1 << (plan->fifo_odr - plan->xl.odr);
+    }
+    
+    if (plan->g.odr) {
+        lsm6d_dev_set_gyro_data_rate(dev, plan->g.odr);
+        decim->dec_g = 1 << (plan->fifo_odr - plan->g.odr);
+    }
+    
+    lsm6d_decim_filter_init(&decim->xl, plan->xl.cic_log2, plan->xl.fir);
+    lsm6d_decim_filter_init(&decim->g, plan->g.cic_log2, plan->g.fir);
+    
+    lsm6d_dev_fifo_configure(dev, plan->fifo_odr, mode, plan->xl.fifo_dec, plan->g.fifo_dec, threshold);
+}
+
+void lsm6d_decim_filter_init(LSM6D_DECIM_FILTER *filter, uint8_t cic_log2, uint8_t fir) {
+    uint8_t axis;
+    uint8_t i;
+    
+    filter->cic_log2 = cic_log2;
+    filter->cic_count = 0;
+    filter->fir = fir;
+    filter->fir_pos = 0;
+    filter->fir_phase = 0;
+    
+    for (axis = 0; axis < 3; axis++) {
+        for (i = 0; i < LSM6D_DECIM_CIC_ORDER; i++) {
+            filter->integ[axis][i] = 0;
+            filter->comb[axis][i] = 0;
+        }
+        for (i = 0; i < LSM6D_DECIM_FIR_TAPS; i++) {
+            filter->hist[axis][i] = 0;
+        }
+    }
+}
+
+uint8_t lsm6d_decim_filter_push(LSM6D_DECIM_FILTER *filter, const int16_t *in, int16_t *out) {
+    int16_t v[3];
+    uint32_t y;
+    uint32_t t;
+    int32_t acc;
+    uint8_t axis;
+    uint8_t i;
+    uint8_t a;
+    uint8_t b;
+    
+    if (filter->cic_log2) {
+        /* Integrators wrap modulo 2^32, which the combs undo */
+        for (axis = 0; axis < 3; axis++) {
+            filter->integ[axis][0] += (uint32_t)(int32_t)in[axis];
+            for (i = 1; i < LSM6D_DECIM_CIC_ORDER; i++) {
+                filter->integ[axis][i] += filter->integ[axis][i - 1];
+            }
+        }
+        
+        if (++filter->cic_count < (1 << filter->cic_log2)) {
+            return 0;
+        }
+        
+        filter->cic_count = 0;
+        
+        for (axis = 0; axis < 3; axis++) {
+            y = filter->integ[axis][LSM6D_DECIM_CIC_ORDER - 1];
+            for (i = 0; i < LSM6D_DECIM_CIC_ORDER; i++) {
+                t = y;
+                y -= filter->comb[axis][i];
+                filter->comb[axis][i] = t;
+            }
+            v[axis] = (int16_t)((int32_t)y >> (LSM6D_DECIM_CIC_ORDER * filter->cic_log2));
+        }
+    } else {
+        v[0] = in[0];
+        v[1] = in[1];
+        v[2] = in[2];
+    }
+    
+    if (!filter->fir) {
+        out[0] = v[0];
+        out[1] = v[1];
+        out[2] = v[2];
+        return 1;
+    }
+    
+    for (axis = 0; axis < 3; axis++) {
+        filter->hist[axis][filter->fir_pos] = v[axis];
+    }
+    
+    if (++filter->fir_pos == LSM6D_DECIM_FIR_TAPS) {
+        filter->fir_pos = 0;
+    }
+    
+    /* Polyphase - the output is only computed for every second input */
+    filter->fir_phase ^= 1;
+    if (filter->fir_phase) {
+        return 0;
+    }
+    
+    for (axis = 0; axis < 3; axis++) {
+        /* Centre tap is LSM6D_DECIM_FIR_TAPS / 2 samples back from the newest */
+        a = filter->fir_pos + LSM6D_DECIM_FIR_TAPS / 2;
+        if (a >= LSM6D_DECIM_FIR_TAPS) {
+            a -= LSM6D_DECIM_FIR_TAPS;
+        }
+        
+        acc = (int32_t)filter->hist[axis][a] << 14;
+        b = a;
+        
+        for (i = 0; i < sizeof(lsm6d_decim_fir) / sizeof(lsm6d_decim_fir[0]); i++) {
+            /* Step one tap outwards, then skip the zero tap */
+            a = (a == 0) ? LSM6D_DECIM_FIR_TAPS - 1 : a - 1;
+            b = (b == LSM6D_DECIM_FIR_TAPS - 1) ? 0 : b + 1;
+            
+            acc += (int32_t)lsm6d_decim_fir[i] * ((int32_t)filter->hist[axis][a] + filter->hist[axis][b]);
+            
+            a = (a == 0) ? LSM6D_DECIM_FIR_TAPS - 1 : a - 1;
+            b = (b == LSM6D_DECIM_FIR_TAPS - 1) ? 0 : b + 1;
+        }
+        
+        acc = (acc + (1L << 14)) >> 15;
+        
+        if (acc > INT16_MAX) {
+            acc = INT16_MAX;
+        } else if (acc < INT16_MIN) {
+            acc = INT16_MIN;
+        }
+        
+        out[axis] = (int16_t)acc;
+    }
+    
+    return 1;
+}
+
+void lsm6d_decim_run(LSM6D_DECIM *decim, const LSM6D_SENSOR_DATA *in, uint16_t count,
+        LSM6D_XL_DATA *xl, uint16_t *xl_count, LSM6D_G_DATA *g, uint16_t *g_count) {
+    LSM6D_FIFO_STATE *fifo = lsm6d_dev_fifo_get_state(decim->dev);
+    uint8_t n = fifo->first;
+    uint16_t i;
+    
+    *xl_count = 0;
+    *g_count = 0;
+    
+    /*
+     * The faster sensor is in every FIFO sample, so the pattern position of each
+     * sample follows from that of the first. The slower one is only new every
+     * dec samples - the rest repeat its last value.
+     */
+    for (i = 0; i < count; i++) {
+        if (decim->dec_xl && (n % decim->dec_xl) == 0) {
+            *xl_count += lsm6d_decim_filter_push(&decim->xl, &in[i].xl.x, &xl[*xl_count].x);
+        }
+        
+        if (decim->dec_g && (n % decim->dec_g) == 0) {
+            *g_count += lsm6d_decim_filter_push(&decim->g, &in[i].g.x, &g[*g_count].x);
+        }
+        
+        if (++n == fifo->period) {
+            n = 0;
+        }
+    }
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+void lsm6d_decim_apply(LSM6D_DECIM *decim, const LSM6D_DECIM_PLAN *plan, uint8_t mode, uint16_t threshold) {
+    lsm6d_decim_dev_apply(decim, &lsm6d_default_device, plan, mode, threshold);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
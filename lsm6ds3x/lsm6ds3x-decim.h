@@ -0,0 +1,126 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x multirate decimation pipeline
+ * Copyright (c) 2019 David Rice
+ * 
+ * Optional definitions (in lsm6ds3x-cfg.h):
+ * LSM6D_DECIM_CHIP_PASS - Passband of the on-chip filters in percent of ODR (default 25)
+ * LSM6D_DECIM_SPI_COST - Estimated cycles to read one FIFO word (default 64)
+ * LSM6D_DECIM_ADD_COST - Estimated cycles for one 32-bit add (default 4)
+ * LSM6D_DECIM_MAC_COST - Estimated cycles for one 16x16 multiply-accumulate (default 16)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_DECIM_H
+#define LSM6DS3X_DECIM_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host stages
+ * 
+ * A CIC decimator of order LSM6D_DECIM_CIC_ORDER reduces the rate by up to
+ * 2^LSM6D_DECIM_CIC_MAX_LOG2, followed by a halfband FIR decimating by 2 that
+ * passes LSM6D_DECIM_FIR_PASS percent of the output rate with about 54 dB
+ * rejection of anything that would alias into it.
+ */
+#define LSM6D_DECIM_CIC_ORDER     3
+#define LSM6D_DECIM_CIC_MAX_LOG2  5     /* Keeps CIC growth within 15 bits */
+#define LSM6D_DECIM_FIR_TAPS      23
+#define LSM6D_DECIM_FIR_PASS      35
+
+/* Largest FIFO decimation between the two sensors (_FIFO_CTRL3_DECIMATION_32) */
+#define LSM6D_DECIM_FIFO_MAX_LOG2 5
+
+/* Decimation plan for one sensor */
+typedef struct {
+    uint8_t odr;                /* _CTRL1_XL_ODR_x / _CTRL2_G_ODR_x setting, 0 if not used */
+    uint8_t fifo_dec;           /* _FIFO_CTRL3_x setting */
+    uint8_t cic_log2;           /* Host CIC decimation (log2), 0 if no CIC stage */
+    uint8_t fir;                /* Host halfband stage used */
+    uint32_t out_rate;          /* Output rate achieved (0.1 Hz) */
+    uint32_t cost;              /* Estimated cycles per second for reading and filtering */
+} LSM6D_DECIM_SENSOR;
+
+typedef struct {
+    uint8_t fifo_odr;           /* _FIFO_CTRL5_ODR_FIFO_x setting */
+    LSM6D_DECIM_SENSOR xl;
+    LSM6D_DECIM_SENSOR g;
+} LSM6D_DECIM_PLAN;
+
+/* Host filter state for one sensor */
+typedef struct {
+    uint8_t cic_log2;
+    uint8_t cic_count;
+    uint8_t fir;
+    uint8_t fir_pos;
+    uint8_t fir_phase;
+    uint32_t integ[3][LSM6D_DECIM_CIC_ORDER];
+    uint32_t comb[3][LSM6D_DECIM_CIC_ORDER];
+    int16_t hist[3][LSM6D_DECIM_FIR_TAPS];
+} LSM6D_DECIM_FILTER;
+
+typedef struct {
+    LSM6D_DEVICE *dev;          /* Device whose FIFO feeds lsm6d_decim_run */
+    LSM6D_DECIM_PLAN plan;
+    uint8_t dec_xl;             /* FIFO decimation factors, to tell which samples are new */
+    uint8_t dec_g;
+    LSM6D_DECIM_FILTER xl;
+    LSM6D_DECIM_FILTER g;
+} LSM6D_DECIM;
+
+/*
+ * Choose the cheapest split between chip and host for each sensor. Rates and
+ * bandwidths are in 0.1 Hz; the output rate is rounded up to the next rate the
+ * chip can produce (12.5 Hz * 2^n). A zero rate leaves the sensor out of the FIFO.
+ * Returns 0 if a bandwidth cannot be met at the requested rate.
+ */
+uint8_t lsm6d_decim_plan(LSM6D_DECIM_PLAN *plan, uint32_t xl_rate, uint32_t xl_bw, uint32_t g_rate, uint32_t g_bw);
+
+/* Set sensor ODRs of dev, start its FIFO and reset the host filters */
+void lsm6d_decim_dev_apply(LSM6D_DECIM *decim, LSM6D_DEVICE *dev, const LSM6D_DECIM_PLAN *plan, uint8_t mode, uint16_t threshold);
+
+/* As lsm6d_decim_dev_apply, on lsm6d_default_device */
+void lsm6d_decim_apply(LSM6D_DECIM *decim, const LSM6D_DECIM_PLAN *plan, uint8_t mode, uint16_t threshold);
+
+void lsm6d_decim_filter_init(LSM6D_DECIM_FILTER *filter, uint8_t cic_log2, uint8_t fir);
+
+/* Push one x/y/z sample - returns 1 if an output sample was written */
+uint8_t lsm6d_decim_filter_push(LSM6D_DECIM_FILTER *filter, const int16_t *in, int16_t *out);
+
+/*
+ * Filter samples returned by lsm6d_dev_fifo_read on the device given to
+ * lsm6d_decim_dev_apply. Outputs of each sensor are written to xl and g
+ * (at most count of each) and their numbers to xl_count and g_count.
+ */
+void lsm6d_decim_run(LSM6D_DECIM *decim, const LSM6D_SENSOR_DATA *in, uint16_t count,
+        LSM6D_XL_DATA *xl, uint16_t *xl_count, LSM6D_G_DATA *g, uint16_t *g_count);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_DECIM_H */
@@ -0,0 +1,557 @@
+/*
+ * Host-side SPI emulator for ST Microelectronics LSM6DS3x
+ * Copyright (c) 2019 David Rice
+ * 
+ * Emulates what the driver relies on at register level: auto-increment with the
+ * FIFO_DATA_OUT rollover, block data update, STATUS_REG data-ready flags, the FIFO
+ * (decimation, timestamp data set, pattern position, threshold, full and overrun
+ * flags, FIFO and continuous modes) and the timestamp counter. Motion comes from a
+ * callback or a recorded trace and is sampled at the configured ODRs as emulated
+ * time advances, so runs are deterministic.
+ * 
+ * Not emulated: embedded functions and their source registers, the embedded
+ * function register bank, filters, self-test and the step counter (always 0).
+ * Trigger modes CONT_THEN_FIFO and BYPASS_THEN_CONT behave as continuous mode.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-emu.h"
+
+#define LSM6D_EMU_WHO_AM_I        0x69
+
+/* Sample clock phase wraps at 1 s in 0.1 Hz units */
+#define LSM6D_EMU_PHASE           10000000UL
+
+/* Largest level DIFF_FIFO can report */
+#define LSM6D_EMU_LEVEL_MAX       0x0FFF
+
+/* Output register pairs */
+#define LSM6D_EMU_TEMP            0
+#define LSM6D_EMU_G               1
+#define LSM6D_EMU_XL              4
+
+/* ODR setting to rate in 0.1 Hz */
+static const uint32_t lsm6d_emu_rates[16] = {0, 125, 260, 520, 1040, 2080, 4160, 8330, 16600, 33300, 66600, 0, 0, 0, 0, 0};
+
+/* Accelerometer sensitivity in ug/LSB by FS_XL setting */
+static const uint16_t lsm6d_emu_xl_ug[4] = {61, 488, 122, 244};
+
+/* Gyro sensitivity in mdps/LSB * 8 by FS_G setting, FS_125 last */
+static const uint16_t lsm6d_emu_g_mdps8[5] = {70, 140, 280, 560, 35};
+
+/* _FIFO_CTRL3_x setting to decimation factor */
+static const uint8_t lsm6d_emu_dec[8] = {0, 1, 2, 3, 4, 8, 16, 32};
+
+static int16_t lsm6d_emu_clamp(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+/* Divide rounding to nearest */
+static int32_t lsm6d_emu_div(int32_t num, int32_t den) {
+    return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+static void lsm6d_emu_reset_regs(LSM6D_EMU *emu) {
+    memset(emu->regs, 0, sizeof(emu->regs));
+    emu->regs[LSM6D_WHO_AM_I] = LSM6D_EMU_WHO_AM_I;
+    emu->regs[LSM6D_CTRL3_C] = _CTRL3_C_IF_INC_MASK;
+    
+    memset(emu->locked, 0, sizeof(emu->locked));
+    emu->fifo_level = 0;
+    emu->fifo_slot = 0;
+    emu->fifo_mode = _FIFO_CTRL5_FIFO_BYPASS;
+    emu->fifo_overrun = 0;
+}
+
+void lsm6d_emu_init(LSM6D_EMU *emu) {
+    memset(emu, 0, sizeof(*emu));
+    lsm6d_emu_reset_regs(emu);
+}
+
+void lsm6d_emu_set_source(LSM6D_EMU *emu, void (*source)(uint32_t t_us, LSM6D_EMU_MOTION *motion)) {
+    emu->source = source;
+    emu->trace = 0;
+}
+
+void lsm6d_emu_set_trace(LSM6D_EMU *emu, const LSM6D_EMU_MOTION *trace, uint32_t len) {
+    emu->source = 0;
+    emu->trace = trace;
+    emu->trace_len = len;
+    emu->trace_pos = 0;
+}
+
+static void lsm6d_emu_motion(LSM6D_EMU *emu, LSM6D_EMU_MOTION *m) {
+    if (emu->source) {
+        emu->source(emu->now_us, m);
+        return;
+    }
+    
+    if (emu->trace && emu->trace_len) {
+        while (emu->trace_pos + 1 < emu->trace_len && emu->trace[emu->trace_pos + 1].t_us <= emu->now_us) {
+            emu->trace_pos++;
+        }
+        *m = emu->trace[emu->trace_pos];
+        return;
+    }
+    
+    memset(m, 0, sizeof(*m));
+    m->xl[2] = 1000;
+    m->temp = 2500;
+}
+
+/* Copy latest value of an output register pair unless block data update holds it */
+static void lsm6d_emu_refresh(LSM6D_EMU *emu, uint8_t pair) {
+    uint8_t reg = LSM6D_OUT_TEMP_L + pair * 2;
+    
+    if (!emu->locked[pair]) {
+        emu->regs[reg] = (uint8_t)emu->latest[pair];
+        emu->regs[reg + 1] = (uint8_t)((uint16_t)emu->latest[pair] >> 8);
+    }
+}
+
+static void lsm6d_emu_sample_xl(LSM6D_EMU *emu) {
+    LSM6D_EMU_MOTION m;
+    uint8_t fs = (emu->regs[LSM6D_CTRL1_XL] & _CTRL1_XL_FS_XL_MASK) >> _CTRL1_XL_FS_XL_POSN;
+    uint8_t i;
+    
+    lsm6d_emu_motion(emu, &m);
+    
+    for (i = 0; i < 3; i++) {
+        emu->latest[LSM6D_EMU_XL + i] = lsm6d_emu_clamp(lsm6d_emu_div(m.xl[i] * 1000, lsm6d_emu_xl_ug[fs]));
+        lsm6d_emu_refresh(emu, LSM6D_EMU_XL + i);
+    }
+    
+    /* 16 LSB/degC, 0 at 25 degC */
+    emu->latest[LSM6D_EMU_TEMP] = lsm6d_emu_clamp(lsm6d_emu_div(((int32_t)m.temp - 2500) * 16, 100));
+    lsm6d_emu_refresh(emu, LSM6D_EMU_TEMP);
+    
+    emu->regs[LSM6D_STATUS_REG] |= _STATUS_REG_XLDA_MASK | _STATUS_REG_TDA_MASK;
+}
+
+static void lsm6d_emu_sample_g(LSM6D_EMU *emu) {
+    LSM6D_EMU_MOTION m;
+    uint8_t ctrl = emu->regs[LSM6D_CTRL2_G];
+    uint8_t fs = (ctrl & _CTRL2_G_FS_125_MASK) ? 4 : (ctrl & _CTRL2_G_FS_G_MASK) >> _CTRL2_G_FS_G_POSN;
+    uint8_t i;
+    
+    lsm6d_emu_motion(emu, &m);
+    
+    for (i = 0; i < 3; i++) {
+        emu->latest[LSM6D_EMU_G + i] = lsm6d_emu_clamp(lsm6d_emu_div(m.g[i] * 8, lsm6d_emu_g_mdps8[fs]));
+        lsm6d_emu_refresh(emu, LSM6D_EMU_G + i);
+    }
+    
+    emu->regs[LSM6D_STATUS_REG] |= _STATUS_REG_GDA_MASK;
+}
+
+static uint32_t lsm6d_emu_timestamp(LSM6D_EMU *emu) {
+    uint16_t lsb = (emu->regs[LSM6D_WAKE_UP_DUR] & _WAKE_UP_DUR_TIMER_HR_MASK) ? LSM6D_TIMESTAMP_LSB_US_HR : LSM6D_TIMESTAMP_LSB_US;
+    
+    return (emu->ts_us / lsb) & 0x00FFFFFFUL;
+}
+
+static uint8_t lsm6d_emu_fifo_threshold(LSM6D_EMU *emu) {
+    uint16_t fth = emu->regs[LSM6D_FIFO_CTRL1] | ((uint16_t)(emu->regs[LSM6D_FIFO_CTRL2] & _FIFO_CTRL2_FTH_H_MASK) << 8);
+    
+    return fth && emu->fifo_level >= fth;
+}
+
+/* Decimation factors of the gyro, accelerometer and timestamp data sets */
+static void lsm6d_emu_fifo_decimation(LSM6D_EMU *emu, uint8_t *dec) {
+    dec[0] = lsm6d_emu_dec[(emu->regs[LSM6D_FIFO_CTRL3] & _FIFO_CTRL3_DEC_FIFO_GYRO_MASK) >> _FIFO_CTRL3_DEC_FIFO_GYRO_POSN];
+    dec[1] = lsm6d_emu_dec[(emu->regs[LSM6D_FIFO_CTRL3] & _FIFO_CTRL3_DEC_FIFO_XL_MASK) >> _FIFO_CTRL3_DEC_FIFO_XL_POSN];
+    dec[2] = (emu->regs[LSM6D_FIFO_CTRL2] & _FIFO_CTRL2_TIMER_PEDO_FIFO_EN_MASK) ?
+            lsm6d_emu_dec[(emu->regs[LSM6D_FIFO_CTRL4] & _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_MASK) >> _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_POSN] : 0;
+}
+
+/* Number of FIFO words stored at slot of the decimation pattern */
+static uint8_t lsm6d_emu_fifo_words(const uint8_t *dec, uint8_t slot) {
+    uint8_t words = 0;
+    uint8_t i;
+    
+    for (i = 0; i < 3; i++) {
+        if (dec[i] && (slot % dec[i]) == 0) {
+            words += 3;
+        }
+    }
+    
+    return words;
+}
+
+/* Pattern length in FIFO ODR ticks */
+static uint8_t lsm6d_emu_fifo_period(const uint8_t *dec) {
+    uint8_t period;
+
+    /* Least common multiple - factors are at most 32, so a linear search is fine */
+    for (period = 1; period < 255; period++) {
+        if ((!dec[0] || period % dec[0] == 0) && (!dec[1] || period % dec[1] == 0) && (!dec[2] || period % dec[2] == 0)) {
+            break;
+        }
+    }
+    
+    return period;
+}
+
+static void lsm6d_emu_fifo_push(LSM6D_EMU *emu, uint16_t word, uint16_t pattern) {
+    uint16_t tail;
+    
+    if (emu->fifo_level == LSM6D_EMU_FIFO_WORDS) {
+        if (emu->fifo_mode == _FIFO_CTRL5_FIFO_UNTIL_FULL) {
+            return;
+        }
+        
+        /* Continuous - oldest word is overwritten */
+        emu->fifo_head = (emu->fifo_head + 1) % LSM6D_EMU_FIFO_WORDS;
+        emu->fifo_level--;
+        emu->fifo_overrun = 1;
+    }
+    
+    tail = (emu->fifo_head + emu->fifo_level) % LSM6D_EMU_FIFO_WORDS;
+    emu->fifo[tail] = word;
+    emu->fifo_pattern[tail] = pattern;
+    emu->fifo_level++;
+}
+
+static void lsm6d_emu_fifo_tick(LSM6D_EMU *emu) {
+    uint8_t dec[3];
+    uint8_t period;
+    uint16_t pattern = 0;
+    uint32_t ts;
+    uint8_t i;
+    
+    if (emu->fifo_mode == _FIFO_CTRL5_FIFO_UNTIL_FULL && emu->fifo_level == LSM6D_EMU_FIFO_WORDS) {
+        return;
+    }
+    
+    lsm6d_emu_fifo_decimation(emu, dec);
+    period = lsm6d_emu_fifo_period(dec);
+    
+    if (emu->fifo_slot >= period) {
+        emu->fifo_slot = 0;
+    }
+    
+    for (i = 0; i < emu->fifo_slot; i++) {
+        pattern += lsm6d_emu_fifo_words(dec, i);
+    }
+    
+    /* Data sets in order: gyro, accelerometer, timestamp/steps */
+    if (dec[0] && (emu->fifo_slot % dec[0]) == 0) {
+        for (i = 0; i < 3; i++) {
+            lsm6d_emu_fifo_push(emu, (uint16_t)emu->latest[LSM6D_EMU_G + i], pattern++);
+        }
+    }
+    
+    if (dec[1] && (emu->fifo_slot % dec[1]) == 0) {
+        for (i = 0; i < 3; i++) {
+            lsm6d_emu_fifo_push(emu, (uint16_t)emu->latest[LSM6D_EMU_XL + i], pattern++);
+        }
+    }
+    
+    if (dec[2] && (emu->fifo_slot % dec[2]) == 0) {
+        ts = lsm6d_emu_timestamp(emu);
+        lsm6d_emu_fifo_push(emu, (uint16_t)(((ts >> 8) & 0xFF) | ((ts >> 16) << 8)), pattern++);
+        lsm6d_emu_fifo_push(emu, (uint16_t)((ts & 0xFF) << 8), pattern++);
+        lsm6d_emu_fifo_push(emu, 0, pattern++);
+    }
+    
+    if (++emu->fifo_slot >= period) {
+        emu->fifo_slot = 0;
+    }
+}
+
+/* Follow FIFO mode changes - bypass empties the FIFO and restarts the pattern */
+static void lsm6d_emu_fifo_mode(LSM6D_EMU *emu) {
+    uint8_t mode = (emu->regs[LSM6D_FIFO_CTRL5] & _FIFO_CTRL5_FIFO_MODE_MASK) >> _FIFO_CTRL5_FIFO_MODE_POSN;
+    
+    if (mode == _FIFO_CTRL5_FIFO_BYPASS) {
+        emu->fifo_level = 0;
+        emu->fifo_slot = 0;
+        emu->fifo_overrun = 0;
+    }
+    
+    emu->fifo_mode = mode;
+}
+
+/* Pattern position of the next word to be read */
+static uint16_t lsm6d_emu_fifo_pattern(LSM6D_EMU *emu) {
+    uint8_t dec[3];
+    uint16_t pattern = 0;
+    uint8_t i;
+    
+    if (emu->fifo_level) {
+        return emu->fifo_pattern[emu->fifo_head];
+    }
+    
+    lsm6d_emu_fifo_decimation(emu, dec);
+    
+    for (i = 0; i < emu->fifo_slot; i++) {
+        pattern += lsm6d_emu_fifo_words(dec, i);
+    }
+    
+    return pattern;
+}
+
+static uint8_t lsm6d_emu_read(LSM6D_EMU *emu, uint8_t addr) {
+    uint16_t level;
+    uint16_t pattern;
+    uint32_t ts;
+    uint8_t value;
+    uint8_t pair;
+    
+    switch (addr) {
+        case LSM6D_FIFO_STATUS1:
+        case LSM6D_FIFO_STATUS2:
+            level = (emu->fifo_level > LSM6D_EMU_LEVEL_MAX) ? LSM6D_EMU_LEVEL_MAX : emu->fifo_level;
+            if (addr == LSM6D_FIFO_STATUS1) {
+                return (uint8_t)level;
+            }
+            value = (level >> 8) & _FIFO_STATUS2_DIFF_FIFO_H_MASK;
+            if (emu->fifo_level == 0) {
+                value |= _FIFO_STATUS2_FIFO_EMPTY_MASK;
+            }
+            if (emu->fifo_level == LSM6D_EMU_FIFO_WORDS) {
+                value |= _FIFO_STATUS2_FIFO_FULL_MASK;
+            }
+            if (emu->fifo_overrun) {
+                value |= _FIFO_STATUS2_FIFO_OVER_RUN_MASK;
+            }
+            if (lsm6d_emu_fifo_threshold(emu)) {
+                value |= _FIFO_STATUS2_FTH_MASK;
+            }
+            return value;
+            
+        case LSM6D_FIFO_STATUS3:
+        case LSM6D_FIFO_STATUS4:
+            pattern = lsm6d_emu_fifo_pattern(emu);
+            return (addr == LSM6D_FIFO_STATUS3) ? (uint8_t)pattern : (uint8_t)(pattern >> 8) & _FIFO_STATUS4_FIFO_PATTERN_H_MASK;
+            
+        case LSM6D_FIFO_DATA_OUT_L:
+            if (emu->fifo_level == 0) {
+                return 0;
+            }
+            return (uint8_t)emu->fifo[emu->fifo_head];
+            
+        case LSM6D_FIFO_DATA_OUT_H:
+            if (emu->fifo_level == 0) {
+                return 0;
+            }
+            value = (uint8_t)(emu->fifo[emu->fifo_head] >> 8);
+            emu->fifo_head = (emu->fifo_head + 1) % LSM6D_EMU_FIFO_WORDS;
+            emu->fifo_level--;
+            emu->fifo_overrun = 0;
+            emu->stats.fifo_words++;
+            return value;
+            
+        case LSM6D_TIMESTAMP0_REG:
+        case LSM6D_TIMESTAMP1_REG:
+        case LSM6D_TIMESTAMP2_REG:
+            ts = lsm6d_emu_timestamp(emu);
+            return (uint8_t)(ts >> ((addr - LSM6D_TIMESTAMP0_REG) * 8));
+    }
+    
+    value = emu->regs[addr];
+    
+    if (addr >= LSM6D_OUT_TEMP_L && addr <= LSM6D_OUTZ_H_XL) {
+        pair = (addr - LSM6D_OUT_TEMP_L) / 2;
+        
+        if ((addr & 1) == 0) {
+            /* Low byte - hold the pair until the high byte has been read */
+            if (emu->regs[LSM6D_CTRL3_C] & _CTRL3_C_BDU_MASK) {
+                emu->locked[pair] = 1;
+            }
+        } else {
+            emu->locked[pair] = 0;
+            lsm6d_emu_refresh(emu, pair);
+            
+            if (pair == LSM6D_EMU_TEMP) {
+                emu->regs[LSM6D_STATUS_REG] &= ~_STATUS_REG_TDA_MASK;
+            } else if (pair < LSM6D_EMU_XL) {
+                emu->regs[LSM6D_STATUS_REG] &= ~_STATUS_REG_GDA_MASK;
+            } else {
+                emu->regs[LSM6D_STATUS_REG] &= ~_STATUS_REG_XLDA_MASK;
+            }
+        }
+    }
+    
+    return value;
+}
+
+static void lsm6d_emu_write(LSM6D_EMU *emu, uint8_t addr, uint8_t value) {
+    if (addr == LSM6D_TIMESTAMP2_REG) {
+        if (value == LSM6D_TIMESTAMP_RESET) {
+            emu->ts_us = 0;
+        }
+        return;
+    }
+    
+    /* Only control registers are writable */
+    if (!(addr == LSM6D_FUNC_CFG_ACCESS || (addr >= LSM6D_FIFO_CTRL1 && addr <= LSM6D_INT2_CTRL) ||
+            (addr >= LSM6D_CTRL1_XL && addr <= LSM6D_CTRL10_C) || (addr >= LSM6D_TAP_CFG && addr <= LSM6D_MD2_CFG))) {
+        return;
+    }
+    
+    if (addr == LSM6D_CTRL3_C && (value & _CTRL3_C_SW_RESET_MASK)) {
+        lsm6d_emu_reset_regs(emu);
+        return;
+    }
+    
+    if (addr == LSM6D_CTRL3_C) {
+        /* Reboot completes immediately */
+        value &= ~_CTRL3_C_BOOT_MASK;
+    }
+    
+    emu->regs[addr] = value;
+    
+    if (addr == LSM6D_FIFO_CTRL5) {
+        lsm6d_emu_fifo_mode(emu);
+    }
+}
+
+void lsm6d_emu_select(LSM6D_EMU *emu, uint8_t selected) {
+    if (selected && !emu->selected) {
+        emu->stats.transactions++;
+        emu->first = 1;
+    }
+    
+    emu->selected = selected;
+}
+
+uint8_t lsm6d_emu_transfer(LSM6D_EMU *emu, uint8_t data) {
+    uint8_t value = 0;
+    
+    if (!emu->selected) {
+        return 0xFF;
+    }
+    
+    emu->stats.bytes++;
+    
+    if (emu->first) {
+        emu->first = 0;
+        emu->addr = data & ~LSM6D_SPI_READ;
+        emu->read = data & LSM6D_SPI_READ;
+        return 0;
+    }
+    
+    if (emu->read) {
+        value = lsm6d_emu_read(emu, emu->addr);
+    } else {
+        lsm6d_emu_write(emu, emu->addr, data);
+    }
+    
+    /* FIFO output rolls over between its two registers */
+    if (emu->addr == LSM6D_FIFO_DATA_OUT_L && emu->read) {
+        emu->addr = LSM6D_FIFO_DATA_OUT_H;
+    } else if (emu->addr == LSM6D_FIFO_DATA_OUT_H && emu->read) {
+        emu->addr = LSM6D_FIFO_DATA_OUT_L;
+    } else if (emu->regs[LSM6D_CTRL3_C] & _CTRL3_C_IF_INC_MASK) {
+        emu->addr = (emu->addr + 1) & (LSM6D_EMU_REGS - 1);
+    }
+    
+    return value;
+}
+
+/* Time in us until a clock at rate reaches the next tick */
+static uint32_t lsm6d_emu_until(uint32_t phase, uint32_t rate) {
+    return (LSM6D_EMU_PHASE - phase + rate - 1) / rate;
+}
+
+void lsm6d_emu_advance(LSM6D_EMU *emu, uint32_t us) {
+    uint32_t rate_xl;
+    uint32_t rate_g;
+    uint32_t rate_fifo;
+    uint32_t step;
+    
+    while (us) {
+        rate_xl = lsm6d_emu_rates[(emu->regs[LSM6D_CTRL1_XL] & _CTRL1_XL_ODR_XL_MASK) >> _CTRL1_XL_ODR_XL_POSN];
+        rate_g = lsm6d_emu_rates[(emu->regs[LSM6D_CTRL2_G] & _CTRL2_G_ODR_G_MASK) >> _CTRL2_G_ODR_G_POSN];
+        rate_fifo = (emu->fifo_mode == _FIFO_CTRL5_FIFO_BYPASS) ? 0 :
+                lsm6d_emu_rates[(emu->regs[LSM6D_FIFO_CTRL5] & _FIFO_CTRL5_ODR_FIFO_MASK) >> _FIFO_CTRL5_ODR_FIFO_POSN];
+        
+        /* Step to the next sample clock tick */
+        step = us;
+        if (rate_xl && lsm6d_emu_until(emu->phase_xl, rate_xl) < step) {
+            step = lsm6d_emu_until(emu->phase_xl, rate_xl);
+        }
+        if (rate_g && lsm6d_emu_until(emu->phase_g, rate_g) < step) {
+            step = lsm6d_emu_until(emu->phase_g, rate_g);
+        }
+        if (rate_fifo && lsm6d_emu_until(emu->phase_fifo, rate_fifo) < step) {
+            step = lsm6d_emu_until(emu->phase_fifo, rate_fifo);
+        }
+        
+        emu->now_us += step;
+        us -= step;
+        
+        if (emu->regs[LSM6D_TAP_CFG] & _TAP_CFG_TIMER_EN_MASK) {
+            emu->ts_us += step;
+        }
+        
+        emu->phase_xl = rate_xl ? emu->phase_xl + step * rate_xl : 0;
+        emu->phase_g = rate_g ? emu->phase_g + step * rate_g : 0;
+        emu->phase_fifo = rate_fifo ? emu->phase_fifo + step * rate_fifo : 0;
+        
+        /* Sensors first, so a coincident FIFO tick stores the new samples */
+        if (emu->phase_xl >= LSM6D_EMU_PHASE) {
+            emu->phase_xl -= LSM6D_EMU_PHASE;
+            lsm6d_emu_sample_xl(emu);
+        }
+        if (emu->phase_g >= LSM6D_EMU_PHASE) {
+            emu->phase_g -= LSM6D_EMU_PHASE;
+            lsm6d_emu_sample_g(emu);
+        }
+        if (emu->phase_fifo >= LSM6D_EMU_PHASE) {
+            emu->phase_fifo -= LSM6D_EMU_PHASE;
+            lsm6d_emu_fifo_tick(emu);
+        }
+    }
+}
+
+uint8_t lsm6d_emu_int1(LSM6D_EMU *emu) {
+    uint8_t ctrl = emu->regs[LSM6D_INT1_CTRL];
+    uint8_t status = emu->regs[LSM6D_STATUS_REG];
+    
+    return ((ctrl & _INT1_CTRL_INT1_DRDY_XL_MASK) && (status & _STATUS_REG_XLDA_MASK)) ||
+            ((ctrl & _INT1_CTRL_INT1_DRDY_G_MASK) && (status & _STATUS_REG_GDA_MASK)) ||
+            ((ctrl & _INT1_CTRL_INT1_FTH_MASK) && lsm6d_emu_fifo_threshold(emu)) ||
+            ((ctrl & _INT1_CTRL_INT1_FIFO_OVR_MASK) && emu->fifo_overrun) ||
+            ((ctrl & _INT1_CTRL_INT1_FULL_FLAG_MASK) && emu->fifo_level == LSM6D_EMU_FIFO_WORDS);
+}
+
+uint8_t lsm6d_emu_int2(LSM6D_EMU *emu) {
+    uint8_t ctrl = emu->regs[LSM6D_INT2_CTRL];
+    uint8_t status = emu->regs[LSM6D_STATUS_REG];
+    
+    return ((ctrl & _INT2_CTRL_INT2_DRDY_XL_MASK) && (status & _STATUS_REG_XLDA_MASK)) ||
+            ((ctrl & _INT2_CTRL_INT2_DRDY_G_MASK) && (status & _STATUS_REG_GDA_MASK)) ||
+            ((ctrl & _INT2_CTRL_INT2_DRDY_TEMP_MASK) && (status & _STATUS_REG_TDA_MASK)) ||
+            ((ctrl & _INT2_CTRL_INT2_FTH_MASK) && lsm6d_emu_fifo_threshold(emu)) ||
+            ((ctrl & _INT2_CTRL_INT2_FIFO_OVR_MASK) && emu->fifo_overrun) ||
+            ((ctrl & _INT2_CTRL_INT2_FULL_FLAG_MASK) && emu->fifo_level == LSM6D_EMU_FIFO_WORDS);
+}
@@ -0,0 +1,127 @@
+/*
+ * Constant definitions and function prototypes for
+ * host-side LSM6DS3x SPI emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * To run the driver against the emulator, lsm6ds3x-cfg.h for the host build
+ * would contain for example:
+ * 
+ * #include "lsm6ds3x-emu.h"
+ * extern LSM6D_EMU emu;
+ * #define LSM6D_SPI_ACTIVE()       lsm6d_emu_select(&emu, 1)
+ * #define LSM6D_SPI_IDLE()         lsm6d_emu_select(&emu, 0)
+ * #define LSM6D_SPI_TRANSFER(x)    lsm6d_emu_transfer(&emu, x)
+ * #define LSM6D_INT1               lsm6d_emu_int1(&emu)
+ * #define LSM6D_INT2               lsm6d_emu_int2(&emu)
+ * 
+ * This header does not include lsm6ds3x.h so it can be included from the config header.
+ * 
+ * Additional emulated devices are bound to their own LSM6D_DEVICE with cs and
+ * xfer_spi callbacks that call lsm6d_emu_select and lsm6d_emu_transfer.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_EMU_H
+#define LSM6DS3X_EMU_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define LSM6D_EMU_REGS            128
+#define LSM6D_EMU_FIFO_WORDS      4096
+
+/* Motion at a point in time */
+typedef struct {
+    uint32_t t_us;              /* Time of this point (traces only) */
+    int32_t xl[3];              /* Acceleration (mg) */
+    int32_t g[3];               /* Angular rate (mdps) */
+    int16_t temp;               /* Temperature (0.01 degC) */
+} LSM6D_EMU_MOTION;
+
+/* Bus statistics, e.g. for benchmarking driver code paths */
+typedef struct {
+    uint32_t transactions;      /* CS assertions */
+    uint32_t bytes;             /* Bytes transferred, including address bytes */
+    uint32_t fifo_words;        /* FIFO words read */
+} LSM6D_EMU_STATS;
+
+typedef struct {
+    uint8_t regs[LSM6D_EMU_REGS];
+    
+    /* SPI transaction in progress */
+    uint8_t selected;
+    uint8_t first;              /* Next byte is the address byte */
+    uint8_t addr;
+    uint8_t read;
+    
+    /* Motion source - callback, or trace replayed with sample-and-hold */
+    void (*source)(uint32_t t_us, LSM6D_EMU_MOTION *motion);
+    const LSM6D_EMU_MOTION *trace;
+    uint32_t trace_len;
+    uint32_t trace_pos;
+    
+    /* Time and sample clocks (phase in 0.1 us * 0.1 Hz units) */
+    uint32_t now_us;
+    uint32_t phase_xl;
+    uint32_t phase_g;
+    uint32_t phase_fifo;
+    uint32_t ts_us;             /* Timestamp counter time, advanced while TIMER_EN is set */
+    
+    /* Latest samples and block data update locks (temperature, gyro x/y/z, accelerometer x/y/z) */
+    int16_t latest[7];
+    uint8_t locked[7];
+    
+    /* FIFO */
+    uint16_t fifo[LSM6D_EMU_FIFO_WORDS];
+    uint16_t fifo_pattern[LSM6D_EMU_FIFO_WORDS];
+    uint16_t fifo_head;
+    uint16_t fifo_level;
+    uint8_t fifo_slot;          /* Position of the next FIFO ODR tick within the decimation period */
+    uint8_t fifo_mode;          /* Mode when the FIFO was last updated */
+    uint8_t fifo_overrun;
+    
+    LSM6D_EMU_STATS stats;
+} LSM6D_EMU;
+
+/* Power-on reset with no motion source (device at rest, +1 g on Z, 25 degC) */
+void lsm6d_emu_init(LSM6D_EMU *emu);
+
+void lsm6d_emu_set_source(LSM6D_EMU *emu, void (*source)(uint32_t t_us, LSM6D_EMU_MOTION *motion));
+void lsm6d_emu_set_trace(LSM6D_EMU *emu, const LSM6D_EMU_MOTION *trace, uint32_t len);
+
+/* Advance emulated time, generating samples at the configured ODRs */
+void lsm6d_emu_advance(LSM6D_EMU *emu, uint32_t us);
+
+/* SPI interface - select with level 1 when CS is driven low */
+void lsm6d_emu_select(LSM6D_EMU *emu, uint8_t selected);
+uint8_t lsm6d_emu_transfer(LSM6D_EMU *emu, uint8_t data);
+
+/* Interrupt pin levels */
+uint8_t lsm6d_emu_int1(LSM6D_EMU *emu);
+uint8_t lsm6d_emu_int2(LSM6D_EMU *emu);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_EMU_H */
@@ -0,0 +1,244 @@
+/*
+ * Embedded function (event detection) manager for ST Microelectronics LSM6DS3x
+ * Copyright (c) 2019 David Rice
+ * 
+ * Wake-up, inactivity, tap, free-fall, 6D, tilt, significant motion and step
+ * detection run on the chip and are routed to INT1/INT2, so the host can sleep
+ * instead of streaming data. The configuration is applied as a register profile,
+ * so TAP_CFG..MD2_CFG are written in one burst. WAKE_UP_SRC, TAP_SRC and D6D_SRC
+ * are read in one burst, and FUNC_SRC only if an embedded function is enabled.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-events.h"
+
+/* Offsets within LSM6D_PROFILE */
+#define LSM6D_EV_INT1_CTRL        0
+#define LSM6D_EV_INT2_CTRL        1
+#define LSM6D_EV_CTRL10_C         (LSM6D_CTRL10_C - LSM6D_CTRL1_XL)
+#define LSM6D_EV_TAP_CFG          0
+#define LSM6D_EV_TAP_THS_6D       1
+#define LSM6D_EV_INT_DUR2         2
+#define LSM6D_EV_WAKE_UP_THS      3
+#define LSM6D_EV_WAKE_UP_DUR      4
+#define LSM6D_EV_FREE_FALL        5
+#define LSM6D_EV_MD1_CFG          6
+#define LSM6D_EV_MD2_CFG          7
+
+/* MD1_CFG / MD2_CFG routing bits, same positions on both */
+#define LSM6D_EV_MD_EVENTS        (LSM6D_EVENT_WAKE | LSM6D_EVENT_SLEEP | LSM6D_EVENT_SINGLE_TAP | LSM6D_EVENT_DOUBLE_TAP | \
+                                   LSM6D_EVENT_FREE_FALL | LSM6D_EVENT_ORIENTATION | LSM6D_EVENT_TILT)
+
+/* Convert events to MD1_CFG / MD2_CFG bits */
+static uint8_t lsm6d_events_md(uint16_t events) {
+    uint8_t md = 0;
+    
+    if (events & LSM6D_EVENT_WAKE) {
+        md |= _MD1_CFG_INT1_WU_MASK;
+    }
+    if (events & LSM6D_EVENT_SLEEP) {
+        md |= _MD1_CFG_INT1_INACT_STATE_MASK;
+    }
+    if (events & LSM6D_EVENT_SINGLE_TAP) {
+        md |= _MD1_CFG_INT1_SINGLE_TAP_MASK;
+    }
+    if (events & LSM6D_EVENT_DOUBLE_TAP) {
+        md |= _MD1_CFG_INT1_DOUBLE_TAP_MASK;
+    }
+    if (events & LSM6D_EVENT_FREE_FALL) {
+        md |= _MD1_CFG_INT1_FF_MASK;
+    }
+    if (events & LSM6D_EVENT_ORIENTATION) {
+        md |= _MD1_CFG_INT1_6D_MASK;
+    }
+    if (events & LSM6D_EVENT_TILT) {
+        md |= _MD1_CFG_INT1_TILT_MASK;
+    }
+    
+    return md;
+}
+
+void lsm6d_events_defaults(LSM6D_EVENT_CFG *cfg) {
+    cfg->enable = 0;
+    cfg->int1 = 0;
+    cfg->int2 = 0;
+    cfg->latched = 0;
+    
+    cfg->wake_ths = 2;
+    cfg->wake_dur = 0;
+    cfg->sleep_dur = 2;
+    
+    cfg->tap_axes = LSM6D_TAP_X | LSM6D_TAP_Y | LSM6D_TAP_Z;
+    cfg->tap_ths = 0b01100;
+    cfg->tap_shock = 0b10;
+    cfg->tap_quiet = 0b01;
+    cfg->tap_dur = 0b0111;
+    
+    cfg->ff_ths = _FREE_FALL_FF_THS_312MG;
+    cfg->ff_dur = 0b000110;
+    
+    cfg->sixd_ths = SIXD_THS_60D;
+}
+
+void lsm6d_events_dev_configure(LSM6D_DEVICE *dev, const LSM6D_EVENT_CFG *cfg) {
+    LSM6D_PROFILE profile;
+    uint8_t *func = profile.func_cfg;
+    uint16_t enable = cfg->enable;
+    uint8_t tap_cfg;
+    uint8_t ctrl10;
+    
+    lsm6d_dev_profile_get(dev, &profile);
+    
+    /* Keep the timestamp counter as it is */
+    tap_cfg = func[LSM6D_EV_TAP_CFG] & _TAP_CFG_TIMER_EN_MASK;
+    
+    if (enable & (LSM6D_EVENT_SINGLE_TAP | LSM6D_EVENT_DOUBLE_TAP)) {
+        tap_cfg |= cfg->tap_axes & (LSM6D_TAP_X | LSM6D_TAP_Y | LSM6D_TAP_Z);
+    }
+    if (enable & LSM6D_EVENT_TILT) {
+        tap_cfg |= _TAP_CFG_TILT_EN_MASK;
+    }
+    /* Significant motion is built on the pedometer, but steps are only reported if asked for */
+    if (enable & (LSM6D_EVENT_STEP | LSM6D_EVENT_SIGN_MOTION)) {
+        tap_cfg |= _TAP_CFG_PEDO_EN_MASK;
+    }
+    if (cfg->latched) {
+        tap_cfg |= _TAP_CFG_LIR_MASK;
+    }
+    
+    func[LSM6D_EV_TAP_CFG] = tap_cfg;
+    func[LSM6D_EV_TAP_THS_6D] = ((cfg->tap_ths << _TAP_THS_6D_TAP_THS_POSN) & _TAP_THS_6D_TAP_THS_MASK) |
+            ((cfg->sixd_ths << _TAP_THS_6D_SIXD_THS_POSN) & _TAP_THS_6D_SIXD_THS_MASK);
+    func[LSM6D_EV_INT_DUR2] = ((cfg->tap_shock << _INT_DUR2_SHOCK_POSN) & _INT_DUR2_SHOCK_MASK) |
+            ((cfg->tap_quiet << _INT_DUR2_QUIET_POSN) & _INT_DUR2_QUIET_MASK) |
+            ((cfg->tap_dur << _INT_DUR2_DUR_POSN) & _INT_DUR2_DUR_MASK);
+    
+    func[LSM6D_EV_WAKE_UP_THS] = (cfg->wake_ths << _WAKE_UP_THS_WK_THS_POSN) & _WAKE_UP_THS_WK_THS_MASK;
+    if (enable & LSM6D_EVENT_SLEEP) {
+        func[LSM6D_EV_WAKE_UP_THS] |= _WAKE_UP_THS_INACTIVITY_MASK;
+    }
+    if (enable & LSM6D_EVENT_DOUBLE_TAP) {
+        func[LSM6D_EV_WAKE_UP_THS] |= _WAKE_UP_THS_SINGLE_DOUBLE_TAP_MASK;
+    }
+    
+    /* TIMER_HR belongs to the timestamp counter */
+    func[LSM6D_EV_WAKE_UP_DUR] = (func[LSM6D_EV_WAKE_UP_DUR] & _WAKE_UP_DUR_TIMER_HR_MASK) |
+            ((cfg->sleep_dur << _WAKE_UP_DUR_SLEEP_DUR_POSN) & _WAKE_UP_DUR_SLEEP_DUR_MASK) |
+            ((cfg->wake_dur << _WAKE_UP_DUR_WAKE_DUR_POSN) & _WAKE_UP_DUR_WAKE_DUR_MASK) |
+            ((cfg->ff_dur & 0b100000) ? _WAKE_UP_DUR_FF_DUR5_MASK : 0);
+    func[LSM6D_EV_FREE_FALL] = ((cfg->ff_ths << _FREE_FALL_FF_THS_POSN) & _FREE_FALL_FF_THS_MASK) |
+            ((cfg->ff_dur << _FREE_FALL_FF_DUR_POSN) & _FREE_FALL_FF_DUR_MASK);
+    
+    func[LSM6D_EV_MD1_CFG] = (func[LSM6D_EV_MD1_CFG] & _MD1_CFG_INT1_TIMER_MASK) | lsm6d_events_md(cfg->int1 & enable & LSM6D_EV_MD_EVENTS);
+    func[LSM6D_EV_MD2_CFG] = (func[LSM6D_EV_MD2_CFG] & _MD2_CFG_INT2_IRON_MASK) | lsm6d_events_md(cfg->int2 & enable & LSM6D_EV_MD_EVENTS);
+    
+    profile.int_ctrl[LSM6D_EV_INT1_CTRL] &= ~(_INT1_CTRL_INT1_SIGN_MOT_MASK | _INT1_CTRL_INT1_STEP_DETECTOR_MASK);
+    if (cfg->int1 & enable & LSM6D_EVENT_SIGN_MOTION) {
+        profile.int_ctrl[LSM6D_EV_INT1_CTRL] |= _INT1_CTRL_INT1_SIGN_MOT_MASK;
+    }
+    if (cfg->int1 & enable & LSM6D_EVENT_STEP) {
+        profile.int_ctrl[LSM6D_EV_INT1_CTRL] |= _INT1_CTRL_INT1_STEP_DETECTOR_MASK;
+    }
+    
+    ctrl10 = profile.ctrl[LSM6D_EV_CTRL10_C] & ~(_CTRL10_C_FUNC_EN_MASK | _CTRL10_C_SIGN_MOTION_EN_MASK);
+    if (enable & LSM6D_EVENT_FUNC) {
+        ctrl10 |= _CTRL10_C_FUNC_EN_MASK;
+    }
+    if (enable & LSM6D_EVENT_SIGN_MOTION) {
+        ctrl10 |= _CTRL10_C_SIGN_MOTION_EN_MASK;
+    }
+    profile.ctrl[LSM6D_EV_CTRL10_C] = ctrl10;
+    
+    lsm6d_dev_profile_apply(dev, &profile);
+    
+    dev->events_enabled = enable;
+}
+
+uint16_t lsm6d_events_dev_read(LSM6D_DEVICE *dev, LSM6D_EVENTS *events) {
+    uint8_t src[3];
+    uint8_t steps[2];
+    uint16_t ev = 0;
+    
+    lsm6d_dev_get_register_multi(dev, LSM6D_WAKE_UP_SRC, src, 3);
+    
+    events->wake_up_src = src[0];
+    events->tap_src = src[1];
+    events->d6d_src = src[2];
+    events->func_src = 0;
+    events->steps = 0;
+    
+    if (src[0] & _WAKE_UP_SRC_WU_IA_MASK) {
+        ev |= LSM6D_EVENT_WAKE;
+    }
+    if (src[0] & _WAKE_UP_SRC_SLEEP_STATE_IA_MASK) {
+        ev |= LSM6D_EVENT_SLEEP;
+    }
+    if (src[0] & _WAKE_UP_SRC_FF_IA_MASK) {
+        ev |= LSM6D_EVENT_FREE_FALL;
+    }
+    if (src[1] & _TAP_SRC_SINGLE_TAP_MASK) {
+        ev |= LSM6D_EVENT_SINGLE_TAP;
+    }
+    if (src[1] & _TAP_SRC_DOUBLE_TAP_MASK) {
+        ev |= LSM6D_EVENT_DOUBLE_TAP;
+    }
+    if (src[2] & _D6D_SRC_D6D_IA_MASK) {
+        ev |= LSM6D_EVENT_ORIENTATION;
+    }
+    
+    if (dev->events_enabled & LSM6D_EVENT_FUNC) {
+        events->func_src = lsm6d_dev_get_register_value(dev, LSM6D_FUNC_SRC);
+        
+        if (events->func_src & _FUNC_SRC_TILT_IA_MASK) {
+            ev |= LSM6D_EVENT_TILT;
+        }
+        if (events->func_src & _FUNC_SRC_SIGN_MOTION_IA_MASK) {
+            ev |= LSM6D_EVENT_SIGN_MOTION;
+        }
+        if ((events->func_src & _FUNC_SRC_STEP_DETECTED_MASK) && (dev->events_enabled & LSM6D_EVENT_STEP)) {
+            ev |= LSM6D_EVENT_STEP;
+            lsm6d_dev_get_register_multi(dev, LSM6D_STEP_COUNTER_L, steps, 2);
+            events->steps = steps[0] | ((uint16_t)steps[1] << 8);
+        }
+    }
+    
+    events->events = ev & dev->events_enabled;
+    
+    return events->events;
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+void lsm6d_events_configure(const LSM6D_EVENT_CFG *cfg) {
+    lsm6d_events_dev_configure(&lsm6d_default_device, cfg);
+}
+
+uint16_t lsm6d_events_read(LSM6D_EVENTS *events) {
+    return lsm6d_events_dev_read(&lsm6d_default_device, events);
+}
+
+uint8_t lsm6d_events_pending(void) {
+    return (LSM6D_INT1 || LSM6D_INT2) ? 1 : 0;
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
@@ -0,0 +1,108 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x embedded function (event detection) manager
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_EVENTS_H
+#define LSM6DS3X_EVENTS_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Events (OR together) */
+#define LSM6D_EVENT_WAKE          0x0001    /* Acceleration above wake-up threshold */
+#define LSM6D_EVENT_SLEEP         0x0002    /* Inactivity - sleep state entered */
+#define LSM6D_EVENT_SINGLE_TAP    0x0004
+#define LSM6D_EVENT_DOUBLE_TAP    0x0008
+#define LSM6D_EVENT_FREE_FALL     0x0010
+#define LSM6D_EVENT_ORIENTATION   0x0020    /* 6D position change */
+#define LSM6D_EVENT_TILT          0x0040
+#define LSM6D_EVENT_SIGN_MOTION   0x0080    /* Significant motion */
+#define LSM6D_EVENT_STEP          0x0100    /* Step detected - INT1 only */
+
+/* Events that need the embedded functions (CTRL10_C FUNC_EN) and an accelerometer ODR of at least 26 Hz */
+#define LSM6D_EVENT_FUNC          (LSM6D_EVENT_TILT | LSM6D_EVENT_SIGN_MOTION | LSM6D_EVENT_STEP)
+
+/* Tap axes */
+#define LSM6D_TAP_X               _TAP_CFG_TAP_X_EN_MASK
+#define LSM6D_TAP_Y               _TAP_CFG_TAP_Y_EN_MASK
+#define LSM6D_TAP_Z               _TAP_CFG_TAP_Z_EN_MASK
+
+/* Event configuration - thresholds and durations are raw register fields */
+typedef struct {
+    uint16_t enable;            /* LSM6D_EVENT_x to detect */
+    uint16_t int1;              /* LSM6D_EVENT_x routed to INT1 */
+    uint16_t int2;              /* LSM6D_EVENT_x routed to INT2 */
+    uint8_t latched;            /* Keep interrupts asserted until the source is read */
+    
+    uint8_t wake_ths;           /* WK_THS, FS_XL / 64 per LSB */
+    uint8_t wake_dur;           /* WAKE_DUR, 1 / ODR per LSB */
+    uint8_t sleep_dur;          /* SLEEP_DUR, 512 / ODR per LSB */
+    
+    uint8_t tap_axes;           /* LSM6D_TAP_x */
+    uint8_t tap_ths;            /* TAP_THS, FS_XL / 32 per LSB */
+    uint8_t tap_shock;          /* SHOCK, 8 / ODR per LSB */
+    uint8_t tap_quiet;          /* QUIET, 4 / ODR per LSB */
+    uint8_t tap_dur;            /* DUR - double tap window, 32 / ODR per LSB */
+    
+    uint8_t ff_ths;             /* _FREE_FALL_FF_THS_x */
+    uint8_t ff_dur;             /* FF_DUR (6 bits), 1 / ODR per LSB */
+    
+    uint8_t sixd_ths;           /* SIXD_THS_x */
+} LSM6D_EVENT_CFG;
+
+/* Decoded event sources */
+typedef struct {
+    uint16_t events;            /* LSM6D_EVENT_x that occurred */
+    uint8_t wake_up_src;        /* Raw source registers */
+    uint8_t tap_src;
+    uint8_t d6d_src;
+    uint8_t func_src;
+    uint16_t steps;             /* Step counter if LSM6D_EVENT_STEP is enabled and a step was detected, otherwise 0 */
+} LSM6D_EVENTS;
+
+/* Fill cfg with datasheet example thresholds and nothing enabled */
+void lsm6d_events_defaults(LSM6D_EVENT_CFG *cfg);
+
+/* Write the configuration - only registers that change are written */
+void lsm6d_events_dev_configure(LSM6D_DEVICE *dev, const LSM6D_EVENT_CFG *cfg);
+
+/* Read and decode all event sources - clears latched interrupts */
+uint16_t lsm6d_events_dev_read(LSM6D_DEVICE *dev, LSM6D_EVENTS *events);
+
+/* Single-device API - each function operates on lsm6d_default_device */
+void lsm6d_events_configure(const LSM6D_EVENT_CFG *cfg);
+uint16_t lsm6d_events_read(LSM6D_EVENTS *events);
+
+/* Return non-zero if either of the default device's interrupt pins (LSM6D_INT1, LSM6D_INT2) is asserted */
+uint8_t lsm6d_events_pending(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_EVENTS_H */
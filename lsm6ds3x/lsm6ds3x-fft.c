@@ -0,0 +1,411 @@
+/*
+ * Fixed-point FFT vibration analysis for LSM6DS3x FIFO data
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-units.h"
+#include "lsm6ds3x-fft.h"
+
+#define LSM6D_FFT_QUARTER         (1U << (LSM6D_FFT_LOG2_MAX - 2))
+
+/* Largest value that cannot overflow in a butterfly: 32767 / (1 + sqrt(2)) */
+#define LSM6D_FFT_HEADROOM        13572
+
+/* sin(2 pi i / 512) in Q15 for the first quarter wave */
+static const int16_t lsm6d_fft_sin[LSM6D_FFT_QUARTER + 1] = {
+    0, 402, 804, 1206, 1608, 2009, 2410, 2811, 3212, 3612, 4011, 4410,
+    4808, 5205, 5602, 5998, 6393, 6786, 7179, 7571, 7962, 8351, 8739, 9126,
+    9512, 9896, 10278, 10659, 11039, 11417, 11793, 12167, 12539, 12910, 13279, 13645,
+    14010, 14372, 14732, 15090, 15446, 15800, 16151, 16499, 16846, 17189, 17530, 17869,
+    18204, 18537, 18868, 19195, 19519, 19841, 20159, 20475, 20787, 21096, 21403, 21705,
+    22005, 22301, 22594, 22884, 23170, 23452, 23731, 24007, 24279, 24547, 24811, 25072,
+    25329, 25582, 25832, 26077, 26319, 26556, 26790, 27019, 27245, 27466, 27683, 27896,
+    28105, 28310, 28510, 28706, 28898, 29085, 29268, 29447, 29621, 29791, 29956, 30117,
+    30273, 30424, 30571, 30714, 30852, 30985, 31113, 31237, 31356, 31470, 31580, 31685,
+    31785, 31880, 31971, 32057, 32137, 32213, 32285, 32351, 32412, 32469, 32521, 32567,
+    32609, 32646, 32678, 32705, 32728, 32745, 32757, 32765, 32767
+};
+
+/* cos(2 pi m / 512) in Q15 for any m */
+static int16_t lsm6d_fft_cos(uint16_t m) {
+    m &= (4 * LSM6D_FFT_QUARTER) - 1;
+    
+    if (m > 2 * LSM6D_FFT_QUARTER) {
+        m = (4 * LSM6D_FFT_QUARTER) - m;
+    }
+    
+    if (m <= LSM6D_FFT_QUARTER) {
+        return lsm6d_fft_sin[LSM6D_FFT_QUARTER - m];
+    }
+    
+    return -lsm6d_fft_sin[m - LSM6D_FFT_QUARTER];
+}
+
+static uint32_t lsm6d_fft_sqrt(uint64_t x) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    
+    while (bit > x) {
+        bit >>= 2;
+    }
+    
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return (uint32_t)root;
+}
+
+/* Shift n values right until none exceeds limit - returns the shift */
+static uint8_t lsm6d_fft_normalize(int16_t *re, int16_t *im, uint16_t n, int16_t limit) {
+    int32_t max = 0;
+    int32_t v;
+    uint8_t shift = 0;
+    uint16_t i;
+    
+    for (i = 0; i < n; i++) {
+        v = (re[i] < 0) ? -(int32_t)re[i] : re[i];
+        if (v > max) {
+            max = v;
+        }
+        v = (im[i] < 0) ? -(int32_t)im[i] : im[i];
+        if (v > max) {
+            max = v;
+        }
+    }
+    
+    while ((max >> shift) > limit) {
+        shift++;
+    }
+    
+    if (shift) {
+        for (i = 0; i < n; i++) {
+            re[i] >>= shift;
+            im[i] >>= shift;
+        }
+    }
+    
+    return shift;
+}
+
+/*
+ * Radix-2 decimation in time with block floating point - each stage is preceded by
+ * just enough scaling to rule out overflow, so quiet signals keep their resolution
+ */
+uint8_t lsm6d_fft(int16_t *re, int16_t *im, uint8_t log2n) {
+    uint16_t n = 1U << log2n;
+    uint16_t i;
+    uint16_t j;
+    uint16_t k;
+    uint16_t half;
+    uint16_t step;
+    uint16_t bit;
+    int16_t c;
+    int16_t s;
+    int16_t t;
+    int32_t tr;
+    int32_t ti;
+    uint8_t e = 0;
+    
+    /* Bit-reversed reordering */
+    for (i = 1, j = 0; i < n; i++) {
+        for (bit = n >> 1; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        
+        if (i < j) {
+            t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    
+    for (half = 1, step = 2 * LSM6D_FFT_QUARTER; half < n; half <<= 1, step >>= 1) {
+        e += lsm6d_fft_normalize(re, im, n, LSM6D_FFT_HEADROOM);
+        
+        for (k = 0; k < half; k++) {
+            /* Twiddle exp(-j 2 pi k / (2 half)) */
+            c = lsm6d_fft_cos(k * step);
+            s = lsm6d_fft_cos(k * step + 3 * LSM6D_FFT_QUARTER);
+            
+            for (i = k; i < n; i += half << 1) {
+                j = i + half;
+                tr = ((int32_t)re[j] * c + (int32_t)im[j] * s + (1L << 14)) >> 15;
+                ti = ((int32_t)im[j] * c - (int32_t)re[j] * s + (1L << 14)) >> 15;
+                re[j] = (int16_t)(re[i] - tr);
+                im[j] = (int16_t)(im[i] - ti);
+                re[i] = (int16_t)(re[i] + tr);
+                im[i] = (int16_t)(im[i] + ti);
+            }
+        }
+    }
+    
+    return e;
+}
+
+uint8_t lsm6d_fft_window(int16_t *x, uint8_t log2n) {
+    uint16_t n = 1U << log2n;
+    uint16_t step = (4 * LSM6D_FFT_QUARTER) >> log2n;
+    uint16_t i;
+    int32_t sum = 0;
+    int32_t mean;
+    int32_t d;
+    int32_t max = 0;
+    uint8_t shift = 0;
+    
+    for (i = 0; i < n; i++) {
+        sum += x[i];
+    }
+    
+    mean = sum / (int32_t)n;
+    
+    /* Removing the mean can need one more bit than the samples themselves */
+    for (i = 0; i < n; i++) {
+        d = x[i] - mean;
+        if (d < 0) {
+            d = -d;
+        }
+        if (d > max) {
+            max = d;
+        }
+    }
+    
+    if (max > INT16_MAX) {
+        shift = 1;
+    }
+    
+    /* Hann: w[i] = (1 - cos(2 pi i / n)) / 2 */
+    for (i = 0; i < n; i++) {
+        d = (x[i] - mean) >> shift;
+        x[i] = (int16_t)((d * ((32768L - lsm6d_fft_cos(i * step)) >> 1) + (1L << 14)) >> 15);
+    }
+    
+    return shift;
+}
+
+void lsm6d_vib_dev_init(LSM6D_VIB *vib, LSM6D_DEVICE *dev, uint8_t log2n, uint8_t axis, uint8_t odr, const uint16_t *edges_hz, uint8_t bands) {
+    uint8_t i;
+    
+    if ((1U << log2n) > LSM6D_VIB_SIZE) {
+        log2n = 0;
+        while ((2U << log2n) <= LSM6D_VIB_SIZE) {
+            log2n++;
+        }
+    }
+    
+    if (bands > LSM6D_VIB_BANDS) {
+        bands = LSM6D_VIB_BANDS;
+    }
+    
+    vib->dev = dev;
+    vib->log2n = log2n;
+    vib->axis = axis;
+    vib->odr = odr;
+    vib->rate_dhz = lsm6d_units_odr_dhz(odr);
+    vib->bands = bands;
+    vib->fill = 0;
+    
+    for (i = 0; i <= bands; i++) {
+        vib->edges_hz[i] = edges_hz[i];
+    }
+}
+
+void lsm6d_vib_start(LSM6D_VIB *vib) {
+    vib->fill = 0;
+    
+    lsm6d_dev_set_accel_data_rate(vib->dev, vib->odr);
+    lsm6d_dev_fifo_configure(vib->dev, vib->odr, _FIFO_CTRL5_FIFO_CONTINUOUS, _FIFO_CTRL3_DECIMATION_NONE, _FIFO_CTRL3_NOT_IN_FIFO,
+            3U << vib->log2n);
+}
+
+uint16_t lsm6d_vib_push(LSM6D_VIB *vib, const LSM6D_SENSOR_DATA *samples, uint16_t count) {
+    uint16_t n = 1U << vib->log2n;
+    uint16_t used = 0;
+    
+    while (used < count && vib->fill < n) {
+        switch (vib->axis) {
+            case 0:
+                vib->re[vib->fill] = samples[used].xl.x;
+                break;
+            case 1:
+                vib->re[vib->fill] = samples[used].xl.y;
+                break;
+            default:
+                vib->re[vib->fill] = samples[used].xl.z;
+                break;
+        }
+        vib->fill++;
+        used++;
+    }
+    
+    return used;
+}
+
+/* Q8 LSB to ug with the accelerometer multiplier */
+static uint32_t lsm6d_vib_ug(uint64_t q8, uint16_t mult) {
+    return (uint32_t)((q8 * mult * 1000U) >> (8 + LSM6D_UNITS_XL_SHIFT));
+}
+
+/* Q8 RMS from a sum of one-sided bin powers, undoing the Hann window's power gain of 3/8 */
+static uint32_t lsm6d_vib_rms(uint64_t power, uint8_t e, uint8_t log2n, uint16_t mult) {
+    int8_t shift = 16 + 2 * (int8_t)e - 2 * (int8_t)log2n;
+    
+    power = power * 16 / 3;
+    power = (shift >= 0) ? (power << shift) : (power >> -shift);
+    
+    return lsm6d_vib_ug(lsm6d_fft_sqrt(power), mult);
+}
+
+/* Keep the strongest peaks, sorted by magnitude */
+static void lsm6d_vib_peak(uint32_t *mags, uint16_t *bins, int16_t *offsets, uint32_t mag, uint16_t bin, int16_t offset) {
+    uint8_t i = LSM6D_VIB_PEAKS;
+    
+    if (mag <= mags[LSM6D_VIB_PEAKS - 1]) {
+        return;
+    }
+    
+    while (i > 1 && mag > mags[i - 2]) {
+        mags[i - 1] = mags[i - 2];
+        bins[i - 1] = bins[i - 2];
+        offsets[i - 1] = offsets[i - 2];
+        i--;
+    }
+    
+    mags[i - 1] = mag;
+    bins[i - 1] = bin;
+    offsets[i - 1] = offset;
+}
+
+/*
+ * Window and transform the collected samples, then reduce the spectrum to overall and
+ * per-band RMS and the strongest peaks. Peak frequency and amplitude are refined from
+ * the ratio of the peak bin to its larger neighbour, which for a Hann window gives
+ * the offset of the tone from the bin centre.
+ */
+void lsm6d_vib_analyze(LSM6D_VIB *vib, LSM6D_VIB_RESULT *result) {
+    uint16_t n = 1U << vib->log2n;
+    uint16_t mult = lsm6d_units_dev_xl_mult(vib->dev);
+    uint16_t i;
+    uint16_t k;
+    uint8_t band = 0;
+    uint8_t e;
+    uint32_t power;
+    uint64_t total = 0;
+    uint64_t band_power = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c;
+    uint32_t side;
+    int16_t offset;
+    uint32_t mags[LSM6D_VIB_PEAKS];
+    uint16_t bins[LSM6D_VIB_PEAKS];
+    int16_t offsets[LSM6D_VIB_PEAKS];
+    
+    for (i = 0; i < n; i++) {
+        vib->im[i] = 0;
+    }
+    
+    e = lsm6d_fft_window(vib->re, vib->log2n);
+    e += lsm6d_fft(vib->re, vib->im, vib->log2n);
+    vib->fill = 0;
+    
+    for (i = 0; i < LSM6D_VIB_PEAKS; i++) {
+        mags[i] = 0;
+        bins[i] = 0;
+        offsets[i] = 0;
+    }
+    
+    for (i = 0; i < LSM6D_VIB_BANDS; i++) {
+        result->band_ug[i] = 0;
+    }
+    
+    /* Bins 1 to n / 2 - 1 carry power, n / 2 is only needed as a neighbour */
+    for (k = 1; k <= n / 2; k++) {
+        power = (uint32_t)((int32_t)vib->re[k] * vib->re[k]) + (uint32_t)((int32_t)vib->im[k] * vib->im[k]);
+        c = lsm6d_fft_sqrt(power);
+        
+        if (k < n / 2) {
+            total += power;
+            
+            /* Bins below the first edge or at and above the last belong to no band */
+            while (band < vib->bands && (uint32_t)k * vib->rate_dhz >= (uint32_t)vib->edges_hz[band + 1] * 10U * n) {
+                if (band_power) {
+                    result->band_ug[band] = lsm6d_vib_rms(band_power, e, vib->log2n, mult);
+                    band_power = 0;
+                }
+                band++;
+            }
+            if (band < vib->bands && (uint32_t)k * vib->rate_dhz >= (uint32_t)vib->edges_hz[band] * 10U * n) {
+                band_power += power;
+            }
+        }
+        
+        /* Bin k - 1 is a local maximum - bin 1 is skipped as it mostly holds leakage from DC */
+        if (k > 2 && b > a && b >= c) {
+            /* Offset towards the larger neighbour and scalloping loss for the Hann window */
+            side = (a > c) ? a : c;
+            offset = (side * 2 > b) ? (int16_t)(((side * 2 - b) << 8) / (side + b)) : 0;
+            power = (b * (65536UL + (((uint32_t)offset * offset * 182) >> 8))) >> 8;
+            lsm6d_vib_peak(mags, bins, offsets, power, k - 1, (a > c) ? -offset : offset);
+        }
+        
+        a = b;
+        b = c;
+    }
+    
+    if (band < vib->bands && band_power) {
+        result->band_ug[band] = lsm6d_vib_rms(band_power, e, vib->log2n, mult);
+    }
+    
+    result->rms_ug = lsm6d_vib_rms(total, e, vib->log2n, mult);
+    
+    /* Amplitude of a sinusoid is 4 |X| / n with the window's coherent gain of 1/2 */
+    for (i = 0; i < LSM6D_VIB_PEAKS; i++) {
+        if (mags[i] == 0) {
+            result->peak_dhz[i] = 0;
+            result->peak_ug[i] = 0;
+            continue;
+        }
+        result->peak_dhz[i] = (uint16_t)(((((int32_t)bins[i] << 8) + offsets[i]) * (int64_t)vib->rate_dhz) >> (8 + vib->log2n));
+        result->peak_ug[i] = lsm6d_vib_ug(((uint64_t)mags[i] << (2 + e)) >> vib->log2n, mult);
+    }
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+void lsm6d_vib_init(LSM6D_VIB *vib, uint8_t log2n, uint8_t axis, uint8_t odr, const uint16_t *edges_hz, uint8_t bands) {
+    lsm6d_vib_dev_init(vib, &lsm6d_default_device, log2n, axis, odr, edges_hz, bands);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
@@ -0,0 +1,107 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x fixed-point FFT vibration analysis
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_FFT_H
+#define LSM6DS3X_FFT_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Largest transform, log2 - sets the size of the twiddle table */
+#define LSM6D_FFT_LOG2_MAX        9
+
+/* Samples per analysis window (power of two, at most 1 << LSM6D_FFT_LOG2_MAX) */
+#ifndef LSM6D_VIB_SIZE
+#define LSM6D_VIB_SIZE            256
+#endif
+
+/* Frequency bands and spectral peaks reported per window */
+#ifndef LSM6D_VIB_BANDS
+#define LSM6D_VIB_BANDS           8
+#endif
+
+#ifndef LSM6D_VIB_PEAKS
+#define LSM6D_VIB_PEAKS           3
+#endif
+
+typedef struct {
+    LSM6D_DEVICE *dev;
+    uint8_t log2n;
+    uint8_t axis;               /* 0 = x, 1 = y, 2 = z */
+    uint8_t odr;                /* _FIFO_CTRL5_ODR_FIFO_x setting, also used for the accelerometer */
+    uint32_t rate_dhz;          /* Sample rate in 0.1 Hz */
+    uint8_t bands;
+    uint16_t edges_hz[LSM6D_VIB_BANDS + 1];
+    uint16_t fill;
+    int16_t re[LSM6D_VIB_SIZE];
+    int16_t im[LSM6D_VIB_SIZE];
+} LSM6D_VIB;
+
+/* Result of one window - everything in ug RMS except peak amplitudes, which are ug peak */
+typedef struct {
+    uint32_t rms_ug;                        /* All bins except DC */
+    uint32_t band_ug[LSM6D_VIB_BANDS];
+    uint16_t peak_dhz[LSM6D_VIB_PEAKS];     /* Peak frequency in 0.1 Hz, strongest first, 0 if none */
+    uint32_t peak_ug[LSM6D_VIB_PEAKS];
+} LSM6D_VIB_RESULT;
+
+/* In-place radix-2 FFT of Q15 data - returns the exponent e, so the transform is the output * 2^e */
+uint8_t lsm6d_fft(int16_t *re, int16_t *im, uint8_t log2n);
+
+/* Remove the mean and apply a Hann window - returns the exponent of any prescaling */
+uint8_t lsm6d_fft_window(int16_t *x, uint8_t log2n);
+
+/*
+ * Set up an analyzer for 1 << log2n samples of one accelerometer axis of dev at the
+ * FIFO ODR setting odr. bands frequency bands are given by bands + 1 edges in Hz.
+ */
+void lsm6d_vib_dev_init(LSM6D_VIB *vib, LSM6D_DEVICE *dev, uint8_t log2n, uint8_t axis, uint8_t odr, const uint16_t *edges_hz, uint8_t bands);
+
+/* As lsm6d_vib_dev_init, on lsm6d_default_device */
+void lsm6d_vib_init(LSM6D_VIB *vib, uint8_t log2n, uint8_t axis, uint8_t odr, const uint16_t *edges_hz, uint8_t bands);
+
+/*
+ * Run the accelerometer and FIFO (accelerometer only, continuous mode) at the analyzer's ODR,
+ * with the watermark at one window
+ */
+void lsm6d_vib_start(LSM6D_VIB *vib);
+
+/* Collect samples, e.g. from lsm6d_dev_fifo_read - returns the number used, stopping when the window is full */
+uint16_t lsm6d_vib_push(LSM6D_VIB *vib, const LSM6D_SENSOR_DATA *samples, uint16_t count);
+
+#define lsm6d_vib_ready(vib)      ((vib)->fill == (1U << (vib)->log2n))
+
+/* Analyze a full window and start collecting the next one */
+void lsm6d_vib_analyze(LSM6D_VIB *vib, LSM6D_VIB_RESULT *result);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_FFT_H */
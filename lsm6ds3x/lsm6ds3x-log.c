@@ -0,0 +1,459 @@
+/*
+ * Compressed sample log format for LSM6DS3x data
+ * Copyright (c) 2019 David Rice
+ * 
+ * The encoder is meant to run on the MCU: it makes two passes over the block, one
+ * to size both encodings and one to write the chosen one, with no buffer beyond the
+ * output. Cost is linear in the block size and the output never exceeds
+ * LSM6D_LOG_MAX_BLOCK. The decoder is plain C for use on the MCU or a host.
+ * 
+ * Sample-to-sample differences of a high-rate stream are dominated by sensor noise,
+ * so lossless coding saves only about 40%. A ratio of 3x is reached only in the lossy
+ * mode, where the quantization shift drops low bits near the noise floor; see
+ * lsm6ds3x-log.h for its error bound.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-log.h"
+#include "lsm6ds3x-crc.h"
+
+/* Channels */
+#define LSM6D_LOG_CH_TEMP         6
+#define LSM6D_LOG_CH_TS           7
+
+/* Bits moved per step, so the bit accumulator never needs more than 32 bits */
+#define LSM6D_LOG_CHUNK           16
+
+typedef struct {
+    uint8_t *out;
+    uint16_t pos;
+    uint32_t acc;
+    uint8_t bits;
+} LSM6D_LOG_WRITER;
+
+typedef struct {
+    const uint8_t *in;
+    uint16_t pos;
+    uint16_t end;
+    uint32_t acc;
+    uint8_t bits;
+} LSM6D_LOG_READER;
+
+static uint8_t lsm6d_log_present(uint8_t flags, uint8_t ch) {
+    if (ch == LSM6D_LOG_CH_TEMP) {
+        return flags & LSM6D_LOG_TEMP;
+    }
+    
+    if (ch == LSM6D_LOG_CH_TS) {
+        return flags & LSM6D_LOG_TS;
+    }
+    
+    return 1;
+}
+
+/* Quantized value of a sensor channel */
+static int16_t lsm6d_log_sensor(const LSM6D_SENSOR_DATA *sample, uint8_t ch, uint8_t shift) {
+    switch (ch) {
+        case 0: return sample->g.x >> (shift >> 4);
+        case 1: return sample->g.y >> (shift >> 4);
+        case 2: return sample->g.z >> (shift >> 4);
+        case 3: return sample->xl.x >> (shift & 0x0F);
+        case 4: return sample->xl.y >> (shift & 0x0F);
+        case 5: return sample->xl.z >> (shift & 0x0F);
+    }
+    
+    return sample->temp;
+}
+
+/* Store a sensor channel, restoring quantized values to the middle of their step */
+static void lsm6d_log_store(LSM6D_SENSOR_DATA *sample, uint8_t ch, uint8_t shift, int16_t q) {
+    int16_t value = q;
+    
+    if (ch != LSM6D_LOG_CH_TEMP) {
+        shift = (ch < 3) ? shift >> 4 : shift & 0x0F;
+        if (shift) {
+            value = (int16_t)(((int32_t)q << shift) + (1 << (shift - 1)));
+        }
+    }
+    
+    switch (ch) {
+        case 0: sample->g.x = value; break;
+        case 1: sample->g.y = value; break;
+        case 2: sample->g.z = value; break;
+        case 3: sample->xl.x = value; break;
+        case 4: sample->xl.y = value; break;
+        case 5: sample->xl.z = value; break;
+        default: sample->temp = value; break;
+    }
+}
+
+/* Zigzag-encoded difference of channel ch between samples i - 1 and i */
+static uint32_t lsm6d_log_delta(const LSM6D_LOG_HEADER *hdr, const LSM6D_SENSOR_DATA *samples, const uint32_t *timestamps,
+        uint8_t i, uint8_t ch) {
+    int32_t d;
+    
+    if (ch == LSM6D_LOG_CH_TS) {
+        d = (int32_t)(timestamps[i] - timestamps[i - 1] - hdr->ts_step);
+    } else {
+        d = (int32_t)lsm6d_log_sensor(&samples[i], ch, hdr->shift) - lsm6d_log_sensor(&samples[i - 1], ch, hdr->shift);
+    }
+    
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static uint8_t lsm6d_log_width(uint32_t value) {
+    uint8_t width = 0;
+    
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    
+    return width;
+}
+
+static void lsm6d_log_put(LSM6D_LOG_WRITER *w, uint32_t value, uint8_t width) {
+    uint8_t chunk;
+    
+    while (width) {
+        chunk = (width > LSM6D_LOG_CHUNK) ? LSM6D_LOG_CHUNK : width;
+        
+        w->acc |= (value & ((1UL << chunk) - 1)) << w->bits;
+        w->bits += chunk;
+        value >>= chunk;
+        width -= chunk;
+        
+        while (w->bits >= 8) {
+            w->out[w->pos++] = (uint8_t)w->acc;
+            w->acc >>= 8;
+            w->bits -= 8;
+        }
+    }
+}
+
+static void lsm6d_log_put_varint(LSM6D_LOG_WRITER *w, uint32_t value) {
+    while (value >= 0x80) {
+        w->out[w->pos++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    
+    w->out[w->pos++] = (uint8_t)value;
+}
+
+static void lsm6d_log_put_word(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+/*
+ * Encode count samples (1..LSM6D_LOG_MAX_SAMPLES) into out, which must hold
+ * LSM6D_LOG_MAX_BLOCK(count) bytes. The caller fills in ctrl1_xl, ctrl2_g, shift and
+ * the LSM6D_LOG_TEMP and LSM6D_LOG_TS_HR flags.
+ * 
+ * With timestamps (e.g. from lsm6d_fifo_read_timed) every timestamp is kept exactly;
+ * ts_step is the nominal sample interval and is taken from the block if left at 0.
+ * Without timestamps the caller also sets ts_base and ts_step.
+ * 
+ * Returns the block length.
+ */
+uint16_t lsm6d_log_encode(LSM6D_LOG_HEADER *hdr, const LSM6D_SENSOR_DATA *samples, const uint32_t *timestamps,
+        uint8_t count, uint8_t method, uint8_t *out) {
+    LSM6D_LOG_WRITER w;
+    uint8_t width[LSM6D_LOG_CHANNELS];
+    uint32_t varint = 0;
+    uint32_t packed = 0;
+    uint32_t zz;
+    uint8_t ch;
+    uint8_t i;
+    
+    hdr->count = count;
+    hdr->flags &= ~(LSM6D_LOG_PACKED | LSM6D_LOG_TS);
+    
+    if (timestamps) {
+        hdr->flags |= LSM6D_LOG_TS;
+        hdr->ts_base = timestamps[0];
+        
+        if (hdr->ts_step == 0 && count > 1) {
+            hdr->ts_step = (uint16_t)((timestamps[count - 1] - timestamps[0]) / (count - 1));
+        }
+    }
+    
+    /* Size both encodings */
+    for (ch = 0; ch < LSM6D_LOG_CHANNELS; ch++) {
+        width[ch] = 0;
+        
+        if (!lsm6d_log_present(hdr->flags, ch)) {
+            continue;
+        }
+        
+        for (i = 1; i < count; i++) {
+            zz = lsm6d_log_delta(hdr, samples, timestamps, i, ch);
+            
+            if (lsm6d_log_width(zz) > width[ch]) {
+                width[ch] = lsm6d_log_width(zz);
+            }
+            
+            varint += zz ? (lsm6d_log_width(zz) + 6) / 7 : 1;
+        }
+        
+        packed += 8 + (uint32_t)width[ch] * (count - 1);
+    }
+    
+    if (method == LSM6D_LOG_BITPACK || (method == LSM6D_LOG_AUTO && (packed + 7) / 8 < varint)) {
+        hdr->flags |= LSM6D_LOG_PACKED;
+    }
+    
+    out[0] = LSM6D_LOG_MAGIC0;
+    out[1] = LSM6D_LOG_MAGIC1;
+    out[2] = hdr->flags;
+    out[3] = count;
+    out[4] = hdr->ctrl1_xl;
+    out[5] = hdr->ctrl2_g;
+    out[6] = hdr->shift;
+    lsm6d_log_put_word(&out[7], (uint16_t)hdr->ts_base);
+    lsm6d_log_put_word(&out[9], (uint16_t)(hdr->ts_base >> 16));
+    lsm6d_log_put_word(&out[11], hdr->ts_step);
+    
+    w.out = out;
+    w.pos = LSM6D_LOG_HEADER_LEN;
+    w.acc = 0;
+    w.bits = 0;
+    
+    /* First sample as it is - its timestamp is ts_base */
+    for (ch = 0; ch < LSM6D_LOG_CH_TS; ch++) {
+        if (lsm6d_log_present(hdr->flags, ch)) {
+            lsm6d_log_put_word(&out[w.pos], (uint16_t)lsm6d_log_sensor(&samples[0], ch, hdr->shift));
+            w.pos += 2;
+        }
+    }
+    
+    if (hdr->flags & LSM6D_LOG_PACKED) {
+        for (ch = 0; ch < LSM6D_LOG_CHANNELS; ch++) {
+            if (lsm6d_log_present(hdr->flags, ch)) {
+                out[w.pos++] = width[ch];
+            }
+        }
+    }
+    
+    for (i = 1; i < count; i++) {
+        for (ch = 0; ch < LSM6D_LOG_CHANNELS; ch++) {
+            if (!lsm6d_log_present(hdr->flags, ch)) {
+                continue;
+            }
+            
+            zz = lsm6d_log_delta(hdr, samples, timestamps, i, ch);
+            
+            if (hdr->flags & LSM6D_LOG_PACKED) {
+                lsm6d_log_put(&w, zz, width[ch]);
+            } else {
+                lsm6d_log_put_varint(&w, zz);
+            }
+        }
+    }
+    
+    if (w.bits) {
+        out[w.pos++] = (uint8_t)w.acc;
+    }
+    
+    lsm6d_log_put_word(&out[13], w.pos - LSM6D_LOG_HEADER_LEN);
+    lsm6d_log_put_word(&out[w.pos], lsm6d_crc16(out, w.pos));
+    
+    return w.pos + 2;
+}
+
+static uint16_t lsm6d_log_get_word(const uint8_t *in) {
+    return in[0] | ((uint16_t)in[1] << 8);
+}
+
+/* Returns 0 if the payload ends first */
+static uint8_t lsm6d_log_get(LSM6D_LOG_READER *r, uint8_t width, uint32_t *value) {
+    uint8_t chunk;
+    uint8_t done = 0;
+    
+    *value = 0;
+    
+    while (done < width) {
+        chunk = (width - done > LSM6D_LOG_CHUNK) ? LSM6D_LOG_CHUNK : width - done;
+        
+        while (r->bits < chunk) {
+            if (r->pos >= r->end) {
+                return 0;
+            }
+            r->acc |= (uint32_t)r->in[r->pos++] << r->bits;
+            r->bits += 8;
+        }
+        
+        *value |= (r->acc & ((1UL << chunk) - 1)) << done;
+        r->acc >>= chunk;
+        r->bits -= chunk;
+        done += chunk;
+    }
+    
+    return 1;
+}
+
+static uint8_t lsm6d_log_get_varint(LSM6D_LOG_READER *r, uint32_t *value) {
+    uint8_t shift = 0;
+    uint8_t byte;
+    
+    *value = 0;
+    
+    do {
+        if (r->pos >= r->end || shift > 28) {
+            return 0;
+        }
+        byte = r->in[r->pos++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    
+    return 1;
+}
+
+/*
+ * Decode the block at the start of in (len bytes available). out and timestamps
+ * (may be NULL) must hold LSM6D_LOG_MAX_SAMPLES entries.
+ * 
+ * On LSM6D_LOG_OK *used is the block length. On LSM6D_LOG_BAD it is 1, so a reader
+ * of a damaged log steps forward to look for the next block.
+ */
+uint8_t lsm6d_log_decode(const uint8_t *in, uint16_t len, LSM6D_LOG_HEADER *hdr, LSM6D_SENSOR_DATA *out,
+        uint32_t *timestamps, uint16_t *used) {
+    LSM6D_LOG_READER r;
+    uint8_t width[LSM6D_LOG_CHANNELS];
+    int16_t q[LSM6D_LOG_CH_TS];
+    uint32_t ts;
+    uint32_t zz;
+    int32_t d;
+    uint16_t payload;
+    uint8_t ch;
+    uint8_t i;
+    
+    *used = 1;
+    
+    if (len < 2) {
+        return LSM6D_LOG_SHORT;
+    }
+    
+    if (in[0] != LSM6D_LOG_MAGIC0 || in[1] != LSM6D_LOG_MAGIC1) {
+        return LSM6D_LOG_BAD;
+    }
+    
+    if (len < LSM6D_LOG_HEADER_LEN) {
+        return LSM6D_LOG_SHORT;
+    }
+    
+    payload = lsm6d_log_get_word(&in[13]);
+    if (in[3] == 0 || payload > LSM6D_LOG_MAX_BLOCK(in[3]) - LSM6D_LOG_HEADER_LEN - 2) {
+        return LSM6D_LOG_BAD;
+    }
+    
+    if (len < LSM6D_LOG_HEADER_LEN + payload + 2) {
+        return LSM6D_LOG_SHORT;
+    }
+    
+    if (lsm6d_crc16(in, LSM6D_LOG_HEADER_LEN + payload) != lsm6d_log_get_word(&in[LSM6D_LOG_HEADER_LEN + payload])) {
+        return LSM6D_LOG_BAD;
+    }
+    
+    hdr->flags = in[2];
+    hdr->count = in[3];
+    hdr->ctrl1_xl = in[4];
+    hdr->ctrl2_g = in[5];
+    hdr->shift = in[6];
+    hdr->ts_base = lsm6d_log_get_word(&in[7]) | ((uint32_t)lsm6d_log_get_word(&in[9]) << 16);
+    hdr->ts_step = lsm6d_log_get_word(&in[11]);
+    
+    r.in = in;
+    r.pos = LSM6D_LOG_HEADER_LEN;
+    r.end = LSM6D_LOG_HEADER_LEN + payload;
+    r.acc = 0;
+    r.bits = 0;
+    
+    for (ch = 0; ch < LSM6D_LOG_CH_TS; ch++) {
+        q[ch] = 0;
+        
+        if (lsm6d_log_present(hdr->flags, ch)) {
+            if (r.pos + 2 > r.end) {
+                return LSM6D_LOG_BAD;
+            }
+            q[ch] = (int16_t)lsm6d_log_get_word(&in[r.pos]);
+            r.pos += 2;
+        }
+        
+        lsm6d_log_store(&out[0], ch, hdr->shift, q[ch]);
+    }
+    
+    ts = hdr->ts_base;
+    
+    if (timestamps) {
+        timestamps[0] = ts;
+    }
+    
+    if (hdr->flags & LSM6D_LOG_PACKED) {
+        for (ch = 0; ch < LSM6D_LOG_CHANNELS; ch++) {
+            width[ch] = 0;
+            
+            if (lsm6d_log_present(hdr->flags, ch)) {
+                if (r.pos >= r.end || in[r.pos] > 32) {
+                    return LSM6D_LOG_BAD;
+                }
+                width[ch] = in[r.pos++];
+            }
+        }
+    }
+    
+    for (i = 1; i < hdr->count; i++) {
+        ts += hdr->ts_step;
+        
+        for (ch = 0; ch < LSM6D_LOG_CHANNELS; ch++) {
+            if (!lsm6d_log_present(hdr->flags, ch)) {
+                continue;
+            }
+            
+            if (!((hdr->flags & LSM6D_LOG_PACKED) ? lsm6d_log_get(&r, width[ch], &zz) : lsm6d_log_get_varint(&r, &zz))) {
+                return LSM6D_LOG_BAD;
+            }
+            
+            d = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+            
+            if (ch == LSM6D_LOG_CH_TS) {
+                ts += (uint32_t)d;
+            } else {
+                q[ch] = (int16_t)(q[ch] + d);
+            }
+        }
+        
+        for (ch = 0; ch < LSM6D_LOG_CH_TS; ch++) {
+            lsm6d_log_store(&out[i], ch, hdr->shift, q[ch]);
+        }
+        
+        if (timestamps) {
+            timestamps[i] = ts;
+        }
+    }
+    
+    *used = LSM6D_LOG_HEADER_LEN + payload + 2;
+    
+    return LSM6D_LOG_OK;
+}
@@ -0,0 +1,115 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x compressed sample log format
+ * Copyright (c) 2019 David Rice
+ * 
+ * A block holds up to 255 samples:
+ * 
+ *   0   'L', '6'
+ *   2   flags (LSM6D_LOG_x)
+ *   3   sample count
+ *   4   CTRL1_XL, CTRL2_G (ODR and full scale of the data)
+ *   6   quantization shift - accelerometer in bits 3:0, gyro in bits 7:4
+ *   7   timestamp of the first sample (32 bits), nominal timestamp step (16 bits)
+ *   13  payload length (16 bits)
+ *   15  payload
+ *   ..  CRC-16/CCITT over everything before it
+ * 
+ * Multi-byte fields are little-endian. The payload holds the first sample as 16-bit
+ * words, then each later sample as per-channel differences from the one before it,
+ * zigzag encoded, either as varints or bit-packed at a per-channel width stored
+ * ahead of the bit stream. Channel order is gyro x/y/z, accelerometer x/y/z, then
+ * temperature and timestamp (difference minus the nominal step) when present.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_LOG_H
+#define LSM6DS3X_LOG_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Block flags */
+#define LSM6D_LOG_PACKED          0x01  /* Bit-packed differences (otherwise varints) */
+#define LSM6D_LOG_TEMP            0x02  /* Temperature channel present */
+#define LSM6D_LOG_TS              0x04  /* Timestamp channel present (otherwise base + n * step) */
+#define LSM6D_LOG_TS_HR           0x08  /* Timestamps in LSM6D_TIMESTAMP_LSB_US_HR units */
+
+/* Encoding methods for lsm6d_log_encode */
+#define LSM6D_LOG_VARINT          0
+#define LSM6D_LOG_BITPACK         1
+#define LSM6D_LOG_AUTO            2     /* Whichever is smaller for this block */
+
+/* Decoder results */
+#define LSM6D_LOG_OK              0
+#define LSM6D_LOG_SHORT           1     /* Block incomplete - supply more data */
+#define LSM6D_LOG_BAD             2     /* Not a valid block - skip *used bytes and retry */
+
+#define LSM6D_LOG_MAGIC0          'L'
+#define LSM6D_LOG_MAGIC1          '6'
+#define LSM6D_LOG_HEADER_LEN      15
+#define LSM6D_LOG_MAX_SAMPLES     255
+#define LSM6D_LOG_CHANNELS        8
+
+/* 
+ * Quantization shift (LSM6D_LOG_HEADER.shift)
+ * 
+ * LSM6D_LOG_LOSSLESS keeps every bit. Lossless blocks of noisy high-rate data come out
+ * at about 1.75x, since the sample-to-sample noise itself has to be stored.
+ * 
+ * Any other shift makes the block lossy: the encoder drops the low bits of each gyro
+ * (bits 7:4) and accelerometer (bits 3:0) value and the decoder restores the middle of
+ * the dropped range, so every decoded value is within LSM6D_LOG_MAX_ERROR(bits) LSB of
+ * the original. Temperature and timestamps are always lossless. The 3x target needs a
+ * shift of 4 on both sensors - at most 8 LSB of error, or 0.49 mg at 2 g and 70 mdps at
+ * 245 dps, well under the rms sensor noise at 1.66 kHz.
+ */
+#define LSM6D_LOG_LOSSLESS        0x00
+#define LSM6D_LOG_SHIFT(g_bits, xl_bits) ((uint8_t)(((g_bits) << 4) | (xl_bits)))
+#define LSM6D_LOG_MAX_ERROR(bits) ((bits) ? (1U << ((bits) - 1)) : 0U)
+
+/* Largest block for count samples - worst case 3 bytes per sensor difference, 5 per timestamp, plus packed widths */
+#define LSM6D_LOG_MAX_BLOCK(count) (LSM6D_LOG_HEADER_LEN + 2 + 2 * 7 + LSM6D_LOG_CHANNELS + ((count) - 1) * (7 * 3 + 5))
+
+typedef struct {
+    uint8_t flags;
+    uint8_t count;
+    uint8_t ctrl1_xl;
+    uint8_t ctrl2_g;
+    uint8_t shift;              /* LSM6D_LOG_LOSSLESS, or LSM6D_LOG_SHIFT(g_bits, xl_bits) for lossy blocks */
+    uint32_t ts_base;
+    uint16_t ts_step;
+} LSM6D_LOG_HEADER;
+
+uint16_t lsm6d_log_encode(LSM6D_LOG_HEADER *hdr, const LSM6D_SENSOR_DATA *samples, const uint32_t *timestamps,
+        uint8_t count, uint8_t method, uint8_t *out);
+uint8_t lsm6d_log_decode(const uint8_t *in, uint16_t len, LSM6D_LOG_HEADER *hdr, LSM6D_SENSOR_DATA *out,
+        uint32_t *timestamps, uint16_t *used);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_LOG_H */
@@ -0,0 +1,166 @@
+/*
+ * Fixed-point unit conversion for ST Microelectronics LSM6DS3x data
+ * Copyright (c) 2019 David Rice
+ * 
+ * Raw values are scaled with one integer multiply and shift per axis. The multiplier
+ * is fixed at compile time (LSM6D_UNITS_FS_XL / LSM6D_UNITS_FS_G) or looked up once
+ * per call from the register shadow, so no SPI traffic is needed.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-units.h"
+
+/* Allow the compiler to vectorize the conversion loops where supported */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define LSM6D_RESTRICT            restrict
+#else
+#define LSM6D_RESTRICT
+#endif
+
+/* Output data rates in 0.1 Hz for ODR_XL / ODR_G settings 1 to 10 */
+static const uint32_t lsm6d_units_odr[_CTRL1_XL_ODR_XL_6_66KHZ] = {
+    125, 260, 520, 1040, 2080, 4160, 8330, 16600, 33300, 66600
+};
+
+/* Multipliers indexed by FS_XL setting */
+static const uint16_t lsm6d_units_xl[4] = {
+    LSM6D_UNITS_XL_2G,          /* 0b00 */
+    LSM6D_UNITS_XL_16G,         /* 0b01 */
+    LSM6D_UNITS_XL_4G,          /* 0b10 */
+    LSM6D_UNITS_XL_8G           /* 0b11 */
+};
+
+/* Multipliers indexed by FS_125 << 2 | FS_G setting */
+static const uint16_t lsm6d_units_g[5] = {
+    LSM6D_UNITS_G_245DPS,
+    LSM6D_UNITS_G_500DPS,
+    LSM6D_UNITS_G_1000DPS,
+    LSM6D_UNITS_G_2000DPS,
+    LSM6D_UNITS_G_125DPS
+};
+
+/* Return output data rate in 0.1 Hz for an ODR_XL / ODR_G setting, 0 for power down */
+uint32_t lsm6d_units_odr_dhz(uint8_t odr) {
+    if (odr < _CTRL1_XL_ODR_XL_13HZ || odr > _CTRL1_XL_ODR_XL_6_66KHZ) {
+        return 0;
+    }
+    
+    return lsm6d_units_odr[odr - 1];
+}
+
+/* Return Q16 mg/LSB multiplier for the scale set in a CTRL1_XL value */
+uint16_t lsm6d_units_xl_mult_reg(uint8_t ctrl1_xl) {
+    return lsm6d_units_xl[(ctrl1_xl & _CTRL1_XL_FS_XL_MASK) >> _CTRL1_XL_FS_XL_POSN];
+}
+
+/* Return Q3 mdps/LSB multiplier for the scale set in a CTRL2_G value */
+uint16_t lsm6d_units_g_mult_reg(uint8_t ctrl2_g) {
+    if (ctrl2_g & _CTRL2_G_FS_125_MASK) {
+        return lsm6d_units_g[LSM6D_UNITS_FS_125];
+    }
+    
+    return lsm6d_units_g[(ctrl2_g & _CTRL2_G_FS_G_MASK) >> _CTRL2_G_FS_G_POSN];
+}
+
+/* Return Q16 mg/LSB multiplier for the device's current accelerometer scale */
+uint16_t lsm6d_units_dev_xl_mult(LSM6D_DEVICE *dev) {
+#ifdef LSM6D_UNITS_FS_XL
+    (void)dev;
+    return lsm6d_units_xl[LSM6D_UNITS_FS_XL];
+#else
+    return lsm6d_units_xl_mult_reg(lsm6d_dev_get_config_value(dev, LSM6D_CTRL1_XL));
+#endif
+}
+
+/* Return Q3 mdps/LSB multiplier for the device's current gyro scale */
+uint16_t lsm6d_units_dev_g_mult(LSM6D_DEVICE *dev) {
+#ifdef LSM6D_UNITS_FS_G
+    (void)dev;
+    return lsm6d_units_g[LSM6D_UNITS_FS_G];
+#else
+    return lsm6d_units_g_mult_reg(lsm6d_dev_get_config_value(dev, LSM6D_CTRL2_G));
+#endif
+}
+
+/* Convert count raw accelerometer values to mg (rounded) */
+void lsm6d_units_dev_accel(LSM6D_DEVICE *dev, const int16_t *LSM6D_RESTRICT raw, int16_t *LSM6D_RESTRICT mg, uint16_t count) {
+    int32_t mult = lsm6d_units_dev_xl_mult(dev);
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        mg[i] = (int16_t)((raw[i] * mult + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT);
+    }
+}
+
+/* Convert count raw gyro values to mdps (rounded) */
+void lsm6d_units_dev_gyro(LSM6D_DEVICE *dev, const int16_t *LSM6D_RESTRICT raw, int32_t *LSM6D_RESTRICT mdps, uint16_t count) {
+    int32_t mult = lsm6d_units_dev_g_mult(dev);
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        mdps[i] = (raw[i] * mult + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT;
+    }
+}
+
+/* Convert count complete samples from the device, e.g. from lsm6d_dev_fifo_read */
+void lsm6d_units_dev_convert(LSM6D_DEVICE *dev, const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count) {
+    int32_t xl = lsm6d_units_dev_xl_mult(dev);
+    int32_t g = lsm6d_units_dev_g_mult(dev);
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        out[i].temp = lsm6d_units_temp(in[i].temp);
+        
+        out[i].xl[0] = (int16_t)((in[i].xl.x * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT);
+        out[i].xl[1] = (int16_t)((in[i].xl.y * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT);
+        out[i].xl[2] = (int16_t)((in[i].xl.z * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT);
+        
+        out[i].g[0] = (in[i].g.x * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT;
+        out[i].g[1] = (in[i].g.y * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT;
+        out[i].g[2] = (in[i].g.z * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT;
+    }
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+uint16_t lsm6d_units_xl_mult(void) {
+    return lsm6d_units_dev_xl_mult(&lsm6d_default_device);
+}
+
+uint16_t lsm6d_units_g_mult(void) {
+    return lsm6d_units_dev_g_mult(&lsm6d_default_device);
+}
+
+void lsm6d_units_accel(const int16_t *raw, int16_t *mg, uint16_t count) {
+    lsm6d_units_dev_accel(&lsm6d_default_device, raw, mg, count);
+}
+
+void lsm6d_units_gyro(const int16_t *raw, int32_t *mdps, uint16_t count) {
+    lsm6d_units_dev_gyro(&lsm6d_default_device, raw, mdps, count);
+}
+
+void lsm6d_units_convert(const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count) {
+    lsm6d_units_dev_convert(&lsm6d_default_device, in, out, count);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
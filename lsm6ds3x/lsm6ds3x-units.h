@@ -0,0 +1,102 @@
+/*
+ * Constant definitions and function prototypes for
+ * LSM6DS3x fixed-point unit conversion
+ * Copyright (c) 2019 David Rice
+ * 
+ * Optional definitions (in lsm6ds3x-cfg.h):
+ * LSM6D_UNITS_FS_XL - Fixed _CTRL1_XL_FS_XL_x setting; if not defined the scale is taken from the register shadow
+ * LSM6D_UNITS_FS_G - Fixed _CTRL2_G_FS_G_x setting, or LSM6D_UNITS_FS_125; as above
+ * A fixed setting applies to every device; otherwise each device's own shadow is used.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_UNITS_H
+#define LSM6DS3X_UNITS_H
+
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Gyro scale setting for LSM6D_UNITS_FS_G meaning CTRL2_G FS_125 is set */
+#define LSM6D_UNITS_FS_125        0b100
+
+/*
+ * Accelerometer multipliers in mg per LSB, Q16 (0.061, 0.122, 0.244, 0.488 mg/LSB).
+ * Product with a raw value stays within 31 bits.
+ */
+#define LSM6D_UNITS_XL_2G         3998U
+#define LSM6D_UNITS_XL_4G         7995U
+#define LSM6D_UNITS_XL_8G         15991U
+#define LSM6D_UNITS_XL_16G        31982U
+#define LSM6D_UNITS_XL_SHIFT      16
+
+/*
+ * Gyro multipliers in mdps per LSB, Q3 (4.375, 8.75, 17.5, 35, 70 mdps/LSB).
+ * The multipliers are exact; results are rounded to the nearest mdps.
+ */
+#define LSM6D_UNITS_G_125DPS      35U
+#define LSM6D_UNITS_G_245DPS      70U
+#define LSM6D_UNITS_G_500DPS      140U
+#define LSM6D_UNITS_G_1000DPS     280U
+#define LSM6D_UNITS_G_2000DPS     560U
+#define LSM6D_UNITS_G_SHIFT       3
+
+/* Temperature in 0.01 degC: 25 degC at zero, 16 LSB/degC */
+#define LSM6D_UNITS_TEMP_OFFSET   2500
+#define lsm6d_units_temp(raw)     ((int16_t)(LSM6D_UNITS_TEMP_OFFSET + (((int32_t)(raw) * 25) >> 2)))
+
+/* Sample converted to engineering units */
+typedef struct {
+    int16_t temp;               /* 0.01 degC */
+    int16_t xl[3];              /* mg */
+    int32_t g[3];               /* mdps */
+} LSM6D_SENSOR_UNITS;
+
+/* Output data rate in 0.1 Hz for an ODR_XL / ODR_G setting, 0 for power down or an invalid setting */
+uint32_t lsm6d_units_odr_dhz(uint8_t odr);
+
+uint16_t lsm6d_units_xl_mult_reg(uint8_t ctrl1_xl);
+uint16_t lsm6d_units_g_mult_reg(uint8_t ctrl2_g);
+
+/* Conversions using the full-scale settings of a given device, e.g. one in an LSM6D_ARRAY */
+uint16_t lsm6d_units_dev_xl_mult(LSM6D_DEVICE *dev);
+uint16_t lsm6d_units_dev_g_mult(LSM6D_DEVICE *dev);
+
+void lsm6d_units_dev_accel(LSM6D_DEVICE *dev, const int16_t *raw, int16_t *mg, uint16_t count);
+void lsm6d_units_dev_gyro(LSM6D_DEVICE *dev, const int16_t *raw, int32_t *mdps, uint16_t count);
+void lsm6d_units_dev_convert(LSM6D_DEVICE *dev, const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count);
+
+/* Single-device API - each function uses the settings of lsm6d_default_device */
+uint16_t lsm6d_units_xl_mult(void);
+uint16_t lsm6d_units_g_mult(void);
+
+void lsm6d_units_accel(const int16_t *raw, int16_t *mg, uint16_t count);
+void lsm6d_units_gyro(const int16_t *raw, int32_t *mdps, uint16_t count);
+void lsm6d_units_convert(const LSM6D_SENSOR_DATA *in, LSM6D_SENSOR_UNITS *out, uint16_t count);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LSM6DS3X_UNITS_H */
@@ -9,7 +9,19 @@
  * LSM6D_INT2 - Bit value for I/O pin input for INT2
  * LSM6D_SPI_TRANSFER(x) - Transfer one byte to/from SPI bus without changing CSN
  * 
+ * Optional definitions:
+ * LSM6D_SPI_TRANSFER_BLOCK(buf, len) - Clock len bytes in to buf (e.g. by DMA) without changing CSN,
+ *                                      returning when the transfer is complete
+ * LSM6D_FIFO_CHUNK - Number of FIFO words read per block transfer (default 16)
+ * LSM6D_MEMORY_BARRIER() - Compiler barrier between filling a queue slot and publishing it
+ *                          (default for GCC-compatible compilers, empty otherwise)
+ * 
  * Configuration is usually located in lsm6ds3x-cfg.h in the same folder with the main project
+ * 
+ * The SPI macros above are only used by lsm6d_default_device, which backs the original
+ * single-device lsm6d_* API. Additional devices are described by their own LSM6D_DEVICE
+ * with callbacks for chip select and the SPI bus, and are driven with the lsm6d_dev_* API.
+ * Define LSM6D_NO_DEFAULT_DEVICE to leave out the default instance and the SPI macros.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -31,232 +43,962 @@
  */ 
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "lsm6ds3x.h"
 #include "lsm6ds3x-cfg.h"
 
-void lsm6d_set_register_value(uint8_t addr, uint8_t value)
+#ifndef LSM6D_FIFO_CHUNK
+#define LSM6D_FIFO_CHUNK          16
+#endif
+
+/* Data sets stored in the FIFO, in the order they appear within one sample */
+#define LSM6D_FIFO_SET_G          0b001
+#define LSM6D_FIFO_SET_XL         0b010
+#define LSM6D_FIFO_SET_TS         0b100
+
+#ifndef LSM6D_MEMORY_BARRIER
+#ifdef __GNUC__
+#define LSM6D_MEMORY_BARRIER()    __asm__ __volatile__("" ::: "memory")
+#else
+#define LSM6D_MEMORY_BARRIER()
+#endif
+#endif
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+/* Bindings for the default instance */
+static void lsm6d_default_cs(uint8_t active)
 {
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_WRITE | addr);
-    LSM6D_SPI_TRANSFER(value);
-    LSM6D_SPI_IDLE();
+    if (active) {
+        LSM6D_SPI_ACTIVE();
+    } else {
+        LSM6D_SPI_IDLE();
+    }
 }
 
-void lsm6d_set_register_bits(uint8_t addr, uint8_t bits) {
-    uint8_t temp;
- 
-    temp = lsm6d_get_register_value(addr);
+static uint8_t lsm6d_default_xfer_spi(uint8_t data)
+{
+    return LSM6D_SPI_TRANSFER(data);
+}
+
+#ifdef LSM6D_SPI_TRANSFER_BLOCK
+static void lsm6d_default_xfer_block(uint8_t *buffer, uint16_t len)
+{
+    LSM6D_SPI_TRANSFER_BLOCK(buffer, len);
+}
+#endif
+
+LSM6D_DEVICE lsm6d_default_device = {
+    lsm6d_default_cs,
+    lsm6d_default_xfer_spi,
+#ifdef LSM6D_SPI_TRANSFER_BLOCK
+    lsm6d_default_xfer_block,
+#else
+    NULL,
+#endif
+    {{0}, {0}, {0}, {0}},       /* shadow */
+    0,                          /* shadow_valid */
+    {0},                        /* fifo */
+    0,                          /* events_enabled */
+    0,                          /* acq_source */
+    0,                          /* acq_head */
+    0,                          /* acq_tail */
+    0,                          /* acq_overflow_events */
+    {{0}}                       /* acq_queue */
+};
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
+
+/* Register ranges held in the configuration shadow, in LSM6D_PROFILE order */
+static const uint8_t lsm6d_shadow_blocks[LSM6D_PROFILE_BLOCKS][2] = {
+    {LSM6D_FIFO_CTRL1, 6},      /* FIFO_CTRL1..FIFO_CTRL5, ORIENT_CFG_G */
+    {LSM6D_INT1_CTRL, 2},       /* INT1_CTRL, INT2_CTRL */
+    {LSM6D_CTRL1_XL, 10},       /* CTRL1_XL..CTRL10_C */
+    {LSM6D_TAP_CFG, 8}          /* TAP_CFG..MD2_CFG */
+};
+
+/* Return offset of register within LSM6D_PROFILE, or -1 if it is not shadowed */
+static int8_t lsm6d_shadow_index(uint8_t addr) {
+    uint8_t block;
+    uint8_t offset = 0;
     
-    temp = temp | bits;
+    for (block = 0; block < LSM6D_PROFILE_BLOCKS; block++) {
+        if (addr >= lsm6d_shadow_blocks[block][0] && addr < lsm6d_shadow_blocks[block][0] + lsm6d_shadow_blocks[block][1]) {
+            return offset + (addr - lsm6d_shadow_blocks[block][0]);
+        }
+        offset += lsm6d_shadow_blocks[block][1];
+    }
     
-    lsm6d_set_register_value(addr, temp);
+    return -1;
 }
 
-void lsm6d_clear_register_bits(uint8_t addr, uint8_t bits) {
-    uint8_t temp;
+/* Strip bits that clear themselves after being written so they are not written again */
+static uint8_t lsm6d_shadow_value(uint8_t addr, uint8_t value) {
+    if (addr == LSM6D_CTRL3_C) {
+        value &= ~(_CTRL3_C_SW_RESET_MASK | _CTRL3_C_BOOT_MASK);
+    } else if (addr == LSM6D_CTRL10_C) {
+        value &= ~_CTRL10_C_PEDO_RST_STEP_MASK;
+    }
     
-    temp = lsm6d_get_register_value(addr);
+    return value;
+}
+
+/* Read every shadowed register range from the device */
+void lsm6d_dev_shadow_sync(LSM6D_DEVICE *dev) {
+    uint8_t *shadow = (uint8_t *)&dev->shadow;
+    uint8_t block;
     
-    temp = temp & ~bits;
+    for (block = 0; block < LSM6D_PROFILE_BLOCKS; block++) {
+        lsm6d_dev_get_register_multi(dev, lsm6d_shadow_blocks[block][0], shadow, lsm6d_shadow_blocks[block][1]);
+        shadow += lsm6d_shadow_blocks[block][1];
+    }
     
-    lsm6d_set_register_value(addr, temp);
+    dev->shadow_valid = 1;
 }
 
-void lsm6d_set_accel_data_rate(uint8_t rate) {
-    uint8_t temp;
+void lsm6d_dev_set_register_value(LSM6D_DEVICE *dev, uint8_t addr, uint8_t value)
+{
+    int8_t index;
     
-    temp = lsm6d_get_register_value(LSM6D_CTRL1_XL);
+    dev->cs(1);
+    dev->xfer_spi(LSM6D_SPI_WRITE | addr);
+    dev->xfer_spi(value);
+    dev->cs(0);
     
-    temp &= ~_CTRL1_XL_ODR_XL_MASK;
-    temp |= rate << _CTRL1_XL_ODR_XL_POSN;
-            
-    lsm6d_set_register_value(LSM6D_CTRL1_XL, temp);
+    if (addr == LSM6D_CTRL3_C && (value & (_CTRL3_C_SW_RESET_MASK | _CTRL3_C_BOOT_MASK))) {
+        /* Registers return to their defaults */
+        dev->shadow_valid = 0;
+    } else if (dev->shadow_valid && (index = lsm6d_shadow_index(addr)) >= 0) {
+        ((uint8_t *)&dev->shadow)[index] = lsm6d_shadow_value(addr, value);
+    }
 }
 
-void lsm6d_set_gyro_data_rate(uint8_t rate) {
-    uint8_t temp;
+/* Return register value from the shadow where possible, otherwise from the device */
+uint8_t lsm6d_dev_get_config_value(LSM6D_DEVICE *dev, uint8_t addr) {
+    int8_t index = lsm6d_shadow_index(addr);
     
-    temp = lsm6d_get_register_value(LSM6D_CTRL2_G);
+    if (index < 0) {
+        return lsm6d_dev_get_register_value(dev, addr);
+    }
     
-    temp &= ~_CTRL2_G_ODR_G_MASK;
-    temp |= rate << _CTRL2_G_ODR_G_POSN;
-            
-    lsm6d_set_register_value(LSM6D_CTRL2_G, temp);
+    if (!dev->shadow_valid) {
+        lsm6d_dev_shadow_sync(dev);
+    }
+    
+    return ((uint8_t *)&dev->shadow)[index];
 }
 
-void lsm6d_set_accel_scale(uint8_t scale) {
+/* Replace the masked field of a register - only a write is needed for shadowed registers */
+static void lsm6d_update_register(LSM6D_DEVICE *dev, uint8_t addr, uint8_t mask, uint8_t value) {
     uint8_t temp;
     
-    temp = lsm6d_get_register_value(LSM6D_CTRL1_XL);
+    temp = lsm6d_dev_get_config_value(dev, addr);
     
-    temp &= ~_CTRL1_XL_FS_XL_MASK;
-    temp |= scale << _CTRL1_XL_FS_XL_POSN;
-            
-    lsm6d_set_register_value(LSM6D_CTRL1_XL, temp);
+    temp &= ~mask;
+    temp |= value & mask;
+    
+    lsm6d_dev_set_register_value(dev, addr, temp);
 }
 
-void lsm6d_set_gyro_scale(uint8_t scale) {
-    uint8_t temp;
+void lsm6d_dev_set_register_bits(LSM6D_DEVICE *dev, uint8_t addr, uint8_t bits) {
+    lsm6d_update_register(dev, addr, bits, bits);
+}
+
+void lsm6d_dev_clear_register_bits(LSM6D_DEVICE *dev, uint8_t addr, uint8_t bits) {
+    lsm6d_update_register(dev, addr, bits, 0);
+}
+
+void lsm6d_dev_set_accel_data_rate(LSM6D_DEVICE *dev, uint8_t rate) {
+    lsm6d_update_register(dev, LSM6D_CTRL1_XL, _CTRL1_XL_ODR_XL_MASK, rate << _CTRL1_XL_ODR_XL_POSN);
+}
+
+void lsm6d_dev_set_gyro_data_rate(LSM6D_DEVICE *dev, uint8_t rate) {
+    lsm6d_update_register(dev, LSM6D_CTRL2_G, _CTRL2_G_ODR_G_MASK, rate << _CTRL2_G_ODR_G_POSN);
+}
+
+void lsm6d_dev_set_accel_scale(LSM6D_DEVICE *dev, uint8_t scale) {
+    lsm6d_update_register(dev, LSM6D_CTRL1_XL, _CTRL1_XL_FS_XL_MASK, scale << _CTRL1_XL_FS_XL_POSN);
+}
+
+void lsm6d_dev_set_gyro_scale(LSM6D_DEVICE *dev, uint8_t scale) {
+    lsm6d_update_register(dev, LSM6D_CTRL2_G, _CTRL2_G_FS_G_MASK, scale << _CTRL2_G_FS_G_POSN);
+}
+
+/* Copy the current configuration shadow, e.g. as a starting point for a new profile */
+void lsm6d_dev_profile_get(LSM6D_DEVICE *dev, LSM6D_PROFILE *profile) {
+    if (!dev->shadow_valid) {
+        lsm6d_dev_shadow_sync(dev);
+    }
     
-    temp = lsm6d_get_register_value(LSM6D_CTRL2_G);
+    *profile = dev->shadow;
+}
+
+/*
+ * Write a complete configuration profile. Only registers that differ from the shadow
+ * are written, using one auto-increment burst per run of changes. Runs separated by
+ * up to LSM6D_PROFILE_GAP unchanged registers are merged, since rewriting a byte is
+ * cheaper than starting another transaction. BDU and IF_INC are always kept set.
+ * 
+ * Returns the number of SPI transactions used.
+ */
+uint8_t lsm6d_dev_profile_apply(LSM6D_DEVICE *dev, const LSM6D_PROFILE *profile) {
+    const uint8_t *want = (const uint8_t *)profile;
+    uint8_t *have = (uint8_t *)&dev->shadow;
+    uint8_t value[sizeof(LSM6D_PROFILE)];
+    uint8_t block;
+    uint8_t start;
+    uint8_t offset = 0;
+    uint8_t i;
+    uint8_t last;
+    uint8_t j;
+    uint8_t transactions = 0;
     
-    temp &= ~_CTRL2_G_FS_G_MASK;
-    temp |= scale << _CTRL2_G_FS_G_POSN;
+    if (!dev->shadow_valid) {
+        lsm6d_dev_shadow_sync(dev);
+        transactions += LSM6D_PROFILE_BLOCKS;
+    }
+    
+    for (block = 0; block < LSM6D_PROFILE_BLOCKS; block++) {
+        start = lsm6d_shadow_blocks[block][0];
+        
+        for (i = 0; i < lsm6d_shadow_blocks[block][1]; i++) {
+            value[offset + i] = lsm6d_shadow_value(start + i, want[offset + i]);
+        }
+        
+        if (start == LSM6D_CTRL1_XL) {
+            value[offset + (LSM6D_CTRL3_C - LSM6D_CTRL1_XL)] |= _CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK;
+        }
+        
+        i = 0;
+        
+        while (i < lsm6d_shadow_blocks[block][1]) {
+            if (value[offset + i] == have[offset + i]) {
+                i++;
+                continue;
+            }
+            
+            /* Extend the run while the next change is close enough */
+            last = i;
+            
+            for (j = i + 1; j < lsm6d_shadow_blocks[block][1] && j <= last + LSM6D_PROFILE_GAP + 1; j++) {
+                if (value[offset + j] != have[offset + j]) {
+                    last = j;
+                }
+            }
+            
+            dev->cs(1);
+            dev->xfer_spi(LSM6D_SPI_WRITE | (start + i));
+            
+            for (j = i; j <= last; j++) {
+                dev->xfer_spi(value[offset + j]);
+                have[offset + j] = value[offset + j];
+            }
+            
+            dev->cs(0);
+            transactions++;
             
-    lsm6d_set_register_value(LSM6D_CTRL2_G, temp);
+            i = last + 1;
+        }
+        
+        offset += lsm6d_shadow_blocks[block][1];
+    }
+    
+    return transactions;
 }
 
-uint8_t lsm6d_get_register_value(uint8_t addr)
+uint8_t lsm6d_dev_get_register_value(LSM6D_DEVICE *dev, uint8_t addr)
 {
     uint8_t temp;
     
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | addr);
-    temp = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    LSM6D_SPI_IDLE();
+    dev->cs(1);
+    dev->xfer_spi(LSM6D_SPI_READ | addr);
+    temp = dev->xfer_spi(LSM6D_DUMMY_DATA);
+    dev->cs(0);
     
     return temp;
 }
 
-void lsm6d_get_register_multi(uint8_t start_addr, uint8_t *buffer, uint8_t num)
+/* Clock len bytes in from the SPI bus without changing CS */
+static void lsm6d_spi_read(LSM6D_DEVICE *dev, uint8_t *buffer, uint16_t len)
 {
-    uint8_t count;
+    if (dev->xfer_block) {
+        dev->xfer_block(buffer, len);
+        return;
+    }
     
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | start_addr);
+    while (len--) {
+        *buffer++ = dev->xfer_spi(LSM6D_DUMMY_DATA);
+    }
+}
+
+void lsm6d_dev_get_register_multi(LSM6D_DEVICE *dev, uint8_t start_addr, uint8_t *buffer, uint8_t num)
+{
+    dev->cs(1);
+    dev->xfer_spi(LSM6D_SPI_READ | start_addr);
+    lsm6d_spi_read(dev, buffer, num);
+    dev->cs(0);
+}
+
+/* Convert count little-endian 16-bit words from buffer */
+void lsm6d_decode_words(const uint8_t *buffer, int16_t *out, uint8_t count)
+{
+    while (count--) {
+        *out++ = (int16_t)(buffer[0] | ((uint16_t)buffer[1] << 8));
+        buffer += 2;
+    }
+}
+
+/*
+ * Set Block Data Update and register auto-increment if either is clear, so a burst read
+ * returns one coherent sample. Once the shadow is synced this is only a RAM check, which
+ * keeps callers that never run lsm6d_dev_init() (or that reset the device) coherent.
+ */
+static void lsm6d_burst_setup(LSM6D_DEVICE *dev)
+{
+    uint8_t ctrl3 = lsm6d_dev_get_config_value(dev, LSM6D_CTRL3_C);
     
-    for (count = 0; count < num; count++) {
-        buffer[count] = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
+    if ((ctrl3 & (_CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK)) != (_CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK)) {
+        lsm6d_dev_set_register_value(dev, LSM6D_CTRL3_C, ctrl3 | _CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK);
     }
+}
+
+/* Reset driver state, then set Block Data Update and register auto-increment */
+void lsm6d_dev_init(LSM6D_DEVICE *dev)
+{
+    static const LSM6D_FIFO_STATE empty = {0};
     
-    LSM6D_SPI_IDLE();
+    dev->fifo = empty;
+    dev->events_enabled = 0;
+    dev->acq_source = LSM6D_ACQ_DRDY;
+    dev->acq_head = 0;
+    dev->acq_tail = 0;
+    dev->acq_overflow_events = 0;
+    
+    lsm6d_dev_shadow_sync(dev);
+    lsm6d_burst_setup(dev);
 }
 
-int16_t lsm6d_get_temperature(void)
+int16_t lsm6d_dev_get_temperature(LSM6D_DEVICE *dev)
 {
-    uint8_t val;
-    uint16_t temperature;
+    uint8_t buffer[2];
+    int16_t temperature;
     
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | LSM6D_OUT_TEMP_L);
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    temperature = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    temperature |= val << 8;
-    LSM6D_SPI_IDLE();
+    lsm6d_burst_setup(dev);
+    lsm6d_dev_get_register_multi(dev, LSM6D_OUT_TEMP_L, buffer, 2);
+    lsm6d_decode_words(buffer, &temperature, 1);
     
     return temperature;
 }
 
-void lsm6d_get_accel_data(LSM6D_XL_DATA *data)
+void lsm6d_dev_get_accel_data(LSM6D_DEVICE *dev, LSM6D_XL_DATA *data)
 {
-    uint8_t val;
-    
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | LSM6D_OUTX_L_XL);
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->z |= val << 8;
-    LSM6D_SPI_IDLE();
-}
-
-void lsm6d_get_gyro_data(LSM6D_G_DATA *data)
+    uint8_t buffer[6];
+    int16_t words[3];
+    
+    lsm6d_burst_setup(dev);
+    lsm6d_dev_get_register_multi(dev, LSM6D_OUTX_L_XL, buffer, 6);
+    lsm6d_decode_words(buffer, words, 3);
+    
+    data->x = words[0];
+    data->y = words[1];
+    data->z = words[2];
+}
+
+void lsm6d_dev_get_gyro_data(LSM6D_DEVICE *dev, LSM6D_G_DATA *data)
 {
-    uint8_t val;
-    
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | LSM6D_OUTX_L_G);
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->z |= val << 8;
-    LSM6D_SPI_IDLE();
-}
-
-void lsm6d_get_all_motion_data(LSM6D_SENSOR_DATA *data)
+    uint8_t buffer[6];
+    int16_t words[3];
+    
+    lsm6d_burst_setup(dev);
+    lsm6d_dev_get_register_multi(dev, LSM6D_OUTX_L_G, buffer, 6);
+    lsm6d_decode_words(buffer, words, 3);
+    
+    data->x = words[0];
+    data->y = words[1];
+    data->z = words[2];
+}
+
+/* Output registers are ordered temperature, gyro, accelerometer starting at OUT_TEMP_L */
+static void lsm6d_read_outputs(LSM6D_DEVICE *dev, uint8_t start_addr, LSM6D_SENSOR_DATA *data)
 {
-    uint8_t val;
-    
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | LSM6D_OUTX_L_G);
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.z |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.z |= val << 8;
-    LSM6D_SPI_IDLE();
-}
-
-void lsm6d_get_all_sensor_data(LSM6D_SENSOR_DATA *data)
+    uint8_t buffer[14];
+    int16_t words[7];
+    uint8_t first = (start_addr - LSM6D_OUT_TEMP_L) / 2;
+    
+    lsm6d_burst_setup(dev);
+    lsm6d_dev_get_register_multi(dev, start_addr, &buffer[first * 2], 14 - first * 2);
+    lsm6d_decode_words(&buffer[first * 2], &words[first], 7 - first);
+    
+    if (first == 0) {
+        data->temp = words[0];
+    }
+    
+    data->g.x = words[1];
+    data->g.y = words[2];
+    data->g.z = words[3];
+    data->xl.x = words[4];
+    data->xl.y = words[5];
+    data->xl.z = words[6];
+}
+
+void lsm6d_dev_get_all_motion_data(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *data)
+{
+    lsm6d_read_outputs(dev, LSM6D_OUTX_L_G, data);
+}
+
+void lsm6d_dev_get_all_sensor_data(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *data)
 {
-    uint8_t val;
-    
-    LSM6D_SPI_ACTIVE();
-    LSM6D_SPI_TRANSFER(LSM6D_SPI_READ | LSM6D_OUT_TEMP_L);
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->temp = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->temp |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->g.z |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.x = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.x |= val << 8;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.y = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.y |= val << 8; 
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.z = val;
-    val = LSM6D_SPI_TRANSFER(LSM6D_DUMMY_DATA);
-    data->xl.z |= val << 8;
-    LSM6D_SPI_IDLE();
-}
\ No newline at end of file
+    lsm6d_read_outputs(dev, LSM6D_OUT_TEMP_L, data);
+}
+
+/* Convert _FIFO_CTRL3_DECIMATION_x setting to decimation factor (0 = not in FIFO) */
+static uint8_t lsm6d_fifo_factor(uint8_t dec) {
+    static const uint8_t factors[8] = {0, 1, 2, 3, 4, 8, 16, 32};
+    
+    return factors[dec & 0b111];
+}
+
+/* Return which data sets are stored for FIFO sample n of the pattern */
+static uint8_t lsm6d_fifo_sets(const LSM6D_FIFO_STATE *fifo, uint8_t n) {
+    uint8_t sets = 0;
+    
+    if (fifo->dec_g && (n % fifo->dec_g) == 0) {
+        sets |= LSM6D_FIFO_SET_G;
+    }
+    
+    if (fifo->dec_xl && (n % fifo->dec_xl) == 0) {
+        sets |= LSM6D_FIFO_SET_XL;
+    }
+    
+    if (fifo->dec_ts && (n % fifo->dec_ts) == 0) {
+        sets |= LSM6D_FIFO_SET_TS;
+    }
+    
+    return sets;
+}
+
+/* Return the data set following set within a sample, or 0 if set was the last one */
+static uint8_t lsm6d_fifo_next_set(uint8_t sets, uint8_t set) {
+    if (set) {
+        sets &= ~((set << 1) - 1);
+    }
+    
+    return sets & -sets;
+}
+
+/* Return _FIFO_CTRL3_DECIMATION_x setting for decimation factor */
+static uint8_t lsm6d_fifo_setting(uint8_t factor) {
+    uint8_t dec;
+    
+    for (dec = _FIFO_CTRL3_DECIMATION_NONE; dec < _FIFO_CTRL3_DECIMATION_32; dec++) {
+        if (lsm6d_fifo_factor(dec) == factor) {
+            break;
+        }
+    }
+    
+    return dec;
+}
+
+/* Take the timestamp and step count from a completed 4th data set */
+static void lsm6d_fifo_timestamp(LSM6D_FIFO_STATE *fifo) {
+    uint32_t ts;
+    
+    /* Data set is TIMESTAMP[15:8], TIMESTAMP[23:16], unused, TIMESTAMP[7:0], STEP_L, STEP_H */
+    ts = ((uint32_t)fifo->ts_raw[1] << 16) | ((uint16_t)fifo->ts_raw[0] << 8) | fifo->ts_raw[3];
+    
+    /* Counter is 24 bits - add the elapsed ticks modulo 2^24 */
+    fifo->timestamp += (ts - fifo->timestamp) & 0x00FFFFFF;
+    fifo->steps = fifo->ts_raw[4] | ((uint16_t)fifo->ts_raw[5] << 8);
+}
+
+/*
+ * Set FIFO ODR, mode, per-sensor decimation (_FIFO_CTRL3_x settings) and the
+ * watermark threshold in words. The FIFO passes through bypass mode, which empties it.
+ * 
+ * If the timestamp counter is enabled, timestamp and step count are stored as the
+ * 4th data set alongside every gyro or accelerometer sample.
+ */
+void lsm6d_dev_fifo_configure(LSM6D_DEVICE *dev, uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold) {
+    LSM6D_FIFO_STATE *fifo = &dev->fifo;
+    uint8_t a;
+    uint8_t b;
+    uint8_t timer;
+    
+    lsm6d_dev_set_register_value(dev, LSM6D_FIFO_CTRL5, _FIFO_CTRL5_FIFO_BYPASS);
+    
+    fifo->dec_g = lsm6d_fifo_factor(dec_g);
+    fifo->dec_xl = lsm6d_fifo_factor(dec_xl);
+    
+    /* Pattern repeats after the least common multiple of the two decimation factors */
+    a = fifo->dec_g ? fifo->dec_g : fifo->dec_xl;
+    b = fifo->dec_xl ? fifo->dec_xl : a;
+    fifo->period = a;
+    
+    while (a && (fifo->period % b) != 0) {
+        fifo->period += a;
+    }
+    
+    /*
+     * Timestamps are stored at the greatest common divisor of the two factors, so every
+     * sample carries one. With factors 2 and 3 this also stores timestamps on their own.
+     */
+    fifo->dec_ts = 0;
+    timer = lsm6d_dev_get_config_value(dev, LSM6D_TAP_CFG) & _TAP_CFG_TIMER_EN_MASK;
+    
+    if (timer && a) {
+        fifo->dec_ts = a;
+        while ((a % fifo->dec_ts) || (b % fifo->dec_ts)) {
+            fifo->dec_ts--;
+        }
+    }
+    
+    lsm6d_dev_set_register_value(dev, LSM6D_FIFO_CTRL1, threshold & _FIFO_CTRL1_FTH_L_MASK);
+    lsm6d_update_register(dev, LSM6D_FIFO_CTRL2, _FIFO_CTRL2_FTH_H_MASK | _FIFO_CTRL2_TIMER_PEDO_FIFO_EN_MASK | _FIFO_CTRL2_TIMER_PEDO_FIFO_DRDY_MASK,
+            (threshold >> 8) | (fifo->dec_ts ? _FIFO_CTRL2_TIMER_PEDO_FIFO_EN_MASK : 0));
+    
+    lsm6d_dev_set_register_value(dev, LSM6D_FIFO_CTRL3, (dec_g << _FIFO_CTRL3_DEC_FIFO_GYRO_POSN) | (dec_xl << _FIFO_CTRL3_DEC_FIFO_XL_POSN));
+    lsm6d_update_register(dev, LSM6D_FIFO_CTRL4, _FIFO_CTRL4_DEC_DS3_FIFO_MASK | _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_MASK,
+            fifo->dec_ts ? lsm6d_fifo_setting(fifo->dec_ts) << _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_POSN : 0);
+    
+    fifo->overruns = 0;
+    fifo->timestamp = 0;
+    
+    lsm6d_dev_set_register_value(dev, LSM6D_FIFO_CTRL5, (odr << _FIFO_CTRL5_ODR_FIFO_POSN) | (mode << _FIFO_CTRL5_FIFO_MODE_POSN));
+}
+
+/* Read FIFO_STATUS1..4 in one burst - returns FIFO_STATUS2 flags */
+uint8_t lsm6d_dev_fifo_get_status(LSM6D_DEVICE *dev, uint16_t *level, uint16_t *pattern) {
+    uint8_t status[4];
+    
+    lsm6d_dev_get_register_multi(dev, LSM6D_FIFO_STATUS1, status, 4);
+    
+    *level = status[0] | ((uint16_t)(status[1] & _FIFO_STATUS2_DIFF_FIFO_H_MASK) << 8);
+    *pattern = status[2] | ((uint16_t)(status[3] & _FIFO_STATUS4_FIFO_PATTERN_H_MASK) << 8);
+    
+    return status[1];
+}
+
+/*
+ * Drain up to max complete samples from the FIFO in a single burst.
+ * 
+ * FIFO_STATUS3/4 give the position of the next word within the data set pattern,
+ * so decoding starts in the right place even after a partial read or an overrun.
+ * Words of an incomplete sample stay in the device's FIFO state until the next call.
+ * 
+ * If timestamps is not NULL it receives the unwrapped on-chip timestamp of each
+ * sample, in LSM6D_TIMESTAMP_LSB_US units (see lsm6d_dev_timestamp_enable).
+ */
+uint16_t lsm6d_dev_fifo_read_timed(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint32_t *timestamps, uint16_t max) {
+    LSM6D_FIFO_STATE *fifo = &dev->fifo;
+    uint16_t level;
+    uint16_t pattern;
+    uint16_t count = 0;
+    uint8_t n = 0;
+    uint8_t sets;
+    uint8_t set;
+    uint8_t axis;
+    uint8_t buffer[LSM6D_FIFO_CHUNK * 2];
+    uint16_t chunk;
+    uint16_t i;
+    int16_t *dest;
+    
+    if (lsm6d_dev_fifo_get_status(dev, &level, &pattern) & _FIFO_STATUS2_FIFO_OVER_RUN_MASK) {
+        fifo->overruns++;
+    }
+    
+    if (fifo->period == 0) {
+        return 0;
+    }
+    
+    /* Find sample, data set and axis of the next word from the pattern position */
+    for (;;) {
+        sets = lsm6d_fifo_sets(fifo, n);
+        
+        for (set = lsm6d_fifo_next_set(sets, 0); set; set = lsm6d_fifo_next_set(sets, set)) {
+            if (pattern < 3) {
+                break;
+            }
+            pattern -= 3;
+        }
+        
+        if (set) {
+            break;
+        }
+        
+        if (++n == fifo->period) {
+            /* Pattern position out of range - start over at the beginning */
+            n = 0;
+            pattern = 0;
+        }
+    }
+    
+    axis = (uint8_t)pattern;
+    
+    dev->cs(1);
+    dev->xfer_spi(LSM6D_SPI_READ | LSM6D_FIFO_DATA_OUT_L);
+    
+    while (level && count < max) {
+        /* Every sample has at least 3 words, so this never reads past sample max */
+        chunk = (max - count < LSM6D_FIFO_CHUNK / 3) ? (max - count) * 3 : LSM6D_FIFO_CHUNK;
+        if (chunk > level) {
+            chunk = level;
+        }
+        
+        lsm6d_spi_read(dev, buffer, chunk * 2);
+        level -= chunk;
+        
+        for (i = 0; i < chunk; i++) {
+            if (set == LSM6D_FIFO_SET_TS) {
+                fifo->ts_raw[axis * 2] = buffer[i * 2];
+                fifo->ts_raw[axis * 2 + 1] = buffer[i * 2 + 1];
+            } else {
+                dest = (set == LSM6D_FIFO_SET_G) ? &fifo->cur.g.x : &fifo->cur.xl.x;
+                lsm6d_decode_words(&buffer[i * 2], &dest[axis], 1);
+            }
+            
+            if (++axis < 3) {
+                continue;
+            }
+            
+            axis = 0;
+            
+            if (set == LSM6D_FIFO_SET_TS) {
+                lsm6d_fifo_timestamp(fifo);
+            }
+            
+            set = lsm6d_fifo_next_set(sets, set);
+            if (set) {
+                continue;
+            }
+            
+            /* A timestamp stored without sensor data only advances the counter */
+            if (sets & (LSM6D_FIFO_SET_G | LSM6D_FIFO_SET_XL)) {
+                if (count == 0) {
+                    fifo->first = n;
+                }
+                if (timestamps) {
+                    timestamps[count] = fifo->timestamp;
+                }
+                out[count++] = fifo->cur;
+            }
+            
+            do {
+                if (++n == fifo->period) {
+                    n = 0;
+                }
+                sets = lsm6d_fifo_sets(fifo, n);
+            } while (!sets);
+            
+            set = lsm6d_fifo_next_set(sets, 0);
+        }
+    }
+    
+    dev->cs(0);
+    
+    return count;
+}
+
+uint16_t lsm6d_dev_fifo_read(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint16_t max) {
+    return lsm6d_dev_fifo_read_timed(dev, out, 0, max);
+}
+
+LSM6D_FIFO_STATE *lsm6d_dev_fifo_get_state(LSM6D_DEVICE *dev) {
+    return &dev->fifo;
+}
+
+/*
+ * Start the on-chip timestamp counter from zero. With high_res set one count is
+ * LSM6D_TIMESTAMP_LSB_US_HR, otherwise LSM6D_TIMESTAMP_LSB_US. Call before
+ * lsm6d_dev_fifo_configure to store timestamps in the FIFO.
+ */
+void lsm6d_dev_timestamp_enable(LSM6D_DEVICE *dev, uint8_t high_res) {
+    lsm6d_update_register(dev, LSM6D_WAKE_UP_DUR, _WAKE_UP_DUR_TIMER_HR_MASK, high_res ? _WAKE_UP_DUR_TIMER_HR_MASK : 0);
+    lsm6d_dev_set_register_bits(dev, LSM6D_TAP_CFG, _TAP_CFG_TIMER_EN_MASK);
+    lsm6d_dev_set_register_value(dev, LSM6D_TIMESTAMP2_REG, LSM6D_TIMESTAMP_RESET);
+    
+    dev->fifo.timestamp = 0;
+}
+
+void lsm6d_dev_timestamp_disable(LSM6D_DEVICE *dev) {
+    lsm6d_dev_clear_register_bits(dev, LSM6D_TAP_CFG, _TAP_CFG_TIMER_EN_MASK);
+}
+
+/* Read the current 24-bit counter value */
+uint32_t lsm6d_dev_get_timestamp(LSM6D_DEVICE *dev) {
+    uint8_t buffer[3];
+    
+    lsm6d_dev_get_register_multi(dev, LSM6D_TIMESTAMP0_REG, buffer, 3);
+    
+    return buffer[0] | ((uint16_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16);
+}
+
+/*
+ * Start interrupt-driven acquisition on INT1. With LSM6D_ACQ_DRDY each data-ready
+ * interrupt queues one sample; with LSM6D_ACQ_FIFO the FIFO threshold interrupt
+ * drains the FIFO (set up with lsm6d_dev_fifo_configure) into the queue.
+ * 
+ * The ISR only writes acq_head and the main loop only writes acq_tail, and both
+ * are single bytes, so no locking is needed.
+ */
+void lsm6d_dev_acq_start(LSM6D_DEVICE *dev, uint8_t source) {
+    dev->acq_source = source;
+    dev->acq_head = 0;
+    dev->acq_tail = 0;
+    dev->acq_overflow_events = 0;
+    
+    lsm6d_update_register(dev, LSM6D_INT1_CTRL, _INT1_CTRL_INT1_DRDY_XL_MASK | _INT1_CTRL_INT1_DRDY_G_MASK | _INT1_CTRL_INT1_FTH_MASK,
+            (source == LSM6D_ACQ_FIFO) ? _INT1_CTRL_INT1_FTH_MASK : _INT1_CTRL_INT1_DRDY_XL_MASK);
+}
+
+void lsm6d_dev_acq_stop(LSM6D_DEVICE *dev) {
+    lsm6d_dev_clear_register_bits(dev, LSM6D_INT1_CTRL, _INT1_CTRL_INT1_DRDY_XL_MASK | _INT1_CTRL_INT1_DRDY_G_MASK | _INT1_CTRL_INT1_FTH_MASK);
+}
+
+/* Call from the device's INT1 interrupt handler */
+void lsm6d_dev_acq_isr(LSM6D_DEVICE *dev) {
+    LSM6D_SENSOR_DATA discard;
+    uint8_t head = dev->acq_head;
+    uint8_t space;
+    uint8_t run;
+    uint16_t level;
+    uint16_t pattern;
+    
+    if (dev->acq_source == LSM6D_ACQ_DRDY) {
+        if ((uint8_t)(head - dev->acq_tail) >= LSM6D_QUEUE_SIZE) {
+            /* Still read the sample so data-ready is released */
+            lsm6d_dev_get_all_sensor_data(dev, &discard);
+            dev->acq_overflow_events++;
+            return;
+        }
+        
+        lsm6d_dev_get_all_sensor_data(dev, &dev->acq_queue[head & (LSM6D_QUEUE_SIZE - 1)]);
+        LSM6D_MEMORY_BARRIER();
+        dev->acq_head = head + 1;
+        return;
+    }
+    
+    /* Up to two contiguous runs, either side of the end of the queue */
+    space = LSM6D_QUEUE_SIZE - (uint8_t)(head - dev->acq_tail);
+    
+    while (space) {
+        run = LSM6D_QUEUE_SIZE - (head & (LSM6D_QUEUE_SIZE - 1));
+        if (run > space) {
+            run = space;
+        }
+        
+        run = (uint8_t)lsm6d_dev_fifo_read(dev, &dev->acq_queue[head & (LSM6D_QUEUE_SIZE - 1)], run);
+        if (run == 0) {
+            break;
+        }
+        
+        head += run;
+        space -= run;
+        LSM6D_MEMORY_BARRIER();
+        dev->acq_head = head;
+    }
+    
+    if (space == 0) {
+        /* Queue full - anything left stays in the FIFO, which may overrun before the next interrupt */
+        lsm6d_dev_fifo_get_status(dev, &level, &pattern);
+        if (level >= 3) {
+            dev->acq_overflow_events++;
+        }
+    }
+}
+
+/* Return the oldest queued samples without copying - *count is set to the number available contiguously */
+LSM6D_SENSOR_DATA *lsm6d_dev_acq_peek(LSM6D_DEVICE *dev, uint8_t *count) {
+    uint8_t tail = dev->acq_tail;
+    uint8_t run = LSM6D_QUEUE_SIZE - (tail & (LSM6D_QUEUE_SIZE - 1));
+    uint8_t used = (uint8_t)(dev->acq_head - tail);
+    
+    LSM6D_MEMORY_BARRIER();
+    
+    *count = (used < run) ? used : run;
+    
+    return &dev->acq_queue[tail & (LSM6D_QUEUE_SIZE - 1)];
+}
+
+/* Release count samples returned by lsm6d_dev_acq_peek */
+void lsm6d_dev_acq_release(LSM6D_DEVICE *dev, uint8_t count) {
+    LSM6D_MEMORY_BARRIER();
+    dev->acq_tail += count;
+}
+
+/* Copy up to max queued samples - returns the number copied */
+uint8_t lsm6d_dev_acq_read(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint8_t max) {
+    LSM6D_SENSOR_DATA *src;
+    uint8_t total = 0;
+    uint8_t count;
+    uint8_t i;
+    
+    while (total < max) {
+        src = lsm6d_dev_acq_peek(dev, &count);
+        if (count == 0) {
+            break;
+        }
+        
+        if (count > max - total) {
+            count = max - total;
+        }
+        
+        for (i = 0; i < count; i++) {
+            out[total + i] = src[i];
+        }
+        
+        lsm6d_dev_acq_release(dev, count);
+        total += count;
+    }
+    
+    return total;
+}
+
+/*
+ * Overflow events, not samples: interrupts that found the queue full. In LSM6D_ACQ_DRDY
+ * mode each event discarded one sample. In LSM6D_ACQ_FIFO mode the data stays in the
+ * FIFO, and is only lost if the FIFO overruns too (see LSM6D_FIFO_STATE overruns).
+ */
+uint16_t lsm6d_dev_acq_get_overflows(LSM6D_DEVICE *dev) {
+    return dev->acq_overflow_events;
+}
+
+#ifndef LSM6D_NO_DEFAULT_DEVICE
+
+void lsm6d_set_register_value(uint8_t addr, uint8_t value) {
+    lsm6d_dev_set_register_value(&lsm6d_default_device, addr, value);
+}
+
+void lsm6d_set_register_bits(uint8_t addr, uint8_t bits) {
+    lsm6d_dev_set_register_bits(&lsm6d_default_device, addr, bits);
+}
+
+void lsm6d_clear_register_bits(uint8_t addr, uint8_t bits) {
+    lsm6d_dev_clear_register_bits(&lsm6d_default_device, addr, bits);
+}
+
+uint8_t lsm6d_get_register_value(uint8_t addr) {
+    return lsm6d_dev_get_register_value(&lsm6d_default_device, addr);
+}
+
+void lsm6d_get_register_multi(uint8_t start_addr, uint8_t *buffer, uint8_t num) {
+    lsm6d_dev_get_register_multi(&lsm6d_default_device, start_addr, buffer, num);
+}
+
+void lsm6d_init(void) {
+    lsm6d_dev_init(&lsm6d_default_device);
+}
+
+void lsm6d_shadow_sync(void) {
+    lsm6d_dev_shadow_sync(&lsm6d_default_device);
+}
+
+uint8_t lsm6d_get_config_value(uint8_t addr) {
+    return lsm6d_dev_get_config_value(&lsm6d_default_device, addr);
+}
+
+void lsm6d_profile_get(LSM6D_PROFILE *profile) {
+    lsm6d_dev_profile_get(&lsm6d_default_device, profile);
+}
+
+uint8_t lsm6d_profile_apply(const LSM6D_PROFILE *profile) {
+    return lsm6d_dev_profile_apply(&lsm6d_default_device, profile);
+}
+
+int16_t lsm6d_get_temperature(void) {
+    return lsm6d_dev_get_temperature(&lsm6d_default_device);
+}
+
+void lsm6d_get_accel_data(LSM6D_XL_DATA *data) {
+    lsm6d_dev_get_accel_data(&lsm6d_default_device, data);
+}
+
+void lsm6d_get_gyro_data(LSM6D_G_DATA *data) {
+    lsm6d_dev_get_gyro_data(&lsm6d_default_device, data);
+}
+
+void lsm6d_get_all_motion_data(LSM6D_SENSOR_DATA *data) {
+    lsm6d_dev_get_all_motion_data(&lsm6d_default_device, data);
+}
+
+void lsm6d_get_all_sensor_data(LSM6D_SENSOR_DATA *data) {
+    lsm6d_dev_get_all_sensor_data(&lsm6d_default_device, data);
+}
+
+void lsm6d_set_accel_data_rate(uint8_t rate) {
+    lsm6d_dev_set_accel_data_rate(&lsm6d_default_device, rate);
+}
+
+void lsm6d_set_gyro_data_rate(uint8_t rate) {
+    lsm6d_dev_set_gyro_data_rate(&lsm6d_default_device, rate);
+}
+
+void lsm6d_set_accel_scale(uint8_t scale) {
+    lsm6d_dev_set_accel_scale(&lsm6d_default_device, scale);
+}
+
+void lsm6d_set_gyro_scale(uint8_t scale) {
+    lsm6d_dev_set_gyro_scale(&lsm6d_default_device, scale);
+}
+
+void lsm6d_timestamp_enable(uint8_t high_res) {
+    lsm6d_dev_timestamp_enable(&lsm6d_default_device, high_res);
+}
+
+void lsm6d_timestamp_disable(void) {
+    lsm6d_dev_timestamp_disable(&lsm6d_default_device);
+}
+
+uint32_t lsm6d_get_timestamp(void) {
+    return lsm6d_dev_get_timestamp(&lsm6d_default_device);
+}
+
+void lsm6d_fifo_configure(uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold) {
+    lsm6d_dev_fifo_configure(&lsm6d_default_device, odr, mode, dec_xl, dec_g, threshold);
+}
+
+uint8_t lsm6d_fifo_get_status(uint16_t *level, uint16_t *pattern) {
+    return lsm6d_dev_fifo_get_status(&lsm6d_default_device, level, pattern);
+}
+
+uint16_t lsm6d_fifo_read(LSM6D_SENSOR_DATA *out, uint16_t max) {
+    return lsm6d_dev_fifo_read(&lsm6d_default_device, out, max);
+}
+
+uint16_t lsm6d_fifo_read_timed(LSM6D_SENSOR_DATA *out, uint32_t *timestamps, uint16_t max) {
+    return lsm6d_dev_fifo_read_timed(&lsm6d_default_device, out, timestamps, max);
+}
+
+LSM6D_FIFO_STATE *lsm6d_fifo_get_state(void) {
+    return lsm6d_dev_fifo_get_state(&lsm6d_default_device);
+}
+
+void lsm6d_acq_start(uint8_t source) {
+    lsm6d_dev_acq_start(&lsm6d_default_device, source);
+}
+
+void lsm6d_acq_stop(void) {
+    lsm6d_dev_acq_stop(&lsm6d_default_device);
+}
+
+void lsm6d_acq_isr(void) {
+    lsm6d_dev_acq_isr(&lsm6d_default_device);
+}
+
+LSM6D_SENSOR_DATA *lsm6d_acq_peek(uint8_t *count) {
+    return lsm6d_dev_acq_peek(&lsm6d_default_device, count);
+}
+
+void lsm6d_acq_release(uint8_t count) {
+    lsm6d_dev_acq_release(&lsm6d_default_device, count);
+}
+
+uint8_t lsm6d_acq_read(LSM6D_SENSOR_DATA *out, uint8_t max) {
+    return lsm6d_dev_acq_read(&lsm6d_default_device, out, max);
+}
+
+uint16_t lsm6d_acq_get_overflows(void) {
+    return lsm6d_dev_acq_get_overflows(&lsm6d_default_device);
+}
+
+#endif /* LSM6D_NO_DEFAULT_DEVICE */
@@ -147,6 +147,10 @@
 #define _FIFO_CTRL3_DECIMATION_32           0b111
 
 /* FIFO_CTRL4 */
+#define _FIFO_CTRL4_DEC_DS3_FIFO_POSN	0
+#define _FIFO_CTRL4_DEC_DS3_FIFO_LEN	3
+#define _FIFO_CTRL4_DEC_DS3_FIFO_MASK	0b00000111
+
 #define _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_POSN	3
 #define _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_LEN	3
 #define _FIFO_CTRL4_TIMER_PEDO_DEC_FIFO_MASK	0b00111000
@@ -729,6 +733,150 @@
 #define _TAP_CFG_TIMER_EN_LEN	1
 #define _TAP_CFG_TIMER_EN_MASK	0b10000000
 
+/* WAKE_UP_DUR */
+#define _WAKE_UP_DUR_SLEEP_DUR_POSN	0
+#define _WAKE_UP_DUR_SLEEP_DUR_LEN	4
+#define _WAKE_UP_DUR_SLEEP_DUR_MASK	0b00001111
+
+#define _WAKE_UP_DUR_TIMER_HR_POSN	4
+#define _WAKE_UP_DUR_TIMER_HR_LEN	1
+#define _WAKE_UP_DUR_TIMER_HR_MASK	0b00010000
+
+#define _WAKE_UP_DUR_WAKE_DUR_POSN	5
+#define _WAKE_UP_DUR_WAKE_DUR_LEN	2
+#define _WAKE_UP_DUR_WAKE_DUR_MASK	0b01100000
+
+#define _WAKE_UP_DUR_FF_DUR5_POSN	7
+#define _WAKE_UP_DUR_FF_DUR5_LEN	1
+#define _WAKE_UP_DUR_FF_DUR5_MASK	0b10000000
+
+/* INT_DUR2 */
+#define _INT_DUR2_SHOCK_POSN	0
+#define _INT_DUR2_SHOCK_LEN	2
+#define _INT_DUR2_SHOCK_MASK	0b00000011
+
+#define _INT_DUR2_QUIET_POSN	2
+#define _INT_DUR2_QUIET_LEN	2
+#define _INT_DUR2_QUIET_MASK	0b00001100
+
+#define _INT_DUR2_DUR_POSN	4
+#define _INT_DUR2_DUR_LEN	4
+#define _INT_DUR2_DUR_MASK	0b11110000
+
+/* WAKE_UP_THS */
+#define _WAKE_UP_THS_WK_THS_POSN	0
+#define _WAKE_UP_THS_WK_THS_LEN	6
+#define _WAKE_UP_THS_WK_THS_MASK	0b00111111
+
+#define _WAKE_UP_THS_INACTIVITY_POSN	6
+#define _WAKE_UP_THS_INACTIVITY_LEN	1
+#define _WAKE_UP_THS_INACTIVITY_MASK	0b01000000
+
+#define _WAKE_UP_THS_SINGLE_DOUBLE_TAP_POSN	7
+#define _WAKE_UP_THS_SINGLE_DOUBLE_TAP_LEN	1
+#define _WAKE_UP_THS_SINGLE_DOUBLE_TAP_MASK	0b10000000
+
+/* FREE_FALL */
+#define _FREE_FALL_FF_THS_POSN	0
+#define _FREE_FALL_FF_THS_LEN	3
+#define _FREE_FALL_FF_THS_MASK	0b00000111
+
+#define _FREE_FALL_FF_DUR_POSN	3
+#define _FREE_FALL_FF_DUR_LEN	5
+#define _FREE_FALL_FF_DUR_MASK	0b11111000
+/* Free-fall threshold values */
+#define _FREE_FALL_FF_THS_156MG             0b000
+#define _FREE_FALL_FF_THS_219MG             0b001
+#define _FREE_FALL_FF_THS_250MG             0b010
+#define _FREE_FALL_FF_THS_312MG             0b011
+#define _FREE_FALL_FF_THS_344MG             0b100
+#define _FREE_FALL_FF_THS_406MG             0b101
+#define _FREE_FALL_FF_THS_469MG             0b110
+#define _FREE_FALL_FF_THS_500MG             0b111
+
+/* MD1_CFG */
+#define _MD1_CFG_INT1_TIMER_POSN	0
+#define _MD1_CFG_INT1_TIMER_LEN	1
+#define _MD1_CFG_INT1_TIMER_MASK	0b00000001
+
+#define _MD1_CFG_INT1_TILT_POSN	1
+#define _MD1_CFG_INT1_TILT_LEN	1
+#define _MD1_CFG_INT1_TILT_MASK	0b00000010
+
+#define _MD1_CFG_INT1_6D_POSN	2
+#define _MD1_CFG_INT1_6D_LEN	1
+#define _MD1_CFG_INT1_6D_MASK	0b00000100
+
+#define _MD1_CFG_INT1_DOUBLE_TAP_POSN	3
+#define _MD1_CFG_INT1_DOUBLE_TAP_LEN	1
+#define _MD1_CFG_INT1_DOUBLE_TAP_MASK	0b00001000
+
+#define _MD1_CFG_INT1_FF_POSN	4
+#define _MD1_CFG_INT1_FF_LEN	1
+#define _MD1_CFG_INT1_FF_MASK	0b00010000
+
+#define _MD1_CFG_INT1_WU_POSN	5
+#define _MD1_CFG_INT1_WU_LEN	1
+#define _MD1_CFG_INT1_WU_MASK	0b00100000
+
+#define _MD1_CFG_INT1_SINGLE_TAP_POSN	6
+#define _MD1_CFG_INT1_SINGLE_TAP_LEN	1
+#define _MD1_CFG_INT1_SINGLE_TAP_MASK	0b01000000
+
+#define _MD1_CFG_INT1_INACT_STATE_POSN	7
+#define _MD1_CFG_INT1_INACT_STATE_LEN	1
+#define _MD1_CFG_INT1_INACT_STATE_MASK	0b10000000
+
+/* MD2_CFG */
+#define _MD2_CFG_INT2_IRON_POSN	0
+#define _MD2_CFG_INT2_IRON_LEN	1
+#define _MD2_CFG_INT2_IRON_MASK	0b00000001
+
+#define _MD2_CFG_INT2_TILT_POSN	1
+#define _MD2_CFG_INT2_TILT_LEN	1
+#define _MD2_CFG_INT2_TILT_MASK	0b00000010
+
+#define _MD2_CFG_INT2_6D_POSN	2
+#define _MD2_CFG_INT2_6D_LEN	1
+#define _MD2_CFG_INT2_6D_MASK	0b00000100
+
+#define _MD2_CFG_INT2_DOUBLE_TAP_POSN	3
+#define _MD2_CFG_INT2_DOUBLE_TAP_LEN	1
+#define _MD2_CFG_INT2_DOUBLE_TAP_MASK	0b00001000
+
+#define _MD2_CFG_INT2_FF_POSN	4
+#define _MD2_CFG_INT2_FF_LEN	1
+#define _MD2_CFG_INT2_FF_MASK	0b00010000
+
+#define _MD2_CFG_INT2_WU_POSN	5
+#define _MD2_CFG_INT2_WU_LEN	1
+#define _MD2_CFG_INT2_WU_MASK	0b00100000
+
+#define _MD2_CFG_INT2_SINGLE_TAP_POSN	6
+#define _MD2_CFG_INT2_SINGLE_TAP_LEN	1
+#define _MD2_CFG_INT2_SINGLE_TAP_MASK	0b01000000
+
+#define _MD2_CFG_INT2_INACT_STATE_POSN	7
+#define _MD2_CFG_INT2_INACT_STATE_LEN	1
+#define _MD2_CFG_INT2_INACT_STATE_MASK	0b10000000
+/* TAP_THS_6D */
+#define _TAP_THS_6D_TAP_THS_POSN	0
+#define _TAP_THS_6D_TAP_THS_LEN	5
+#define _TAP_THS_6D_TAP_THS_MASK	0b00011111
+
+#define _TAP_THS_6D_SIXD_THS_POSN	5
+#define _TAP_THS_6D_SIXD_THS_LEN	2
+#define _TAP_THS_6D_SIXD_THS_MASK	0b01100000
+
+#define _TAP_THS_6D_D4D_EN_POSN	7
+#define _TAP_THS_6D_D4D_EN_LEN	1
+#define _TAP_THS_6D_D4D_EN_MASK	0b10000000
+
+/* Timestamp counter - writing LSM6D_TIMESTAMP_RESET to TIMESTAMP2_REG clears it */
+#define LSM6D_TIMESTAMP_RESET     0xAA
+#define LSM6D_TIMESTAMP_LSB_US    6400      /* TIMER_HR = 0 */
+#define LSM6D_TIMESTAMP_LSB_US_HR 25        /* TIMER_HR = 1 */
+
 /* TAP_THS_6D bit values */
 #define TAP_THS                 0
 #define SIXD_THS                5
@@ -758,6 +906,132 @@ typedef struct {
     LSM6D_G_DATA g;
 } LSM6D_SENSOR_DATA;
 
+/* Registers covered by a configuration profile, in address order */
+typedef struct {
+    uint8_t fifo_ctrl[6];       /* FIFO_CTRL1..FIFO_CTRL5, ORIENT_CFG_G */
+    uint8_t int_ctrl[2];        /* INT1_CTRL, INT2_CTRL */
+    uint8_t ctrl[10];           /* CTRL1_XL..CTRL10_C */
+    uint8_t func_cfg[8];        /* TAP_CFG, TAP_THS_6D, INT_DUR2, WAKE_UP_THS, WAKE_UP_DUR, FREE_FALL, MD1_CFG, MD2_CFG */
+} LSM6D_PROFILE;
+
+#define LSM6D_PROFILE_BLOCKS      4
+
+/* Unchanged registers bridged rather than starting a new burst when applying a profile */
+#ifndef LSM6D_PROFILE_GAP
+#define LSM6D_PROFILE_GAP         2
+#endif
+
+/* Samples buffered between interrupt and main loop (must be a power of two, at most 128)
+ * 
+ * Define LSM6D_QUEUE_SIZE project-wide (compiler command line) to override,
+ * since it changes the size of LSM6D_DEVICE
+ */
+#ifndef LSM6D_QUEUE_SIZE
+#define LSM6D_QUEUE_SIZE          16
+#endif
+
+/* Interrupt sources for lsm6d_acq_start */
+#define LSM6D_ACQ_DRDY            0     /* One sample per accelerometer data-ready */
+#define LSM6D_ACQ_FIFO            1     /* FIFO threshold */
+
+/* FIFO capacity in 16-bit words */
+#define LSM6D_FIFO_WORDS          4096
+
+/* FIFO decoder state - one sample is assembled from the gyro and accelerometer data sets */
+typedef struct {
+    uint8_t dec_g;              /* Gyro decimation factor, 0 if not stored in FIFO */
+    uint8_t dec_xl;             /* Accelerometer decimation factor, 0 if not stored in FIFO */
+    uint8_t dec_ts;             /* Timestamp/step decimation factor, 0 if not stored in FIFO */
+    uint8_t period;             /* FIFO ODR samples before the data set pattern repeats */
+    uint8_t first;              /* Pattern position of the first sample returned by the last read */
+    uint16_t overruns;          /* Times FIFO_OVER_RUN was seen (data was lost) */
+    LSM6D_SENSOR_DATA cur;      /* Sample being assembled - carries the last value of each sensor */
+    uint8_t ts_raw[6];          /* Timestamp/step data set being assembled */
+    uint32_t timestamp;         /* Last FIFO timestamp, unwrapped from 24 bits */
+    uint16_t steps;             /* Last FIFO step count */
+} LSM6D_FIFO_STATE;
+
+/* 
+ * Per-device state
+ * 
+ * The first three members bind the instance to its chip select and SPI bus and must
+ * be filled in before calling lsm6d_dev_init(). Everything else is owned by the driver.
+ */
+typedef struct {
+    void (*cs)(uint8_t active);                         /* Set CS pin low (active) or high */
+    uint8_t (*xfer_spi)(uint8_t data);                  /* Transfer one byte to/from SPI bus without changing CS */
+    void (*xfer_block)(uint8_t *buffer, uint16_t len);  /* Clock len bytes in without changing CS (optional, may be NULL) */
+    
+    LSM6D_PROFILE shadow;                               /* Last values written to the configuration registers */
+    uint8_t shadow_valid;
+    LSM6D_FIFO_STATE fifo;
+    uint16_t events_enabled;                            /* LSM6D_EVENT_x set by lsm6d_events_dev_configure */
+    
+    uint8_t acq_source;                                 /* LSM6D_ACQ_x source passed to lsm6d_dev_acq_start */
+    volatile uint8_t acq_head;                          /* Written only by lsm6d_dev_acq_isr */
+    volatile uint8_t acq_tail;                          /* Written only by the main loop */
+    volatile uint16_t acq_overflow_events;              /* Interrupts that found the queue full (see lsm6d_dev_acq_get_overflows) */
+    LSM6D_SENSOR_DATA acq_queue[LSM6D_QUEUE_SIZE];
+} LSM6D_DEVICE;
+
+/* Instance that the lsm6d_* functions below operate on - bound to the LSM6D_SPI_* macros in lsm6ds3x-cfg.h */
+extern LSM6D_DEVICE lsm6d_default_device;
+
+void lsm6d_dev_set_register_value(LSM6D_DEVICE *dev, uint8_t addr, uint8_t value);
+void lsm6d_dev_set_register_bits(LSM6D_DEVICE *dev, uint8_t addr, uint8_t bits);
+void lsm6d_dev_clear_register_bits(LSM6D_DEVICE *dev, uint8_t addr, uint8_t bits);
+
+uint8_t lsm6d_dev_get_register_value(LSM6D_DEVICE *dev, uint8_t addr);
+void lsm6d_dev_get_register_multi(LSM6D_DEVICE *dev, uint8_t start_addr, uint8_t *buffer, uint8_t num);
+
+/*
+ * Reset driver state and set BDU and IF_INC - bindings must already be set. Calling this
+ * is recommended but not required: the output reads set BDU and IF_INC themselves the
+ * first time they find either clear, e.g. after power-up or a software reset.
+ */
+void lsm6d_dev_init(LSM6D_DEVICE *dev);
+
+void lsm6d_dev_shadow_sync(LSM6D_DEVICE *dev);
+uint8_t lsm6d_dev_get_config_value(LSM6D_DEVICE *dev, uint8_t addr);
+void lsm6d_dev_profile_get(LSM6D_DEVICE *dev, LSM6D_PROFILE *profile);
+uint8_t lsm6d_dev_profile_apply(LSM6D_DEVICE *dev, const LSM6D_PROFILE *profile);
+
+int16_t lsm6d_dev_get_temperature(LSM6D_DEVICE *dev);
+void lsm6d_dev_get_accel_data(LSM6D_DEVICE *dev, LSM6D_XL_DATA *data);
+void lsm6d_dev_get_gyro_data(LSM6D_DEVICE *dev, LSM6D_G_DATA *data);
+
+void lsm6d_dev_get_all_motion_data(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *data);
+void lsm6d_dev_get_all_sensor_data(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *data);
+
+void lsm6d_dev_set_accel_data_rate(LSM6D_DEVICE *dev, uint8_t rate);
+void lsm6d_dev_set_gyro_data_rate(LSM6D_DEVICE *dev, uint8_t rate);
+
+void lsm6d_dev_set_accel_scale(LSM6D_DEVICE *dev, uint8_t scale);
+void lsm6d_dev_set_gyro_scale(LSM6D_DEVICE *dev, uint8_t scale);
+
+void lsm6d_dev_timestamp_enable(LSM6D_DEVICE *dev, uint8_t high_res);
+void lsm6d_dev_timestamp_disable(LSM6D_DEVICE *dev);
+uint32_t lsm6d_dev_get_timestamp(LSM6D_DEVICE *dev);
+
+void lsm6d_dev_fifo_configure(LSM6D_DEVICE *dev, uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold);
+uint8_t lsm6d_dev_fifo_get_status(LSM6D_DEVICE *dev, uint16_t *level, uint16_t *pattern);
+uint16_t lsm6d_dev_fifo_read(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint16_t max);
+uint16_t lsm6d_dev_fifo_read_timed(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint32_t *timestamps, uint16_t max);
+LSM6D_FIFO_STATE *lsm6d_dev_fifo_get_state(LSM6D_DEVICE *dev);
+
+void lsm6d_dev_acq_start(LSM6D_DEVICE *dev, uint8_t source);
+void lsm6d_dev_acq_stop(LSM6D_DEVICE *dev);
+void lsm6d_dev_acq_isr(LSM6D_DEVICE *dev);
+LSM6D_SENSOR_DATA *lsm6d_dev_acq_peek(LSM6D_DEVICE *dev, uint8_t *count);
+void lsm6d_dev_acq_release(LSM6D_DEVICE *dev, uint8_t count);
+uint8_t lsm6d_dev_acq_read(LSM6D_DEVICE *dev, LSM6D_SENSOR_DATA *out, uint8_t max);
+uint16_t lsm6d_dev_acq_get_overflows(LSM6D_DEVICE *dev);
+
+/* Does not depend on the device instance */
+void lsm6d_decode_words(const uint8_t *buffer, int16_t *out, uint8_t count);
+
+/* Single-device API - each function operates on lsm6d_default_device */
+
 void lsm6d_set_register_value(uint8_t addr, uint8_t value);
 void lsm6d_set_register_bits(uint8_t addr, uint8_t bits);
 void lsm6d_clear_register_bits(uint8_t addr, uint8_t bits);
@@ -765,7 +1039,14 @@ void lsm6d_clear_register_bits(uint8_t addr, uint8_t bits);
 uint8_t lsm6d_get_register_value(uint8_t addr);
 void lsm6d_get_register_multi(uint8_t startAddr, uint8_t *buffer, uint8_t num);
 
-int16_t lsm6d_get_temperature();
+void lsm6d_init(void);
+
+void lsm6d_shadow_sync(void);
+uint8_t lsm6d_get_config_value(uint8_t addr);
+void lsm6d_profile_get(LSM6D_PROFILE *profile);
+uint8_t lsm6d_profile_apply(const LSM6D_PROFILE *profile);
+
+int16_t lsm6d_get_temperature(void);
 void lsm6d_get_accel_data(LSM6D_XL_DATA *data);
 void lsm6d_get_gyro_data(LSM6D_G_DATA *data);
 
@@ -778,6 +1059,24 @@ void lsm6d_set_gyro_data_rate(uint8_t rate);
 void lsm6d_set_accel_scale(uint8_t scale);
 void lsm6d_set_gyro_scale(uint8_t scale);
 
+void lsm6d_timestamp_enable(uint8_t high_res);
+void lsm6d_timestamp_disable(void);
+uint32_t lsm6d_get_timestamp(void);
+
+void lsm6d_fifo_configure(uint8_t odr, uint8_t mode, uint8_t dec_xl, uint8_t dec_g, uint16_t threshold);
+uint8_t lsm6d_fifo_get_status(uint16_t *level, uint16_t *pattern);
+uint16_t lsm6d_fifo_read(LSM6D_SENSOR_DATA *out, uint16_t max);
+uint16_t lsm6d_fifo_read_timed(LSM6D_SENSOR_DATA *out, uint32_t *timestamps, uint16_t max);
+LSM6D_FIFO_STATE *lsm6d_fifo_get_state(void);
+
+void lsm6d_acq_start(uint8_t source);
+void lsm6d_acq_stop(void);
+void lsm6d_acq_isr(void);
+LSM6D_SENSOR_DATA *lsm6d_acq_peek(uint8_t *count);
+void lsm6d_acq_release(uint8_t count);
+uint8_t lsm6d_acq_read(LSM6D_SENSOR_DATA *out, uint8_t max);
+uint16_t lsm6d_acq_get_overflows(void);
+
 #ifdef	__cplusplus
 }
 #endif
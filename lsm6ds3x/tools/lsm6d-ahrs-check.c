@@ -0,0 +1,346 @@
+/*
+ * Host accuracy check and benchmark of the LSM6DS3x fixed-point orientation filter
+ * Copyright (c) 2019 David Rice
+ * 
+ * Feeds 60 s of synthetic motion, quantized as the sensor would report it, to
+ * lsm6d_ahrs_update and to the single-precision reference (lsm6d_ahrs_float_update),
+ * and checks that the orientations never differ by more than LIMIT_DEG and the Euler
+ * angles by more than EULER_LIMIT_DEG. Every gyro scale is run at 416 Hz and 1.66 kHz,
+ * with the default gains and with gyro integration only. With gyro integration only,
+ * the reference is also checked against the true motion. Also checks that long
+ * timestamp gaps are clamped to LSM6D_AHRS_MAX_DT_US. Prints each check and exits with
+ * status 1 if any failed.
+ * 
+ * With -b, also times both filters over BENCH_SAMPLES samples and prints the time per
+ * sample on this host. A host with an FPU favours the float filter, so the figures are
+ * only useful for comparing changes to either filter; target cycle counts need the
+ * target's simulator.
+ * 
+ * Build with, for example:
+ * cc -O2 -I. -I.. -DLSM6D_AHRS_FLOAT -o lsm6d-ahrs-check lsm6d-ahrs-check.c ../lsm6ds3x-ahrs.c -lm
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-ahrs.h"
+#include "lsm6ds3x-units.h"
+
+#ifndef LSM6D_AHRS_FLOAT
+#error "Build with -DLSM6D_AHRS_FLOAT so that the reference filter is included"
+#endif
+
+#define LIMIT_DEG       0.02
+#define EULER_LIMIT_DEG 0.05
+#define TRUTH_LIMIT_DEG 0.1
+#define EULER_MAX_PITCH 80.0    /* Roll and yaw are ill-conditioned closer to +/-90 degrees pitch */
+#define RUN_S           60
+#define BATCH           32
+#define BENCH_SAMPLES   4096
+#define BENCH_REPEAT    64
+#define XL_1G           16393   /* LSB at 2 g */
+#define PI              3.14159265358979
+
+/* True orientation and the sensor readings it produces */
+typedef struct {
+    double p[4];
+    double lsb;                 /* Gyro rad/s per LSB */
+    double dt;
+    long n;
+} MOTION;
+
+/* Largest differences seen over a run, in degrees */
+typedef struct {
+    double fixed;               /* Fixed point against the reference */
+    double euler;               /* Euler angles, fixed point against the reference */
+    double truth;               /* Reference against the true orientation */
+} RESULT;
+
+static int failures;
+
+static void check(int ok, const char *what) {
+    printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+    
+    if (!ok) {
+        failures++;
+    }
+}
+
+static void motion_init(MOTION *m, uint16_t g_mult, double dt) {
+    m->p[0] = 1.0;
+    m->p[1] = m->p[2] = m->p[3] = 0.0;
+    m->lsb = g_mult * PI / 1440000.0;
+    m->dt = dt;
+    m->n = 0;
+}
+
+/* Rotate the true orientation by the next rate, then report it as the sensor would */
+static void motion_next(MOTION *m, LSM6D_SENSOR_DATA *s) {
+    double *p = m->p;
+    double t = m->n * m->dt;
+    double w[3];
+    double h[3];
+    double p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3];
+    double n;
+    int i;
+    
+    w[0] = 1.5 * sin(t);
+    w[1] = 1.0 * cos(0.7 * t);
+    w[2] = 2.0 + 0.5 * sin(0.3 * t);
+    
+    for (i = 0; i < 3; i++) {
+        h[i] = 0.5 * w[i] * m->dt;
+    }
+    
+    p[0] = p0 - p1 * h[0] - p2 * h[1] - p3 * h[2];
+    p[1] = p1 + p0 * h[0] + p2 * h[2] - p3 * h[1];
+    p[2] = p2 + p0 * h[1] - p1 * h[2] + p3 * h[0];
+    p[3] = p3 + p0 * h[2] + p1 * h[1] - p2 * h[0];
+    
+    n = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2] + p[3] * p[3]);
+    
+    for (i = 0; i < 4; i++) {
+        p[i] /= n;
+    }
+    
+    s->g.x = (int16_t)lround(w[0] / m->lsb);
+    s->g.y = (int16_t)lround(w[1] / m->lsb);
+    s->g.z = (int16_t)lround(w[2] / m->lsb);
+    s->xl.x = (int16_t)lround(2.0 * (p[1] * p[3] - p[0] * p[2]) * XL_1G);
+    s->xl.y = (int16_t)lround(2.0 * (p[0] * p[1] + p[2] * p[3]) * XL_1G);
+    s->xl.z = (int16_t)lround((p[0] * p[0] - p[1] * p[1] - p[2] * p[2] + p[3] * p[3]) * XL_1G);
+    s->temp = 0;
+    
+    m->n++;
+}
+
+/* Rotation angle from a to b in degrees - from the relative quaternion, so rounding of |a| and |b| does not matter */
+static double angle_between(const double *a, const double *b) {
+    double w = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    double x = a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+    double y = a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+    double z = a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+    
+    return 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(w)) * 180.0 / PI;
+}
+
+/* Difference of two angles in degrees, wrapped to +/-180 */
+static double angle_diff(double a, double b) {
+    double d = fmod(a - b + 540.0, 360.0) - 180.0;
+    
+    return fabs(d);
+}
+
+static void run(uint16_t g_mult, uint32_t step_ticks, int gyro_only, RESULT *result) {
+    LSM6D_AHRS ahrs;
+    LSM6D_AHRS_F ref;
+    LSM6D_AHRS_EULER euler;
+    MOTION m;
+    LSM6D_SENSOR_DATA s[BATCH];
+    uint32_t ts[BATCH];
+    uint32_t t = 0xFFFFF000UL;          /* Wraps early in the run */
+    double dt = step_ticks * LSM6D_TIMESTAMP_LSB_US_HR * 1e-6;
+    double fixed_q[4];
+    double ref_q[4];
+    float roll, pitch, yaw;
+    double diff;
+    long batches = (long)(RUN_S / dt) / BATCH;
+    long b;
+    int k;
+    
+    memset(result, 0, sizeof(*result));
+    motion_init(&m, g_mult, dt);
+    
+    lsm6d_ahrs_init(&ahrs, g_mult, LSM6D_TIMESTAMP_LSB_US_HR, step_ticks * LSM6D_TIMESTAMP_LSB_US_HR);
+    lsm6d_ahrs_float_init(&ref, g_mult, LSM6D_TIMESTAMP_LSB_US_HR, step_ticks * LSM6D_TIMESTAMP_LSB_US_HR);
+    
+    if (gyro_only) {
+        ahrs.kp = 0;
+        ref.kp = 0.0f;
+    }
+    
+    /* The filters only start integrating at the second sample, so the truth starts there too */
+    motion_next(&m, &s[0]);
+    ts[0] = t;
+    t += step_ticks;
+    
+    lsm6d_ahrs_update(&ahrs, s, ts, 1);
+    lsm6d_ahrs_float_update(&ref, s, ts, 1);
+    motion_init(&m, g_mult, dt);
+    m.n = 1;
+    
+    for (b = 0; b < batches; b++) {
+        for (k = 0; k < BATCH; k++) {
+            motion_next(&m, &s[k]);
+            ts[k] = t;
+            t += step_ticks;
+        }
+        
+        lsm6d_ahrs_update(&ahrs, s, ts, BATCH);
+        lsm6d_ahrs_float_update(&ref, s, ts, BATCH);
+        
+        for (k = 0; k < 4; k++) {
+            fixed_q[k] = ahrs.q[k] / (double)LSM6D_AHRS_ONE;
+            ref_q[k] = ref.q[k];
+        }
+        
+        diff = angle_between(fixed_q, ref_q);
+        if (diff > result->fixed) {
+            result->fixed = diff;
+        }
+        
+        /* With accelerometer correction the filters lag the motion, so only gyro integration has a truth */
+        diff = angle_between(m.p, ref_q);
+        if (gyro_only && diff > result->truth) {
+            result->truth = diff;
+        }
+        
+        lsm6d_ahrs_get_euler(&ahrs, &euler);
+        lsm6d_ahrs_float_get_euler(&ref, &roll, &pitch, &yaw);
+        
+        diff = angle_diff(euler.pitch / 100.0, pitch);
+        
+        if (fabs(pitch) < EULER_MAX_PITCH) {
+            if (angle_diff(euler.roll / 100.0, roll) > diff) {
+                diff = angle_diff(euler.roll / 100.0, roll);
+            }
+            if (angle_diff(euler.yaw / 100.0, yaw) > diff) {
+                diff = angle_diff(euler.yaw / 100.0, yaw);
+            }
+        }
+        
+        if (diff > result->euler) {
+            result->euler = diff;
+        }
+    }
+}
+
+static void test_accuracy(uint16_t g_mult, const char *scale) {
+    static const uint32_t steps[2] = {96, 24};      /* 416 Hz and 1.66 kHz in 25 us ticks */
+    static const char *const rates[2] = {"416 Hz", "1.66 kHz"};
+    RESULT result;
+    char what[128];
+    int i;
+    int gyro_only;
+    
+    for (i = 0; i < 2; i++) {
+        for (gyro_only = 0; gyro_only < 2; gyro_only++) {
+            run(g_mult, steps[i], gyro_only, &result);
+            
+            snprintf(what, sizeof(what), "%s at %s%s within %.2f deg of reference (%.4f)",
+                    scale, rates[i], gyro_only ? ", gyro only," : "", LIMIT_DEG, result.fixed);
+            check(result.fixed <= LIMIT_DEG, what);
+            
+            snprintf(what, sizeof(what), "%s at %s%s Euler angles within %.2f deg of reference (%.4f)",
+                    scale, rates[i], gyro_only ? ", gyro only," : "", EULER_LIMIT_DEG, result.euler);
+            check(result.euler <= EULER_LIMIT_DEG, what);
+            
+            if (gyro_only) {
+                snprintf(what, sizeof(what), "%s at %s, gyro only, reference within %.2f deg of truth (%.4f)",
+                        scale, rates[i], TRUTH_LIMIT_DEG, result.truth);
+                check(result.truth <= TRUTH_LIMIT_DEG, what);
+            }
+        }
+    }
+}
+
+/* A gap longer than LSM6D_AHRS_MAX_DT_US is integrated as LSM6D_AHRS_MAX_DT_US */
+static void test_gap(uint16_t tick_us, uint32_t gap_ticks) {
+    LSM6D_AHRS ahrs;
+    LSM6D_SENSOR_DATA s[2] = {{0}};
+    uint32_t ts[2] = {1000, 1000 + gap_ticks};
+    int32_t expected = (int32_t)((((int64_t)LSM6D_AHRS_MAX_DT_US << LSM6D_AHRS_Q) + 500000L) / 1000000L);
+    char what[96];
+    
+    lsm6d_ahrs_init(&ahrs, LSM6D_UNITS_G_245DPS, tick_us, 2404);
+    lsm6d_ahrs_update(&ahrs, s, ts, 2);
+    
+    snprintf(what, sizeof(what), "gap of %lu ticks of %u us clamped", (unsigned long)gap_ticks, tick_us);
+    check(ahrs.dt == expected, what);
+}
+
+/* Host time per sample for both filters at 416 Hz and 2000 dps */
+static void bench(void) {
+    static LSM6D_SENSOR_DATA s[BENCH_SAMPLES];
+    static uint32_t ts[BENCH_SAMPLES];
+    LSM6D_AHRS ahrs;
+    LSM6D_AHRS_F ref;
+    MOTION m;
+    clock_t start;
+    double fixed_ns;
+    double float_ns;
+    int i;
+    int r;
+    
+    motion_init(&m, LSM6D_UNITS_G_2000DPS, 96 * LSM6D_TIMESTAMP_LSB_US_HR * 1e-6);
+    
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        motion_next(&m, &s[i]);
+        ts[i] = (uint32_t)i * 96;
+    }
+    
+    lsm6d_ahrs_init(&ahrs, LSM6D_UNITS_G_2000DPS, LSM6D_TIMESTAMP_LSB_US_HR, 2404);
+    start = clock();
+    for (r = 0; r < BENCH_REPEAT; r++) {
+        for (i = 0; i < BENCH_SAMPLES; i += BATCH) {
+            lsm6d_ahrs_update(&ahrs, &s[i], &ts[i], BATCH);
+        }
+    }
+    fixed_ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / ((double)BENCH_SAMPLES * BENCH_REPEAT);
+    
+    lsm6d_ahrs_float_init(&ref, LSM6D_UNITS_G_2000DPS, LSM6D_TIMESTAMP_LSB_US_HR, 2404);
+    start = clock();
+    for (r = 0; r < BENCH_REPEAT; r++) {
+        for (i = 0; i < BENCH_SAMPLES; i += BATCH) {
+            lsm6d_ahrs_float_update(&ref, &s[i], &ts[i], BATCH);
+        }
+    }
+    float_ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / ((double)BENCH_SAMPLES * BENCH_REPEAT);
+    
+    /* Print the results so that neither loop can be optimized away */
+    printf("bench: fixed %.1f ns/sample, float %.1f ns/sample on this host (q0 %ld, %f)\n",
+            fixed_ns, float_ns, (long)ahrs.q[0], ref.q[0]);
+}
+
+int main(int argc, char **argv) {
+    test_accuracy(LSM6D_UNITS_G_125DPS, "125 dps");
+    test_accuracy(LSM6D_UNITS_G_245DPS, "245 dps");
+    test_accuracy(LSM6D_UNITS_G_500DPS, "500 dps");
+    test_accuracy(LSM6D_UNITS_G_1000DPS, "1000 dps");
+    test_accuracy(LSM6D_UNITS_G_2000DPS, "2000 dps");
+    
+    test_gap(LSM6D_TIMESTAMP_LSB_US_HR, 40000);
+    test_gap(LSM6D_TIMESTAMP_LSB_US_HR, 0x80000000UL);
+    test_gap(LSM6D_TIMESTAMP_LSB_US, 16);
+    test_gap(LSM6D_TIMESTAMP_LSB_US, 100000);
+    
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        bench();
+    }
+    
+    printf("%d failed\n", failures);
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,396 @@
+/*
+ * Host test of the LSM6DS3x driver against the emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Runs the driver on the emulated SPI bus, covering FIFO pattern decoding after
+ * partial reads, FIFO decimation, 24-bit timestamp rollover, BDU and IF_INC setup,
+ * and acquisition queue overflow in both interrupt modes. Prints each check and
+ * exits with status 1 if any failed.
+ * 
+ * Build with, for example:
+ * cc -I. -I.. -o lsm6d-emu-test lsm6d-emu-test.c ../lsm6ds3x.c ../lsm6ds3x-emu.c
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-emu.h"
+
+/* One sample period at 104 Hz, rounded up */
+#define PERIOD_US       9616
+
+LSM6D_EMU emu;
+
+static LSM6D_SENSOR_DATA data[128];
+static uint32_t timestamps[128];
+static int failures;
+
+static void check(int ok, const char *what) {
+    printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+    
+    if (!ok) {
+        failures++;
+    }
+}
+
+/* Sample tick at 104 Hz - exact while the sample clocks started at time 0 */
+static uint32_t tick(uint32_t t_us) {
+    return (uint32_t)((uint64_t)t_us * 104 / 1000000);
+}
+
+/* Every axis encodes the tick it was sampled at, so a sample shows where each of its words came from */
+static void ramp(uint32_t t_us, LSM6D_EMU_MOTION *m) {
+    uint32_t k = tick(t_us);
+    uint8_t i;
+    
+    memset(m, 0, sizeof(*m));
+    
+    for (i = 0; i < 3; i++) {
+        m->xl[i] = (int32_t)(k + i);            /* mg */
+        m->g[i] = 35 * (int32_t)(k + i);        /* mdps, 4 LSB per step at 250 dps */
+    }
+    
+    m->temp = 2500;
+}
+
+/* Accelerometer X alternates between two values whose high bytes differ */
+static void toggle(uint32_t t_us, LSM6D_EMU_MOTION *m) {
+    memset(m, 0, sizeof(*m));
+    m->xl[0] = (tick(t_us) & 1) ? 16 : 15;
+    m->temp = 2500;
+}
+
+/* Raw output for an acceleration in mg at 2 g full scale, as the emulator rounds it */
+static int16_t xl_raw(int32_t mg) {
+    return (int16_t)((mg * 1000 + 30) / 61);
+}
+
+static int xl_at(const LSM6D_XL_DATA *xl, uint32_t k) {
+    return xl->x == xl_raw(k) && xl->y == xl_raw(k + 1) && xl->z == xl_raw(k + 2);
+}
+
+static int g_at(const LSM6D_G_DATA *g, uint32_t k) {
+    return g->x == (int16_t)(4 * k) && g->y == (int16_t)(4 * (k + 1)) && g->z == (int16_t)(4 * (k + 2));
+}
+
+/*
+ * Check samples decoded from a FIFO with the given decimation factors, the first at
+ * pattern position first. A sensor stored at a position has data from that tick; one
+ * that is not carries its previous value.
+ */
+static int check_stream(const LSM6D_SENSOR_DATA *s, uint16_t count, uint8_t first, uint8_t dec_xl, uint8_t dec_g, uint8_t period) {
+    uint8_t n = first;
+    uint32_t k = 0;
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        if (i == 0) {
+            k = (n % dec_xl == 0) ? ((uint32_t)s[0].xl.x * 61 + 500) / 1000 : (uint32_t)s[0].g.x / 4;
+        }
+        
+        if (n % dec_xl == 0) {
+            if (!xl_at(&s[i].xl, k)) {
+                return 0;
+            }
+        } else if (i && memcmp(&s[i].xl, &s[i - 1].xl, sizeof(s[i].xl)) != 0) {
+            return 0;
+        }
+        
+        if (n % dec_g == 0) {
+            if (!g_at(&s[i].g, k)) {
+                return 0;
+            }
+        } else if (i && memcmp(&s[i].g, &s[i - 1].g, sizeof(s[i].g)) != 0) {
+            return 0;
+        }
+        
+        /* Positions with neither sensor hold only a timestamp and produce no sample */
+        do {
+            n = (n + 1) % period;
+            k++;
+        } while ((n % dec_xl) && (n % dec_g));
+    }
+    
+    return 1;
+}
+
+static void setup(void (*source)(uint32_t t_us, LSM6D_EMU_MOTION *motion)) {
+    lsm6d_emu_init(&emu);
+    lsm6d_emu_set_source(&emu, source);
+    lsm6d_init();
+}
+
+static void start_sensors(void) {
+    lsm6d_set_accel_data_rate(_CTRL1_XL_ODR_XL_104HZ);
+    lsm6d_set_gyro_data_rate(_CTRL2_G_ODR_G_104HZ);
+}
+
+/* Reads that stop mid-sample, or words taken out behind the driver's back, resume at the right word */
+static void test_fifo_pattern(void) {
+    uint8_t word[2];
+    uint8_t first;
+    uint16_t count = 0;
+    
+    setup(ramp);
+    start_sensors();
+    lsm6d_fifo_configure(_FIFO_CTRL5_ODR_FIFO_104HZ, _FIFO_CTRL5_FIFO_CONTINUOUS,
+            _FIFO_CTRL3_DECIMATION_NONE, _FIFO_CTRL3_DECIMATION_NONE, 0);
+    
+    lsm6d_emu_advance(&emu, 20 * PERIOD_US);
+    check(lsm6d_fifo_read(data, 8) == 8 && check_stream(data, 8, 0, 1, 1, 1), "FIFO read decodes gyro and accelerometer of each sample");
+    
+    /* One sample at a time - each read takes 3 words, leaving half a sample behind */
+    while (count < 10) {
+        if (lsm6d_fifo_read(&data[count], 1) == 0) {
+            break;
+        }
+        count++;
+    }
+    check(count == 10 && check_stream(data, count, 0, 1, 1, 1), "FIFO reads ending mid-sample continue in the next read");
+    
+    /* Drop one word - FIFO_STATUS3 puts the decoder back on the pattern */
+    lsm6d_emu_advance(&emu, 10 * PERIOD_US);
+    lsm6d_get_register_multi(LSM6D_FIFO_DATA_OUT_L, word, 2);
+    count = lsm6d_fifo_read(data, 64);
+    first = lsm6d_fifo_get_state()->first;
+    check(count > 2 && first == 0 && g_at(&data[1].g, (uint32_t)data[1].g.x / 4) &&
+            check_stream(&data[1], count - 1, 0, 1, 1, 1), "FIFO read resynchronizes after a word was taken out");
+}
+
+/* Decimated sensors repeat their last value between stored samples */
+static void test_fifo_decimation(void) {
+    uint16_t count;
+    uint16_t i;
+    int ok = 1;
+    
+    setup(ramp);
+    start_sensors();
+    lsm6d_fifo_configure(_FIFO_CTRL5_ODR_FIFO_104HZ, _FIFO_CTRL5_FIFO_CONTINUOUS,
+            _FIFO_CTRL3_DECIMATION_NONE, _FIFO_CTRL3_DECIMATION_2, 0);
+    
+    lsm6d_emu_advance(&emu, 40 * PERIOD_US);
+    count = lsm6d_fifo_read(data, 16);
+    check(lsm6d_fifo_get_state()->period == 2 && count == 16 &&
+            check_stream(data, count, lsm6d_fifo_get_state()->first, 1, 2, 2), "FIFO gyro decimated by 2");
+    
+    count = lsm6d_fifo_read(data, 64);
+    check(count > 16 && check_stream(data, count, lsm6d_fifo_get_state()->first, 1, 2, 2), "FIFO gyro decimated by 2, second read");
+    
+    /* Factors 2 and 3 with timestamps - some pattern positions hold a timestamp alone */
+    setup(ramp);
+    start_sensors();
+    lsm6d_timestamp_enable(0);
+    lsm6d_fifo_configure(_FIFO_CTRL5_ODR_FIFO_104HZ, _FIFO_CTRL5_FIFO_CONTINUOUS,
+            _FIFO_CTRL3_DECIMATION_2, _FIFO_CTRL3_DECIMATION_3, 0);
+    
+    lsm6d_emu_advance(&emu, 60 * PERIOD_US);
+    count = lsm6d_fifo_read_timed(data, timestamps, 64);
+    
+    for (i = 1; i < count; i++) {
+        if (timestamps[i] <= timestamps[i - 1]) {
+            ok = 0;
+        }
+    }
+    
+    check(lsm6d_fifo_get_state()->period == 6 && lsm6d_fifo_get_state()->dec_ts == 1 && count == 40 &&
+            check_stream(data, count, lsm6d_fifo_get_state()->first, 2, 3, 6), "FIFO accelerometer by 2, gyro by 3");
+    check(ok, "FIFO timestamps increase with decimation");
+}
+
+/* The FIFO timestamp keeps counting past 2^24 while the chip counter wraps */
+static void test_timestamp_rollover(void) {
+    uint16_t count;
+    uint16_t i;
+    uint32_t step;
+    int ok = 1;
+    
+    setup(ramp);
+    lsm6d_timestamp_enable(1);
+    
+    /* 100 ms before the 24-bit counter wraps at 25 us per count */
+    lsm6d_emu_advance(&emu, (0x01000000UL - 4000) * LSM6D_TIMESTAMP_LSB_US_HR);
+    
+    start_sensors();
+    lsm6d_fifo_configure(_FIFO_CTRL5_ODR_FIFO_104HZ, _FIFO_CTRL5_FIFO_CONTINUOUS,
+            _FIFO_CTRL3_DECIMATION_NONE, _FIFO_CTRL3_DECIMATION_NONE, 0);
+    lsm6d_emu_advance(&emu, 300000);
+    
+    /* Two reads, so the unwrapped count is carried between calls */
+    count = lsm6d_fifo_read_timed(data, timestamps, 5);
+    count += lsm6d_fifo_read_timed(&data[count], &timestamps[count], 64);
+    
+    for (i = 1; i < count; i++) {
+        step = timestamps[i] - timestamps[i - 1];
+        if (step < PERIOD_US / LSM6D_TIMESTAMP_LSB_US_HR - 1 || step > PERIOD_US / LSM6D_TIMESTAMP_LSB_US_HR + 1) {
+            ok = 0;
+        }
+    }
+    
+    check(count >= 30 && timestamps[0] < 0x01000000UL && timestamps[count - 1] > 0x01000000UL,
+            "FIFO timestamps unwrapped across 24-bit rollover");
+    check(ok, "FIFO timestamp steps are one sample period across rollover");
+    check(lsm6d_get_timestamp() < 10000, "Timestamp register wraps at 24 bits");
+}
+
+/* CS and SPI bindings that advance the emulator one sample period per byte */
+static void slow_cs(uint8_t active) {
+    lsm6d_emu_select(&emu, active);
+}
+
+static uint8_t slow_xfer(uint8_t data) {
+    uint8_t value = lsm6d_emu_transfer(&emu, data);
+    
+    lsm6d_emu_advance(&emu, PERIOD_US);
+    
+    return value;
+}
+
+/* Count accelerometer X readings that mix bytes of two samples (toggle source) */
+static uint8_t torn_reads(LSM6D_DEVICE *dev, uint8_t reads) {
+    LSM6D_SENSOR_DATA s;
+    uint8_t torn = 0;
+    uint8_t i;
+    
+    for (i = 0; i < reads; i++) {
+        lsm6d_dev_get_all_sensor_data(dev, &s);
+        if (s.xl.x != xl_raw(15) && s.xl.x != xl_raw(16)) {
+            torn++;
+        }
+    }
+    
+    return torn;
+}
+
+/* Output reads set BDU and IF_INC themselves, also without lsm6d_init or after a reset */
+static void test_bdu(void) {
+    static LSM6D_DEVICE slow;
+    LSM6D_SENSOR_DATA s;
+    LSM6D_PROFILE profile;
+    uint32_t transactions;
+    
+    /* Power-on defaults: IF_INC set, BDU clear - the device is never initialized */
+    slow.cs = slow_cs;
+    slow.xfer_spi = slow_xfer;
+    lsm6d_emu_init(&emu);
+    lsm6d_emu_set_source(&emu, toggle);
+    lsm6d_dev_set_accel_data_rate(&slow, _CTRL1_XL_ODR_XL_104HZ);
+    
+    check(torn_reads(&slow, 20) == 0 && (emu.regs[LSM6D_CTRL3_C] & _CTRL3_C_BDU_MASK),
+            "BDU set by the first read keeps samples whole");
+    
+    /* Clearing BDU behind the driver's back shows the reads would tear without it */
+    emu.regs[LSM6D_CTRL3_C] &= ~_CTRL3_C_BDU_MASK;
+    check(torn_reads(&slow, 20) > 0, "Reads tear without BDU");
+    
+    setup(ramp);
+    start_sensors();
+    lsm6d_emu_advance(&emu, 5 * PERIOD_US);
+    
+    /* Once set, the check is made on the shadow and costs no bus traffic */
+    transactions = emu.stats.transactions;
+    lsm6d_get_all_sensor_data(&s);
+    check(emu.stats.transactions == transactions + 1, "Output read is a single transaction after init");
+    
+    lsm6d_set_register_value(LSM6D_CTRL3_C, _CTRL3_C_SW_RESET_MASK);
+    start_sensors();
+    lsm6d_emu_advance(&emu, 5 * PERIOD_US);
+    lsm6d_get_all_sensor_data(&s);
+    check((emu.regs[LSM6D_CTRL3_C] & _CTRL3_C_BDU_MASK) && g_at(&s.g, tick(emu.now_us)) && xl_at(&s.xl, tick(emu.now_us)),
+            "BDU restored after software reset");
+    
+    lsm6d_set_register_value(LSM6D_CTRL3_C, 0);
+    lsm6d_get_all_sensor_data(&s);
+    check((emu.regs[LSM6D_CTRL3_C] & _CTRL3_C_IF_INC_MASK) && g_at(&s.g, tick(emu.now_us)) && xl_at(&s.xl, tick(emu.now_us)),
+            "IF_INC restored before a burst read");
+    
+    lsm6d_profile_get(&profile);
+    profile.ctrl[LSM6D_CTRL3_C - LSM6D_CTRL1_XL] = 0;
+    lsm6d_profile_apply(&profile);
+    check((emu.regs[LSM6D_CTRL3_C] & (_CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK)) == (_CTRL3_C_BDU_MASK | _CTRL3_C_IF_INC_MASK),
+            "Profile apply keeps BDU and IF_INC set");
+}
+
+/* Advance in 1 ms steps, running the acquisition ISR while INT1 is asserted */
+static uint16_t run_acq(uint32_t ms) {
+    uint16_t interrupts = 0;
+    
+    while (ms--) {
+        lsm6d_emu_advance(&emu, 1000);
+        
+        if (LSM6D_INT1) {
+            lsm6d_acq_isr();
+            interrupts++;
+        }
+    }
+    
+    return interrupts;
+}
+
+/* Data-ready mode drops one sample per overflow; FIFO mode leaves the data in the FIFO */
+static void test_acq_overflow(void) {
+    uint16_t interrupts;
+    uint16_t count;
+    uint16_t i;
+    
+    setup(ramp);
+    start_sensors();
+    lsm6d_acq_start(LSM6D_ACQ_DRDY);
+    
+    interrupts = run_acq(300);
+    count = lsm6d_acq_read(data, 64);
+    check(count == LSM6D_QUEUE_SIZE && check_stream(data, count, 0, 1, 1, 1), "Data-ready queue keeps the oldest samples");
+    check(interrupts > LSM6D_QUEUE_SIZE && lsm6d_acq_get_overflows() == interrupts - LSM6D_QUEUE_SIZE,
+            "Data-ready overflow events match samples dropped");
+    
+    setup(ramp);
+    start_sensors();
+    lsm6d_fifo_configure(_FIFO_CTRL5_ODR_FIFO_104HZ, _FIFO_CTRL5_FIFO_CONTINUOUS,
+            _FIFO_CTRL3_DECIMATION_NONE, _FIFO_CTRL3_DECIMATION_NONE, 24);
+    lsm6d_acq_start(LSM6D_ACQ_FIFO);
+    
+    /* Nothing is taken from the queue until well after it fills */
+    run_acq(400);
+    check(lsm6d_acq_get_overflows() > 0, "FIFO mode counts overflow events");
+    
+    count = lsm6d_acq_read(data, 64);
+    
+    for (i = 0; i < 300 && count < 64; i++) {
+        run_acq(1);
+        count += lsm6d_acq_read(&data[count], 64 - count);
+    }
+    
+    check(count == 64 && lsm6d_fifo_get_state()->overruns == 0 && check_stream(data, count, 0, 1, 1, 1),
+            "FIFO mode loses no samples after queue overflow");
+}
+
+int main(void) {
+    test_fifo_pattern();
+    test_fifo_decimation();
+    test_timestamp_rollover();
+    test_bdu();
+    test_acq_overflow();
+    
+    printf("%d failed\n", failures);
+    
+    return failures ? 1 : 0;
+}
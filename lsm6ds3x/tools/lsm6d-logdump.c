@@ -0,0 +1,145 @@
+/*
+ * Host tool to dump LSM6DS3x compressed sample logs
+ * Copyright (c) 2019 David Rice
+ * 
+ * Prints every sample of a log written with lsm6d_log_encode as CSV - time in us,
+ * gyro in mdps, acceleration in mg and, when logged, temperature in 0.01 degC -
+ * followed by a summary on stderr. Damaged blocks are skipped.
+ * 
+ * Build with, for example:
+ * cc -I. -I.. -DLSM6D_UNITS_FS_XL=0 -DLSM6D_UNITS_FS_G=0 -o lsm6d-logdump lsm6d-logdump.c \
+ *         ../lsm6ds3x-log.c ../lsm6ds3x-crc.c ../lsm6ds3x-units.c
+ * 
+ * The scale comes from each block header; the fixed scale settings only keep
+ * lsm6ds3x-units.c from needing the driver's register shadow.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "lsm6ds3x.h"
+#include "lsm6ds3x-log.h"
+#include "lsm6ds3x-units.h"
+
+/* Temperature column state of the last header printed: -1 before the first block */
+static int temp_column = -1;
+
+static void dump_block(const LSM6D_LOG_HEADER *hdr, const LSM6D_SENSOR_DATA *samples, const uint32_t *timestamps) {
+    int32_t xl = lsm6d_units_xl_mult_reg(hdr->ctrl1_xl);
+    int32_t g = lsm6d_units_g_mult_reg(hdr->ctrl2_g);
+    uint32_t lsb = (hdr->flags & LSM6D_LOG_TS_HR) ? LSM6D_TIMESTAMP_LSB_US_HR : LSM6D_TIMESTAMP_LSB_US;
+    int temp = (hdr->flags & LSM6D_LOG_TEMP) ? 1 : 0;
+    const LSM6D_SENSOR_DATA *s;
+    uint16_t i;
+    
+    /* Column header again whenever the temperature channel comes or goes */
+    if (temp != temp_column) {
+        printf("t_us,gx_mdps,gy_mdps,gz_mdps,ax_mg,ay_mg,az_mg%s\n", temp ? ",temp_cdeg" : "");
+        temp_column = temp;
+    }
+    
+    for (i = 0; i < hdr->count; i++) {
+        s = &samples[i];
+        
+        printf("%llu,%ld,%ld,%ld,%ld,%ld,%ld", (unsigned long long)timestamps[i] * lsb,
+                (long)((s->g.x * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT),
+                (long)((s->g.y * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT),
+                (long)((s->g.z * g + (1L << (LSM6D_UNITS_G_SHIFT - 1))) >> LSM6D_UNITS_G_SHIFT),
+                (long)((s->xl.x * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT),
+                (long)((s->xl.y * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT),
+                (long)((s->xl.z * xl + (1L << (LSM6D_UNITS_XL_SHIFT - 1))) >> LSM6D_UNITS_XL_SHIFT));
+        
+        if (hdr->flags & LSM6D_LOG_TEMP) {
+            printf(",%d", lsm6d_units_temp(s->temp));
+        }
+        
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    static LSM6D_SENSOR_DATA samples[LSM6D_LOG_MAX_SAMPLES];
+    static uint32_t timestamps[LSM6D_LOG_MAX_SAMPLES];
+    LSM6D_LOG_HEADER hdr;
+    FILE *f;
+    uint8_t *data;
+    long size;
+    long pos = 0;
+    long len;
+    long blocks = 0;
+    long samples_total = 0;
+    long skipped = 0;
+    uint16_t used;
+    uint8_t result;
+    
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s log-file\n", argv[0]);
+        return 2;
+    }
+    
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    
+    data = malloc(size ? size : 1);
+    if (!data || fread(data, 1, size, f) != (size_t)size) {
+        fprintf(stderr, "%s: read failed\n", argv[1]);
+        return 1;
+    }
+    
+    fclose(f);
+    
+    while (pos < size) {
+        len = (size - pos > 0xFFFF) ? 0xFFFF : size - pos;
+        result = lsm6d_log_decode(&data[pos], (uint16_t)len, &hdr, samples, timestamps, &used);
+        
+        if (result == LSM6D_LOG_SHORT) {
+            skipped += size - pos;
+            break;
+        }
+        
+        if (result == LSM6D_LOG_BAD) {
+            skipped += used;
+            pos += used;
+            continue;
+        }
+        
+        dump_block(&hdr, samples, timestamps);
+        
+        blocks++;
+        samples_total += hdr.count;
+        pos += used;
+    }
+    
+    fprintf(stderr, "%ld blocks, %ld samples, %ld bytes skipped, %.2f bytes/sample (raw 12)\n",
+            blocks, samples_total, skipped, samples_total ? (double)(size - skipped) / samples_total : 0.0);
+    
+    free(data);
+    
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * LSM6DS3x driver configuration for host tools - binds the driver to the emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LSM6DS3X_CFG_H
+#define LSM6DS3X_CFG_H
+
+#include "lsm6ds3x-emu.h"
+
+/* Defined by the tool, e.g. lsm6d-emu-test.c */
+extern LSM6D_EMU emu;
+
+#define LSM6D_SPI_ACTIVE()          lsm6d_emu_select(&emu, 1)
+#define LSM6D_SPI_IDLE()            lsm6d_emu_select(&emu, 0)
+#define LSM6D_SPI_TRANSFER(x)       lsm6d_emu_transfer(&emu, x)
+#define LSM6D_INT1                  lsm6d_emu_int1(&emu)
+#define LSM6D_INT2                  lsm6d_emu_int2(&emu)
+
+#endif	/* LSM6DS3X_CFG_H */
@@ -0,0 +1,226 @@
+/*
+ * Non-blocking MPU-6050 data path on the I2C transaction engine
+ * Copyright (c) 2019 David Rice
+ * 
+ * The blocking driver holds the CPU for the whole burst (about 400 us for the sensor
+ * registers at 400 kHz). Requests here are queued on i2c.c instead and complete in
+ * the background, so other interrupts, e.g. the radio, are serviced meanwhile.
+ * Configuration is still done with the blocking mpu6050_* functions, which must not
+ * be used while requests are queued since they drive the bus directly. FIFO streaming
+ * is a chain of transactions, so a FIFO read never holds the bus between steps.
+ * 
+ * Uses MPU6050_ADDRESS from mpu6050-cfg.h.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Configuration first, so that it can override MPU6050_ADDRESS */
+#include "mpu6050-cfg.h"
+#include "mpu6050.h"
+#include "mpu6050-async.h"
+
+static void mpu6050_async_complete(I2C_TRANSACTION *t) {
+    MPU6050_ASYNC *req = (MPU6050_ASYNC *)t->context;
+    
+    if (req->done) {
+        req->done(req);
+    }
+}
+
+static void mpu6050_async_sensors_complete(I2C_TRANSACTION *t) {
+    MPU6050_ASYNC *req = (MPU6050_ASYNC *)t->context;
+    
+    if (t->status == I2C_DONE) {
+        mpu6050_decode_sensor_data(req->buffer, &req->data);
+    }
+    
+    if (req->done) {
+        req->done(req);
+    }
+}
+
+static uint8_t mpu6050_async_submit(MPU6050_ASYNC *req, uint8_t tx_len, uint8_t *rx, uint16_t rx_len,
+        void (*complete)(I2C_TRANSACTION *t), void (*done)(MPU6050_ASYNC *req)) {
+    I2C_TRANSACTION *t = &req->t;
+    
+    t->addr = MPU6050_ADDRESS;
+    t->tx = req->reg;
+    t->tx_len = tx_len;
+    t->rx = rx;
+    t->rx_len = rx_len;
+    t->done = complete;
+    t->context = req;
+    req->done = done;
+    
+    return i2c_submit(t);
+}
+
+uint8_t mpu6050_async_read_sensors(MPU6050_ASYNC *req, uint8_t ext_len, void (*done)(MPU6050_ASYNC *req)) {
+    if (ext_len > MPU6050_EXT_SENS_BYTES) {
+        ext_len = MPU6050_EXT_SENS_BYTES;
+    }
+    
+    req->reg[0] = ACCEL_XOUT_H;
+    
+    return mpu6050_async_submit(req, 1, req->buffer, MPU6050_SENSOR_BYTES + ext_len, mpu6050_async_sensors_complete, done);
+}
+
+uint8_t mpu6050_async_read_registers(MPU6050_ASYNC *req, uint8_t start_addr, uint8_t *buffer, uint16_t len,
+        void (*done)(MPU6050_ASYNC *req)) {
+    req->reg[0] = start_addr;
+    
+    return mpu6050_async_submit(req, 1, buffer, len, mpu6050_async_complete, done);
+}
+
+uint8_t mpu6050_async_write_register(MPU6050_ASYNC *req, uint8_t addr, uint8_t value, void (*done)(MPU6050_ASYNC *req)) {
+    req->reg[0] = addr;
+    req->reg[1] = value;
+    
+    return mpu6050_async_submit(req, 2, NULL, 0, mpu6050_async_complete, done);
+}
+
+static void mpu6050_async_fifo_finish(MPU6050_ASYNC_FIFO *fifo, uint8_t status) {
+    fifo->status = status;
+    
+    if (fifo->done) {
+        fifo->done(fifo);
+    }
+}
+
+/* Steps are queued from the completion of the previous one, which has just freed a slot */
+static void mpu6050_async_fifo_step(MPU6050_ASYNC_FIFO *fifo, uint8_t queued) {
+    if (!queued) {
+        mpu6050_async_fifo_finish(fifo, I2C_IDLE);
+    }
+}
+
+static void mpu6050_async_fifo_burst(MPU6050_ASYNC_FIFO *fifo);
+
+static void mpu6050_async_fifo_write_done(MPU6050_ASYNC *req) {
+    mpu6050_async_fifo_finish((MPU6050_ASYNC_FIFO *)req->context, req->t.status);
+}
+
+static void mpu6050_async_fifo_reset_done(MPU6050_ASYNC *req) {
+    MPU6050_ASYNC_FIFO *fifo = (MPU6050_ASYNC_FIFO *)req->context;
+    
+    if (req->t.status != I2C_DONE || !mpu6050_fifo_get_state()->sensors) {
+        mpu6050_async_fifo_finish(fifo, req->t.status);
+        return;
+    }
+    
+    mpu6050_async_fifo_step(fifo, mpu6050_async_write_register(req, USER_CTRL, mpu6050_get_user_ctrl(),
+            mpu6050_async_fifo_write_done));
+}
+
+static void mpu6050_async_fifo_data_done(MPU6050_ASYNC *req) {
+    MPU6050_ASYNC_FIFO *fifo = (MPU6050_ASYNC_FIFO *)req->context;
+    uint8_t frame_len = mpu6050_fifo_get_state()->frame_len;
+    uint16_t i;
+    
+    if (req->t.status != I2C_DONE) {
+        mpu6050_async_fifo_finish(fifo, req->t.status);
+        return;
+    }
+    
+    for (i = 0; i < req->t.rx_len; i += frame_len) {
+        mpu6050_fifo_decode(&fifo->buffer[i], &fifo->out[fifo->count++], NULL);
+    }
+    
+    mpu6050_async_fifo_burst(fifo);
+}
+
+static void mpu6050_async_fifo_burst(MPU6050_ASYNC_FIFO *fifo) {
+    uint8_t frame_len = mpu6050_fifo_get_state()->frame_len;
+    uint8_t per_burst = MPU6050_ASYNC_FIFO_BURST / frame_len;
+    uint8_t burst;
+    
+    if (fifo->count >= fifo->frames) {
+        mpu6050_async_fifo_finish(fifo, I2C_DONE);
+        return;
+    }
+    
+    burst = (fifo->frames - fifo->count > per_burst) ? per_burst : (uint8_t)(fifo->frames - fifo->count);
+    
+    mpu6050_async_fifo_step(fifo, mpu6050_async_read_registers(&fifo->req, FIFO_R_W, fifo->buffer,
+            (uint16_t)burst * frame_len, mpu6050_async_fifo_data_done));
+}
+
+/* The count alone misses an overflow once frames have been read out after it */
+static void mpu6050_async_fifo_count_done(MPU6050_ASYNC *req) {
+    MPU6050_ASYNC_FIFO *fifo = (MPU6050_ASYNC_FIFO *)req->context;
+    uint16_t count;
+    
+    if (req->t.status != I2C_DONE) {
+        mpu6050_async_fifo_finish(fifo, req->t.status);
+        return;
+    }
+    
+    count = ((uint16_t)req->buffer[0] << 8) | req->buffer[1];
+    
+    if ((fifo->int_status & INT_STATUS_FIFO_OFLOW_INT) || count >= MPU6050_FIFO_SIZE) {
+        mpu6050_fifo_get_state()->overflows++;
+        fifo->overflow = 1;
+        mpu6050_async_fifo_step(fifo, mpu6050_async_write_register(req, USER_CTRL,
+                (mpu6050_get_user_ctrl() & ~USER_CTRL_FIFO_EN) | USER_CTRL_FIFO_RESET, mpu6050_async_fifo_reset_done));
+        return;
+    }
+    
+    fifo->frames = count / mpu6050_fifo_get_state()->frame_len;
+    
+    if (fifo->frames > fifo->max) {
+        fifo->frames = fifo->max;
+    }
+    
+    mpu6050_async_fifo_burst(fifo);
+}
+
+static void mpu6050_async_fifo_status_done(MPU6050_ASYNC *req) {
+    MPU6050_ASYNC_FIFO *fifo = (MPU6050_ASYNC_FIFO *)req->context;
+    
+    if (req->t.status != I2C_DONE) {
+        mpu6050_async_fifo_finish(fifo, req->t.status);
+        return;
+    }
+    
+    fifo->int_status = req->buffer[0];
+    
+    mpu6050_async_fifo_step(fifo, mpu6050_async_read_registers(req, FIFO_COUNTH, req->buffer, 2,
+            mpu6050_async_fifo_count_done));
+}
+
+uint8_t mpu6050_async_fifo_read(MPU6050_ASYNC_FIFO *fifo, MPU6050_SENSOR_DATA *out, uint16_t max,
+        void (*done)(MPU6050_ASYNC_FIFO *fifo)) {
+    if (mpu6050_fifo_get_state()->frame_len == 0) {
+        return 0;
+    }
+    
+    fifo->out = out;
+    fifo->max = max;
+    fifo->frames = 0;
+    fifo->count = 0;
+    fifo->overflow = 0;
+    fifo->status = I2C_PENDING;
+    fifo->done = done;
+    fifo->req.context = fifo;
+    
+    return mpu6050_async_read_registers(&fifo->req, INT_STATUS, fifo->req.buffer, 1, mpu6050_async_fifo_status_done);
+}
@@ -0,0 +1,110 @@
+/*
+ * Constant definitions and function prototypes for
+ * MPU-6050 non-blocking data path on the I2C transaction engine
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MPU6050_ASYNC_H
+#define MPU6050_ASYNC_H
+
+#include <stdint.h>
+
+#include "mpu6050.h"
+#include "i2c.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * A request owns its transaction and buffers, and must not be reused until it completes.
+ * done is called from i2c_isr with t.status set to I2C_DONE, or I2C_NACK, I2C_COLLISION or
+ * I2C_TIMEOUT if it failed.
+ */
+typedef struct MPU6050_ASYNC {
+    I2C_TRANSACTION t;
+    uint8_t reg[2];                                         /* Register address, and value for writes */
+    uint8_t buffer[MPU6050_SENSOR_BYTES + MPU6050_EXT_SENS_BYTES];
+    MPU6050_SENSOR_DATA data;                               /* Decoded by mpu6050_async_read_sensors */
+    void (*done)(struct MPU6050_ASYNC *req);
+    void *context;                                          /* For the owner of the request */
+} MPU6050_ASYNC;
+
+/* Slave data read along with the sensors, after MPU6050_SENSOR_BYTES */
+#define mpu6050_async_ext(req)      (&(req)->buffer[MPU6050_SENSOR_BYTES])
+
+/*
+ * Queue the 14-byte accelerometer, temperature and gyro burst, plus ext_len bytes of
+ * EXT_SENS_DATA - e.g. from the data ready interrupt. Returns 0 if the queue is full.
+ */
+uint8_t mpu6050_async_read_sensors(MPU6050_ASYNC *req, uint8_t ext_len, void (*done)(MPU6050_ASYNC *req));
+
+/* Read len bytes from start_addr into buffer (FIFO_R_W does not auto-increment, so FIFO bursts work too) */
+uint8_t mpu6050_async_read_registers(MPU6050_ASYNC *req, uint8_t start_addr, uint8_t *buffer, uint16_t len,
+        void (*done)(MPU6050_ASYNC *req));
+
+uint8_t mpu6050_async_write_register(MPU6050_ASYNC *req, uint8_t addr, uint8_t value, void (*done)(MPU6050_ASYNC *req));
+
+/*
+ * Most FIFO bytes per transaction of mpu6050_async_fifo_read, rounded down to whole frames.
+ * Define it project-wide to override, since it sets the size of MPU6050_ASYNC_FIFO.
+ */
+#ifndef MPU6050_ASYNC_FIFO_BURST
+#define MPU6050_ASYNC_FIFO_BURST    120
+#endif
+
+#if MPU6050_ASYNC_FIFO_BURST < MPU6050_SENSOR_BYTES + MPU6050_EXT_SENS_BYTES
+#error "MPU6050_ASYNC_FIFO_BURST must hold at least one frame"
+#endif
+
+/*
+ * A FIFO read runs as a chain of transactions on req: INT_STATUS, FIFO_COUNTH, then
+ * bursts from FIFO_R_W, each queued from the completion of the one before. done is
+ * called once, from i2c_isr, with status set to the status of the last transaction, or
+ * I2C_IDLE if a step could not be queued.
+ */
+typedef struct MPU6050_ASYNC_FIFO {
+    MPU6050_ASYNC req;
+    uint8_t buffer[MPU6050_ASYNC_FIFO_BURST];
+    MPU6050_SENSOR_DATA *out;
+    uint16_t max;
+    uint16_t frames;                                        /* Whole frames to read, at most max */
+    uint16_t count;                                         /* Frames decoded into out so far */
+    uint8_t int_status;
+    uint8_t overflow;                                       /* The FIFO was reset, and count is 0 */
+    uint8_t status;
+    void (*done)(struct MPU6050_ASYNC_FIFO *fifo);
+    void *context;                                          /* For the owner of the request */
+} MPU6050_ASYNC_FIFO;
+
+/*
+ * As mpu6050_fifo_read, without slave data: up to max whole frames are decoded into out.
+ * An overflow resets the FIFO, counted in mpu6050_fifo_get_state()->overflows. Returns 0
+ * if the FIFO is not configured or the queue is full.
+ */
+uint8_t mpu6050_async_fifo_read(MPU6050_ASYNC_FIFO *fifo, MPU6050_SENSOR_DATA *out, uint16_t max,
+        void (*done)(MPU6050_ASYNC_FIFO *fifo));
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* MPU6050_ASYNC_H */
@@ -0,0 +1,544 @@
+/*
+ * Host-side I2C emulator for InvenSense MPU-6050
+ * Copyright (c) 2019 David Rice
+ * 
+ * Emulates what the driver relies on at register level: WHO_AM_I, auto-increment
+ * (except at FIFO_R_W), SLEEP and DEVICE_RESET, sampling at the rate set by
+ * SMPLRT_DIV and DLPF_CFG with full-scale settings applied, the FIFO (frame layout
+ * from FIFO_EN, FIFO_COUNT, FIFO_RESET, and overwriting the oldest data when full),
+ * INT_STATUS latching with clear-on-read or INT_RD_CLEAR, and the auxiliary master:
+ * slaves 0 to 3 are read into EXT_SENS_DATA (with BYTE_SW, GRP, REG_DIS, I2C_MST_DLY
+ * and the FIFO) or written from I2C_SLVx_DO each sample, and SLV4 single-byte
+ * transfers complete at the next sample with I2C_MST_STATUS set. Motion comes from a
+ * callback or a recorded trace, so runs are deterministic.
+ * 
+ * Not emulated: the DLPF itself and sensor noise, self-test, cycle mode and the
+ * standby bits in PWR_MGMT_2, FSYNC, the 50 us INT pulse (the pin follows the
+ * enabled INT_STATUS bits), bypass mode and I2C_MST_P_NSR (a repeated START is
+ * always used). The FIFO reads as 0 when empty.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mpu6050.h"
+#include "mpu6050-emu.h"
+
+#define MPU6050_EMU_FIFO_MASK     (MPU6050_EMU_FIFO_BYTES - 1)
+
+/* Sample period in us before SMPLRT_DIV, with the DLPF disabled or enabled */
+#define MPU6050_EMU_PERIOD_FAST   125U
+#define MPU6050_EMU_PERIOD        1000U
+
+/* Accelerometer sensitivity in LSB/g by AFS_SEL setting */
+static const int32_t mpu6050_emu_xl_lsb[4] = {16384, 8192, 4096, 2048};
+
+/* Gyro sensitivity in 0.1 LSB/dps by FS_SEL setting */
+static const int32_t mpu6050_emu_g_lsb10[4] = {1310, 655, 328, 164};
+
+static int16_t mpu6050_emu_clamp(int64_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+/* Divide rounding to nearest */
+static int64_t mpu6050_emu_div(int64_t num, int64_t den) {
+    return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+static void mpu6050_emu_fifo_clear(MPU6050_EMU *emu) {
+    emu->fifo_head = 0;
+    emu->fifo_count = 0;
+}
+
+static void mpu6050_emu_reset_regs(MPU6050_EMU *emu) {
+    memset(emu->regs, 0, sizeof(emu->regs));
+    emu->regs[PWR_MGMT_1] = PWR_MGMT_1_SLEEP;
+    emu->regs[WHO_AM_I] = MPU6050_WHO_AM_I_VALUE;
+    
+    mpu6050_emu_fifo_clear(emu);
+    emu->sample_us = 0;
+    emu->aux_count = 0;
+}
+
+void mpu6050_emu_init(MPU6050_EMU *emu) {
+    memset(emu, 0, sizeof(*emu));
+    mpu6050_emu_reset_regs(emu);
+}
+
+void mpu6050_emu_set_aux(MPU6050_EMU *emu, I2C_SIM *aux) {
+    emu->aux = aux;
+}
+
+void mpu6050_emu_set_source(MPU6050_EMU *emu, void (*source)(uint32_t t_us, MPU6050_EMU_MOTION *motion)) {
+    emu->source = source;
+    emu->trace = 0;
+}
+
+void mpu6050_emu_set_trace(MPU6050_EMU *emu, const MPU6050_EMU_MOTION *trace, uint32_t len) {
+    emu->source = 0;
+    emu->trace = trace;
+    emu->trace_len = len;
+    emu->trace_pos = 0;
+}
+
+static void mpu6050_emu_motion(MPU6050_EMU *emu, MPU6050_EMU_MOTION *m) {
+    if (emu->source) {
+        emu->source(emu->now_us, m);
+        return;
+    }
+    
+    if (emu->trace && emu->trace_len) {
+        while (emu->trace_pos + 1 < emu->trace_len && emu->trace[emu->trace_pos + 1].t_us <= emu->now_us) {
+            emu->trace_pos++;
+        }
+        *m = emu->trace[emu->trace_pos];
+        return;
+    }
+    
+    memset(m, 0, sizeof(*m));
+    m->xl[2] = 1000;
+    m->temp = 2500;
+}
+
+/* Add a byte to the FIFO, dropping the oldest when it is full */
+static void mpu6050_emu_fifo_push(MPU6050_EMU *emu, uint8_t data) {
+    if (emu->fifo_count == MPU6050_EMU_FIFO_BYTES) {
+        emu->fifo_head = (emu->fifo_head + 1) & MPU6050_EMU_FIFO_MASK;
+        emu->fifo_count--;
+        emu->stats.fifo_lost++;
+        emu->regs[INT_STATUS] |= INT_STATUS_FIFO_OFLOW_INT;
+    }
+    
+    emu->fifo[(emu->fifo_head + emu->fifo_count) & MPU6050_EMU_FIFO_MASK] = data;
+    emu->fifo_count++;
+}
+
+static uint8_t mpu6050_emu_fifo_pop(MPU6050_EMU *emu) {
+    uint8_t data;
+    
+    if (emu->fifo_count == 0) {
+        return 0;
+    }
+    
+    data = emu->fifo[emu->fifo_head];
+    emu->fifo_head = (emu->fifo_head + 1) & MPU6050_EMU_FIFO_MASK;
+    emu->fifo_count--;
+    emu->stats.fifo_read++;
+    
+    return data;
+}
+
+static void mpu6050_emu_fifo_push_regs(MPU6050_EMU *emu, uint8_t reg, uint8_t len) {
+    while (len--) {
+        mpu6050_emu_fifo_push(emu, emu->regs[reg++]);
+    }
+}
+
+/* Bytes of EXT_SENS_DATA filled by a slot - only enabled reads take space */
+static uint8_t mpu6050_emu_slot_len(MPU6050_EMU *emu, uint8_t slot) {
+    uint8_t base = I2C_SLV0_ADDR + slot * (I2C_SLV1_ADDR - I2C_SLV0_ADDR);
+    uint8_t ctrl = emu->regs[base + 2];
+    
+    if (!(ctrl & I2C_SLV0_CTRL_I2C_SLV0_EN) || !(emu->regs[base] & I2C_SLV0_ADDR_I2C_SLV0_RW)) {
+        return 0;
+    }
+    
+    return (ctrl & I2C_SLV0_CTRL_I2C_SLV0_LEN_Msk) >> I2C_SLV0_CTRL_I2C_SLV0_LEN_Pos;
+}
+
+/* One transfer on the auxiliary bus - a read fills len bytes of data, a write sends data[0] */
+static uint8_t mpu6050_emu_aux_transfer(I2C_SIM *aux, uint8_t addr, uint8_t reg, uint8_t reg_dis, uint8_t *data, uint8_t len) {
+    uint8_t read = addr & I2C_SLV0_ADDR_I2C_SLV0_RW;
+    uint8_t ack = 1;
+    
+    addr &= I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk;
+    
+    i2c_sim_start(aux);
+    
+    if (!read || !reg_dis) {
+        ack = i2c_sim_write(aux, addr << 1);
+        
+        if (ack && !reg_dis) {
+            ack = i2c_sim_write(aux, reg);
+        }
+        
+        if (ack && !read) {
+            ack = i2c_sim_write(aux, data[0]);
+        }
+        
+        if (ack && read) {
+            i2c_sim_restart(aux);
+        }
+    }
+    
+    if (ack && read) {
+        ack = i2c_sim_write(aux, (addr << 1) | 1);
+        
+        while (ack && len) {
+            len--;
+            *data++ = i2c_sim_read(aux, len != 0);
+        }
+    }
+    
+    i2c_sim_stop(aux);
+    
+    return ack;
+}
+
+/* Swap byte pairs, starting with bytes 1 and 2 when grouped from an odd address */
+static void mpu6050_emu_byte_swap(uint8_t *data, uint8_t len, uint8_t odd) {
+    uint8_t i;
+    uint8_t tmp;
+    
+    for (i = odd; i + 1 < len; i += 2) {
+        tmp = data[i];
+        data[i] = data[i + 1];
+        data[i + 1] = tmp;
+    }
+}
+
+/* Auxiliary master sequence for one sample: slaves 0 to 3 in order, then SLV4 */
+static void mpu6050_emu_aux(MPU6050_EMU *emu) {
+    uint8_t dly = (emu->regs[I2C_SLV4_CTRL] & I2C_SLV4_CTRL_I2C_MST_DLY_Msk) >> I2C_SLV4_CTRL_I2C_MST_DLY_Pos;
+    uint8_t delayed = emu->regs[I2C_MST_DELAY_CTRL];
+    uint8_t due = (emu->aux_count == 0);
+    uint8_t ext = 0;
+    uint8_t slot;
+    uint8_t base;
+    uint8_t ctrl;
+    uint8_t len;
+    uint8_t ack;
+    
+    emu->aux_count = (emu->aux_count >= dly) ? 0 : emu->aux_count + 1;
+    
+    if (!(emu->regs[USER_CTRL] & USER_CTRL_I2C_MST_EN) || !emu->aux) {
+        return;
+    }
+    
+    for (slot = 0; slot < MPU6050_AUX_SLOTS; slot++) {
+        base = I2C_SLV0_ADDR + slot * (I2C_SLV1_ADDR - I2C_SLV0_ADDR);
+        ctrl = emu->regs[base + 2];
+        len = mpu6050_emu_slot_len(emu, slot);
+        
+        if (ext + len > MPU6050_EXT_SENS_BYTES) {
+            len = MPU6050_EXT_SENS_BYTES - ext;
+        }
+        
+        if (!(ctrl & I2C_SLV0_CTRL_I2C_SLV0_EN) || ((delayed & (1 << slot)) && !due)) {
+            ext += len;
+            continue;
+        }
+        
+        if (len) {
+            ack = mpu6050_emu_aux_transfer(emu->aux, emu->regs[base], emu->regs[base + 1],
+                    ctrl & I2C_SLV0_CTRL_I2C_SLV0_REG_DIS, &emu->regs[EXT_SENS_DATA_00 + ext], len);
+            
+            if (ctrl & I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW) {
+                mpu6050_emu_byte_swap(&emu->regs[EXT_SENS_DATA_00 + ext], len,
+                        (ctrl & I2C_SLV0_CTRL_I2C_SLV0_GRP) ? 1 : 0);
+            }
+        } else if (emu->regs[base] & I2C_SLV0_ADDR_I2C_SLV0_RW) {
+            continue;
+        } else {
+            ack = mpu6050_emu_aux_transfer(emu->aux, emu->regs[base], emu->regs[base + 1],
+                    ctrl & I2C_SLV0_CTRL_I2C_SLV0_REG_DIS, &emu->regs[I2C_SLV0_DO + slot], 0);
+        }
+        
+        if (!ack) {
+            emu->stats.aux_nacks++;
+            emu->regs[I2C_MST_STATUS] |= I2C_MST_STATUS_I2C_SLV0_NACK << slot;
+            emu->regs[INT_STATUS] |= INT_STATUS_I2C_MST_INT;
+        }
+        
+        ext += len;
+    }
+    
+    ctrl = emu->regs[I2C_SLV4_CTRL];
+    
+    if (!(ctrl & I2C_SLV4_CTRL_I2C_SLV4_EN) || ((delayed & I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN) && !due)) {
+        return;
+    }
+    
+    /* A read returns its byte in I2C_SLV4_DI, a write sends I2C_SLV4_DO */
+    if (emu->regs[I2C_SLV4_ADDR] & I2C_SLV0_ADDR_I2C_SLV0_RW) {
+        ack = mpu6050_emu_aux_transfer(emu->aux, emu->regs[I2C_SLV4_ADDR], emu->regs[I2C_SLV4_REG],
+                ctrl & I2C_SLV4_CTRL_I2C_SLV4_REG_DIS, &emu->regs[I2C_SLV4_DI], 1);
+    } else {
+        ack = mpu6050_emu_aux_transfer(emu->aux, emu->regs[I2C_SLV4_ADDR], emu->regs[I2C_SLV4_REG],
+                ctrl & I2C_SLV4_CTRL_I2C_SLV4_REG_DIS, &emu->regs[I2C_SLV4_DO], 0);
+    }
+    
+    emu->regs[I2C_SLV4_CTRL] = ctrl & ~I2C_SLV4_CTRL_I2C_SLV4_EN;
+    emu->regs[I2C_MST_STATUS] |= I2C_MST_STATUS_I2C_SLV4_DONE;
+    
+    if (!ack) {
+        emu->stats.aux_nacks++;
+        emu->regs[I2C_MST_STATUS] |= I2C_MST_STATUS_I2C_SLV4_NACK;
+    }
+    
+    if (!ack || (ctrl & I2C_SLV4_CTRL_I2C_SLV4_INT_EN)) {
+        emu->regs[INT_STATUS] |= INT_STATUS_I2C_MST_INT;
+    }
+}
+
+static void mpu6050_emu_set_word(MPU6050_EMU *emu, uint8_t reg, int16_t value) {
+    emu->regs[reg] = (uint8_t)((uint16_t)value >> 8);
+    emu->regs[reg + 1] = (uint8_t)value;
+}
+
+/* Frames hold the sensors enabled in FIFO_EN in register order, then slave data */
+static void mpu6050_emu_fifo_frame(MPU6050_EMU *emu) {
+    uint8_t fifo_en = emu->regs[FIFO_EN];
+    uint8_t ext = 0;
+    uint8_t slot;
+    uint8_t len;
+    uint8_t store;
+    
+    if (fifo_en & FIFO_EN_ACCEL_FIFO_EN) {
+        mpu6050_emu_fifo_push_regs(emu, ACCEL_XOUT_H, 6);
+    }
+    if (fifo_en & FIFO_EN_TEMP_FIFO_EN) {
+        mpu6050_emu_fifo_push_regs(emu, TEMP_OUT_H, 2);
+    }
+    if (fifo_en & FIFO_EN_XG_FIFO_EN) {
+        mpu6050_emu_fifo_push_regs(emu, GYRO_XOUT_H, 2);
+    }
+    if (fifo_en & FIFO_EN_YG_FIFO_EN) {
+        mpu6050_emu_fifo_push_regs(emu, GYRO_YOUT_H, 2);
+    }
+    if (fifo_en & FIFO_EN_ZG_FIFO_EN) {
+        mpu6050_emu_fifo_push_regs(emu, GYRO_ZOUT_H, 2);
+    }
+    
+    for (slot = 0; slot < MPU6050_AUX_SLOTS; slot++) {
+        len = mpu6050_emu_slot_len(emu, slot);
+        
+        if (ext + len > MPU6050_EXT_SENS_BYTES) {
+            len = MPU6050_EXT_SENS_BYTES - ext;
+        }
+        
+        /* SLV3 is enabled in I2C_MST_CTRL, slaves 0 to 2 in FIFO_EN */
+        store = (slot == 3) ? (emu->regs[I2C_MST_CTRL] & I2C_MST_CTRL_SLV_3_FIFO_EN) : (fifo_en & (FIFO_EN_SLV0_FIFO_EN << slot));
+        
+        if (store) {
+            mpu6050_emu_fifo_push_regs(emu, EXT_SENS_DATA_00 + ext, len);
+        }
+        
+        ext += len;
+    }
+}
+
+static void mpu6050_emu_sample(MPU6050_EMU *emu) {
+    MPU6050_EMU_MOTION m;
+    int32_t xl_lsb = mpu6050_emu_xl_lsb[(emu->regs[ACCEL_CONFIG] & ACCEL_CONFIG_AFS_SEL_Msk) >> ACCEL_CONFIG_AFS_SEL_Pos];
+    int32_t g_lsb10 = mpu6050_emu_g_lsb10[(emu->regs[GYRO_CONFIG] & GYRO_CONFIG_FS_SEL_Msk) >> GYRO_CONFIG_FS_SEL_Pos];
+    uint8_t i;
+    
+    mpu6050_emu_motion(emu, &m);
+    
+    /* With WAIT_FOR_ES the sample waits for slave data, which is always at once here */
+    mpu6050_emu_aux(emu);
+    
+    for (i = 0; i < 3; i++) {
+        mpu6050_emu_set_word(emu, ACCEL_XOUT_H + i * 2, mpu6050_emu_clamp(mpu6050_emu_div((int64_t)m.xl[i] * xl_lsb, 1000)));
+        mpu6050_emu_set_word(emu, GYRO_XOUT_H + i * 2, mpu6050_emu_clamp(mpu6050_emu_div((int64_t)m.g[i] * g_lsb10, 10000)));
+    }
+    
+    /* degC = TEMP_OUT / 340 + 36.53 */
+    mpu6050_emu_set_word(emu, TEMP_OUT_H, mpu6050_emu_clamp(mpu6050_emu_div(((int64_t)m.temp - 3653) * 340, 100)));
+    
+    if (emu->regs[USER_CTRL] & USER_CTRL_FIFO_EN) {
+        mpu6050_emu_fifo_frame(emu);
+    }
+    
+    emu->regs[INT_STATUS] |= INT_STATUS_DATA_RDY_INT;
+    emu->stats.samples++;
+}
+
+static uint8_t mpu6050_emu_read(MPU6050_EMU *emu, uint8_t reg) {
+    uint8_t value = emu->regs[reg];
+    
+    switch (reg) {
+        case FIFO_COUNTH:
+            value = (uint8_t)(emu->fifo_count >> 8);
+            break;
+            
+        case FIFO_COUNTL:
+            value = (uint8_t)emu->fifo_count;
+            break;
+            
+        case FIFO_R_W:
+            value = mpu6050_emu_fifo_pop(emu);
+            break;
+            
+        case I2C_MST_STATUS:
+            emu->regs[I2C_MST_STATUS] = 0;
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (reg == INT_STATUS || (emu->regs[INT_PIN_CFG] & INT_PIN_CFG_INT_RD_CLEAR)) {
+        emu->regs[INT_STATUS] = 0;
+    }
+    
+    return value;
+}
+
+static void mpu6050_emu_write(MPU6050_EMU *emu, uint8_t reg, uint8_t value) {
+    /* Read-only registers */
+    if ((reg >= ACCEL_XOUT_H && reg <= EXT_SENS_DATA_23) || reg == INT_STATUS || reg == I2C_MST_STATUS
+            || reg == I2C_SLV4_DI || reg == FIFO_COUNTH || reg == FIFO_COUNTL || reg == WHO_AM_I) {
+        return;
+    }
+    
+    switch (reg) {
+        case FIFO_R_W:
+            mpu6050_emu_fifo_push(emu, value);
+            return;
+            
+        case USER_CTRL:
+            if (value & USER_CTRL_FIFO_RESET) {
+                mpu6050_emu_fifo_clear(emu);
+            }
+            
+            /* Reset bits clear themselves */
+            value &= ~(USER_CTRL_FIFO_RESET | USER_CTRL_I2C_MST_RESET | USER_CTRL_SIG_COND_RESET);
+            break;
+            
+        case PWR_MGMT_1:
+            if (value & PWR_MGMT_1_DEVICE_RESET) {
+                mpu6050_emu_reset_regs(emu);
+                return;
+            }
+            break;
+            
+        case SIGNAL_PATH_RESET:
+            value = 0;
+            break;
+            
+        default:
+            break;
+    }
+    
+    emu->regs[reg] = value;
+}
+
+/* Bus interface - the first byte of a write sets the register address */
+static void mpu6050_emu_start(void *context, uint8_t read) {
+    MPU6050_EMU *emu = context;
+    
+    emu->address_next = !read;
+}
+
+static uint8_t mpu6050_emu_bus_write(void *context, uint8_t data) {
+    MPU6050_EMU *emu = context;
+    
+    if (emu->address_next) {
+        emu->address_next = 0;
+        emu->addr = data & (MPU6050_EMU_REGS - 1);
+        return 1;
+    }
+    
+    mpu6050_emu_write(emu, emu->addr, data);
+    
+    if (emu->addr != FIFO_R_W) {
+        emu->addr = (emu->addr + 1) & (MPU6050_EMU_REGS - 1);
+    }
+    
+    return 1;
+}
+
+static uint8_t mpu6050_emu_bus_read(void *context) {
+    MPU6050_EMU *emu = context;
+    uint8_t value = mpu6050_emu_read(emu, emu->addr);
+    
+    if (emu->addr != FIFO_R_W) {
+        emu->addr = (emu->addr + 1) & (MPU6050_EMU_REGS - 1);
+    }
+    
+    return value;
+}
+
+static void mpu6050_emu_stop(void *context) {
+    MPU6050_EMU *emu = context;
+    
+    emu->address_next = 0;
+}
+
+static const I2C_SIM_OPS mpu6050_emu_ops = {
+    mpu6050_emu_start,
+    mpu6050_emu_bus_write,
+    mpu6050_emu_bus_read,
+    mpu6050_emu_stop
+};
+
+uint8_t mpu6050_emu_attach(MPU6050_EMU *emu, I2C_SIM *bus, uint8_t addr) {
+    return i2c_sim_attach(bus, addr, &mpu6050_emu_ops, emu);
+}
+
+/* Sample period from SMPLRT_DIV, with the gyro output rate at 8 kHz when the DLPF is off */
+static uint32_t mpu6050_emu_period(MPU6050_EMU *emu) {
+    uint8_t dlpf = (emu->regs[CONFIG] & CONFIG_DLPF_CFG_Msk) >> CONFIG_DLPF_CFG_Pos;
+    uint32_t period = (dlpf == 0 || dlpf == 7) ? MPU6050_EMU_PERIOD_FAST : MPU6050_EMU_PERIOD;
+    
+    return period * (1 + emu->regs[SMPLRT_DIV]);
+}
+
+void mpu6050_emu_advance(MPU6050_EMU *emu, uint32_t us) {
+    uint32_t period;
+    uint32_t step;
+    
+    while (us) {
+        if (emu->regs[PWR_MGMT_1] & PWR_MGMT_1_SLEEP) {
+            emu->now_us += us;
+            emu->sample_us = 0;
+            return;
+        }
+        
+        /* Step to the next sample, at once if the rate was raised past the time waited */
+        period = mpu6050_emu_period(emu);
+        step = (emu->sample_us < period) ? period - emu->sample_us : 0;
+        if (step > us) {
+            step = us;
+        }
+        
+        emu->now_us += step;
+        emu->sample_us += step;
+        us -= step;
+        
+        if (emu->sample_us >= period) {
+            emu->sample_us = 0;
+            mpu6050_emu_sample(emu);
+        }
+    }
+}
+
+uint8_t mpu6050_emu_int(MPU6050_EMU *emu) {
+    return (emu->regs[INT_STATUS] & emu->regs[INT_ENABLE]) != 0;
+}
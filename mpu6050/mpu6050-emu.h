@@ -0,0 +1,112 @@
+/*
+ * Constant definitions and function prototypes for
+ * host-side MPU-6050 emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * The device is attached to an I2C_SIM bus with mpu6050_emu_attach and the driver
+ * is bound to that bus as described in i2c-sim.h. External sensors for the
+ * auxiliary master are attached to a second I2C_SIM given to mpu6050_emu_set_aux.
+ * tools/mpu6050-cfg.h is a complete binding, with MPU6050_DELAY_US advancing
+ * emulated time.
+ * 
+ * This header does not include mpu6050.h so it can be included from the config header.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MPU6050_EMU_H
+#define MPU6050_EMU_H
+
+#include <stdint.h>
+
+#include "i2c-sim.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define MPU6050_EMU_REGS          128
+#define MPU6050_EMU_FIFO_BYTES    1024
+
+/* Motion at a point in time */
+typedef struct {
+    uint32_t t_us;              /* Time of this point (traces only) */
+    int32_t xl[3];              /* Acceleration (mg) */
+    int32_t g[3];               /* Angular rate (mdps) */
+    int16_t temp;               /* Temperature (0.01 degC) */
+} MPU6050_EMU_MOTION;
+
+/* Device statistics - bus traffic is counted by the I2C_SIM */
+typedef struct {
+    uint32_t samples;
+    uint32_t fifo_read;         /* FIFO bytes read */
+    uint32_t fifo_lost;         /* FIFO bytes overwritten while the FIFO was full */
+    uint32_t aux_nacks;         /* Auxiliary master transfers not acknowledged */
+} MPU6050_EMU_STATS;
+
+typedef struct {
+    uint8_t regs[MPU6050_EMU_REGS];
+    
+    /* Transfer in progress */
+    uint8_t addr;
+    uint8_t address_next;       /* Next byte written is the register address */
+    
+    /* Motion source - callback, or trace replayed with sample-and-hold */
+    void (*source)(uint32_t t_us, MPU6050_EMU_MOTION *motion);
+    const MPU6050_EMU_MOTION *trace;
+    uint32_t trace_len;
+    uint32_t trace_pos;
+    
+    /* Time and sample clock */
+    uint32_t now_us;
+    uint32_t sample_us;         /* Time since the last sample */
+    uint8_t aux_count;          /* Samples since delayed slaves were last accessed */
+    
+    /* FIFO */
+    uint8_t fifo[MPU6050_EMU_FIFO_BYTES];
+    uint16_t fifo_head;
+    uint16_t fifo_count;
+    
+    I2C_SIM *aux;               /* Auxiliary bus, 0 if nothing is attached */
+    
+    MPU6050_EMU_STATS stats;
+} MPU6050_EMU;
+
+/* Power-on reset, asleep, with no motion source (device at rest, +1 g on Z, 25 degC) */
+void mpu6050_emu_init(MPU6050_EMU *emu);
+
+/* Attach to a bus at addr - returns 0 if the bus has no room or the address is taken */
+uint8_t mpu6050_emu_attach(MPU6050_EMU *emu, I2C_SIM *bus, uint8_t addr);
+
+void mpu6050_emu_set_aux(MPU6050_EMU *emu, I2C_SIM *aux);
+
+void mpu6050_emu_set_source(MPU6050_EMU *emu, void (*source)(uint32_t t_us, MPU6050_EMU_MOTION *motion));
+void mpu6050_emu_set_trace(MPU6050_EMU *emu, const MPU6050_EMU_MOTION *trace, uint32_t len);
+
+/* Advance emulated time, sampling at the configured rate while awake */
+void mpu6050_emu_advance(MPU6050_EMU *emu, uint32_t us);
+
+/* Nonzero while an enabled interrupt is pending - INT pin active */
+uint8_t mpu6050_emu_int(MPU6050_EMU *emu);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* MPU6050_EMU_H */
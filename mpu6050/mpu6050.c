@@ -0,0 +1,682 @@
+/*
+ * Driver for InvenSense MPU-6050
+ * Copyright (c) 2019 David Rice
+ * 
+ * Requires definitions for:
+ * MPU6050_I2C_START() - Generate a START condition
+ * MPU6050_I2C_RESTART() - Generate a repeated START condition
+ * MPU6050_I2C_STOP() - Generate a STOP condition
+ * MPU6050_I2C_WRITE(x) - Write one byte, evaluating to nonzero if it was acknowledged
+ * MPU6050_I2C_READ(ack) - Read one byte, then ACK it if ack is nonzero or NACK it otherwise
+ * MPU6050_DELAY_US(x) - Wait x microseconds, x constant (used while waiting for SLV4 transfers)
+ * 
+ * Optional definitions:
+ * MPU6050_ADDRESS - 7-bit device address (default MPU6050_ADDRESS_AD0_LOW)
+ * MPU6050_FIFO_BURST - Most FIFO bytes read per I2C transaction, rounded down to whole frames (default 120)
+ * MPU6050_AUX_POLL_US - Time between I2C_MST_STATUS reads while waiting for an SLV4 transfer (default 500)
+ * 
+ * Configuration is usually located in mpu6050-cfg.h in the same folder with the main project
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Configuration first, so that it can override MPU6050_ADDRESS */
+#include "mpu6050-cfg.h"
+#include "mpu6050.h"
+
+#ifndef MPU6050_FIFO_BURST
+#define MPU6050_FIFO_BURST          120
+#endif
+
+/* Largest frame: accelerometer, temperature, gyro and all EXT_SENS_DATA */
+#if MPU6050_FIFO_BURST < MPU6050_SENSOR_BYTES + MPU6050_EXT_SENS_BYTES
+#error "MPU6050_FIFO_BURST must hold at least one frame"
+#endif
+
+#ifndef MPU6050_AUX_POLL_US
+#define MPU6050_AUX_POLL_US         500
+#endif
+
+/* I2C_MST_STATUS bits kept for mpu6050_aux_get_status when read while waiting for SLV4 */
+#define MPU6050_AUX_STATUS_KEEP     (I2C_MST_STATUS_I2C_SLV0_NACK | I2C_MST_STATUS_I2C_SLV1_NACK | I2C_MST_STATUS_I2C_SLV2_NACK \
+                                    | I2C_MST_STATUS_I2C_SLV3_NACK | I2C_MST_STATUS_I2C_LOST_ARB)
+
+#define MPU6050_I2C_ADDR_WRITE      (MPU6050_ADDRESS << 1)
+#define MPU6050_I2C_ADDR_READ       ((MPU6050_ADDRESS << 1) | 1)
+
+/* Configuration registers SMPLRT_DIV, CONFIG, GYRO_CONFIG and ACCEL_CONFIG are consecutive */
+#define MPU6050_CONFIG_REGS         4
+
+/* Gyro output rate in Hz with the DLPF disabled or enabled */
+#define MPU6050_GYRO_RATE_FAST      8000U
+#define MPU6050_GYRO_RATE           1000U
+
+/* Last values written to SMPLRT_DIV .. ACCEL_CONFIG */
+static uint8_t mpu6050_shadow[MPU6050_CONFIG_REGS];
+
+/* USER_CTRL without the self-clearing reset bits */
+static uint8_t mpu6050_user_ctrl;
+
+static MPU6050_FIFO_STATE mpu6050_fifo;
+static uint8_t mpu6050_fifo_buffer[MPU6050_FIFO_BURST];
+
+/* Bytes read by each auxiliary slot, and the I2C_MST_DLY setting kept in I2C_SLV4_CTRL */
+static uint8_t mpu6050_aux_len[MPU6050_AUX_SLOTS];
+static uint8_t mpu6050_aux_dly;
+static uint8_t mpu6050_aux_status;
+
+uint8_t mpu6050_write_registers(uint8_t start_addr, const uint8_t *data, uint8_t num) {
+    uint8_t ack;
+    
+    MPU6050_I2C_START();
+    
+    ack = MPU6050_I2C_WRITE(MPU6050_I2C_ADDR_WRITE) && MPU6050_I2C_WRITE(start_addr);
+    
+    while (ack && num--) {
+        ack = MPU6050_I2C_WRITE(*data++);
+    }
+    
+    MPU6050_I2C_STOP();
+    
+    return ack;
+}
+
+/* Register address auto-increments, so any run of registers is one transaction */
+uint8_t mpu6050_read_registers(uint8_t start_addr, uint8_t *buffer, uint16_t num) {
+    uint8_t ack;
+    
+    MPU6050_I2C_START();
+    
+    ack = MPU6050_I2C_WRITE(MPU6050_I2C_ADDR_WRITE) && MPU6050_I2C_WRITE(start_addr);
+    
+    if (ack) {
+        MPU6050_I2C_RESTART();
+        ack = MPU6050_I2C_WRITE(MPU6050_I2C_ADDR_READ);
+    }
+    
+    if (ack) {
+        /* NACK the last byte to end the read */
+        while (num) {
+            num--;
+            *buffer++ = MPU6050_I2C_READ(num != 0);
+        }
+    }
+    
+    MPU6050_I2C_STOP();
+    
+    return ack;
+}
+
+uint8_t mpu6050_set_register_value(uint8_t addr, uint8_t value) {
+    return mpu6050_write_registers(addr, &value, 1);
+}
+
+uint8_t mpu6050_get_register_value(uint8_t addr, uint8_t *value) {
+    return mpu6050_read_registers(addr, value, 1);
+}
+
+void mpu6050_decode_words(const uint8_t *buffer, int16_t *out, uint8_t count) {
+    while (count--) {
+        *out++ = (int16_t)(((uint16_t)buffer[0] << 8) | buffer[1]);
+        buffer += 2;
+    }
+}
+
+uint8_t mpu6050_init(void) {
+    uint8_t regs[2];
+    uint8_t who_am_i;
+    uint8_t i;
+    
+    if (!mpu6050_get_register_value(WHO_AM_I, &who_am_i) || who_am_i != MPU6050_WHO_AM_I_VALUE) {
+        return 0;
+    }
+    
+    /* USER_CTRL and PWR_MGMT_1 in one burst - clearing SLEEP wakes the device */
+    regs[0] = 0;
+    regs[1] = MPU6050_CLKSEL_PLL_XGYRO << PWR_MGMT_1_CLKSEL_Pos;
+    
+    if (!mpu6050_write_registers(USER_CTRL, regs, sizeof(regs))) {
+        return 0;
+    }
+    
+    mpu6050_user_ctrl = 0;
+    mpu6050_fifo.sensors = 0;
+    mpu6050_fifo.frame_len = 0;
+    mpu6050_fifo.ext_len = 0;
+    mpu6050_fifo.overflows = 0;
+    
+    for (i = 0; i < MPU6050_AUX_SLOTS; i++) {
+        mpu6050_aux_len[i] = 0;
+    }
+    mpu6050_aux_dly = 0;
+    mpu6050_aux_status = 0;
+    
+    return mpu6050_read_registers(SMPLRT_DIV, mpu6050_shadow, MPU6050_CONFIG_REGS);
+}
+
+uint8_t mpu6050_configure(uint8_t rate_div, uint8_t dlpf, uint8_t gyro_scale, uint8_t accel_scale) {
+    uint8_t regs[MPU6050_CONFIG_REGS];
+    
+    regs[0] = rate_div;
+    regs[1] = (mpu6050_shadow[CONFIG - SMPLRT_DIV] & ~CONFIG_DLPF_CFG_Msk) | ((dlpf << CONFIG_DLPF_CFG_Pos) & CONFIG_DLPF_CFG_Msk);
+    regs[2] = (mpu6050_shadow[GYRO_CONFIG - SMPLRT_DIV] & ~GYRO_CONFIG_FS_SEL_Msk) | ((gyro_scale << GYRO_CONFIG_FS_SEL_Pos) & GYRO_CONFIG_FS_SEL_Msk);
+    regs[3] = (mpu6050_shadow[ACCEL_CONFIG - SMPLRT_DIV] & ~ACCEL_CONFIG_AFS_SEL_Msk) | ((accel_scale << ACCEL_CONFIG_AFS_SEL_Pos) & ACCEL_CONFIG_AFS_SEL_Msk);
+    
+    if (!mpu6050_write_registers(SMPLRT_DIV, regs, MPU6050_CONFIG_REGS)) {
+        return 0;
+    }
+    
+    mpu6050_shadow[0] = regs[0];
+    mpu6050_shadow[1] = regs[1];
+    mpu6050_shadow[2] = regs[2];
+    mpu6050_shadow[3] = regs[3];
+    
+    return 1;
+}
+
+/* Update bits of one configuration register from the shadow, without reading it back */
+static uint8_t mpu6050_update_config(uint8_t addr, uint8_t mask, uint8_t value) {
+    uint8_t reg = (mpu6050_shadow[addr - SMPLRT_DIV] & ~mask) | (value & mask);
+    
+    if (!mpu6050_set_register_value(addr, reg)) {
+        return 0;
+    }
+    
+    mpu6050_shadow[addr - SMPLRT_DIV] = reg;
+    
+    return 1;
+}
+
+uint8_t mpu6050_get_config_value(uint8_t addr) {
+    return mpu6050_shadow[addr - SMPLRT_DIV];
+}
+
+uint8_t mpu6050_set_sample_rate_div(uint8_t rate_div) {
+    return mpu6050_update_config(SMPLRT_DIV, 0xFF, rate_div);
+}
+
+/* Sample rate is the gyro output rate / (1 + SMPLRT_DIV) */
+static uint16_t mpu6050_gyro_rate(void) {
+    uint8_t dlpf = (mpu6050_shadow[CONFIG - SMPLRT_DIV] & CONFIG_DLPF_CFG_Msk) >> CONFIG_DLPF_CFG_Pos;
+    
+    return (dlpf == 0 || dlpf == 7) ? MPU6050_GYRO_RATE_FAST : MPU6050_GYRO_RATE;
+}
+
+/* Nearest rate at or above rate_hz - set the DLPF first, since it changes the gyro output rate */
+uint8_t mpu6050_set_sample_rate(uint16_t rate_hz) {
+    uint16_t div = rate_hz ? mpu6050_gyro_rate() / rate_hz : 256;
+    
+    if (div > 256) {
+        div = 256;
+    } else if (div == 0) {
+        div = 1;
+    }
+    
+    return mpu6050_set_sample_rate_div((uint8_t)(div - 1));
+}
+
+uint16_t mpu6050_get_sample_rate(void) {
+    return mpu6050_gyro_rate() / (1 + mpu6050_shadow[0]);
+}
+
+uint8_t mpu6050_set_dlpf(uint8_t dlpf) {
+    return mpu6050_update_config(CONFIG, CONFIG_DLPF_CFG_Msk, dlpf << CONFIG_DLPF_CFG_Pos);
+}
+
+uint8_t mpu6050_set_gyro_scale(uint8_t scale) {
+    return mpu6050_update_config(GYRO_CONFIG, GYRO_CONFIG_FS_SEL_Msk, scale << GYRO_CONFIG_FS_SEL_Pos);
+}
+
+uint8_t mpu6050_set_accel_scale(uint8_t scale) {
+    return mpu6050_update_config(ACCEL_CONFIG, ACCEL_CONFIG_AFS_SEL_Msk, scale << ACCEL_CONFIG_AFS_SEL_Pos);
+}
+
+uint8_t mpu6050_get_temperature(int16_t *temp) {
+    uint8_t buffer[2];
+    
+    if (!mpu6050_read_registers(TEMP_OUT_H, buffer, sizeof(buffer))) {
+        return 0;
+    }
+    
+    mpu6050_decode_words(buffer, temp, 1);
+    
+    return 1;
+}
+
+uint8_t mpu6050_get_accel_data(MPU6050_XL_DATA *data) {
+    uint8_t buffer[6];
+    int16_t words[3];
+    
+    if (!mpu6050_read_registers(ACCEL_XOUT_H, buffer, sizeof(buffer))) {
+        return 0;
+    }
+    
+    mpu6050_decode_words(buffer, words, 3);
+    
+    data->x = words[0];
+    data->y = words[1];
+    data->z = words[2];
+    
+    return 1;
+}
+
+uint8_t mpu6050_get_gyro_data(MPU6050_G_DATA *data) {
+    uint8_t buffer[6];
+    int16_t words[3];
+    
+    if (!mpu6050_read_registers(GYRO_XOUT_H, buffer, sizeof(buffer))) {
+        return 0;
+    }
+    
+    mpu6050_decode_words(buffer, words, 3);
+    
+    data->x = words[0];
+    data->y = words[1];
+    data->z = words[2];
+    
+    return 1;
+}
+
+/* Output registers are ordered accelerometer, temperature, gyro starting at ACCEL_XOUT_H */
+void mpu6050_decode_sensor_data(const uint8_t *buffer, MPU6050_SENSOR_DATA *data) {
+    int16_t words[MPU6050_SENSOR_BYTES / 2];
+    
+    mpu6050_decode_words(buffer, words, MPU6050_SENSOR_BYTES / 2);
+    
+    data->xl.x = words[0];
+    data->xl.y = words[1];
+    data->xl.z = words[2];
+    data->temp = words[3];
+    data->g.x = words[4];
+    data->g.y = words[5];
+    data->g.z = words[6];
+}
+
+uint8_t mpu6050_get_all_sensor_data(MPU6050_SENSOR_DATA *data) {
+    return mpu6050_get_all_sensor_data_ext(data, NULL);
+}
+
+/* EXT_SENS_DATA_00 directly follows GYRO_ZOUT_L, so slave data extends the same burst */
+uint8_t mpu6050_get_all_sensor_data_ext(MPU6050_SENSOR_DATA *data, uint8_t *ext) {
+    uint8_t buffer[MPU6050_SENSOR_BYTES + MPU6050_EXT_SENS_BYTES];
+    uint8_t ext_len = ext ? mpu6050_aux_get_len() : 0;
+    uint8_t i;
+    
+    if (!mpu6050_read_registers(ACCEL_XOUT_H, buffer, MPU6050_SENSOR_BYTES + ext_len)) {
+        return 0;
+    }
+    
+    mpu6050_decode_sensor_data(buffer, data);
+    
+    for (i = 0; i < ext_len; i++) {
+        ext[i] = buffer[MPU6050_SENSOR_BYTES + i];
+    }
+    
+    return 1;
+}
+
+/* Stop the FIFO, clear it, and start it again if any sensors are enabled */
+uint8_t mpu6050_fifo_reset(void) {
+    uint8_t user_ctrl = mpu6050_user_ctrl & ~USER_CTRL_FIFO_EN;
+    
+    if (!mpu6050_set_register_value(USER_CTRL, user_ctrl | USER_CTRL_FIFO_RESET)) {
+        return 0;
+    }
+    
+    if (mpu6050_fifo.sensors) {
+        user_ctrl |= USER_CTRL_FIFO_EN;
+        if (!mpu6050_set_register_value(USER_CTRL, user_ctrl)) {
+            return 0;
+        }
+    }
+    
+    mpu6050_user_ctrl = user_ctrl;
+    
+    return 1;
+}
+
+uint8_t mpu6050_fifo_configure(uint8_t sensors) {
+    sensors &= MPU6050_FIFO_MOTION | MPU6050_FIFO_AUX;
+    
+    mpu6050_fifo.sensors = sensors;
+    mpu6050_fifo.frame_len = 0;
+    mpu6050_fifo.ext_len = 0;
+    
+    if (sensors & FIFO_EN_SLV0_FIFO_EN) {
+        mpu6050_fifo.ext_len += mpu6050_aux_len[0];
+    }
+    if (sensors & FIFO_EN_SLV1_FIFO_EN) {
+        mpu6050_fifo.ext_len += mpu6050_aux_len[1];
+    }
+    if (sensors & FIFO_EN_SLV2_FIFO_EN) {
+        mpu6050_fifo.ext_len += mpu6050_aux_len[2];
+    }
+    
+    if (sensors & FIFO_EN_ACCEL_FIFO_EN) {
+        mpu6050_fifo.frame_len += 6;
+    }
+    if (sensors & FIFO_EN_TEMP_FIFO_EN) {
+        mpu6050_fifo.frame_len += 2;
+    }
+    if (sensors & FIFO_EN_XG_FIFO_EN) {
+        mpu6050_fifo.frame_len += 2;
+    }
+    if (sensors & FIFO_EN_YG_FIFO_EN) {
+        mpu6050_fifo.frame_len += 2;
+    }
+    if (sensors & FIFO_EN_ZG_FIFO_EN) {
+        mpu6050_fifo.frame_len += 2;
+    }
+    
+    mpu6050_fifo.frame_len += mpu6050_fifo.ext_len;
+    
+    /* Disable before changing FIFO_EN so no partial frame is stored */
+    if (!mpu6050_set_register_value(USER_CTRL, mpu6050_user_ctrl & ~USER_CTRL_FIFO_EN)) {
+        return 0;
+    }
+    
+    if (!mpu6050_set_register_value(FIFO_EN, sensors)) {
+        return 0;
+    }
+    
+    return mpu6050_fifo_reset();
+}
+
+uint8_t mpu6050_fifo_get_count(uint16_t *count) {
+    uint8_t buffer[2];
+    
+    if (!mpu6050_read_registers(FIFO_COUNTH, buffer, sizeof(buffer))) {
+        return 0;
+    }
+    
+    *count = ((uint16_t)buffer[0] << 8) | buffer[1];
+    
+    return 1;
+}
+
+/* Unpack one frame in FIFO order: accelerometer, temperature, gyro x, y, z, slaves 0 to 2 */
+void mpu6050_fifo_decode(const uint8_t *frame, MPU6050_SENSOR_DATA *data, uint8_t *ext) {
+    uint8_t sensors = mpu6050_fifo.sensors;
+    int16_t words[3];
+    uint8_t i;
+    
+    data->xl.x = 0;
+    data->xl.y = 0;
+    data->xl.z = 0;
+    data->temp = 0;
+    data->g.x = 0;
+    data->g.y = 0;
+    data->g.z = 0;
+    
+    if (sensors & FIFO_EN_ACCEL_FIFO_EN) {
+        mpu6050_decode_words(frame, words, 3);
+        data->xl.x = words[0];
+        data->xl.y = words[1];
+        data->xl.z = words[2];
+        frame += 6;
+    }
+    
+    if (sensors & FIFO_EN_TEMP_FIFO_EN) {
+        mpu6050_decode_words(frame, &data->temp, 1);
+        frame += 2;
+    }
+    
+    if (sensors & FIFO_EN_XG_FIFO_EN) {
+        mpu6050_decode_words(frame, &data->g.x, 1);
+        frame += 2;
+    }
+    
+    if (sensors & FIFO_EN_YG_FIFO_EN) {
+        mpu6050_decode_words(frame, &data->g.y, 1);
+        frame += 2;
+    }
+    
+    if (sensors & FIFO_EN_ZG_FIFO_EN) {
+        mpu6050_decode_words(frame, &data->g.z, 1);
+        frame += 2;
+    }
+    
+    if (ext) {
+        for (i = 0; i < mpu6050_fifo.ext_len; i++) {
+            ext[i] = frame[i];
+        }
+    }
+}
+
+/*
+ * Whole frames are read in bursts from FIFO_R_W, which does not auto-increment, so
+ * each burst drains up to MPU6050_FIFO_BURST bytes. A full FIFO has been overwriting
+ * its oldest bytes, and since the 1024 bytes are not generally a whole number of
+ * frames the read position is no longer on a frame boundary.
+ */
+uint16_t mpu6050_fifo_read(MPU6050_SENSOR_DATA *out, uint16_t max) {
+    return mpu6050_fifo_read_ext(out, NULL, max);
+}
+
+uint16_t mpu6050_fifo_read_ext(MPU6050_SENSOR_DATA *out, uint8_t *ext, uint16_t max) {
+    uint8_t frame_len = mpu6050_fifo.frame_len;
+    uint8_t per_burst;
+    uint8_t burst;
+    uint8_t i;
+    uint8_t status;
+    uint16_t count;
+    uint16_t frames;
+    uint16_t n = 0;
+    
+    if (frame_len == 0 || !mpu6050_get_register_value(INT_STATUS, &status) || !mpu6050_fifo_get_count(&count)) {
+        return 0;
+    }
+    
+    /* The count alone misses an overflow once frames have been read out after it */
+    if ((status & INT_STATUS_FIFO_OFLOW_INT) || count >= MPU6050_FIFO_SIZE) {
+        mpu6050_fifo.overflows++;
+        mpu6050_fifo_reset();
+        return 0;
+    }
+    
+    frames = count / frame_len;
+    
+    if (frames > max) {
+        frames = max;
+    }
+    
+    per_burst = MPU6050_FIFO_BURST / frame_len;
+    
+    while (n < frames) {
+        burst = (frames - n > per_burst) ? per_burst : (uint8_t)(frames - n);
+        
+        if (!mpu6050_read_registers(FIFO_R_W, mpu6050_fifo_buffer, (uint16_t)burst * frame_len)) {
+            break;
+        }
+        
+        for (i = 0; i < burst; i++) {
+            mpu6050_fifo_decode(&mpu6050_fifo_buffer[i * frame_len], &out[n++], ext);
+            if (ext) {
+                ext += mpu6050_fifo.ext_len;
+            }
+        }
+    }
+    
+    return n;
+}
+
+MPU6050_FIFO_STATE *mpu6050_fifo_get_state(void) {
+    return &mpu6050_fifo;
+}
+
+uint8_t mpu6050_get_user_ctrl(void) {
+    return mpu6050_user_ctrl;
+}
+
+uint8_t mpu6050_aux_enable(uint8_t clock) {
+    uint8_t user_ctrl = mpu6050_user_ctrl | USER_CTRL_I2C_MST_EN;
+    
+    if (!mpu6050_set_register_value(I2C_MST_CTRL, I2C_MST_CTRL_WAIT_FOR_ES | ((clock << I2C_MST_CTRL_I2C_MST_CLK_Pos) & I2C_MST_CTRL_I2C_MST_CLK_Msk))) {
+        return 0;
+    }
+    
+    if (!mpu6050_set_register_value(USER_CTRL, user_ctrl)) {
+        return 0;
+    }
+    
+    mpu6050_user_ctrl = user_ctrl;
+    
+    return 1;
+}
+
+uint8_t mpu6050_aux_disable(void) {
+    uint8_t user_ctrl = mpu6050_user_ctrl & ~USER_CTRL_I2C_MST_EN;
+    
+    if (!mpu6050_set_register_value(USER_CTRL, user_ctrl)) {
+        return 0;
+    }
+    
+    mpu6050_user_ctrl = user_ctrl;
+    
+    return 1;
+}
+
+/*
+ * I2C_SLVx_ADDR, I2C_SLVx_REG and I2C_SLVx_CTRL are consecutive and written in one burst.
+ * flags may contain I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW, _REG_DIS and _GRP.
+ */
+uint8_t mpu6050_aux_set_slot(uint8_t slot, uint8_t addr, uint8_t reg, uint8_t len, uint8_t flags) {
+    uint8_t regs[3];
+    uint8_t total = 0;
+    uint8_t i;
+    
+    if (slot >= MPU6050_AUX_SLOTS || len > (I2C_SLV0_CTRL_I2C_SLV0_LEN_Msk >> I2C_SLV0_CTRL_I2C_SLV0_LEN_Pos)) {
+        return 0;
+    }
+    
+    for (i = 0; i < MPU6050_AUX_SLOTS; i++) {
+        total += (i == slot) ? len : mpu6050_aux_len[i];
+    }
+    
+    if (total > MPU6050_EXT_SENS_BYTES) {
+        return 0;
+    }
+    
+    regs[0] = I2C_SLV0_ADDR_I2C_SLV0_RW | (addr & I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk);
+    regs[1] = reg;
+    regs[2] = len ? (I2C_SLV0_CTRL_I2C_SLV0_EN | (flags & (I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW | I2C_SLV0_CTRL_I2C_SLV0_REG_DIS
+            | I2C_SLV0_CTRL_I2C_SLV0_GRP)) | len) : 0;
+    
+    if (!mpu6050_write_registers(I2C_SLV0_ADDR + slot * (I2C_SLV1_ADDR - I2C_SLV0_ADDR), regs, sizeof(regs))) {
+        return 0;
+    }
+    
+    mpu6050_aux_len[slot] = len;
+    
+    return 1;
+}
+
+uint8_t mpu6050_aux_set_delay(uint8_t dly, uint8_t slots) {
+    mpu6050_aux_dly = dly & I2C_SLV4_CTRL_I2C_MST_DLY_Msk;
+    
+    if (!mpu6050_set_register_value(I2C_SLV4_CTRL, mpu6050_aux_dly)) {
+        return 0;
+    }
+    
+    return mpu6050_set_register_value(I2C_MST_DELAY_CTRL, slots & (I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN
+            | I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN | I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN
+            | I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN | I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN));
+}
+
+/* Time between samples in us */
+static uint32_t mpu6050_sample_period_us(void) {
+    return (1000000UL / mpu6050_gyro_rate()) * (1 + mpu6050_shadow[0]);
+}
+
+/*
+ * Start an SLV4 transfer (I2C_SLV4_ADDR .. I2C_SLV4_CTRL in one burst) and wait for it to
+ * finish. The master runs it at the next sample it is due on, so the wait is bounded by
+ * 1 + I2C_MST_DLY sample periods, plus one for margin.
+ */
+static uint8_t mpu6050_aux_slv4(uint8_t addr, uint8_t reg, uint8_t value) {
+    uint8_t regs[4];
+    uint8_t status;
+    uint32_t timeout = mpu6050_sample_period_us() * (2 + (mpu6050_aux_dly >> I2C_SLV4_CTRL_I2C_MST_DLY_Pos));
+    uint32_t waited;
+    
+    regs[0] = addr;
+    regs[1] = reg;
+    regs[2] = value;
+    regs[3] = I2C_SLV4_CTRL_I2C_SLV4_EN | mpu6050_aux_dly;
+    
+    if (!mpu6050_write_registers(I2C_SLV4_ADDR, regs, sizeof(regs))) {
+        return 0;
+    }
+    
+    /* I2C_MST_STATUS clears when read, so keep the bits for the other slaves */
+    for (waited = 0; waited <= timeout; waited += MPU6050_AUX_POLL_US) {
+        MPU6050_DELAY_US(MPU6050_AUX_POLL_US);
+        
+        if (!mpu6050_get_register_value(I2C_MST_STATUS, &status)) {
+            return 0;
+        }
+        
+        mpu6050_aux_status |= status & MPU6050_AUX_STATUS_KEEP;
+        
+        if (status & I2C_MST_STATUS_I2C_SLV4_DONE) {
+            return (status & I2C_MST_STATUS_I2C_SLV4_NACK) ? 0 : 1;
+        }
+    }
+    
+    return 0;
+}
+
+uint8_t mpu6050_aux_write(uint8_t addr, uint8_t reg, uint8_t value) {
+    return mpu6050_aux_slv4(addr & I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk, reg, value);
+}
+
+uint8_t mpu6050_aux_read(uint8_t addr, uint8_t reg, uint8_t *value) {
+    if (!mpu6050_aux_slv4(I2C_SLV0_ADDR_I2C_SLV0_RW | (addr & I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk), reg, 0)) {
+        return 0;
+    }
+    
+    return mpu6050_get_register_value(I2C_SLV4_DI, value);
+}
+
+uint8_t mpu6050_aux_get_status(uint8_t *status) {
+    uint8_t current;
+    
+    if (!mpu6050_get_register_value(I2C_MST_STATUS, &current)) {
+        return 0;
+    }
+    
+    *status = (current | mpu6050_aux_status) & MPU6050_AUX_STATUS_KEEP;
+    mpu6050_aux_status = 0;
+    
+    return 1;
+}
+
+uint8_t mpu6050_aux_get_len(void) {
+    uint8_t len = 0;
+    uint8_t i;
+    
+    for (i = 0; i < MPU6050_AUX_SLOTS; i++) {
+        len += mpu6050_aux_len[i];
+    }
+    
+    return len;
+}
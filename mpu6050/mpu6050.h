@@ -1,6 +1,6 @@
 /*
  * mpu6050.h
- *
+ * 
  *  Created on: Sep 25, 2016
  *      Author: David Rice
  */
@@ -60,7 +60,7 @@
 #define EXT_SENS_DATA_00	0x49
 #define EXT_SENS_DATA_01	0x4A
 #define EXT_SENS_DATA_02	0x4B
-#define EXT_SENS_DATA_03	0x4B
+#define EXT_SENS_DATA_03	0x4C
 #define EXT_SENS_DATA_04	0x4D
 #define EXT_SENS_DATA_05	0x4E
 #define EXT_SENS_DATA_06	0x4F
@@ -136,8 +136,507 @@
 #define CONFIG_DLPF_CFG_Msk			(0b111 << CONFIG_DLPF_CFG_Pos)
 #define CONFIG_DLPF_CFG				CONFIG_DLPF_CFG_Msk
 #define CONFIG_EXT_SYNC_SET_Pos		(3U)
-#define CONFIG_EXT_SYNC_SET_Msk		(0b111 << CONFIG_EXT_SYNC_SET_Msk)
+#define CONFIG_EXT_SYNC_SET_Msk		(0b111 << CONFIG_EXT_SYNC_SET_Pos)
 #define CONFIG_EXT_SYNC_SET			CONFIG_EXT_SYNC_SET_Msk
 
+/*
+ * GYRO_CONFIG register bits
+ */
+
+#define GYRO_CONFIG_FS_SEL_Pos		(3U)
+#define GYRO_CONFIG_FS_SEL_Msk		(0b11 << GYRO_CONFIG_FS_SEL_Pos)
+#define GYRO_CONFIG_FS_SEL			GYRO_CONFIG_FS_SEL_Msk
+#define GYRO_CONFIG_ZG_ST_Pos		(5U)
+#define GYRO_CONFIG_ZG_ST_Msk		(0b1 << GYRO_CONFIG_ZG_ST_Pos)
+#define GYRO_CONFIG_ZG_ST			GYRO_CONFIG_ZG_ST_Msk
+#define GYRO_CONFIG_YG_ST_Pos		(6U)
+#define GYRO_CONFIG_YG_ST_Msk		(0b1 << GYRO_CONFIG_YG_ST_Pos)
+#define GYRO_CONFIG_YG_ST			GYRO_CONFIG_YG_ST_Msk
+#define GYRO_CONFIG_XG_ST_Pos		(7U)
+#define GYRO_CONFIG_XG_ST_Msk		(0b1 << GYRO_CONFIG_XG_ST_Pos)
+#define GYRO_CONFIG_XG_ST			GYRO_CONFIG_XG_ST_Msk
+
+/*
+ * ACCEL_CONFIG register bits
+ */
+
+#define ACCEL_CONFIG_AFS_SEL_Pos	(3U)
+#define ACCEL_CONFIG_AFS_SEL_Msk	(0b11 << ACCEL_CONFIG_AFS_SEL_Pos)
+#define ACCEL_CONFIG_AFS_SEL		ACCEL_CONFIG_AFS_SEL_Msk
+#define ACCEL_CONFIG_ZA_ST_Pos		(5U)
+#define ACCEL_CONFIG_ZA_ST_Msk		(0b1 << ACCEL_CONFIG_ZA_ST_Pos)
+#define ACCEL_CONFIG_ZA_ST			ACCEL_CONFIG_ZA_ST_Msk
+#define ACCEL_CONFIG_YA_ST_Pos		(6U)
+#define ACCEL_CONFIG_YA_ST_Msk		(0b1 << ACCEL_CONFIG_YA_ST_Pos)
+#define ACCEL_CONFIG_YA_ST			ACCEL_CONFIG_YA_ST_Msk
+#define ACCEL_CONFIG_XA_ST_Pos		(7U)
+#define ACCEL_CONFIG_XA_ST_Msk		(0b1 << ACCEL_CONFIG_XA_ST_Pos)
+#define ACCEL_CONFIG_XA_ST			ACCEL_CONFIG_XA_ST_Msk
+
+/*
+ * FIFO_EN register bits
+ */
+
+#define FIFO_EN_SLV0_FIFO_EN_Pos	(0U)
+#define FIFO_EN_SLV0_FIFO_EN_Msk	(0b1 << FIFO_EN_SLV0_FIFO_EN_Pos)
+#define FIFO_EN_SLV0_FIFO_EN		FIFO_EN_SLV0_FIFO_EN_Msk
+#define FIFO_EN_SLV1_FIFO_EN_Pos	(1U)
+#define FIFO_EN_SLV1_FIFO_EN_Msk	(0b1 << FIFO_EN_SLV1_FIFO_EN_Pos)
+#define FIFO_EN_SLV1_FIFO_EN		FIFO_EN_SLV1_FIFO_EN_Msk
+#define FIFO_EN_SLV2_FIFO_EN_Pos	(2U)
+#define FIFO_EN_SLV2_FIFO_EN_Msk	(0b1 << FIFO_EN_SLV2_FIFO_EN_Pos)
+#define FIFO_EN_SLV2_FIFO_EN		FIFO_EN_SLV2_FIFO_EN_Msk
+#define FIFO_EN_ACCEL_FIFO_EN_Pos	(3U)
+#define FIFO_EN_ACCEL_FIFO_EN_Msk	(0b1 << FIFO_EN_ACCEL_FIFO_EN_Pos)
+#define FIFO_EN_ACCEL_FIFO_EN		FIFO_EN_ACCEL_FIFO_EN_Msk
+#define FIFO_EN_ZG_FIFO_EN_Pos		(4U)
+#define FIFO_EN_ZG_FIFO_EN_Msk		(0b1 << FIFO_EN_ZG_FIFO_EN_Pos)
+#define FIFO_EN_ZG_FIFO_EN			FIFO_EN_ZG_FIFO_EN_Msk
+#define FIFO_EN_YG_FIFO_EN_Pos		(5U)
+#define FIFO_EN_YG_FIFO_EN_Msk		(0b1 << FIFO_EN_YG_FIFO_EN_Pos)
+#define FIFO_EN_YG_FIFO_EN			FIFO_EN_YG_FIFO_EN_Msk
+#define FIFO_EN_XG_FIFO_EN_Pos		(6U)
+#define FIFO_EN_XG_FIFO_EN_Msk		(0b1 << FIFO_EN_XG_FIFO_EN_Pos)
+#define FIFO_EN_XG_FIFO_EN			FIFO_EN_XG_FIFO_EN_Msk
+#define FIFO_EN_TEMP_FIFO_EN_Pos	(7U)
+#define FIFO_EN_TEMP_FIFO_EN_Msk	(0b1 << FIFO_EN_TEMP_FIFO_EN_Pos)
+#define FIFO_EN_TEMP_FIFO_EN		FIFO_EN_TEMP_FIFO_EN_Msk
+
+/*
+ * I2C_MST_CTRL register bits
+ */
+
+#define I2C_MST_CTRL_I2C_MST_CLK_Pos	(0U)
+#define I2C_MST_CTRL_I2C_MST_CLK_Msk	(0b1111 << I2C_MST_CTRL_I2C_MST_CLK_Pos)
+#define I2C_MST_CTRL_I2C_MST_CLK	I2C_MST_CTRL_I2C_MST_CLK_Msk
+#define I2C_MST_CTRL_I2C_MST_P_NSR_Pos	(4U)
+#define I2C_MST_CTRL_I2C_MST_P_NSR_Msk	(0b1 << I2C_MST_CTRL_I2C_MST_P_NSR_Pos)
+#define I2C_MST_CTRL_I2C_MST_P_NSR	I2C_MST_CTRL_I2C_MST_P_NSR_Msk
+#define I2C_MST_CTRL_SLV_3_FIFO_EN_Pos	(5U)
+#define I2C_MST_CTRL_SLV_3_FIFO_EN_Msk	(0b1 << I2C_MST_CTRL_SLV_3_FIFO_EN_Pos)
+#define I2C_MST_CTRL_SLV_3_FIFO_EN	I2C_MST_CTRL_SLV_3_FIFO_EN_Msk
+#define I2C_MST_CTRL_WAIT_FOR_ES_Pos	(6U)
+#define I2C_MST_CTRL_WAIT_FOR_ES_Msk	(0b1 << I2C_MST_CTRL_WAIT_FOR_ES_Pos)
+#define I2C_MST_CTRL_WAIT_FOR_ES	I2C_MST_CTRL_WAIT_FOR_ES_Msk
+#define I2C_MST_CTRL_MULT_MST_EN_Pos	(7U)
+#define I2C_MST_CTRL_MULT_MST_EN_Msk	(0b1 << I2C_MST_CTRL_MULT_MST_EN_Pos)
+#define I2C_MST_CTRL_MULT_MST_EN	I2C_MST_CTRL_MULT_MST_EN_Msk
+
+/*
+ * I2C_SLV0_ADDR register bits (I2C_SLV1_ADDR .. I2C_SLV3_ADDR are the same)
+ */
+
+#define I2C_SLV0_ADDR_I2C_SLV0_ADDR_Pos	(0U)
+#define I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk	(0b1111111 << I2C_SLV0_ADDR_I2C_SLV0_ADDR_Pos)
+#define I2C_SLV0_ADDR_I2C_SLV0_ADDR	I2C_SLV0_ADDR_I2C_SLV0_ADDR_Msk
+#define I2C_SLV0_ADDR_I2C_SLV0_RW_Pos	(7U)
+#define I2C_SLV0_ADDR_I2C_SLV0_RW_Msk	(0b1 << I2C_SLV0_ADDR_I2C_SLV0_RW_Pos)
+#define I2C_SLV0_ADDR_I2C_SLV0_RW	I2C_SLV0_ADDR_I2C_SLV0_RW_Msk
+
+/*
+ * I2C_SLV0_CTRL register bits (I2C_SLV1_CTRL .. I2C_SLV3_CTRL are the same)
+ */
+
+#define I2C_SLV0_CTRL_I2C_SLV0_LEN_Pos	(0U)
+#define I2C_SLV0_CTRL_I2C_SLV0_LEN_Msk	(0b1111 << I2C_SLV0_CTRL_I2C_SLV0_LEN_Pos)
+#define I2C_SLV0_CTRL_I2C_SLV0_LEN	I2C_SLV0_CTRL_I2C_SLV0_LEN_Msk
+#define I2C_SLV0_CTRL_I2C_SLV0_GRP_Pos	(4U)
+#define I2C_SLV0_CTRL_I2C_SLV0_GRP_Msk	(0b1 << I2C_SLV0_CTRL_I2C_SLV0_GRP_Pos)
+#define I2C_SLV0_CTRL_I2C_SLV0_GRP	I2C_SLV0_CTRL_I2C_SLV0_GRP_Msk
+#define I2C_SLV0_CTRL_I2C_SLV0_REG_DIS_Pos	(5U)
+#define I2C_SLV0_CTRL_I2C_SLV0_REG_DIS_Msk	(0b1 << I2C_SLV0_CTRL_I2C_SLV0_REG_DIS_Pos)
+#define I2C_SLV0_CTRL_I2C_SLV0_REG_DIS	I2C_SLV0_CTRL_I2C_SLV0_REG_DIS_Msk
+#define I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW_Pos	(6U)
+#define I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW_Msk	(0b1 << I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW_Pos)
+#define I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW	I2C_SLV0_CTRL_I2C_SLV0_BYTE_SW_Msk
+#define I2C_SLV0_CTRL_I2C_SLV0_EN_Pos	(7U)
+#define I2C_SLV0_CTRL_I2C_SLV0_EN_Msk	(0b1 << I2C_SLV0_CTRL_I2C_SLV0_EN_Pos)
+#define I2C_SLV0_CTRL_I2C_SLV0_EN	I2C_SLV0_CTRL_I2C_SLV0_EN_Msk
+
+/*
+ * I2C_SLV4_CTRL register bits
+ */
+
+#define I2C_SLV4_CTRL_I2C_MST_DLY_Pos	(0U)
+#define I2C_SLV4_CTRL_I2C_MST_DLY_Msk	(0b11111 << I2C_SLV4_CTRL_I2C_MST_DLY_Pos)
+#define I2C_SLV4_CTRL_I2C_MST_DLY	I2C_SLV4_CTRL_I2C_MST_DLY_Msk
+#define I2C_SLV4_CTRL_I2C_SLV4_REG_DIS_Pos	(5U)
+#define I2C_SLV4_CTRL_I2C_SLV4_REG_DIS_Msk	(0b1 << I2C_SLV4_CTRL_I2C_SLV4_REG_DIS_Pos)
+#define I2C_SLV4_CTRL_I2C_SLV4_REG_DIS	I2C_SLV4_CTRL_I2C_SLV4_REG_DIS_Msk
+#define I2C_SLV4_CTRL_I2C_SLV4_INT_EN_Pos	(6U)
+#define I2C_SLV4_CTRL_I2C_SLV4_INT_EN_Msk	(0b1 << I2C_SLV4_CTRL_I2C_SLV4_INT_EN_Pos)
+#define I2C_SLV4_CTRL_I2C_SLV4_INT_EN	I2C_SLV4_CTRL_I2C_SLV4_INT_EN_Msk
+#define I2C_SLV4_CTRL_I2C_SLV4_EN_Pos	(7U)
+#define I2C_SLV4_CTRL_I2C_SLV4_EN_Msk	(0b1 << I2C_SLV4_CTRL_I2C_SLV4_EN_Pos)
+#define I2C_SLV4_CTRL_I2C_SLV4_EN	I2C_SLV4_CTRL_I2C_SLV4_EN_Msk
+
+/*
+ * I2C_MST_STATUS register bits
+ */
+
+#define I2C_MST_STATUS_I2C_SLV0_NACK_Pos	(0U)
+#define I2C_MST_STATUS_I2C_SLV0_NACK_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV0_NACK_Pos)
+#define I2C_MST_STATUS_I2C_SLV0_NACK	I2C_MST_STATUS_I2C_SLV0_NACK_Msk
+#define I2C_MST_STATUS_I2C_SLV1_NACK_Pos	(1U)
+#define I2C_MST_STATUS_I2C_SLV1_NACK_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV1_NACK_Pos)
+#define I2C_MST_STATUS_I2C_SLV1_NACK	I2C_MST_STATUS_I2C_SLV1_NACK_Msk
+#define I2C_MST_STATUS_I2C_SLV2_NACK_Pos	(2U)
+#define I2C_MST_STATUS_I2C_SLV2_NACK_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV2_NACK_Pos)
+#define I2C_MST_STATUS_I2C_SLV2_NACK	I2C_MST_STATUS_I2C_SLV2_NACK_Msk
+#define I2C_MST_STATUS_I2C_SLV3_NACK_Pos	(3U)
+#define I2C_MST_STATUS_I2C_SLV3_NACK_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV3_NACK_Pos)
+#define I2C_MST_STATUS_I2C_SLV3_NACK	I2C_MST_STATUS_I2C_SLV3_NACK_Msk
+#define I2C_MST_STATUS_I2C_SLV4_NACK_Pos	(4U)
+#define I2C_MST_STATUS_I2C_SLV4_NACK_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV4_NACK_Pos)
+#define I2C_MST_STATUS_I2C_SLV4_NACK	I2C_MST_STATUS_I2C_SLV4_NACK_Msk
+#define I2C_MST_STATUS_I2C_LOST_ARB_Pos	(5U)
+#define I2C_MST_STATUS_I2C_LOST_ARB_Msk	(0b1 << I2C_MST_STATUS_I2C_LOST_ARB_Pos)
+#define I2C_MST_STATUS_I2C_LOST_ARB	I2C_MST_STATUS_I2C_LOST_ARB_Msk
+#define I2C_MST_STATUS_I2C_SLV4_DONE_Pos	(6U)
+#define I2C_MST_STATUS_I2C_SLV4_DONE_Msk	(0b1 << I2C_MST_STATUS_I2C_SLV4_DONE_Pos)
+#define I2C_MST_STATUS_I2C_SLV4_DONE	I2C_MST_STATUS_I2C_SLV4_DONE_Msk
+#define I2C_MST_STATUS_PASS_THROUGH_Pos	(7U)
+#define I2C_MST_STATUS_PASS_THROUGH_Msk	(0b1 << I2C_MST_STATUS_PASS_THROUGH_Pos)
+#define I2C_MST_STATUS_PASS_THROUGH	I2C_MST_STATUS_PASS_THROUGH_Msk
+
+/*
+ * INT_PIN_CFG register bits
+ */
+
+#define INT_PIN_CFG_I2C_BYPASS_EN_Pos	(1U)
+#define INT_PIN_CFG_I2C_BYPASS_EN_Msk	(0b1 << INT_PIN_CFG_I2C_BYPASS_EN_Pos)
+#define INT_PIN_CFG_I2C_BYPASS_EN	INT_PIN_CFG_I2C_BYPASS_EN_Msk
+#define INT_PIN_CFG_FSYNC_INT_EN_Pos	(2U)
+#define INT_PIN_CFG_FSYNC_INT_EN_Msk	(0b1 << INT_PIN_CFG_FSYNC_INT_EN_Pos)
+#define INT_PIN_CFG_FSYNC_INT_EN	INT_PIN_CFG_FSYNC_INT_EN_Msk
+#define INT_PIN_CFG_FSYNC_INT_LEVEL_Pos	(3U)
+#define INT_PIN_CFG_FSYNC_INT_LEVEL_Msk	(0b1 << INT_PIN_CFG_FSYNC_INT_LEVEL_Pos)
+#define INT_PIN_CFG_FSYNC_INT_LEVEL	INT_PIN_CFG_FSYNC_INT_LEVEL_Msk
+#define INT_PIN_CFG_INT_RD_CLEAR_Pos	(4U)
+#define INT_PIN_CFG_INT_RD_CLEAR_Msk	(0b1 << INT_PIN_CFG_INT_RD_CLEAR_Pos)
+#define INT_PIN_CFG_INT_RD_CLEAR	INT_PIN_CFG_INT_RD_CLEAR_Msk
+#define INT_PIN_CFG_LATCH_INT_EN_Pos	(5U)
+#define INT_PIN_CFG_LATCH_INT_EN_Msk	(0b1 << INT_PIN_CFG_LATCH_INT_EN_Pos)
+#define INT_PIN_CFG_LATCH_INT_EN	INT_PIN_CFG_LATCH_INT_EN_Msk
+#define INT_PIN_CFG_INT_OPEN_Pos	(6U)
+#define INT_PIN_CFG_INT_OPEN_Msk	(0b1 << INT_PIN_CFG_INT_OPEN_Pos)
+#define INT_PIN_CFG_INT_OPEN		INT_PIN_CFG_INT_OPEN_Msk
+#define INT_PIN_CFG_INT_LEVEL_Pos	(7U)
+#define INT_PIN_CFG_INT_LEVEL_Msk	(0b1 << INT_PIN_CFG_INT_LEVEL_Pos)
+#define INT_PIN_CFG_INT_LEVEL		INT_PIN_CFG_INT_LEVEL_Msk
+
+/*
+ * INT_ENABLE register bits
+ */
+
+#define INT_ENABLE_DATA_RDY_EN_Pos	(0U)
+#define INT_ENABLE_DATA_RDY_EN_Msk	(0b1 << INT_ENABLE_DATA_RDY_EN_Pos)
+#define INT_ENABLE_DATA_RDY_EN		INT_ENABLE_DATA_RDY_EN_Msk
+#define INT_ENABLE_I2C_MST_INT_EN_Pos	(3U)
+#define INT_ENABLE_I2C_MST_INT_EN_Msk	(0b1 << INT_ENABLE_I2C_MST_INT_EN_Pos)
+#define INT_ENABLE_I2C_MST_INT_EN	INT_ENABLE_I2C_MST_INT_EN_Msk
+#define INT_ENABLE_FIFO_OFLOW_EN_Pos	(4U)
+#define INT_ENABLE_FIFO_OFLOW_EN_Msk	(0b1 << INT_ENABLE_FIFO_OFLOW_EN_Pos)
+#define INT_ENABLE_FIFO_OFLOW_EN	INT_ENABLE_FIFO_OFLOW_EN_Msk
+
+/*
+ * INT_STATUS register bits
+ */
+
+#define INT_STATUS_DATA_RDY_INT_Pos	(0U)
+#define INT_STATUS_DATA_RDY_INT_Msk	(0b1 << INT_STATUS_DATA_RDY_INT_Pos)
+#define INT_STATUS_DATA_RDY_INT		INT_STATUS_DATA_RDY_INT_Msk
+#define INT_STATUS_I2C_MST_INT_Pos	(3U)
+#define INT_STATUS_I2C_MST_INT_Msk	(0b1 << INT_STATUS_I2C_MST_INT_Pos)
+#define INT_STATUS_I2C_MST_INT		INT_STATUS_I2C_MST_INT_Msk
+#define INT_STATUS_FIFO_OFLOW_INT_Pos	(4U)
+#define INT_STATUS_FIFO_OFLOW_INT_Msk	(0b1 << INT_STATUS_FIFO_OFLOW_INT_Pos)
+#define INT_STATUS_FIFO_OFLOW_INT	INT_STATUS_FIFO_OFLOW_INT_Msk
+
+/*
+ * I2C_MST_DELAY_CTRL register bits
+ */
+
+#define I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN_Pos	(0U)
+#define I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN_Msk	(0b1 << I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN_Pos)
+#define I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN	I2C_MST_DELAY_CTRL_I2C_SLV0_DLY_EN_Msk
+#define I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN_Pos	(1U)
+#define I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN_Msk	(0b1 << I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN_Pos)
+#define I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN	I2C_MST_DELAY_CTRL_I2C_SLV1_DLY_EN_Msk
+#define I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN_Pos	(2U)
+#define I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN_Msk	(0b1 << I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN_Pos)
+#define I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN	I2C_MST_DELAY_CTRL_I2C_SLV2_DLY_EN_Msk
+#define I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN_Pos	(3U)
+#define I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN_Msk	(0b1 << I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN_Pos)
+#define I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN	I2C_MST_DELAY_CTRL_I2C_SLV3_DLY_EN_Msk
+#define I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN_Pos	(4U)
+#define I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN_Msk	(0b1 << I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN_Pos)
+#define I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN	I2C_MST_DELAY_CTRL_I2C_SLV4_DLY_EN_Msk
+#define I2C_MST_DELAY_CTRL_DELAY_ES_SHADOW_Pos	(7U)
+#define I2C_MST_DELAY_CTRL_DELAY_ES_SHADOW_Msk	(0b1 << I2C_MST_DELAY_CTRL_DELAY_ES_SHADOW_Pos)
+#define I2C_MST_DELAY_CTRL_DELAY_ES_SHADOW	I2C_MST_DELAY_CTRL_DELAY_ES_SHADOW_Msk
+
+/*
+ * USER_CTRL register bits
+ */
+
+#define USER_CTRL_SIG_COND_RESET_Pos	(0U)
+#define USER_CTRL_SIG_COND_RESET_Msk	(0b1 << USER_CTRL_SIG_COND_RESET_Pos)
+#define USER_CTRL_SIG_COND_RESET	USER_CTRL_SIG_COND_RESET_Msk
+#define USER_CTRL_I2C_MST_RESET_Pos	(1U)
+#define USER_CTRL_I2C_MST_RESET_Msk	(0b1 << USER_CTRL_I2C_MST_RESET_Pos)
+#define USER_CTRL_I2C_MST_RESET		USER_CTRL_I2C_MST_RESET_Msk
+#define USER_CTRL_FIFO_RESET_Pos	(2U)
+#define USER_CTRL_FIFO_RESET_Msk	(0b1 << USER_CTRL_FIFO_RESET_Pos)
+#define USER_CTRL_FIFO_RESET		USER_CTRL_FIFO_RESET_Msk
+#define USER_CTRL_I2C_IF_DIS_Pos	(4U)
+#define USER_CTRL_I2C_IF_DIS_Msk	(0b1 << USER_CTRL_I2C_IF_DIS_Pos)
+#define USER_CTRL_I2C_IF_DIS		USER_CTRL_I2C_IF_DIS_Msk
+#define USER_CTRL_I2C_MST_EN_Pos	(5U)
+#define USER_CTRL_I2C_MST_EN_Msk	(0b1 << USER_CTRL_I2C_MST_EN_Pos)
+#define USER_CTRL_I2C_MST_EN		USER_CTRL_I2C_MST_EN_Msk
+#define USER_CTRL_FIFO_EN_Pos		(6U)
+#define USER_CTRL_FIFO_EN_Msk		(0b1 << USER_CTRL_FIFO_EN_Pos)
+#define USER_CTRL_FIFO_EN			USER_CTRL_FIFO_EN_Msk
+
+/*
+ * PWR_MGMT_1 register bits
+ */
+
+#define PWR_MGMT_1_CLKSEL_Pos		(0U)
+#define PWR_MGMT_1_CLKSEL_Msk		(0b111 << PWR_MGMT_1_CLKSEL_Pos)
+#define PWR_MGMT_1_CLKSEL			PWR_MGMT_1_CLKSEL_Msk
+#define PWR_MGMT_1_TEMP_DIS_Pos		(3U)
+#define PWR_MGMT_1_TEMP_DIS_Msk		(0b1 << PWR_MGMT_1_TEMP_DIS_Pos)
+#define PWR_MGMT_1_TEMP_DIS			PWR_MGMT_1_TEMP_DIS_Msk
+#define PWR_MGMT_1_CYCLE_Pos		(5U)
+#define PWR_MGMT_1_CYCLE_Msk		(0b1 << PWR_MGMT_1_CYCLE_Pos)
+#define PWR_MGMT_1_CYCLE			PWR_MGMT_1_CYCLE_Msk
+#define PWR_MGMT_1_SLEEP_Pos		(6U)
+#define PWR_MGMT_1_SLEEP_Msk		(0b1 << PWR_MGMT_1_SLEEP_Pos)
+#define PWR_MGMT_1_SLEEP			PWR_MGMT_1_SLEEP_Msk
+#define PWR_MGMT_1_DEVICE_RESET_Pos	(7U)
+#define PWR_MGMT_1_DEVICE_RESET_Msk	(0b1 << PWR_MGMT_1_DEVICE_RESET_Pos)
+#define PWR_MGMT_1_DEVICE_RESET		PWR_MGMT_1_DEVICE_RESET_Msk
+
+/*
+ * PWR_MGMT_2 register bits
+ */
+
+#define PWR_MGMT_2_STBY_ZG_Pos		(0U)
+#define PWR_MGMT_2_STBY_ZG_Msk		(0b1 << PWR_MGMT_2_STBY_ZG_Pos)
+#define PWR_MGMT_2_STBY_ZG			PWR_MGMT_2_STBY_ZG_Msk
+#define PWR_MGMT_2_STBY_YG_Pos		(1U)
+#define PWR_MGMT_2_STBY_YG_Msk		(0b1 << PWR_MGMT_2_STBY_YG_Pos)
+#define PWR_MGMT_2_STBY_YG			PWR_MGMT_2_STBY_YG_Msk
+#define PWR_MGMT_2_STBY_XG_Pos		(2U)
+#define PWR_MGMT_2_STBY_XG_Msk		(0b1 << PWR_MGMT_2_STBY_XG_Pos)
+#define PWR_MGMT_2_STBY_XG			PWR_MGMT_2_STBY_XG_Msk
+#define PWR_MGMT_2_STBY_ZA_Pos		(3U)
+#define PWR_MGMT_2_STBY_ZA_Msk		(0b1 << PWR_MGMT_2_STBY_ZA_Pos)
+#define PWR_MGMT_2_STBY_ZA			PWR_MGMT_2_STBY_ZA_Msk
+#define PWR_MGMT_2_STBY_YA_Pos		(4U)
+#define PWR_MGMT_2_STBY_YA_Msk		(0b1 << PWR_MGMT_2_STBY_YA_Pos)
+#define PWR_MGMT_2_STBY_YA			PWR_MGMT_2_STBY_YA_Msk
+#define PWR_MGMT_2_STBY_XA_Pos		(5U)
+#define PWR_MGMT_2_STBY_XA_Msk		(0b1 << PWR_MGMT_2_STBY_XA_Pos)
+#define PWR_MGMT_2_STBY_XA			PWR_MGMT_2_STBY_XA_Msk
+#define PWR_MGMT_2_LP_WAKE_CTRL_Pos	(6U)
+#define PWR_MGMT_2_LP_WAKE_CTRL_Msk	(0b11 << PWR_MGMT_2_LP_WAKE_CTRL_Pos)
+#define PWR_MGMT_2_LP_WAKE_CTRL		PWR_MGMT_2_LP_WAKE_CTRL_Msk
+
+/*
+ * Driver definitions
+ */
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* 7-bit address with AD0 low - define MPU6050_ADDRESS in mpu6050-cfg.h for 0x69 */
+#define MPU6050_ADDRESS_AD0_LOW     0x68
+#define MPU6050_ADDRESS_AD0_HIGH    0x69
+
+/* Device address used by the drivers, which include mpu6050-cfg.h ahead of this header */
+#ifndef MPU6050_ADDRESS
+#define MPU6050_ADDRESS             MPU6050_ADDRESS_AD0_LOW
+#endif
+
+#define MPU6050_WHO_AM_I_VALUE      0x68
+
+/* CONFIG DLPF_CFG settings, accelerometer / gyro bandwidth */
+#define MPU6050_DLPF_260HZ          0b000       /* Gyro output rate 8 kHz */
+#define MPU6050_DLPF_184HZ          0b001
+#define MPU6050_DLPF_94HZ           0b010
+#define MPU6050_DLPF_44HZ           0b011
+#define MPU6050_DLPF_21HZ           0b100
+#define MPU6050_DLPF_10HZ           0b101
+#define MPU6050_DLPF_5HZ            0b110
+
+/* GYRO_CONFIG FS_SEL settings */
+#define MPU6050_GYRO_FS_250DPS      0b00
+#define MPU6050_GYRO_FS_500DPS      0b01
+#define MPU6050_GYRO_FS_1000DPS     0b10
+#define MPU6050_GYRO_FS_2000DPS     0b11
+
+/* ACCEL_CONFIG AFS_SEL settings */
+#define MPU6050_ACCEL_FS_2G         0b00
+#define MPU6050_ACCEL_FS_4G         0b01
+#define MPU6050_ACCEL_FS_8G         0b10
+#define MPU6050_ACCEL_FS_16G        0b11
+
+/* PWR_MGMT_1 CLKSEL settings */
+#define MPU6050_CLKSEL_INTERNAL     0b000
+#define MPU6050_CLKSEL_PLL_XGYRO    0b001
+
+/* Accelerometer, temperature and gyro output registers read as one burst */
+#define MPU6050_SENSOR_BYTES        14
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} MPU6050_XL_DATA;
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} MPU6050_G_DATA;
+
+typedef struct {
+    int16_t temp;               /* degC = temp / 340 + 36.53 */
+    MPU6050_XL_DATA xl;
+    MPU6050_G_DATA g;
+} MPU6050_SENSOR_DATA;
+
+/* Register access - functions returning uint8_t return 0 if the device did not acknowledge */
+uint8_t mpu6050_write_registers(uint8_t start_addr, const uint8_t *data, uint8_t num);
+uint8_t mpu6050_read_registers(uint8_t start_addr, uint8_t *buffer, uint16_t num);
+
+uint8_t mpu6050_set_register_value(uint8_t addr, uint8_t value);
+uint8_t mpu6050_get_register_value(uint8_t addr, uint8_t *value);
+
+/* Convert big-endian register pairs */
+void mpu6050_decode_words(const uint8_t *buffer, int16_t *out, uint8_t count);
+
+/* Unpack MPU6050_SENSOR_BYTES read from ACCEL_XOUT_H */
+void mpu6050_decode_sensor_data(const uint8_t *buffer, MPU6050_SENSOR_DATA *data);
+
+/* Wake the device with the gyro PLL as clock source - returns 0 if WHO_AM_I does not match */
+uint8_t mpu6050_init(void);
+
+/* Write SMPLRT_DIV, CONFIG, GYRO_CONFIG and ACCEL_CONFIG in one burst */
+uint8_t mpu6050_configure(uint8_t rate_div, uint8_t dlpf, uint8_t gyro_scale, uint8_t accel_scale);
+
+uint8_t mpu6050_set_sample_rate_div(uint8_t rate_div);
+uint8_t mpu6050_set_sample_rate(uint16_t rate_hz);
+uint16_t mpu6050_get_sample_rate(void);
+uint8_t mpu6050_set_dlpf(uint8_t dlpf);
+uint8_t mpu6050_set_gyro_scale(uint8_t scale);
+uint8_t mpu6050_set_accel_scale(uint8_t scale);
+
+/* Last value written to a configuration register SMPLRT_DIV .. ACCEL_CONFIG, without bus traffic */
+uint8_t mpu6050_get_config_value(uint8_t addr);
+
+uint8_t mpu6050_get_temperature(int16_t *temp);
+uint8_t mpu6050_get_accel_data(MPU6050_XL_DATA *data);
+uint8_t mpu6050_get_gyro_data(MPU6050_G_DATA *data);
+uint8_t mpu6050_get_all_sensor_data(MPU6050_SENSOR_DATA *data);
+
+/* FIFO depth in bytes - frames hold the sensors enabled in FIFO_EN, in register order */
+#define MPU6050_FIFO_SIZE           1024
+
+/* FIFO_EN bits for the motion sensors */
+#define MPU6050_FIFO_GYRO           (FIFO_EN_XG_FIFO_EN | FIFO_EN_YG_FIFO_EN | FIFO_EN_ZG_FIFO_EN)
+#define MPU6050_FIFO_MOTION         (FIFO_EN_TEMP_FIFO_EN | MPU6050_FIFO_GYRO | FIFO_EN_ACCEL_FIFO_EN)
+
+typedef struct {
+    uint8_t sensors;            /* FIFO_EN bits */
+    uint8_t frame_len;          /* Bytes per sample */
+    uint8_t ext_len;            /* Bytes of auxiliary slave data at the end of each frame */
+    uint16_t overflows;         /* Times the FIFO filled and was reset to regain frame alignment */
+} MPU6050_FIFO_STATE;
+
+/*
+ * Select FIFO_EN sensors and start the FIFO empty - 0 disables it. Slaves 0 to 2 can be
+ * included with FIFO_EN_SLVx_FIFO_EN once their slots are set with mpu6050_aux_set_slot.
+ */
+uint8_t mpu6050_fifo_configure(uint8_t sensors);
+uint8_t mpu6050_fifo_reset(void);
+uint8_t mpu6050_fifo_get_count(uint16_t *count);
+
+/*
+ * Read up to max whole frames, sensors not in the FIFO read as 0. After an overflow the
+ * FIFO is reset and nothing is returned, so that reading resumes on a frame boundary.
+ * Overflow is detected from INT_STATUS, which this read clears.
+ */
+uint16_t mpu6050_fifo_read(MPU6050_SENSOR_DATA *out, uint16_t max);
+
+/* As mpu6050_fifo_read, also copying ext_len bytes of slave data per frame to ext */
+uint16_t mpu6050_fifo_read_ext(MPU6050_SENSOR_DATA *out, uint8_t *ext, uint16_t max);
+MPU6050_FIFO_STATE *mpu6050_fifo_get_state(void);
+
+/* Unpack one frame read from FIFO_R_W, for FIFO reads made outside mpu6050_fifo_read */
+void mpu6050_fifo_decode(const uint8_t *frame, MPU6050_SENSOR_DATA *data, uint8_t *ext);
+
+/* USER_CTRL as last written, without the self-clearing reset bits */
+uint8_t mpu6050_get_user_ctrl(void);
+
+/*
+ * Auxiliary I2C master - slots SLV0 .. SLV3 read external sensors once per sample (or
+ * every 1 + dly samples) into EXT_SENS_DATA, which follows the gyro output registers,
+ * so motion and external data arrive in the same burst or FIFO frame. For example,
+ * an HMC5883L magnetometer in continuous mode:
+ * 
+ * mpu6050_aux_enable(MPU6050_AUX_CLK_400KHZ);
+ * mpu6050_aux_write(0x1E, 0x02, 0x00);
+ * mpu6050_aux_set_slot(0, 0x1E, 0x03, 6, 0);
+ * mpu6050_get_all_sensor_data_ext(&data, mag);
+ */
+#define MPU6050_AUX_SLOTS           4
+#define MPU6050_EXT_SENS_BYTES      24
+
+/* I2C_MST_CTRL I2C_MST_CLK settings */
+#define MPU6050_AUX_CLK_348KHZ      0
+#define MPU6050_AUX_CLK_400KHZ      13
+
+/* FIFO_EN bits for auxiliary slaves */
+#define MPU6050_FIFO_AUX            (FIFO_EN_SLV0_FIFO_EN | FIFO_EN_SLV1_FIFO_EN | FIFO_EN_SLV2_FIFO_EN)
+
+/* Start the master - sample data is held back until slave reads complete */
+uint8_t mpu6050_aux_enable(uint8_t clock);
+uint8_t mpu6050_aux_disable(void);
+
+/* Read len bytes (at most 15, 24 over all slots) from reg of device addr each sample - len 0 frees the slot */
+uint8_t mpu6050_aux_set_slot(uint8_t slot, uint8_t addr, uint8_t reg, uint8_t len, uint8_t flags);
+
+/* Access slots (bit per slot, bit 4 for SLV4) only every 1 + dly samples */
+uint8_t mpu6050_aux_set_delay(uint8_t dly, uint8_t slots);
+
+/*
+ * Single-byte transfers through SLV4, e.g. to set up an external sensor - these wait up to
+ * 2 + dly sample periods, since SLV4 runs at the next sample, so set the sample rate first
+ */
+uint8_t mpu6050_aux_write(uint8_t addr, uint8_t reg, uint8_t value);
+uint8_t mpu6050_aux_read(uint8_t addr, uint8_t reg, uint8_t *value);
+
+/*
+ * Slave NACK (I2C_MST_STATUS_I2C_SLVx_NACK, x 0 to 3) and LOST_ARB bits seen since the
+ * last call, including those read while waiting for SLV4 transfers
+ */
+uint8_t mpu6050_aux_get_status(uint8_t *status);
+
+/* Bytes of EXT_SENS_DATA filled by the slots */
+uint8_t mpu6050_aux_get_len(void);
+
+/* As mpu6050_get_all_sensor_data, with EXT_SENS_DATA in the same burst */
+uint8_t mpu6050_get_all_sensor_data_ext(MPU6050_SENSOR_DATA *data, uint8_t *ext);
+
+#ifdef	__cplusplus
+}
+#endif
 
 #endif /* MPU6050_H_ */
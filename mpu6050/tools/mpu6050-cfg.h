@@ -0,0 +1,42 @@
+/*
+ * MPU-6050 driver configuration for host tools - binds the driver to the emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MPU6050_CFG_H
+#define MPU6050_CFG_H
+
+#include "i2c-sim.h"
+#include "mpu6050-emu.h"
+
+extern I2C_SIM bus;
+extern MPU6050_EMU emu;
+
+#define MPU6050_I2C_START()         i2c_sim_start(&bus)
+#define MPU6050_I2C_RESTART()       i2c_sim_restart(&bus)
+#define MPU6050_I2C_STOP()          i2c_sim_stop(&bus)
+#define MPU6050_I2C_WRITE(x)        i2c_sim_write(&bus, x)
+#define MPU6050_I2C_READ(ack)       i2c_sim_read(&bus, ack)
+
+/* Waiting lets emulated time pass */
+#define MPU6050_DELAY_US(x)         mpu6050_emu_advance(&emu, x)
+
+#endif	/* MPU6050_CFG_H */
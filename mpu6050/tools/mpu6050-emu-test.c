@@ -0,0 +1,309 @@
+/*
+ * Host test of the MPU-6050 driver against the emulator
+ * Copyright (c) 2019 David Rice
+ * 
+ * Runs the driver on an emulated bus with an external sensor (a register file at
+ * 0x1E standing in for an HMC5883L) on the auxiliary bus, covering the SLV4 wait,
+ * FIFO overflow handling and the bus traffic of the sensor and FIFO bursts. The
+ * non-blocking data path is run on the I2C transaction engine over the same bus, with
+ * i2c/tools/i2c-cfg.h, and checked against the blocking reads. Prints each check and
+ * exits with status 1 if any failed.
+ * 
+ * Build with, for example:
+ * cc -I. -I.. -I../../i2c -I../../i2c/tools -o mpu6050-emu-test mpu6050-emu-test.c ../mpu6050.c ../mpu6050-async.c \
+ *     ../mpu6050-emu.c ../../i2c/i2c.c ../../i2c/i2c-sim.c
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "mpu6050.h"
+#include "mpu6050-async.h"
+#include "mpu6050-emu.h"
+#include "i2c.h"
+#include "i2c-sim.h"
+
+#define MAG_ADDRESS     0x1E
+
+/* Bytes per transaction besides the data: address for write, register, address for read */
+#define READ_OVERHEAD   3
+
+/* SCL periods per byte including the acknowledge, and for START, repeated START and STOP */
+#define BYTE_CLOCKS     9
+#define READ_CLOCKS     3
+
+/* Frames per FIFO burst for 14-byte frames, with the default MPU6050_FIFO_BURST */
+#define BURST_FRAMES    (120 / MPU6050_SENSOR_BYTES)
+
+I2C_SIM bus;
+MPU6050_EMU emu;
+
+static I2C_SIM aux;
+static I2C_SIM_REGFILE mag;
+static int failures;
+
+static void check(int ok, const char *what) {
+    printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+    
+    if (!ok) {
+        failures++;
+    }
+}
+
+/* Motion that changes with every sample, so that stale or misplaced frames show */
+static void ramp(uint32_t t_us, MPU6050_EMU_MOTION *motion) {
+    int32_t k = (int32_t)(t_us / 1000);
+    
+    motion->xl[0] = k;
+    motion->xl[1] = -2 * k;
+    motion->xl[2] = 1000 + k;
+    motion->g[0] = 100 * k;
+    motion->g[1] = -50 * k;
+    motion->g[2] = 25 * k;
+    motion->temp = (int16_t)(2500 + k);
+}
+
+/* Service engine interrupts until the bus has nothing more to do */
+static void pump(void) {
+    while (i2c_sim_interrupt(&bus)) {
+        i2c_isr();
+    }
+}
+
+static void setup(uint8_t rate_div) {
+    i2c_sim_init(&bus);
+    i2c_init();
+    i2c_sim_init(&aux);
+    mpu6050_emu_init(&emu);
+    mpu6050_emu_attach(&emu, &bus, MPU6050_ADDRESS_AD0_LOW);
+    mpu6050_emu_set_aux(&emu, &aux);
+    
+    mag.regs[0x0A] = 'H';
+    i2c_sim_attach_regfile(&aux, MAG_ADDRESS, &mag);
+    
+    mpu6050_init();
+    mpu6050_configure(rate_div, MPU6050_DLPF_44HZ, MPU6050_GYRO_FS_250DPS, MPU6050_ACCEL_FS_2G);
+    mpu6050_aux_enable(MPU6050_AUX_CLK_400KHZ);
+}
+
+/* SLV4 completes at the next sample, so the wait has to cover a whole sample period */
+static void test_slv4(uint8_t rate_div, const char *rate) {
+    uint8_t value = 0;
+    uint8_t status = 0;
+    char what[64];
+    
+    setup(rate_div);
+    
+    snprintf(what, sizeof(what), "SLV4 write at %s", rate);
+    check(mpu6050_aux_write(MAG_ADDRESS, 0x02, 0x55) && mag.regs[0x02] == 0x55, what);
+    
+    snprintf(what, sizeof(what), "SLV4 read at %s", rate);
+    check(mpu6050_aux_read(MAG_ADDRESS, 0x0A, &value) && value == 'H', what);
+    
+    snprintf(what, sizeof(what), "SLV4 write to a missing device fails at %s", rate);
+    check(!mpu6050_aux_write(MAG_ADDRESS + 1, 0x02, 0x55), what);
+    
+    /* A slot reading a missing device NACKs every sample while SLV4 is polled */
+    mpu6050_aux_set_slot(1, MAG_ADDRESS + 1, 0x03, 6, 0);
+    
+    snprintf(what, sizeof(what), "SLV1 NACK kept across SLV4 wait at %s", rate);
+    check(mpu6050_aux_write(MAG_ADDRESS, 0x00, 0x70) && mpu6050_aux_get_status(&status)
+            && (status & I2C_MST_STATUS_I2C_SLV1_NACK), what);
+}
+
+/* An overflow is caught from INT_STATUS even after frames were read out below the full mark */
+static void test_fifo_overflow(void) {
+    static MPU6050_SENSOR_DATA data[64];
+    uint8_t bytes[28];
+    uint16_t count = 0;
+    
+    setup(0);
+    mpu6050_fifo_configure(MPU6050_FIFO_MOTION);
+    
+    mpu6050_emu_advance(&emu, 10000);
+    check(mpu6050_fifo_read(data, 64) == 10 && mpu6050_fifo_get_state()->overflows == 0, "FIFO read without overflow");
+    
+    /* 100 frames of 14 bytes overflow the 1024-byte FIFO, then two frames are taken out */
+    mpu6050_emu_advance(&emu, 100000);
+    mpu6050_read_registers(FIFO_R_W, bytes, sizeof(bytes));
+    check(mpu6050_fifo_get_count(&count) && count < MPU6050_FIFO_SIZE, "FIFO count below full after overflow");
+    
+    check(mpu6050_fifo_read(data, 64) == 0 && mpu6050_fifo_get_state()->overflows == 1, "FIFO overflow detected from INT_STATUS");
+    
+    mpu6050_emu_advance(&emu, 10000);
+    check(mpu6050_fifo_read(data, 64) == 10 && mpu6050_fifo_get_state()->overflows == 1, "FIFO read resumes after overflow");
+}
+
+static int same_data(const MPU6050_SENSOR_DATA *a, const MPU6050_SENSOR_DATA *b, uint16_t count) {
+    uint16_t i;
+    
+    for (i = 0; i < count; i++) {
+        if (a[i].temp != b[i].temp || a[i].xl.x != b[i].xl.x || a[i].xl.y != b[i].xl.y || a[i].xl.z != b[i].xl.z
+                || a[i].g.x != b[i].g.x || a[i].g.y != b[i].g.y || a[i].g.z != b[i].g.z) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+/* One transaction with a repeated START - 17 bytes, 156 SCL periods */
+static void check_read_traffic(const I2C_SIM_STATS *before, uint16_t len, const char *what) {
+    char text[96];
+    
+    snprintf(text, sizeof(text), "%s: 1 transaction, 1 repeated START", what);
+    check(bus.stats.transactions - before->transactions == 1 && bus.stats.restarts - before->restarts == 1, text);
+    
+    snprintf(text, sizeof(text), "%s: %u bytes", what, READ_OVERHEAD + len);
+    check(bus.stats.bytes - before->bytes == (uint32_t)(READ_OVERHEAD + len) && bus.stats.nacks == before->nacks, text);
+    
+    snprintf(text, sizeof(text), "%s: %u SCL periods", what, (READ_OVERHEAD + len) * BYTE_CLOCKS + READ_CLOCKS);
+    check(bus.stats.clocks - before->clocks == (uint32_t)(READ_OVERHEAD + len) * BYTE_CLOCKS + READ_CLOCKS, text);
+}
+
+/*
+ * A FIFO read of frames 14-byte frames: INT_STATUS, FIFO_COUNTH, then bursts of up to
+ * BURST_FRAMES frames from FIFO_R_W
+ */
+static void check_fifo_traffic(const I2C_SIM_STATS *before, uint16_t frames, const char *what) {
+    uint16_t bursts = (frames + BURST_FRAMES - 1) / BURST_FRAMES;
+    uint32_t bytes = READ_OVERHEAD + 1 + READ_OVERHEAD + 2 + bursts * READ_OVERHEAD + frames * MPU6050_SENSOR_BYTES;
+    char text[96];
+    
+    snprintf(text, sizeof(text), "%s: %u transactions", what, 2 + bursts);
+    check(bus.stats.transactions - before->transactions == 2U + bursts && bus.stats.nacks == before->nacks, text);
+    
+    snprintf(text, sizeof(text), "%s: %lu bytes", what, (unsigned long)bytes);
+    check(bus.stats.bytes - before->bytes == bytes, text);
+    
+    snprintf(text, sizeof(text), "%s: %lu SCL periods", what, (unsigned long)(bytes * BYTE_CLOCKS + (2 + bursts) * READ_CLOCKS));
+    check(bus.stats.clocks - before->clocks == bytes * BYTE_CLOCKS + (2U + bursts) * READ_CLOCKS, text);
+}
+
+/* Bus traffic of the blocking 14-byte sensor burst and FIFO burst */
+static void test_traffic(void) {
+    static MPU6050_SENSOR_DATA data[64];
+    I2C_SIM_STATS before;
+    
+    setup(0);
+    mpu6050_emu_advance(&emu, 2000);
+    
+    before = bus.stats;
+    check(mpu6050_get_all_sensor_data(&data[0]), "sensor burst read");
+    check_read_traffic(&before, MPU6050_SENSOR_BYTES, "sensor burst");
+    
+    mpu6050_fifo_configure(MPU6050_FIFO_MOTION);
+    mpu6050_emu_advance(&emu, 10000);
+    
+    before = bus.stats;
+    check(mpu6050_fifo_read(data, 64) == 10, "FIFO burst read");
+    check_fifo_traffic(&before, 10, "FIFO burst");
+}
+
+static uint8_t async_completions;
+
+static void async_done(MPU6050_ASYNC *req) {
+    (void)req;
+    
+    async_completions++;
+}
+
+static uint8_t fifo_completions;
+
+static void fifo_done(MPU6050_ASYNC_FIFO *fifo) {
+    (void)fifo;
+    
+    fifo_completions++;
+}
+
+/* mpu6050-async.c on the transaction engine returns what the blocking driver does, with the same traffic */
+static void test_async(void) {
+    static MPU6050_SENSOR_DATA blocking[64];
+    static MPU6050_SENSOR_DATA async[64];
+    static MPU6050_ASYNC req;
+    static MPU6050_ASYNC_FIFO fifo;
+    MPU6050_SENSOR_DATA sample;
+    I2C_SIM_STATS before;
+    uint16_t count;
+    
+    /* The same emulated history is replayed for each path */
+    setup(0);
+    mpu6050_emu_set_source(&emu, ramp);
+    mpu6050_emu_advance(&emu, 2000);
+    mpu6050_get_all_sensor_data(&sample);
+    mpu6050_fifo_configure(MPU6050_FIFO_MOTION);
+    mpu6050_emu_advance(&emu, 20000);
+    count = mpu6050_fifo_read(blocking, 64);
+    
+    setup(0);
+    mpu6050_emu_set_source(&emu, ramp);
+    mpu6050_emu_advance(&emu, 2000);
+    
+    async_completions = 0;
+    before = bus.stats;
+    check(mpu6050_async_read_sensors(&req, 0, async_done), "async sensor burst submitted");
+    pump();
+    check(async_completions == 1 && req.t.status == I2C_DONE && !i2c_busy(), "async sensor burst completes");
+    check(same_data(&req.data, &sample, 1), "async sensor burst matches the blocking read");
+    check_read_traffic(&before, MPU6050_SENSOR_BYTES, "async sensor burst");
+    
+    mpu6050_fifo_configure(MPU6050_FIFO_MOTION);
+    mpu6050_emu_advance(&emu, 20000);
+    
+    fifo_completions = 0;
+    before = bus.stats;
+    check(mpu6050_async_fifo_read(&fifo, async, 64, fifo_done), "async FIFO read submitted");
+    pump();
+    check(fifo_completions == 1 && fifo.status == I2C_DONE && !fifo.overflow, "async FIFO read completes");
+    check(count == 20 && fifo.count == count && same_data(async, blocking, count), "async FIFO frames match the blocking read");
+    check_fifo_traffic(&before, count, "async FIFO burst");
+    
+    /* max limits the frames taken, leaving the rest in the FIFO */
+    mpu6050_emu_advance(&emu, 10000);
+    check(mpu6050_async_fifo_read(&fifo, async, 4, fifo_done), "async FIFO read of 4 submitted");
+    pump();
+    check(fifo.status == I2C_DONE && fifo.count == 4, "async FIFO read stops at max");
+    
+    mpu6050_emu_advance(&emu, 100000);
+    check(mpu6050_async_fifo_read(&fifo, async, 64, fifo_done), "async FIFO read after overflow submitted");
+    pump();
+    check(fifo.status == I2C_DONE && fifo.overflow && fifo.count == 0 && mpu6050_fifo_get_state()->overflows == 1,
+            "async FIFO overflow detected and reset");
+    
+    mpu6050_emu_advance(&emu, 10000);
+    check(mpu6050_async_fifo_read(&fifo, async, 64, fifo_done), "async FIFO read after reset submitted");
+    pump();
+    check(fifo.status == I2C_DONE && fifo.count == 10 && !fifo.overflow, "async FIFO read resumes after overflow");
+    check(fifo_completions == 4 && !i2c_busy(), "one completion per async FIFO read");
+}
+
+int main(void) {
+    test_slv4(0, "1 kHz");
+    test_slv4(9, "100 Hz");
+    test_slv4(255, "3.9 Hz");
+    test_fifo_overflow();
+    test_traffic();
+    test_async();
+    
+    printf("%d failed\n", failures);
+    
+    return failures ? 1 : 0;
+}
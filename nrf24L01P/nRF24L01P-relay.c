@@ -0,0 +1,308 @@
+/*
+ * Multi-hop relay layer for nRF24L01+
+ * Copyright (c) 2019 David Rice
+ * 
+ * Frames carry a four-byte header (destination, source, sequence, TTL). Each relay
+ * learns which child pipe a source was heard on and sends frames for that node back
+ * down as an ACK payload on the same pipe, so it is picked up the next time the child
+ * transmits. Frames for any other node go to the parent.
+ * 
+ * Frames are forwarded straight out of the receive queue slot, so nothing is copied
+ * between the RX and TX FIFOs. A frame that cannot be sent yet stays at the head of
+ * the queue until the next call to nrf24_relay_service.
+ * 
+ * Per-hop latency is measured as the time a frame waits in the relay, from the moment
+ * it is moved into the receive queue until it is loaded into the TX FIFO.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nRF24L01P.h"
+#include "nRF24L01P-relay.h"
+
+/* Results of nrf24_relay_transmit */
+#define NRF24_RELAY_SENT        0
+#define NRF24_RELAY_BLOCKED     1
+#define NRF24_RELAY_DROPPED     2
+
+/* Return child pipe for the destination, or NRF24_RELAY_ADDR_NONE if it is not a known descendant */
+static uint8_t nrf24_relay_lookup(NRF24_RELAY *relay, uint8_t dst)
+{
+    uint8_t i;
+    
+    for (i = 0; i < NRF24_RELAY_ROUTES; i++) {
+        if (relay->routes[i].dst == dst) {
+            return relay->routes[i].pipe;
+        }
+    }
+    
+    return NRF24_RELAY_ADDR_NONE;
+}
+
+/* Record the child pipe a source was heard on - oldest entry is replaced when the table is full */
+static void nrf24_relay_learn(NRF24_RELAY *relay, uint8_t src, uint8_t pipe)
+{
+    uint8_t i;
+    
+    for (i = 0; i < NRF24_RELAY_ROUTES; i++) {
+        if (relay->routes[i].dst == src) {
+            relay->routes[i].pipe = pipe;
+            return;
+        }
+    }
+    
+    relay->routes[relay->route_next].dst = src;
+    relay->routes[relay->route_next].pipe = pipe;
+    
+    if (++relay->route_next == NRF24_RELAY_ROUTES) {
+        relay->route_next = 0;
+    }
+}
+
+/* Return true if this source and sequence number pair was handled recently */
+static bool nrf24_relay_is_duplicate(NRF24_RELAY *relay, uint8_t src, uint8_t seq)
+{
+    uint8_t i;
+    
+    for (i = 0; i < NRF24_RELAY_DUP_SLOTS; i++) {
+        if (relay->seen[i].src == src && relay->seen[i].seq == seq) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/* Remember a handled frame for duplicate suppression */
+static void nrf24_relay_remember(NRF24_RELAY *relay, uint8_t src, uint8_t seq)
+{
+    relay->seen[relay->seen_next].src = src;
+    relay->seen[relay->seen_next].seq = seq;
+    
+    if (++relay->seen_next == NRF24_RELAY_DUP_SLOTS) {
+        relay->seen_next = 0;
+    }
+}
+
+/* Send frame towards its destination - returns NRF24_RELAY_SENT, NRF24_RELAY_BLOCKED or NRF24_RELAY_DROPPED */
+static uint8_t nrf24_relay_transmit(NRF24_RELAY *relay, uint8_t *frame, uint8_t len, bool from_up)
+{
+    uint8_t pipe;
+    
+    pipe = nrf24_relay_lookup(relay, frame[NRF24_RELAY_HDR_DST]);
+    
+    if (pipe != NRF24_RELAY_ADDR_NONE && relay->down != NULL) {
+        if (nrf24_dev_read_register(relay->down, NRF24_FIFO_STATUS) & NRF24_TX_FULL) {
+            return NRF24_RELAY_BLOCKED;
+        }
+        
+        nrf24_dev_write_ack_payload(relay->down, pipe, frame, len);
+        relay->stats.forwarded_down++;
+        
+        return NRF24_RELAY_SENT;
+    }
+    
+    /* Never send a frame back up the link it arrived on */
+    if (from_up || relay->up == NULL) {
+        relay->stats.no_route++;
+        return NRF24_RELAY_DROPPED;
+    }
+    
+    if (relay->up_busy) {
+        return NRF24_RELAY_BLOCKED;
+    }
+    
+    if (relay->up == relay->down) {
+        /* ACK payloads still waiting for children would be sent as ordinary packets */
+        if (!(nrf24_dev_read_register(relay->up, NRF24_FIFO_STATUS) & NRF24_TX_EMPTY)) {
+            return NRF24_RELAY_BLOCKED;
+        }
+        
+        nrf24_dev_pwr_request(relay->up, NRF24_STATE_STANDBY_II);
+    }
+    
+    nrf24_dev_send(relay->up, frame, len);
+    relay->up_busy = true;
+    relay->stats.forwarded_up++;
+    
+    return NRF24_RELAY_SENT;
+}
+
+/* Handle one received frame - returns false if it must stay queued and be retried later */
+static bool nrf24_relay_forward(NRF24_RELAY *relay, NRF24_DEVICE *dev, NRF24_PAYLOAD *frame)
+{
+    uint8_t src;
+    uint8_t seq;
+    bool from_up;
+    uint16_t held;
+    
+    if (frame->len < NRF24_RELAY_HDR_LEN) {
+        return true;
+    }
+    
+    src = frame->data[NRF24_RELAY_HDR_SRC];
+    seq = frame->data[NRF24_RELAY_HDR_SEQ];
+    from_up = (frame->pipe == 0);
+    
+    if (!from_up) {
+        nrf24_relay_learn(relay, src, frame->pipe);
+    }
+    
+    if (nrf24_relay_is_duplicate(relay, src, seq)) {
+        relay->stats.duplicates++;
+        return true;
+    }
+    
+    if (frame->data[NRF24_RELAY_HDR_DST] == relay->id) {
+        relay->deliver(frame);
+        relay->stats.delivered++;
+    } else if (frame->data[NRF24_RELAY_HDR_TTL] == 0) {
+        relay->stats.ttl_expired++;
+    } else {
+        /* TTL is decremented in place and restored if the frame has to wait */
+        frame->data[NRF24_RELAY_HDR_TTL]--;
+        
+        switch (nrf24_relay_transmit(relay, frame->data, frame->len, from_up)) {
+            case NRF24_RELAY_BLOCKED:
+                frame->data[NRF24_RELAY_HDR_TTL]++;
+                return false;
+            case NRF24_RELAY_SENT:
+                held = (uint16_t)(dev->get_time_us() - frame->time);
+                relay->stats.hold_total += held;
+                if (held > relay->stats.hold_max) {
+                    relay->stats.hold_max = held;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    nrf24_relay_remember(relay, src, seq);
+    
+    return true;
+}
+
+/* Handle everything waiting in the receive queue of the specified radio */
+static void nrf24_relay_drain(NRF24_RELAY *relay, NRF24_DEVICE *dev)
+{
+    NRF24_PAYLOAD *frame;
+    
+    nrf24_dev_service_rx(dev);
+    
+    while ((frame = nrf24_dev_rx_peek(dev)) != NULL) {
+        if (!nrf24_relay_forward(relay, dev, frame)) {
+            break;
+        }
+        
+        nrf24_dev_rx_release(dev);
+    }
+}
+
+/* Reset routing and duplicate tables - down, up, id and deliver must already be set */
+void nrf24_relay_init(NRF24_RELAY *relay)
+{
+    uint8_t i;
+    
+    for (i = 0; i < NRF24_RELAY_ROUTES; i++) {
+        relay->routes[i].dst = NRF24_RELAY_ADDR_NONE;
+    }
+    
+    for (i = 0; i < NRF24_RELAY_DUP_SLOTS; i++) {
+        relay->seen[i].src = NRF24_RELAY_ADDR_NONE;
+    }
+    
+    relay->seq = 0;
+    relay->up_busy = false;
+    relay->route_next = 0;
+    relay->seen_next = 0;
+    
+    relay->stats.forwarded_up = 0;
+    relay->stats.forwarded_down = 0;
+    relay->stats.delivered = 0;
+    relay->stats.duplicates = 0;
+    relay->stats.no_route = 0;
+    relay->stats.ttl_expired = 0;
+    relay->stats.up_failed = 0;
+    relay->stats.hold_max = 0;
+    relay->stats.hold_total = 0;
+}
+
+/* Forward or deliver everything received and collect upstream send results - call regularly */
+void nrf24_relay_service(NRF24_RELAY *relay)
+{
+    uint8_t result;
+    
+    if (relay->up_busy) {
+        result = nrf24_dev_poll_tx(relay->up);
+        
+        if (result != NRF24_TX_PENDING) {
+            relay->up_busy = false;
+            
+            if (result == NRF24_TX_FAILED) {
+                relay->stats.up_failed++;
+            }
+            
+            /* Shared radio goes back to listening for children */
+            if (relay->up == relay->down) {
+                nrf24_dev_pwr_request(relay->down, NRF24_STATE_RX);
+            }
+        }
+    }
+    
+    if (relay->up != NULL && relay->up != relay->down) {
+        nrf24_relay_drain(relay, relay->up);
+    }
+    
+    if (relay->down != NULL) {
+        nrf24_relay_drain(relay, relay->down);
+    }
+}
+
+/* Originate a frame from this node - returns false if the link is busy or there is no route */
+bool nrf24_relay_send(NRF24_RELAY *relay, uint8_t dst, uint8_t *data, uint8_t len)
+{
+    uint8_t frame[NRF24_MAX_PAYLOAD];
+    uint8_t i;
+    
+    if (len > NRF24_RELAY_MAX_DATA) {
+        return false;
+    }
+    
+    frame[NRF24_RELAY_HDR_DST] = dst;
+    frame[NRF24_RELAY_HDR_SRC] = relay->id;
+    frame[NRF24_RELAY_HDR_SEQ] = relay->seq + 1;
+    frame[NRF24_RELAY_HDR_TTL] = NRF24_RELAY_DEFAULT_TTL;
+    
+    for (i = 0; i < len; i++) {
+        frame[NRF24_RELAY_HDR_LEN + i] = data[i];
+    }
+    
+    if (nrf24_relay_transmit(relay, frame, NRF24_RELAY_HDR_LEN + len, false) != NRF24_RELAY_SENT) {
+        return false;
+    }
+    
+    relay->seq++;
+    
+    return true;
+}
@@ -0,0 +1,117 @@
+/*
+ * Constant definitions and function prototypes for
+ * multi-hop relay layer over nRF24L01+
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NRF24L01P_RELAY_H
+#define NRF24L01P_RELAY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Frame header - first four bytes of every relayed payload */
+
+#define NRF24_RELAY_HDR_DST     0
+#define NRF24_RELAY_HDR_SRC     1
+#define NRF24_RELAY_HDR_SEQ     2
+#define NRF24_RELAY_HDR_TTL     3
+#define NRF24_RELAY_HDR_LEN     4
+#define NRF24_RELAY_MAX_DATA    (NRF24_MAX_PAYLOAD - NRF24_RELAY_HDR_LEN)
+
+#define NRF24_RELAY_DEFAULT_TTL 4
+#define NRF24_RELAY_ADDR_NONE   0xFFU   /* Reserved node ID - marks unused table entries */
+
+/* Table sizes */
+
+#ifndef NRF24_RELAY_ROUTES
+#define NRF24_RELAY_ROUTES      8       /* Descendants reachable through child pipes */
+#endif
+
+#ifndef NRF24_RELAY_DUP_SLOTS
+#define NRF24_RELAY_DUP_SLOTS   8       /* Recently seen (source, sequence) pairs */
+#endif
+
+/* Route to a descendant - pipe is the child pipe (1-5) the node was last heard on */
+typedef struct {
+    uint8_t dst;
+    uint8_t pipe;
+} NRF24_ROUTE;
+
+/* Recently seen frame, used to drop retransmitted duplicates */
+typedef struct {
+    uint8_t src;
+    uint8_t seq;
+} NRF24_RELAY_SEEN;
+
+typedef struct {
+    uint16_t forwarded_up;      /* Frames sent to the parent */
+    uint16_t forwarded_down;    /* Frames loaded as ACK payloads for a child */
+    uint16_t delivered;         /* Frames addressed to this node */
+    uint16_t duplicates;        /* Frames dropped as already seen */
+    uint16_t no_route;          /* Frames dropped with no way to reach the destination */
+    uint16_t ttl_expired;       /* Frames dropped after too many hops */
+    uint16_t up_failed;         /* Upstream sends that hit MAX_RT */
+    uint16_t hold_max;          /* Longest time a frame waited in this node (us) */
+    uint32_t hold_total;        /* Sum of wait times, divide by forwarded_up + forwarded_down (us) */
+} NRF24_RELAY_STATS;
+
+/* 
+ * Relay node state
+ * 
+ * Children transmit to the down radio on pipes 1-5. Pipe 0 is reserved for the parent
+ * link, which is also where ACK payloads from the parent arrive. Both radios need
+ * dynamic payloads and ACK payloads enabled.
+ * 
+ * down and up may point to the same radio, in which case the relay switches it to TX
+ * for each upstream frame, and only does so while no ACK payloads are waiting for
+ * children. Two radios avoid both restrictions.
+ */
+typedef struct {
+    NRF24_DEVICE *down;                     /* Radio receiving from children, or NULL for a leaf node */
+    NRF24_DEVICE *up;                       /* Radio sending to the parent, or NULL at the root */
+    uint8_t id;                             /* This node's ID */
+    void (*deliver)(NRF24_PAYLOAD *frame);  /* Called with frames addressed to this node */
+    
+    uint8_t seq;
+    bool up_busy;
+    uint8_t route_next;
+    uint8_t seen_next;
+    NRF24_ROUTE routes[NRF24_RELAY_ROUTES];
+    NRF24_RELAY_SEEN seen[NRF24_RELAY_DUP_SLOTS];
+    NRF24_RELAY_STATS stats;
+} NRF24_RELAY;
+
+/* Reset routing and duplicate tables - down, up, id and deliver must already be set */
+void nrf24_relay_init(NRF24_RELAY *relay);
+
+/* Forward or deliver everything received and collect upstream send results - call regularly */
+void nrf24_relay_service(NRF24_RELAY *relay);
+
+/* Originate a frame from this node - returns false if the link is busy or there is no route */
+bool nrf24_relay_send(NRF24_RELAY *relay, uint8_t dst, uint8_t *data, uint8_t len);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* NRF24L01P_RELAY_H */
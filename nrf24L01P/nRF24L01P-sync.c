@@ -0,0 +1,286 @@
+/*
+ * Over-the-air time synchronization for nRF24L01+
+ * Copyright (c) 2019 David Rice
+ * 
+ * A node sends a short beacon request and timestamps it locally when it is loaded (t1)
+ * and when the ACK arrives (t4). The gateway timestamps the request on arrival (t2) and
+ * loads t2 as the ACK payload for that pipe, so the node receives it with the ACK to its
+ * following request. The midpoint of t1 and t4 is matched against t2 to measure offset,
+ * and successive offsets give the skew between the two clocks.
+ * 
+ * Exchanges that needed a retransmission or took longer than max_rtt are not used,
+ * since their delay is unlikely to be symmetric.
+ * 
+ * Accuracy depends on how promptly t2 and t4 are taken - call nrf24_sync_gateway_handle
+ * with the time the IRQ fired and poll the node side from the IRQ handler where possible.
+ * 
+ * Both sides need dynamic payloads and ACK payloads enabled (FEATURE EN_DPL | EN_ACK_PAY).
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */ 
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nRF24L01P.h"
+#include "nRF24L01P-sync.h"
+
+/* 
+ * Return skew correction (elapsed * skew) >> NRF24_SYNC_SKEW_SHIFT for a positive elapsed
+ * local time. With skew clamped to NRF24_SYNC_MAX_SKEW (< 2^15), elapsed is split into
+ * 16-bit halves so that both partial products fit in 32 bits.
+ */
+static int32_t nrf24_sync_correction(int32_t skew, uint32_t elapsed)
+{
+    int32_t hi = (int32_t)(elapsed >> 16) * skew;
+    int32_t lo = (int32_t)(elapsed & 0xFFFFU) * skew;
+    
+    /* (hi << 16 + lo) >> 24 - low byte of hi is carried into the low half before shifting */
+    return (hi >> 8) + ((((hi & 0xFF) << 16) + lo) >> NRF24_SYNC_SKEW_SHIFT);
+}
+
+/* 
+ * Return (err << NRF24_SYNC_SKEW_SHIFT) / dt in 32 bits. Rates of 1/64 or more saturate,
+ * which is far beyond NRF24_SYNC_MAX_SKEW and is clamped by the caller anyway.
+ */
+static int32_t nrf24_sync_rate(int32_t err, uint32_t dt)
+{
+    uint32_t rem = (err < 0) ? (0UL - (uint32_t)err) : (uint32_t)err;
+    uint32_t rate = 0;
+    uint8_t i;
+    
+    if (dt == 0 || rem == 0) {
+        return 0;
+    }
+    
+    if (rem >= (dt >> 6)) {
+        rate = 1UL << (NRF24_SYNC_SKEW_SHIFT - 6);
+    } else {
+        /* Long division one fraction bit at a time - rem < dt, and doubling is compared
+         * against dt - rem so it never overflows */
+        for (i = 0; i < NRF24_SYNC_SKEW_SHIFT; i++) {
+            rate <<= 1;
+            
+            if (rem >= dt - rem) {
+                rem -= dt - rem;
+                rate |= 1;
+            } else {
+                rem <<= 1;
+            }
+        }
+    }
+    
+    return (err < 0) ? -(int32_t)rate : (int32_t)rate;
+}
+
+/* Return gateway-minus-local offset predicted by the clock model at the specified local time */
+static int32_t nrf24_sync_predict(NRF24_SYNC *sync, uint32_t local)
+{
+    /* Timer wraps every 2^32 us - the signed difference is correct within +/- 2^31 us */
+    int32_t elapsed = (int32_t)(local - sync->ref_local);
+    
+    if (elapsed < 0) {
+        return sync->offset - nrf24_sync_correction(sync->skew, (uint32_t)-elapsed);
+    }
+    
+    return sync->offset + nrf24_sync_correction(sync->skew, (uint32_t)elapsed);
+}
+
+/* Fold a new offset measurement taken at local time mid into the clock model */
+static void nrf24_sync_update(NRF24_SYNC *sync, uint32_t mid, uint32_t t2)
+{
+    int32_t measured = (int32_t)(t2 - mid);
+    int32_t err;
+    int32_t rate_err;
+    uint32_t dt;
+    
+    if (sync->samples == 0) {
+        sync->offset = measured;
+        sync->skew = 0;
+    } else {
+        err = measured - nrf24_sync_predict(sync, mid);
+        dt = mid - sync->ref_local;
+        rate_err = nrf24_sync_rate(err, dt);
+        
+        if (sync->samples == 1) {
+            /* First rate measurement - take it in full */
+            sync->offset = measured;
+            sync->skew += rate_err;
+        } else {
+            /* Afterwards split the error between phase and rate to filter timestamp jitter */
+            sync->offset = measured - err / 2;
+            sync->skew += rate_err / 4;
+        }
+        
+        if (sync->skew > NRF24_SYNC_MAX_SKEW) {
+            sync->skew = NRF24_SYNC_MAX_SKEW;
+        } else if (sync->skew < -NRF24_SYNC_MAX_SKEW) {
+            sync->skew = -NRF24_SYNC_MAX_SKEW;
+        }
+    }
+    
+    sync->ref_local = mid;
+    
+    if (sync->samples < 255) {
+        sync->samples++;
+    }
+}
+
+/* 
+ * Remove every sync response from the RX queue, leaving other payloads in order for the
+ * caller. Returns true and the gateway time if one of them answers request seq.
+ */
+static bool nrf24_sync_take_resp(NRF24_DEVICE *dev, uint8_t seq, uint32_t *t2)
+{
+    NRF24_PAYLOAD *payload;
+    uint8_t rd;
+    uint8_t wr = dev->rx_tail;
+    bool found = false;
+    
+    for (rd = dev->rx_tail; rd != dev->rx_head; rd++) {
+        payload = &dev->rx_queue[rd & (NRF24_RX_QUEUE_SIZE - 1)];
+        
+        if (payload->len >= NRF24_SYNC_RESP_LEN && payload->data[0] == NRF24_SYNC_RESP) {
+            if (payload->data[1] == seq) {
+                *t2 = (uint32_t)payload->data[2] | ((uint32_t)payload->data[3] << 8) |
+                        ((uint32_t)payload->data[4] << 16) | ((uint32_t)payload->data[5] << 24);
+                found = true;
+            }
+        } else {
+            if (wr != rd) {
+                dev->rx_queue[wr & (NRF24_RX_QUEUE_SIZE - 1)] = *payload;
+            }
+            
+            wr++;
+        }
+    }
+    
+    dev->rx_head = wr;
+    
+    return found;
+}
+
+/* Reset node-side state - dev, local_time_us and max_rtt must already be set */
+void nrf24_sync_node_init(NRF24_SYNC *sync)
+{
+    sync->seq = 0;
+    sync->prev_valid = false;
+    sync->samples = 0;
+    sync->ref_local = 0;
+    sync->offset = 0;
+    sync->skew = 0;
+}
+
+/* Send a timestamped beacon request - radio must be in TX or standby-II */
+void nrf24_sync_node_start(NRF24_SYNC *sync)
+{
+    uint8_t req[NRF24_SYNC_REQ_LEN];
+    
+    sync->seq++;
+    
+    req[0] = NRF24_SYNC_REQ;
+    req[1] = sync->seq;
+    
+    sync->retransmits = sync->dev->stats.retransmits;
+    sync->t1 = sync->local_time_us();
+    
+    nrf24_dev_send(sync->dev, req, NRF24_SYNC_REQ_LEN);
+}
+
+/* Check progress of the request - returns one of NRF24_SYNC_PENDING/DONE/UPDATED/FAILED */
+uint8_t nrf24_sync_node_poll(NRF24_SYNC *sync)
+{
+    uint8_t tx_result;
+    uint8_t result = NRF24_SYNC_DONE;
+    uint32_t t2;
+    uint32_t t4;
+    uint32_t rtt;
+    
+    tx_result = nrf24_dev_poll_tx(sync->dev);
+    t4 = sync->local_time_us();
+    
+    if (tx_result == NRF24_TX_PENDING) {
+        return NRF24_SYNC_PENDING;
+    }
+    
+    if (tx_result == NRF24_TX_FAILED) {
+        sync->prev_valid = false;
+        return NRF24_SYNC_FAILED;
+    }
+    
+    /* ACK payload carries the gateway timestamp for the previous request */
+    nrf24_dev_service_rx(sync->dev);
+    
+    if (nrf24_sync_take_resp(sync->dev, sync->prev_seq, &t2) && sync->prev_valid) {
+        nrf24_sync_update(sync, sync->prev_mid, t2);
+        result = NRF24_SYNC_UPDATED;
+    }
+    
+    rtt = t4 - sync->t1;
+    
+    sync->prev_valid = (rtt <= sync->max_rtt) && (sync->dev->stats.retransmits == sync->retransmits);
+    sync->prev_seq = sync->seq;
+    sync->prev_mid = sync->t1 + rtt / 2;
+    
+    return result;
+}
+
+/* Convert a local timestamp to gateway time */
+uint32_t nrf24_sync_to_global(NRF24_SYNC *sync, uint32_t local)
+{
+    return local + (uint32_t)nrf24_sync_predict(sync, local);
+}
+
+/* Return current gateway time as estimated by the node */
+uint32_t nrf24_sync_now(NRF24_SYNC *sync)
+{
+    return nrf24_sync_to_global(sync, sync->local_time_us());
+}
+
+/* Return true once two updates have been made and skew is being corrected */
+bool nrf24_sync_locked(NRF24_SYNC *sync)
+{
+    return sync->samples >= 2;
+}
+
+/* 
+ * Gateway side - call for each received payload with the gateway time at which it arrived.
+ * Returns true if the payload was a sync request. The response is loaded as the ACK
+ * payload for the pipe and is returned to the node with its next request.
+ */
+bool nrf24_sync_gateway_handle(NRF24_DEVICE *dev, NRF24_PAYLOAD *payload, uint32_t rx_time)
+{
+    uint8_t resp[NRF24_SYNC_RESP_LEN];
+    
+    if (payload->len < NRF24_SYNC_REQ_LEN || payload->data[0] != NRF24_SYNC_REQ) {
+        return false;
+    }
+    
+    resp[0] = NRF24_SYNC_RESP;
+    resp[1] = payload->data[1];
+    resp[2] = (uint8_t)rx_time;
+    resp[3] = (uint8_t)(rx_time >> 8);
+    resp[4] = (uint8_t)(rx_time >> 16);
+    resp[5] = (uint8_t)(rx_time >> 24);
+    
+    nrf24_dev_write_ack_payload(dev, payload->pipe, resp, NRF24_SYNC_RESP_LEN);
+    
+    return true;
+}
@@ -0,0 +1,114 @@
+/*
+ * Constant definitions and function prototypes for
+ * over-the-air time synchronization using nRF24L01+ ACK payloads
+ * Copyright (c) 2019 David Rice
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NRF24L01P_SYNC_H
+#define NRF24L01P_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nRF24L01P.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Payload types (first byte of payload) */
+
+#define NRF24_SYNC_REQ          0x53U   /* Node to gateway: type, seq */
+#define NRF24_SYNC_RESP         0x54U   /* Gateway to node in ACK payload: type, seq, t2 (LE) */
+
+#define NRF24_SYNC_REQ_LEN      2
+#define NRF24_SYNC_RESP_LEN     6
+
+/* Return values for nrf24_sync_node_poll */
+
+#define NRF24_SYNC_PENDING      0
+#define NRF24_SYNC_DONE         1   /* Exchange finished - clock may or may not have been updated */
+#define NRF24_SYNC_UPDATED      2   /* Exchange finished and clock was corrected */
+#define NRF24_SYNC_FAILED       3   /* Request was not acknowledged */
+
+/* Clock model limits
+ * 
+ * Skew is stored in units of 2^-24 (about 0.06 ppm) and clamped to NRF24_SYNC_MAX_SKEW.
+ * 
+ */
+
+#define NRF24_SYNC_SKEW_SHIFT   24
+#define NRF24_SYNC_MAX_SKEW     16777L  /* 1000 ppm */
+
+/* Node-side synchronization state */
+typedef struct {
+    NRF24_DEVICE *dev;                  /* Radio used for the exchange (TX mode, ACK payloads enabled) */
+    uint32_t (*local_time_us)(void);    /* Free-running 32-bit local timer with 1 us resolution */
+    uint16_t max_rtt;                   /* Exchanges with a longer round trip are not used (us) */
+    
+    uint8_t seq;                        /* Sequence number of the request in flight */
+    uint32_t t1;                        /* Local time the request in flight was loaded */
+    uint32_t retransmits;               /* Radio retransmit count when the request was loaded */
+    
+    bool prev_valid;                    /* Previous exchange is usable as a sample */
+    uint8_t prev_seq;
+    uint32_t prev_mid;                  /* Local midpoint of the previous exchange, (t1 + t4) / 2 */
+    
+    uint8_t samples;                    /* Number of clock updates (saturates at 255) */
+    uint32_t ref_local;                 /* Local time at which offset was last measured */
+    int32_t offset;                     /* Gateway time minus local time at ref_local */
+    int32_t skew;                       /* Gateway clock rate relative to local clock, minus 1 */
+} NRF24_SYNC;
+
+/* Reset node-side state - dev, local_time_us and max_rtt must already be set */
+void nrf24_sync_node_init(NRF24_SYNC *sync);
+
+/* Send a timestamped beacon request - radio must be in TX or standby-II */
+void nrf24_sync_node_start(NRF24_SYNC *sync);
+
+/* 
+ * Check progress of the request - returns one of NRF24_SYNC_PENDING/DONE/UPDATED/FAILED.
+ * Sync responses are taken out of the RX queue wherever they sit; any other payloads are
+ * left queued in order for the caller.
+ */
+uint8_t nrf24_sync_node_poll(NRF24_SYNC *sync);
+
+/* Convert a local timestamp to gateway time */
+uint32_t nrf24_sync_to_global(NRF24_SYNC *sync, uint32_t local);
+
+/* Return current gateway time as estimated by the node */
+uint32_t nrf24_sync_now(NRF24_SYNC *sync);
+
+/* Return true once two updates have been made and skew is being corrected */
+bool nrf24_sync_locked(NRF24_SYNC *sync);
+
+/* 
+ * Gateway side - call for each received payload with the gateway time at which it arrived.
+ * Returns true if the payload was a sync request. The response is loaded as the ACK
+ * payload for the pipe and is returned to the node with its next request.
+ */
+bool nrf24_sync_gateway_handle(NRF24_DEVICE *dev, NRF24_PAYLOAD *payload, uint32_t rx_time);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* NRF24L01P_SYNC_H */
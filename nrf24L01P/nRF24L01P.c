@@ -9,8 +9,15 @@
  * NRF24_CE_IDLE() - Macro to set CE pin low
  * NRF24_IRQ - Interrupt pin (active low) on nRF24L01+
  * NRF24_XFER_SPI(x) - Transfer one byte to/from SPI bus without changing CSN
+ * NRF24_GET_TIME_US() - Free-running 16-bit timer value with 1 us resolution
  * 
  * Configuration is usually located in nRF24L01P-cfg.h in the same folder with the main project
+ * 
+ * The macros above are only used by nrf24_default_device, which backs the original
+ * single-radio nrf24_* API. Additional radios are described by their own NRF24_DEVICE
+ * with callbacks for their pins and SPI bus, and are driven with the nrf24_dev_* API.
+ * Define NRF24_NO_DEFAULT_DEVICE project-wide (it must be visible to nRF24L01P.h as well)
+ * to leave out the default instance, the macros and the nrf24_* single-radio API.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -32,152 +39,700 @@
  */ 
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #include "nRF24L01P.h"
 #include "nRF24L01P-cfg.h"
 
+#ifndef NRF24_NO_DEFAULT_DEVICE
+
+/* Bindings for the default instance */
+static void nrf24_default_csn(bool active)
+{
+    if (active) {
+        NRF24_CSN_ACTIVE();
+    } else {
+        NRF24_CSN_IDLE();
+    }
+}
+
+static void nrf24_default_ce(bool active)
+{
+    if (active) {
+        NRF24_CE_ACTIVE();
+    } else {
+        NRF24_CE_IDLE();
+    }
+}
+
+static uint8_t nrf24_default_xfer_spi(uint8_t data)
+{
+    return NRF24_XFER_SPI(data);
+}
+
+static uint16_t nrf24_default_get_time_us(void)
+{
+    return NRF24_GET_TIME_US();
+}
+
+NRF24_DEVICE nrf24_default_device = {
+    nrf24_default_csn,
+    nrf24_default_ce,
+    nrf24_default_xfer_spi,
+    nrf24_default_get_time_us,
+    0,                                  /* payload_width - dynamic payloads */
+    0,                                  /* config_shadow */
+    NRF24_STATE_POWER_DOWN,             /* pwr_state */
+    NRF24_STATE_POWER_DOWN,             /* pwr_target */
+    0,                                  /* pwr_since */
+    0,                                  /* pwr_settle */
+    0,                                  /* tx_start */
+    {0},                                /* stats */
+    0,                                  /* rx_head */
+    0,                                  /* rx_tail */
+    {{0}}                               /* rx_queue */
+};
+
+#endif /* NRF24_NO_DEFAULT_DEVICE */
+
+/* Assert CSN and count the SPI transaction */
+static void nrf24_dev_select(NRF24_DEVICE *dev)
+{
+    dev->stats.spi_transactions++;
+    dev->csn(true);
+}
+
+/* Transfer one byte and count it */
+static uint8_t nrf24_dev_xfer(NRF24_DEVICE *dev, uint8_t data)
+{
+    dev->stats.spi_bytes++;
+    return dev->xfer_spi(data);
+}
+
+/* STATUS is clocked out with the first byte of every command, so a NOP reads it in one byte */
+static uint8_t nrf24_dev_status(NRF24_DEVICE *dev)
+{
+    uint8_t status;
+    
+    nrf24_dev_select(dev);
+    status = nrf24_dev_xfer(dev, NRF24_SPI_NOP);
+    dev->csn(false);
+    
+    return status;
+}
+
+/* Reset driver state and put radio in power down - bindings must already be set */
+void nrf24_dev_init(NRF24_DEVICE *dev)
+{
+    dev->rx_head = 0;
+    dev->rx_tail = 0;
+    
+    nrf24_dev_stats_reset(dev);
+    
+    nrf24_dev_pwr_init(dev);
+}
+
 /* Write the specified value to a single-byte register */
-void nrf24_write_register(uint8_t reg, uint8_t value)
+void nrf24_dev_write_register(NRF24_DEVICE *dev, uint8_t reg, uint8_t value)
 {
-    NRF24_CSN_ACTIVE();
+    if (reg == NRF24_CONFIG) {
+        dev->config_shadow = value;
+    }
+    
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_W_REGISTER | reg);
-    NRF24_XFER_SPI(value);
+    nrf24_dev_xfer(dev, NRF24_W_REGISTER | reg);
+    nrf24_dev_xfer(dev, value);
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Write values from a buffer to a multi-byte register */
-void nrf24_write_register_multi(uint8_t reg, uint8_t *buf, uint8_t len)
+void nrf24_dev_write_register_multi(NRF24_DEVICE *dev, uint8_t reg, uint8_t *buf, uint8_t len)
 {
     uint8_t i;
     
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_W_REGISTER | reg);
+    nrf24_dev_xfer(dev, NRF24_W_REGISTER | reg);
     
     for (i = 0; i < len; i++) {
-        NRF24_XFER_SPI(buf[i]);
+        nrf24_dev_xfer(dev, buf[i]);
     }
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Read the value of a single-byte register */
-uint8_t nrf24_read_register(uint8_t reg)
+uint8_t nrf24_dev_read_register(NRF24_DEVICE *dev, uint8_t reg)
 {
     uint8_t value; 
     
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_R_REGISTER | reg);
-    value = NRF24_XFER_SPI(NRF24_SPI_NOP);
+    nrf24_dev_xfer(dev, NRF24_R_REGISTER | reg);
+    value = nrf24_dev_xfer(dev, NRF24_SPI_NOP);
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
     
     return value;
 }
 
 /* Read values from a multi-byte register into a buffer */
-void nrf24_read_register_multi(uint8_t reg, uint8_t *buf, uint8_t len)
+void nrf24_dev_read_register_multi(NRF24_DEVICE *dev, uint8_t reg, uint8_t *buf, uint8_t len)
 {
     uint8_t i;
     
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_R_REGISTER | reg);
+    nrf24_dev_xfer(dev, NRF24_R_REGISTER | reg);
     
     for (i = 0; i < len; i++) {
-        buf[i] = NRF24_XFER_SPI(NRF24_SPI_NOP);
+        buf[i] = nrf24_dev_xfer(dev, NRF24_SPI_NOP);
     }
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Set the specified bits in a single-byte register - performs read/modify/write */
-void nrf24_set_register_bits(uint8_t reg, uint8_t bits)
+void nrf24_dev_set_register_bits(NRF24_DEVICE *dev, uint8_t reg, uint8_t bits)
 {
     uint8_t currentValue;
     
-    currentValue = nrf24_read_register(reg);
+    currentValue = nrf24_dev_read_register(dev, reg);
     
     currentValue = currentValue | bits;
     
-    nrf24_write_register(reg, currentValue);
+    nrf24_dev_write_register(dev, reg, currentValue);
 }
 
 /* Clear the specified bits in a single-byte register - performs read/modify/write */
-void nrf24_clear_register_bits(uint8_t reg, uint8_t bits)
+void nrf24_dev_clear_register_bits(NRF24_DEVICE *dev, uint8_t reg, uint8_t bits)
 {
     uint8_t currentValue;
     
-    currentValue = nrf24_read_register(reg);
+    currentValue = nrf24_dev_read_register(dev, reg);
     
     currentValue = currentValue & ~bits;
     
-    nrf24_write_register(reg, currentValue);
+    nrf24_dev_write_register(dev, reg, currentValue);
 }
 
 /* Flush transmit FIFO */
-void nrf24_flush_tx(void)
+void nrf24_dev_flush_tx(NRF24_DEVICE *dev)
 {
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_FLUSH_TX);
+    nrf24_dev_xfer(dev, NRF24_FLUSH_TX);
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Flush receive FIFO */
-void nrf24_flush_rx(void)
+void nrf24_dev_flush_rx(NRF24_DEVICE *dev)
 {
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_FLUSH_RX);
+    nrf24_dev_xfer(dev, NRF24_FLUSH_RX);
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Set transmit address */
-void nrf24_set_tx_address(uint8_t *addr, uint8_t addr_len)
+void nrf24_dev_set_tx_address(NRF24_DEVICE *dev, uint8_t *addr, uint8_t addr_len)
 {
-    nrf24_write_register_multi(NRF24_TX_ADDR, addr, addr_len);
+    nrf24_dev_write_register_multi(dev, NRF24_TX_ADDR, addr, addr_len);
 }
 
 /* Set receive address for specified pipe */
-void nrf24_set_rx_address(uint8_t pipe, uint8_t *addr, uint8_t addr_len)
+void nrf24_dev_set_rx_address(NRF24_DEVICE *dev, uint8_t pipe, uint8_t *addr, uint8_t addr_len)
 {
-    nrf24_write_register_multi(pipe, addr, addr_len);
+    nrf24_dev_write_register_multi(dev, pipe, addr, addr_len);
 }
 
 /* Write payload to transmit FIFO - does NOT actually transmit data */
-void nrf24_write_payload(uint8_t *buffer, uint8_t len)
+void nrf24_dev_write_payload(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len)
 {
     uint8_t i;
     
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_W_TX_PAYLOAD);
+    nrf24_dev_xfer(dev, NRF24_W_TX_PAYLOAD);
     
     for (i = 0; i < len; i++) {
-        NRF24_XFER_SPI(buffer[i]);
+        nrf24_dev_xfer(dev, buffer[i]);
     }
     
-    NRF24_CSN_IDLE();
+    dev->csn(false);
 }
 
 /* Read data from receive FIFO */
-void nrf24_read_payload(uint8_t *buffer, uint8_t len)
+uint8_t nrf24_dev_read_payload(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len)
+{
+    uint8_t status;
+    uint8_t i;
+    
+    nrf24_dev_select(dev);
+    
+    status = nrf24_dev_xfer(dev, NRF24_R_RX_PAYLOAD);
+    
+    for (i = 0; i < len; i++) {
+        buffer[i] = nrf24_dev_xfer(dev, NRF24_SPI_NOP);
+    }
+    
+    dev->csn(false);
+    
+    return status;
+}
+
+/* Write payload to be returned with the next ACK on the specified pipe (pipe number 0-5) */
+void nrf24_dev_write_ack_payload(NRF24_DEVICE *dev, uint8_t pipe, uint8_t *buffer, uint8_t len)
 {
     uint8_t i;
     
-    NRF24_CSN_ACTIVE();
+    nrf24_dev_select(dev);
     
-    NRF24_XFER_SPI(NRF24_R_RX_PAYLOAD);
+    nrf24_dev_xfer(dev, NRF24_W_ACK_PAYLOAD | pipe);
     
     for (i = 0; i < len; i++) {
-        buffer[i] = NRF24_XFER_SPI(NRF24_SPI_NOP);
+        nrf24_dev_xfer(dev, buffer[i]);
+    }
+    
+    dev->csn(false);
+}
+
+/* Move everything in the RX FIFO into the RX queue - returns number of payloads queued */
+uint8_t nrf24_dev_service_rx(NRF24_DEVICE *dev)
+{
+    NRF24_PAYLOAD *slot;
+    uint8_t status;
+    uint8_t len;
+    uint8_t count = 0;
+    
+    if (nrf24_dev_read_register(dev, NRF24_FIFO_STATUS) & NRF24_RX_FULL) {
+        dev->stats.rx_overflows++;
+    }
+    
+    /* If the queue fills first, RX_DR stays set so the remaining payloads are not forgotten */
+    while ((uint8_t)(dev->rx_head - dev->rx_tail) < NRF24_RX_QUEUE_SIZE) {
+        /* With dynamic payloads the width command returns STATUS, so no separate read is needed */
+        if (dev->payload_width) {
+            status = nrf24_dev_status(dev);
+            len = dev->payload_width;
+        } else {
+            nrf24_dev_select(dev);
+            status = nrf24_dev_xfer(dev, NRF24_R_RX_PL_WID);
+            len = nrf24_dev_xfer(dev, NRF24_SPI_NOP);
+            dev->csn(false);
+        }
+        
+        /*
+         * RX_P_NO reads 0b111 when the RX FIFO is empty. Only then clear RX_DR, and look
+         * again in case a payload arrived before it was cleared.
+         */
+        if ((status & NRF24_RX_P_NO) == NRF24_RX_P_NO) {
+            nrf24_dev_write_register(dev, NRF24_STATUS, NRF24_RX_DR);
+            
+            if ((nrf24_dev_status(dev) & NRF24_RX_P_NO) == NRF24_RX_P_NO) {
+                break;
+            }
+            
+            continue;
+        }
+        
+        /* Data sheet requires a corrupt width to be discarded with a flush */
+        if (len > NRF24_MAX_PAYLOAD) {
+            nrf24_dev_flush_rx(dev);
+            continue;
+        }
+        
+        slot = &dev->rx_queue[dev->rx_head & (NRF24_RX_QUEUE_SIZE - 1)];
+        slot->len = len;
+        slot->time = dev->get_time_us();
+        
+        /* STATUS clocked out with R_RX_PAYLOAD gives the pipe of the payload being read */
+        status = nrf24_dev_read_payload(dev, slot->data, len);
+        slot->pipe = (status & NRF24_RX_P_NO) >> 1;
+        
+        dev->stats.rx_packets++;
+        dev->stats.rx_pipe[slot->pipe]++;
+        
+        dev->rx_head++;
+        count++;
+    }
+    
+    return count;
+}
+
+/* Return oldest queued payload without copying it, or NULL if the queue is empty */
+NRF24_PAYLOAD *nrf24_dev_rx_peek(NRF24_DEVICE *dev)
+{
+    if (dev->rx_head == dev->rx_tail) {
+        return NULL;
+    }
+    
+    return &dev->rx_queue[dev->rx_tail & (NRF24_RX_QUEUE_SIZE - 1)];
+}
+
+/* Release the payload returned by nrf24_dev_rx_peek */
+void nrf24_dev_rx_release(NRF24_DEVICE *dev)
+{
+    if (dev->rx_head != dev->rx_tail) {
+        dev->rx_tail++;
+    }
+}
+
+/* Load payload and start transmission - radio must already be in TX or standby-II */
+void nrf24_dev_send(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len)
+{
+    /* CE is already high, so loading the FIFO starts the PLL and the transmission */
+    nrf24_dev_write_payload(dev, buffer, len);
+    
+    dev->tx_start = dev->get_time_us();
+    dev->pwr_state = NRF24_STATE_TX;
+}
+
+/* Check result of nrf24_dev_send - returns NRF24_TX_PENDING, NRF24_TX_OK or NRF24_TX_FAILED */
+uint8_t nrf24_dev_poll_tx(NRF24_DEVICE *dev)
+{
+    uint8_t status;
+    uint16_t latency;
+    uint8_t bucket = 0;
+    
+    status = nrf24_dev_read_register(dev, NRF24_STATUS);
+    
+    if (!(status & (NRF24_TX_DS | NRF24_MAX_RT))) {
+        return NRF24_TX_PENDING;
     }
     
-    NRF24_CSN_IDLE();
+    dev->stats.retransmits += nrf24_dev_read_register(dev, NRF24_OBSERVE_TX) & NRF24_ARC_CNT;
+    
+    nrf24_dev_write_register(dev, NRF24_STATUS, status & (NRF24_TX_DS | NRF24_MAX_RT));
+    
+    if (status & NRF24_MAX_RT) {
+        /* Failed payload stays in the FIFO and would block everything behind it */
+        nrf24_dev_flush_tx(dev);
+        dev->stats.tx_failed++;
+        
+        return NRF24_TX_FAILED;
+    }
+    
+    latency = (uint16_t)(dev->get_time_us() - dev->tx_start) / NRF24_STATS_HIST_BASE_US;
+    
+    while (latency && bucket < NRF24_STATS_HIST_BUCKETS - 1) {
+        latency >>= 1;
+        bucket++;
+    }
+    
+    dev->stats.ack_latency[bucket]++;
+    dev->stats.tx_ok++;
+    
+    return NRF24_TX_OK;
 }
+
+/* Clear all link statistics */
+void nrf24_dev_stats_reset(NRF24_DEVICE *dev)
+{
+    uint8_t *p = (uint8_t *)&dev->stats;
+    uint8_t i;
+    
+    for (i = 0; i < sizeof(NRF24_STATS); i++) {
+        p[i] = 0;
+    }
+}
+
+/* Append little-endian value to snapshot buffer */
+static uint8_t *nrf24_put_le(uint8_t *buf, uint32_t value, uint8_t len)
+{
+    while (len--) {
+        *buf++ = (uint8_t)value;
+        value >>= 8;
+    }
+    
+    return buf;
+}
+
+/* 
+ * Serialize one page of link statistics (little-endian) - returns number of bytes written
+ * 
+ * Page 0: version/page, tx_ok, tx_failed, retransmits, rx_packets, rx_overflows, rx_pipe[0..5]
+ * Page 1: version/page, spi_bytes, spi_transactions, ack_latency[0..7]
+ * 
+ * The first byte holds the version in the upper nibble and the page number in the lower nibble.
+ */
+uint8_t nrf24_dev_stats_snapshot(NRF24_DEVICE *dev, uint8_t page, uint8_t *buf)
+{
+    NRF24_STATS *st = &dev->stats;
+    uint8_t *p = buf;
+    uint8_t i;
+    
+    *p++ = (NRF24_STATS_VERSION << 4) | page;
+    
+    if (page == 0) {
+        p = nrf24_put_le(p, st->tx_ok, 2);
+        p = nrf24_put_le(p, st->tx_failed, 2);
+        p = nrf24_put_le(p, st->retransmits, 4);
+        p = nrf24_put_le(p, st->rx_packets, 2);
+        p = nrf24_put_le(p, st->rx_overflows, 2);
+        
+        for (i = 0; i < NRF24_NUM_PIPES; i++) {
+            p = nrf24_put_le(p, st->rx_pipe[i], 2);
+        }
+    } else if (page == 1) {
+        p = nrf24_put_le(p, st->spi_bytes, 4);
+        p = nrf24_put_le(p, st->spi_transactions, 4);
+        
+        for (i = 0; i < NRF24_STATS_HIST_BUCKETS; i++) {
+            p = nrf24_put_le(p, st->ack_latency[i], 2);
+        }
+    }
+    
+    return (uint8_t)(p - buf);
+}
+
+/* Apply one step of the pending transition and record how long it takes to settle */
+static void nrf24_dev_pwr_step(NRF24_DEVICE *dev)
+{
+    uint8_t target = dev->pwr_target;
+    
+    dev->pwr_since = dev->get_time_us();
+    dev->pwr_settle = 0;
+    
+    if (target == NRF24_STATE_POWER_DOWN) {
+        dev->ce(false);
+        nrf24_dev_write_register(dev, NRF24_CONFIG, dev->config_shadow & ~(NRF24_PWR_UP | NRF24_PRIM_RX));
+        dev->pwr_state = NRF24_STATE_POWER_DOWN;
+    } else if (dev->pwr_state == NRF24_STATE_POWER_DOWN) {
+        /* Crystal must be running before CE can be raised */
+        nrf24_dev_write_register(dev, NRF24_CONFIG, dev->config_shadow | NRF24_PWR_UP);
+        dev->pwr_state = NRF24_STATE_STANDBY_I;
+        dev->pwr_settle = NRF24_TPD2STBY_US;
+    } else if ((dev->pwr_state == NRF24_STATE_STANDBY_II || dev->pwr_state == NRF24_STATE_TX)
+            && (target == NRF24_STATE_STANDBY_II || target == NRF24_STATE_TX)) {
+        /* Same register settings with CE already high - the radio moves on its own as payloads are loaded */
+        dev->pwr_state = target;
+    } else if (dev->pwr_state != NRF24_STATE_STANDBY_I) {
+        /* RX and TX cannot be switched directly - drop CE to return to standby-I first */
+        dev->ce(false);
+        dev->pwr_state = NRF24_STATE_STANDBY_I;
+    } else if (target == NRF24_STATE_RX) {
+        nrf24_dev_write_register(dev, NRF24_CONFIG, dev->config_shadow | NRF24_PRIM_RX);
+        dev->ce(true);
+        dev->pwr_state = NRF24_STATE_RX;
+        dev->pwr_settle = NRF24_TSTBY2A_US;
+    } else if (target == NRF24_STATE_TX || target == NRF24_STATE_STANDBY_II) {
+        if (dev->config_shadow & NRF24_PRIM_RX) {
+            nrf24_dev_write_register(dev, NRF24_CONFIG, dev->config_shadow & ~NRF24_PRIM_RX);
+        }
+        dev->ce(true);
+        dev->pwr_state = target;
+        
+        /* Standby-II is entered directly - the PLL only settles once a payload is loaded */
+        if (target == NRF24_STATE_TX) {
+            dev->pwr_settle = NRF24_TSTBY2A_US;
+        }
+    }
+}
+
+/* Initialize power manager - puts radio in power down and loads CONFIG shadow */
+void nrf24_dev_pwr_init(NRF24_DEVICE *dev)
+{
+    dev->config_shadow = nrf24_dev_read_register(dev, NRF24_CONFIG);
+    
+    dev->pwr_target = NRF24_STATE_POWER_DOWN;
+    nrf24_dev_pwr_step(dev);
+}
+
+/* Start transition to the specified power state - does NOT wait for it to complete */
+void nrf24_dev_pwr_request(NRF24_DEVICE *dev, uint8_t state)
+{
+    dev->pwr_target = state;
+    
+    nrf24_dev_pwr_poll(dev);
+}
+
+/* Advance pending transition - returns true once the requested state is reached and settled */
+bool nrf24_dev_pwr_poll(NRF24_DEVICE *dev)
+{
+    while ((uint16_t)(dev->get_time_us() - dev->pwr_since) >= dev->pwr_settle) {
+        if (dev->pwr_state == dev->pwr_target) {
+            dev->pwr_settle = 0;
+            return true;
+        }
+        
+        nrf24_dev_pwr_step(dev);
+    }
+    
+    return false;
+}
+
+/* Spin on the timer until the requested state is reached and settled */
+void nrf24_dev_pwr_wait(NRF24_DEVICE *dev)
+{
+    while (!nrf24_dev_pwr_poll(dev));
+}
+
+/* Return the power state most recently applied to the radio */
+uint8_t nrf24_dev_pwr_get_state(NRF24_DEVICE *dev)
+{
+    return dev->pwr_state;
+}
+
+/* Return time (in microseconds) to go from the specified state to the first packet on air */
+uint16_t nrf24_pwr_wake_latency(uint8_t state, bool rx)
+{
+    switch (state) {
+        case NRF24_STATE_POWER_DOWN:
+            return NRF24_TPD2STBY_US + NRF24_TSTBY2A_US;
+        case NRF24_STATE_RX:
+            return rx ? 0 : NRF24_TSTBY2A_US;
+        case NRF24_STATE_TX:
+            return rx ? NRF24_TSTBY2A_US : 0;
+        default:
+            /* Standby-II saves nothing here - loading a payload still waits for the PLL */
+            return NRF24_TSTBY2A_US;
+    }
+}
+
+/* Return typical supply current (in nanoamps) for the specified state */
+uint32_t nrf24_pwr_state_current(uint8_t state)
+{
+    switch (state) {
+        case NRF24_STATE_POWER_DOWN:
+            return NRF24_I_POWER_DOWN_NA;
+        case NRF24_STATE_STANDBY_I:
+            return NRF24_I_STANDBY_I_NA;
+        case NRF24_STATE_STANDBY_II:
+            return NRF24_I_STANDBY_II_NA;
+        case NRF24_STATE_RX:
+            return NRF24_I_RX_NA;
+        default:
+            return NRF24_I_TX_NA;
+    }
+}
+
+/* 
+ * Return lowest-current idle state that can still send (or receive) within max_latency microseconds
+ * 
+ * Candidates are checked in order of increasing current. If nothing meets the
+ * requested latency, the fastest candidate is returned.
+ */
+uint8_t nrf24_pwr_select_idle(uint16_t max_latency, bool rx)
+{
+    if (nrf24_pwr_wake_latency(NRF24_STATE_POWER_DOWN, rx) <= max_latency) {
+        return NRF24_STATE_POWER_DOWN;
+    }
+    
+    if (!rx || nrf24_pwr_wake_latency(NRF24_STATE_STANDBY_I, rx) <= max_latency) {
+        return NRF24_STATE_STANDBY_I;
+    }
+    
+    return NRF24_STATE_RX;
+}
+
+#ifndef NRF24_NO_DEFAULT_DEVICE
+
+/* Write the specified value to a single-byte register */
+void nrf24_write_register(uint8_t reg, uint8_t value)
+{
+    nrf24_dev_write_register(&nrf24_default_device, reg, value);
+}
+
+/* Write values from a buffer to a multi-byte register */
+void nrf24_write_register_multi(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    nrf24_dev_write_register_multi(&nrf24_default_device, reg, buf, len);
+}
+
+/* Read the value of a single-byte register */
+uint8_t nrf24_read_register(uint8_t reg)
+{
+    return nrf24_dev_read_register(&nrf24_default_device, reg);
+}
+
+/* Read values from a multi-byte register into a buffer */
+void nrf24_read_register_multi(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    nrf24_dev_read_register_multi(&nrf24_default_device, reg, buf, len);
+}
+
+/* Set the specified bits in a single-byte register - performs read/modify/write */
+void nrf24_set_register_bits(uint8_t reg, uint8_t bits)
+{
+    nrf24_dev_set_register_bits(&nrf24_default_device, reg, bits);
+}
+
+/* Clear the specified bits in a single-byte register - performs read/modify/write */
+void nrf24_clear_register_bits(uint8_t reg, uint8_t bits)
+{
+    nrf24_dev_clear_register_bits(&nrf24_default_device, reg, bits);
+}
+
+/* Flush transmit FIFO */
+void nrf24_flush_tx(void)
+{
+    nrf24_dev_flush_tx(&nrf24_default_device);
+}
+
+/* Flush receive FIFO */
+void nrf24_flush_rx(void)
+{
+    nrf24_dev_flush_rx(&nrf24_default_device);
+}
+
+/* Set transmit address */
+void nrf24_set_tx_address(uint8_t *addr, uint8_t addr_len)
+{
+    nrf24_dev_set_tx_address(&nrf24_default_device, addr, addr_len);
+}
+
+/* Set receive address for specified pipe */
+void nrf24_set_rx_address(uint8_t pipe, uint8_t *addr, uint8_t addr_len)
+{
+    nrf24_dev_set_rx_address(&nrf24_default_device, pipe, addr, addr_len);
+}
+
+/* Write payload to transmit FIFO - does NOT actually transmit data */
+void nrf24_write_payload(uint8_t *buffer, uint8_t len)
+{
+    nrf24_dev_write_payload(&nrf24_default_device, buffer, len);
+}
+
+/* Read data from receive FIFO */
+void nrf24_read_payload(uint8_t *buffer, uint8_t len)
+{
+    nrf24_dev_read_payload(&nrf24_default_device, buffer, len);
+}
+
+/* Initialize power manager - puts radio in power down and loads CONFIG shadow */
+void nrf24_pwr_init(void)
+{
+    nrf24_dev_pwr_init(&nrf24_default_device);
+}
+
+/* Start transition to the specified power state - does NOT wait for it to complete */
+void nrf24_pwr_request(uint8_t state)
+{
+    nrf24_dev_pwr_request(&nrf24_default_device, state);
+}
+
+/* Advance pending transition - returns true once the requested state is reached and settled */
+bool nrf24_pwr_poll(void)
+{
+    return nrf24_dev_pwr_poll(&nrf24_default_device);
+}
+
+/* Spin on the timer until the requested state is reached and settled */
+void nrf24_pwr_wait(void)
+{
+    nrf24_dev_pwr_wait(&nrf24_default_device);
+}
+
+/* Return the power state most recently applied to the radio */
+uint8_t nrf24_pwr_get_state(void)
+{
+    return nrf24_dev_pwr_get_state(&nrf24_default_device);
+}
+
+#endif /* NRF24_NO_DEFAULT_DEVICE */
@@ -217,6 +217,215 @@ extern "C" {
 #define NRF24_EN_ACK_PAY   (1 << 1)
 #define NRF24_EN_DYN_ACK   (1 << 0)
 
+/* Power states tracked by the power manager
+ * 
+ * STANDBY_II and TX share register settings (PWR_UP = 1, PRIM_RX = 0, CE high);
+ * the radio itself moves between them depending on whether the TX FIFO is empty
+ * 
+ */
+
+#define NRF24_STATE_POWER_DOWN  0
+#define NRF24_STATE_STANDBY_I   1
+#define NRF24_STATE_STANDBY_II  2
+#define NRF24_STATE_RX          3
+#define NRF24_STATE_TX          4
+
+/* Transition timing constants (in microseconds)
+ * 
+ * TPD2STBY depends on the crystal - 1.5 ms is the data sheet value for Ls < 30 mH.
+ * Define NRF24_TPD2STBY_US in nRF24L01P-cfg.h to override for a faster crystal.
+ * 
+ */
+
+#ifndef NRF24_TPD2STBY_US
+#define NRF24_TPD2STBY_US       1500U // Power down to standby-I (crystal start-up)
+#endif
+#define NRF24_TSTBY2A_US        130U  // Standby to TX or RX (PLL settling)
+
+/* Typical supply current in each state (in nanoamps) from the data sheet */
+
+#define NRF24_I_POWER_DOWN_NA   900UL
+#define NRF24_I_STANDBY_I_NA    26000UL
+#define NRF24_I_STANDBY_II_NA   320000UL
+#define NRF24_I_RX_NA           13500000UL
+#define NRF24_I_TX_NA           11300000UL
+
+/* Driver limits */
+
+#define NRF24_MAX_PAYLOAD       32
+#define NRF24_NUM_PIPES         6
+
+/* Number of received payloads buffered per radio (must be a power of two)
+ * 
+ * Define NRF24_RX_QUEUE_SIZE project-wide (compiler command line) to override,
+ * since it changes the size of NRF24_DEVICE
+ * 
+ */
+
+#ifndef NRF24_RX_QUEUE_SIZE
+#define NRF24_RX_QUEUE_SIZE     4
+#endif
+
+/* Return values for nrf24_dev_poll_tx */
+
+#define NRF24_TX_PENDING        0
+#define NRF24_TX_OK             1
+#define NRF24_TX_FAILED         2
+
+/* Link statistics
+ * 
+ * Send-to-ACK latency buckets double in width: bucket 0 is < 250 us, bucket 1 is
+ * 250-499 us, bucket 2 is 500-999 us and so on, with the last bucket open-ended.
+ * 
+ * Snapshots are split into pages that each fit in a single payload.
+ * 
+ */
+
+#define NRF24_STATS_HIST_BUCKETS    8
+#define NRF24_STATS_HIST_BASE_US    250U
+#define NRF24_STATS_VERSION         1
+#define NRF24_STATS_PAGES           2
+#define NRF24_STATS_PAGE_SIZE       25
+
+typedef struct {
+    uint16_t tx_ok;             /* Payloads acknowledged (or sent without ACK) */
+    uint16_t tx_failed;         /* Payloads dropped after MAX_RT */
+    uint32_t retransmits;       /* Sum of ARC_CNT over all sent payloads */
+    uint16_t rx_packets;        /* Payloads moved into the RX queue */
+    uint16_t rx_overflows;      /* Times the RX FIFO was found full (payloads may have been lost) */
+    uint16_t rx_pipe[NRF24_NUM_PIPES];
+    uint32_t spi_bytes;         /* Bytes clocked over SPI, including command bytes */
+    uint32_t spi_transactions;  /* CSN assertions */
+    uint16_t ack_latency[NRF24_STATS_HIST_BUCKETS];
+} NRF24_STATS;
+
+/* Payload received from the radio and held in the RX queue */
+typedef struct {
+    uint8_t pipe;
+    uint8_t len;
+    uint16_t time;      /* Timer value when the payload was moved into the queue */
+    uint8_t data[NRF24_MAX_PAYLOAD];
+} NRF24_PAYLOAD;
+
+/* 
+ * Per-radio state
+ * 
+ * The first four members bind the instance to its pins and SPI bus and must be
+ * filled in before calling nrf24_dev_init(). Everything else is owned by the driver.
+ */
+typedef struct {
+    void (*csn)(bool active);           /* Set CSN pin low (active) or high */
+    void (*ce)(bool active);            /* Set CE pin high (active) or low */
+    uint8_t (*xfer_spi)(uint8_t data);  /* Transfer one byte to/from SPI bus without changing CSN */
+    uint16_t (*get_time_us)(void);      /* Free-running 16-bit timer value with 1 us resolution */
+    
+    uint8_t payload_width;              /* Static payload width, or 0 for dynamic payloads */
+    
+    uint8_t config_shadow;              /* Last value written to CONFIG */
+    uint8_t pwr_state;                  /* State currently applied to the radio */
+    uint8_t pwr_target;                 /* State requested by the caller */
+    uint16_t pwr_since;                 /* Timer value when the current step was applied */
+    uint16_t pwr_settle;                /* Time the current step needs before the next one */
+    
+    uint16_t tx_start;                  /* Timer value when the pending payload was loaded */
+    NRF24_STATS stats;
+    
+    uint8_t rx_head;                    /* Next queue slot to be filled from the RX FIFO */
+    uint8_t rx_tail;                    /* Oldest queue slot not yet released by the caller */
+    NRF24_PAYLOAD rx_queue[NRF24_RX_QUEUE_SIZE];
+} NRF24_DEVICE;
+
+#ifndef NRF24_NO_DEFAULT_DEVICE
+/* Instance that the nrf24_* functions below operate on - bound to the NRF24_* macros in nRF24L01P-cfg.h */
+extern NRF24_DEVICE nrf24_default_device;
+#endif
+
+/* Reset driver state and put radio in power down - bindings must already be set */
+void nrf24_dev_init(NRF24_DEVICE *dev);
+
+/* Write the specified value to a single-byte register */
+void nrf24_dev_write_register(NRF24_DEVICE *dev, uint8_t reg, uint8_t value);
+
+/* Write values from a buffer to a multi-byte register */
+void nrf24_dev_write_register_multi(NRF24_DEVICE *dev, uint8_t reg, uint8_t *buf, uint8_t len);
+
+/* Read the value of a single-byte register */
+uint8_t nrf24_dev_read_register(NRF24_DEVICE *dev, uint8_t reg);
+
+/* Read values from a multi-byte register into a buffer */
+void nrf24_dev_read_register_multi(NRF24_DEVICE *dev, uint8_t reg, uint8_t *buf, uint8_t len);
+
+/* Set the specified bits in a single-byte register - performs read/modify/write */
+void nrf24_dev_set_register_bits(NRF24_DEVICE *dev, uint8_t reg, uint8_t bits);
+
+/* Clear the specified bits in a single-byte register - performs read/modify/write */
+void nrf24_dev_clear_register_bits(NRF24_DEVICE *dev, uint8_t reg, uint8_t bits);
+
+/* Flush transmit FIFO */
+void nrf24_dev_flush_tx(NRF24_DEVICE *dev);
+
+/* Flush receive FIFO */
+void nrf24_dev_flush_rx(NRF24_DEVICE *dev);
+
+/* Set transmit address */
+void nrf24_dev_set_tx_address(NRF24_DEVICE *dev, uint8_t *addr, uint8_t addr_len);
+
+/* Set receive address for specified pipe */
+void nrf24_dev_set_rx_address(NRF24_DEVICE *dev, uint8_t pipe, uint8_t *addr, uint8_t addr_len);
+
+/* Write payload to transmit FIFO - does NOT actually transmit data */
+void nrf24_dev_write_payload(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len);
+
+/* Read data from receive FIFO - returns STATUS, whose RX_P_NO is the pipe the payload came from */
+uint8_t nrf24_dev_read_payload(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len);
+
+/* Write payload to be returned with the next ACK on the specified pipe (pipe number 0-5) */
+void nrf24_dev_write_ack_payload(NRF24_DEVICE *dev, uint8_t pipe, uint8_t *buffer, uint8_t len);
+
+/*
+ * Move everything in the RX FIFO into the RX queue - returns number of payloads queued.
+ * RX_DR is cleared once the FIFO is empty. If the queue fills first, RX_DR stays set and
+ * IRQ stays asserted, so call again after releasing payloads.
+ */
+uint8_t nrf24_dev_service_rx(NRF24_DEVICE *dev);
+
+/* Return oldest queued payload without copying it, or NULL if the queue is empty */
+NRF24_PAYLOAD *nrf24_dev_rx_peek(NRF24_DEVICE *dev);
+
+/* Release the payload returned by nrf24_dev_rx_peek */
+void nrf24_dev_rx_release(NRF24_DEVICE *dev);
+
+/* Load payload and start transmission - radio must already be in TX or standby-II */
+void nrf24_dev_send(NRF24_DEVICE *dev, uint8_t *buffer, uint8_t len);
+
+/* Check result of nrf24_dev_send - returns NRF24_TX_PENDING, NRF24_TX_OK or NRF24_TX_FAILED */
+uint8_t nrf24_dev_poll_tx(NRF24_DEVICE *dev);
+
+/* Clear all link statistics */
+void nrf24_dev_stats_reset(NRF24_DEVICE *dev);
+
+/* Serialize one page of link statistics (little-endian) - returns number of bytes written */
+uint8_t nrf24_dev_stats_snapshot(NRF24_DEVICE *dev, uint8_t page, uint8_t *buf);
+
+/* Initialize power manager - puts radio in power down and loads CONFIG shadow */
+void nrf24_dev_pwr_init(NRF24_DEVICE *dev);
+
+/* Start transition to the specified power state - does NOT wait for it to complete */
+void nrf24_dev_pwr_request(NRF24_DEVICE *dev, uint8_t state);
+
+/* Advance pending transition - returns true once the requested state is reached and settled */
+bool nrf24_dev_pwr_poll(NRF24_DEVICE *dev);
+
+/* Spin on the timer until the requested state is reached and settled */
+void nrf24_dev_pwr_wait(NRF24_DEVICE *dev);
+
+/* Return the power state most recently applied to the radio */
+uint8_t nrf24_dev_pwr_get_state(NRF24_DEVICE *dev);
+
+#ifndef NRF24_NO_DEFAULT_DEVICE
+
+/* Single-radio API - each function operates on nrf24_default_device */
+
 /* Write the specified value to a single-byte register */
 void nrf24_write_register(uint8_t reg, uint8_t value);
 
@@ -253,6 +462,34 @@ void nrf24_write_payload(uint8_t *buffer, uint8_t len);
 /* Read data from receive FIFO */
 void nrf24_read_payload(uint8_t *buffer, uint8_t len);
 
+/* Initialize power manager - puts radio in power down and loads CONFIG shadow */
+void nrf24_pwr_init(void);
+
+/* Start transition to the specified power state - does NOT wait for it to complete */
+void nrf24_pwr_request(uint8_t state);
+
+/* Advance pending transition - returns true once the requested state is reached and settled */
+bool nrf24_pwr_poll(void);
+
+/* Spin on the timer until the requested state is reached and settled */
+void nrf24_pwr_wait(void);
+
+/* Return the power state most recently applied to the radio */
+uint8_t nrf24_pwr_get_state(void);
+
+#endif /* NRF24_NO_DEFAULT_DEVICE */
+
+/* Power state properties - these do not depend on the radio instance */
+
+/* Return time (in microseconds) to go from the specified state to the first packet on air */
+uint16_t nrf24_pwr_wake_latency(uint8_t state, bool rx);
+
+/* Return typical supply current (in nanoamps) for the specified state */
+uint32_t nrf24_pwr_state_current(uint8_t state);
+
+/* Return lowest-current idle state that can still send (or receive) within max_latency microseconds */
+uint8_t nrf24_pwr_select_idle(uint16_t max_latency, bool rx);
+
 #ifdef	__cplusplus
 }
 #endif